@@ -0,0 +1,179 @@
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+
+#include <getopt.h>
+
+#include "booker.h"
+#include "booking.h"
+
+
+/*
+    Throughput of many sessions hammering different theatres of the same movie.
+    Every session books and unbooks two seats in a loop, sessions are spread
+    over theatres round-robin, every session of the theatre has its own pair
+    of seats. Only pairs, which booked and released both seats, are counted.
+    Run with:
+        booking_bench [-s sessions] [-t theatres] [-d milliseconds]
+*/
+
+
+static constexpr uint32_t bench_seats = 256; /*!< seats of every theatre */
+
+/*! \brief Benchmark configuration */
+struct bench_config
+{
+    uint32_t sessions_ = 8; /*!< number of concurrent sessions (threads) */
+    uint32_t theatres_ = 8; /*!< number of theatres of the movie */
+    uint32_t duration_ms_ = 1000; /*!< duration of a single run */
+};
+
+/// @brief Load single movie played in all the theatres
+/// @param booking [io] booking ctx
+/// @param theatres [in] number of theatres
+/// @return Negative on error, >=0 on success
+static int32_t load_movie(CBooking &booking, uint32_t theatres)
+{
+    std::stringstream ss;
+    boost::property_tree::ptree pt;
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [";
+    for (uint32_t i = 0; i < theatres; ++i) {
+        ss << (i ? "," : "") << "{\"theatre\": \"T" << i << "\", \"seats\": " << bench_seats << "}";
+    }
+    ss << "]}]}";
+
+    boost::property_tree::read_json(ss, pt);
+    return booking.load_data(pt);
+}
+
+/// @brief Run single benchmark
+/// @param cfg [in] benchmark configuration
+/// @param engine [in] booking engine
+/// @param theatres [in] number of theatres sessions are spread over
+/// @param failures [out] number of book/unbook pairs, which failed
+/// @return number of successful book/unbook pairs per second
+static double run(const bench_config &cfg, CBooking::engine_t engine, uint32_t theatres, uint64_t &failures)
+{
+    CBooking booking;
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> operations(0);
+    std::atomic<uint64_t> failed(0);
+    std::vector<std::thread> threads;
+
+    failures = 0;
+    booking.set_engine(engine);
+    if (load_movie(booking, theatres) < EXIT_SUCCESS) {
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < cfg.sessions_; ++i) {
+        threads.emplace_back([&booking, &stop, &operations, &failed, i, theatres]() {
+            int32_t rc;
+            uint64_t ops;
+            uint64_t errors;
+            uint32_t seat;
+            std::string theatre = "T" + std::to_string(i % theatres);
+            std::vector<uint32_t> unavalable_seats;
+            std::vector<uint32_t> invalid_seats;
+            CBooker::booker_ptr booker = std::make_shared<CBooker>();
+
+            booking.join_booker(booker);
+
+            /*sessions of the same theatre use different seats, so they contend on lock only.
+              Configuration is checked, so seats of the theatre are not exhausted*/
+            ops = 0;
+            errors = 0;
+            seat = (i / theatres) * 2;
+            while (stop.load(std::memory_order_relaxed) != true) {
+                std::set<uint32_t> seats({seat, seat + 1});
+                rc = booking.book_seats(booker, "Matrix", theatre, seats, unavalable_seats, false);
+                if ((rc != static_cast<int32_t>(seats.size()))||(unavalable_seats.empty() != true)) {
+                    errors++;
+                    continue;
+                }
+                rc = booking.unbook_seats(booker, "Matrix", theatre, seats, invalid_seats);
+                if ((rc < EXIT_SUCCESS)||(invalid_seats.empty() != true)) {
+                    errors++;
+                    continue;
+                }
+                ops++;
+            }
+
+            booking.leave_booker(booker);
+            operations += ops;
+            failed += errors;
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(cfg.duration_ms_));
+    stop = true;
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    failures = failed.load();
+    return static_cast<double>(operations.load()) * 1000.0 / cfg.duration_ms_;
+}
+
+/// @brief Main entry
+/// @param argc [in] number of parameters
+/// @param argv [in] parameter value
+/// @return Program compltition
+int main(int argc, char* argv[])
+{
+    int opt;
+    bench_config cfg;
+    uint64_t failures;
+
+    while ((opt = getopt(argc, argv, "s:t:d:")) != -1) {
+        switch (opt) {
+        case 's':
+            cfg.sessions_ = static_cast<uint32_t>(std::stoul(optarg));
+            break;
+        case 't':
+            cfg.theatres_ = static_cast<uint32_t>(std::stoul(optarg));
+            break;
+        case 'd':
+            cfg.duration_ms_ = static_cast<uint32_t>(std::stoul(optarg));
+            break;
+        default:
+            std::cerr << "Usage: " << argv[0] << " [-s sessions] [-t theatres] [-d milliseconds]\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    if ((cfg.sessions_ == 0)||(cfg.theatres_ == 0)||(cfg.duration_ms_ == 0)) {
+        std::cerr << "Invalid configuration\n";
+        return EXIT_FAILURE;
+    }
+
+    /*single theatre run holds all the sessions, each of them needs its own pair of seats*/
+    if (cfg.sessions_ > bench_seats / 2) {
+        std::cerr << "Invalid configuration, at most " << bench_seats / 2 << " sessions share seats of one theatre\n";
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "sessions: " << cfg.sessions_ << ", duration: " << cfg.duration_ms_ << " ms\n";
+    std::cout << std::left << std::setw(12) << "engine" << std::setw(12) << "theatres" << "ops/s\n";
+
+    for (auto engine : {CBooking::engine_t::locked, CBooking::engine_t::lock_free}) {
+        const char *name = (engine == CBooking::engine_t::locked) ? "locked" : "lock_free";
+
+        /*everybody in one theatre is the old per movie lock case*/
+        for (uint32_t theatres : {1u, cfg.theatres_}) {
+            double ops = run(cfg, engine, theatres, failures);
+            std::cout << std::left << std::setw(12) << name << std::setw(12) << theatres << std::fixed << std::setprecision(0) << ops << "\n";
+            if (failures != 0) {
+                std::cerr << "Failed book/unbook pairs: " << failures << "\n";
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+#include <queue>
+#include <utility>
+#include <algorithm>
+
+#include "availability.h"
+
+
+/// @brief Size the tree, all the values are 0
+///     Tree must not be used concurrently while resizing
+/// @param size [in] number of entries
+void CAvailability::resize(uint32_t size)
+{
+    m_size = size;
+    m_leaves = 1;
+    while (m_leaves < size) {
+        m_leaves *= 2;
+    }
+
+    m_nodes = std::make_unique<std::atomic<uint32_t>[]>(2 * m_leaves);
+    for (std::size_t i = 0; i < 2 * m_leaves; ++i) {
+        m_nodes[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+/// @brief Set value of the entry and refresh its ancestors
+/// @param index [in] index of the entry
+/// @param value [in] new value
+void CAvailability::set(uint32_t index, uint32_t value)
+{
+    std::size_t node;
+    uint32_t max_value;
+
+    if (index >= m_size) {
+        return;
+    }
+
+    node = m_leaves + index;
+    m_nodes[node].store(value, std::memory_order_seq_cst);
+
+    for (node /= 2; node >= 1; node /= 2) {
+        /*concurrent writer of the sibling may store older maximum, whoever writes last checks again*/
+        for (;;) {
+            max_value = children_max(node);
+            if (m_nodes[node].exchange(max_value, std::memory_order_seq_cst) == max_value) {
+                if (children_max(node) == max_value) {
+                    /*node didn't change, so its ancestors don't change either*/
+                    return;
+                }
+                continue;
+            }
+            if (children_max(node) == max_value) {
+                break;
+            }
+        }
+    }
+}
+
+/// @brief Get value of the entry
+/// @param index [in] index of the entry
+/// @return value, 0 if entry doesn't exist
+uint32_t CAvailability::get(uint32_t index) const
+{
+    if (index >= m_size) {
+        return 0;
+    }
+
+    return m_nodes[m_leaves + index].load(std::memory_order_acquire);
+}
+
+/// @brief Find entries with value at least n
+/// @param n [in] minimal value, at least 1
+/// @param entries [out] indexes of the entries, in ascending order
+void CAvailability::find_at_least(uint32_t n, std::vector<uint32_t> &entries) const
+{
+    std::size_t node;
+    std::vector<std::size_t> stack;
+
+    entries.clear();
+    if (m_size == 0) {
+        return;
+    }
+
+    n = std::max<uint32_t>(n, 1);
+    stack.push_back(1);
+    while (stack.empty() != true) {
+        node = stack.back();
+        stack.pop_back();
+
+        /*subtree without such entry is skipped as a whole*/
+        if (m_nodes[node].load(std::memory_order_acquire) < n)
+            continue;
+
+        if (node >= m_leaves) {
+            entries.push_back(static_cast<uint32_t>(node - m_leaves));
+            continue;
+        }
+
+        stack.push_back(2 * node + 1);
+        stack.push_back(2 * node);
+    }
+}
+
+/// @brief Find entries with the largest values, entries with value 0 are not reported
+/// @param k [in] maximal number of entries
+/// @param entries [out] indexes of the entries, from the largest value, equal values in ascending order
+void CAvailability::find_top(uint32_t k, std::vector<uint32_t> &entries) const
+{
+    std::size_t node;
+    uint32_t value;
+
+    /*the largest value first, lower node first among equal values*/
+    auto compare = [](const std::pair<uint32_t, std::size_t> &a, const std::pair<uint32_t, std::size_t> &b)
+    {
+        return (a.first != b.first) ? (a.first < b.first) : (a.second > b.second);
+    };
+    std::priority_queue<std::pair<uint32_t, std::size_t>, std::vector<std::pair<uint32_t, std::size_t>>, decltype(compare)> queue(compare);
+
+    entries.clear();
+    if (m_size == 0) {
+        return;
+    }
+
+    queue.emplace(m_nodes[1].load(std::memory_order_acquire), 1);
+    while ((queue.empty() != true)&&(entries.size() < k)) {
+        std::tie(value, node) = queue.top();
+        queue.pop();
+
+        if (value == 0)
+            break;
+
+        if (node >= m_leaves) {
+            entries.push_back(static_cast<uint32_t>(node - m_leaves));
+            continue;
+        }
+
+        queue.emplace(m_nodes[2 * node].load(std::memory_order_acquire), 2 * node);
+        queue.emplace(m_nodes[2 * node + 1].load(std::memory_order_acquire), 2 * node + 1);
+    }
+}
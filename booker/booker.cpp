@@ -0,0 +1,87 @@
+#include "booker.h"
+
+
+/// @brief get number of seats owned by the booker, over all theatres
+/// @return number of owned seats
+uint32_t CBooker::get_seats_count(void) const
+{
+    std::lock_guard<std::mutex> lck(m_mutex);
+
+    return m_seats_count;
+}
+
+/// @brief get number of seats owned by the booker in theatre
+/// @param theatre [in] theatre id
+/// @return number of owned seats
+uint32_t CBooker::get_seats_count(uint32_t theatre) const
+{
+    std::lock_guard<std::mutex> lck(m_mutex);
+
+    auto it = m_holdings.find(theatre);
+    if (it == m_holdings.end())
+        return 0;
+
+    return static_cast<uint32_t>(it->second.size());
+}
+
+/// @brief get seats owned by the booker in theatre
+/// @param theatre [in] theatre id
+/// @param seats [out] owned seats
+void CBooker::get_owned_seats(uint32_t theatre, std::set<uint32_t> &seats) const
+{
+    std::lock_guard<std::mutex> lck(m_mutex);
+
+    seats.clear();
+    auto it = m_holdings.find(theatre);
+    if (it != m_holdings.end())
+        seats = it->second;
+}
+
+/// @brief get seats owned by the booker in all theatres
+/// @param holdings [out] owned seats per theatre
+void CBooker::get_holdings(holdings_t &holdings) const
+{
+    std::lock_guard<std::mutex> lck(m_mutex);
+
+    holdings = m_holdings;
+}
+
+/// @brief Account newly owned seats
+/// @param theatre [in] theatre id
+/// @param seats [in] list of seats
+void CBooker::add_seats(uint32_t theatre, const std::vector<uint32_t> &seats)
+{
+    if (seats.empty())
+        return;
+
+    std::lock_guard<std::mutex> lck(m_mutex);
+
+    std::set<uint32_t> &owned = m_holdings[theatre];
+    for (uint32_t seat : seats) {
+        if (owned.insert(seat).second)
+            m_seats_count++;
+    }
+}
+
+/// @brief Account released seats
+/// @param theatre [in] theatre id
+/// @param seats [in] list of seats
+void CBooker::remove_seats(uint32_t theatre, const std::vector<uint32_t> &seats)
+{
+    if (seats.empty())
+        return;
+
+    std::lock_guard<std::mutex> lck(m_mutex);
+
+    auto it = m_holdings.find(theatre);
+    if (it == m_holdings.end())
+        return;
+
+    for (uint32_t seat : seats) {
+        m_seats_count -= static_cast<uint32_t>(it->second.erase(seat));
+    }
+
+    /*theatres without seats are dropped, so cleanup touches held theatres only*/
+    if (it->second.empty())
+        m_holdings.erase(it);
+}
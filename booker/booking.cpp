@@ -1,4 +1,13 @@
+#include <bit>
 #include <cassert>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <utility>
+#include <system_error>
+#include <iterator>
+#include <algorithm>
 
 #include <boost/optional/optional.hpp>
 
@@ -7,58 +16,522 @@
 
 
 /// @brief Standard constructor
-CBooking::CBooking()
+CBooking::CBooking() :\
+    m_catalog_owner(std::make_shared<catalog>()), m_catalog(m_catalog_owner.get())
 {
 
 }
 
-/// @brief Join new session as booker
+/// @brief Join new session as booker, booker gets compact handle
+///     Handles of left bookers are reused, so handles stay dense
 /// @param booker [in] new booker
-/// @return Negative on error, >=0 on success
+/// @return Negative on error, booker handle on success
 int32_t CBooking::join_booker(CBooker::booker_ptr booker)
 {
-    uint32_t connections_ctx;
-
-    if (booker == nullptr)
-        return -EINVAL;
-
-    auto it = m_active_bookers_set.insert(booker);
-    if (it.second != true)
-        return -EEXIST;
-
-    connections_ctx = m_connections_ctx++;
-    return static_cast<int32_t>(connections_ctx + 1);
+    return m_bookers.insert(booker);
 }
 
 /// @brief Leave us(booker) from booking. Session was closed
+///     Seats are kept, released at once, or released after grace period,
+///     depending on release policy
 /// @param booker [in] Removing booker
 void CBooking::leave_booker(CBooker::booker_ptr booker)
 {
+    uint32_t handle;
+
     if (booker == nullptr)
         return;
 
-    m_active_bookers_set.erase(booker);
+    handle = booker->get_booker_id();
+    if ((handle == 0)||(m_bookers.find(handle) != booker))
+        return;
+
+    if (booker->get_seats_count() == 0) {
+        m_bookers.erase(booker, true);
+        return;
+    }
+
+    if (m_release_policy == release_policy_t::keep) {
+        /*seats stay booked, so the handle can't be reused anymore*/
+        m_bookers.erase(booker, false);
+        return;
+    }
+
+    if (m_release_grace.count() > 0) {
+        /*booker stays registered, so its seats are still shown with its name*/
+        std::lock_guard<std::mutex> lck(m_departed_mutex);
+        m_departed_bookers.push_back(departed_booker{std::chrono::steady_clock::now() + m_release_grace, booker});
+        return;
+    }
+
+    release_booker(booker);
+}
+
+/// @brief Release seats of closed sessions, which grace period is over
+/// @param now [in] current time
+/// @return number of released seats
+uint32_t CBooking::release_departed(std::chrono::steady_clock::time_point now)
+{
+    uint32_t released;
+    std::vector<CBooker::booker_ptr> expired;
+
+    {
+        std::lock_guard<std::mutex> lck(m_departed_mutex);
+
+        /*grace period is the same for everybody, so deadlines are ordered*/
+        while ((m_departed_bookers.empty() != true)&&(m_departed_bookers.front().deadline_ <= now)) {
+            expired.push_back(std::move(m_departed_bookers.front().booker_));
+            m_departed_bookers.pop_front();
+        }
+    }
+
+    released = 0;
+    for (auto &booker : expired) {
+        released += release_booker(booker);
+    }
+
+    return released;
+}
+
+/// @brief Release all the seats of the booker and forget the booker
+///     Cost is proportional to the number of held seats
+/// @param booker [in] booker
+/// @return number of released seats
+uint32_t CBooking::release_booker(CBooker::booker_ptr booker)
+{
+    int32_t rc;
+    uint32_t released;
+    CBooker::holdings_t holdings;
+    std::vector<uint32_t> invalid_seats;
+
+    CEpoch::reader reader(m_epoch);
+
+    released = 0;
+    booker->get_holdings(holdings);
+    for (auto it = holdings.begin(); it != holdings.end(); ++it) {
+        theatre_reservation *p_reservation = find_theatre(it->first);
+        if (p_reservation == nullptr) {
+            /*theatre was removed, reload forgets its seats*/
+            continue;
+        }
+
+        theatre_access access(*p_reservation, m_engine == engine_t::lock_free);
+
+        rc = unbook_seats(booker, *p_reservation, it->second, invalid_seats);
+        if (rc > 0) {
+            released += static_cast<uint32_t>(rc);
+        }
+    }
+
+    /*handle, which still marks seats, is retired*/
+    m_bookers.erase(booker, booker->get_seats_count() == 0);
+
+    return released;
 }
 
 /// @brief Create list of empty seats
+///     Seats are not allocated, theatre shares all free sentinel until it is changed
+/// @param reservations [out] Location, where list needs to be stored
+/// @param capacity [in] number of seats in the theatre
+/// @return Negative on error, >=0 on success
+int32_t CBooking::prepare_reservation (theatre_reservation &reservations, uint32_t capacity)
+{
+    if ((capacity == 0)||(capacity > m_max_seats_capacity)) {
+        return -ERANGE;
+    }
+
+    reservations.seats_.store(get_sentinel(capacity), std::memory_order_release);
+
+    return static_cast<int32_t>(capacity);
+}
+
+/// @brief Create empty seats
+/// @param seats [out] seats, all of them are free
+/// @param capacity [in] number of seats in the theatre
+void CBooking::prepare_seats (seat_state &seats, uint32_t capacity)
+{
+    /*all the seats are free at the beginning*/
+    seats.free_seats_map_.resize(capacity, true);
+
+    /*array of atomics can't be resized, create it at once*/
+    seats.owners_storage_ = std::make_unique<seat_state::owner_t[]>(capacity);
+    seats.owners_ = seats.owners_storage_.get();
+
+    seats.runs_.build(seats.free_seats_map_);
+}
+
+/// @brief Get all free sentinel of the capacity, shared by all the theatres nobody changed yet
+/// @param capacity [in] number of seats in the theatre
+/// @return sentinel, it lives as long as the process
+CBooking::seat_state *CBooking::get_sentinel(uint32_t capacity)
+{
+    /*catalogs have few distinct capacities, so sentinels are few.
+      They are shared by all the bookings, theatre can outlive its booking*/
+    static std::mutex sentinels_mutex;
+    static std::unordered_map<uint32_t, std::unique_ptr<seat_state>> sentinels;
+
+    std::lock_guard<std::mutex> lck(sentinels_mutex);
+
+    std::unique_ptr<seat_state> &sentinel = sentinels[capacity];
+    if (sentinel == nullptr) {
+        sentinel = std::make_unique<seat_state>();
+        prepare_seats(*sentinel, capacity);
+        sentinel->shared_ = true;
+    }
+
+    return sentinel.get();
+}
+
+/// @brief Give the theatre its own seats, before they are changed for the first time.
+///     Concurrent callers agree on the same seats without lock
+/// @param reservation [io] theatre
+/// @return seats of the theatre, never the sentinel
+CBooking::seat_state &CBooking::materialize(theatre_reservation &reservation)
+{
+    seat_state *p_seats;
+
+    p_seats = reservation.seats_.load(std::memory_order_acquire);
+    if (p_seats->shared_ != true) {
+        return *p_seats;
+    }
+
+    auto own_seats = std::make_unique<seat_state>();
+    prepare_seats(*own_seats, p_seats->free_seats_map_.capacity());
+
+    /*the first one publishes its seats, the others use them and drop their own*/
+    if (reservation.seats_.compare_exchange_strong(p_seats, own_seats.get(), std::memory_order_acq_rel)) {
+        p_seats = own_seats.get();
+        reservation.own_seats_ = std::move(own_seats);
+    }
+
+    return *p_seats;
+}
+
+/// @brief Parse single theatre configuration
+///     Theatre is either just a name, or an object with name, capacity and layout
+///     "Tokyo"
+///     {"theatre": "Tokyo", "seats": 30}
+///     {"theatre": "Tokyo", "layout": [{"section": "Stalls", "row": "A", "seats": 10}, ...]}
+/// @param pt [in] theatre configuration tree
+/// @param theatre [out] name of the theatre
 /// @param reservations [out] Location, where list needs to be stored
 /// @return Negative on error, >=0 on success
-int32_t CBooking::prepare_reservation (theatre_reservation &reservations)
+int32_t CBooking::load_theatre
+(
+    const boost::property_tree::ptree &pt,
+    std::string &theatre,
+    theatre_reservation &reservations
+)
 {
-    for (uint32_t seat = 0; seat < m_max_seats_capacity; ++seat) {
-        auto rc = reservations.free_reservations_set_.insert(seat);
-        if (rc.second != true) {
-            return -ENOMEM;
+    uint32_t capacity;
+
+    if (pt.empty()) {
+        /*just a name, theatre has default capacity*/
+        theatre = pt.get_value<std::string>();
+        if (theatre.empty()) {
+            return -EBADMSG;
+        }
+        return prepare_reservation(reservations, m_default_seats_capacity);
+    }
+
+    theatre = pt.get<std::string>("theatre", "");
+    if (theatre.empty()) {
+        /*theatre without name can't be booked*/
+        return -EBADMSG;
+    }
+
+    capacity = 0;
+    auto layout = pt.get_child_optional("layout");
+    if (layout) {
+        for (auto it = layout->begin(); it != layout->end(); ++it) {
+            /*rows are numbered one after another*/
+            seat_row new_row;
+
+            auto seats = it->second.get_optional<uint32_t>("seats");
+            if ((!seats)||(*seats == 0)||(*seats > m_max_seats_capacity - capacity)) {
+                return -EBADMSG;
+            }
+
+            new_row.section_ = it->second.get<std::string>("section", "");
+            new_row.row_ = it->second.get<std::string>("row", std::to_string(reservations.layout_.size() + 1));
+            new_row.first_seat_ = capacity;
+            new_row.seats_ = *seats;
+            capacity += *seats;
+
+            reservations.layout_.push_back(std::move(new_row));
+        }
+    }
+
+    auto seats = pt.get_optional<uint32_t>("seats");
+    if (seats) {
+        if ((layout)&&(*seats != capacity)) {
+            /*layout doesn't match the capacity*/
+            return -EBADMSG;
         }
+        capacity = *seats;
+    }
+    else if (!layout) {
+        capacity = m_default_seats_capacity;
     }
 
-    return static_cast<int32_t>(m_max_seats_capacity);
+    return prepare_reservation(reservations, capacity);
 }
 
-/// @brief Load dynamic configuration
+/// @brief Load dynamic configuration, or replace loaded one while bookings keep on running
+///     Theatre with the same movie, name, capacity and layout keeps its seats and show handle.
+///     Seats and holds of removed theatres are dropped, new theatres get new handles
 /// @param pt [in] configuration tree
-/// @return Negative on error, >=0 on success
+/// @return Negative on error, -EBUSY if journal or seat store is open, >=0 on success
 int32_t CBooking::load_data(const boost::property_tree::ptree &pt)
+{
+    int32_t rc;
+    std::vector<catalog_config> shards(1);
+
+    rc = read_config(pt, shards.front());
+    if (rc < EXIT_SUCCESS) {
+        return rc;
+    }
+
+    return publish_catalog(shards);
+}
+
+/// @brief Load dynamic configuration from JSON document, or replace loaded one.
+///     Document is parsed as it is read, theatres are built without configuration tree
+/// @param stream [in] configuration document
+/// @return Negative on error, -EBUSY if journal or seat store is open, >=0 on success
+int32_t CBooking::load_data(std::istream &stream)
+{
+    int32_t rc;
+    std::vector<catalog_config> shards(1);
+
+    rc = parse_catalog(stream, shards.front());
+    if (rc < EXIT_SUCCESS) {
+        return rc;
+    }
+
+    return publish_catalog(shards);
+}
+
+/// @brief Load dynamic configuration from JSON file, or from all the *.json shards of the directory.
+///     Shards are parsed in parallel, then merged in the order of file names,
+///     so handles don't depend on the number of threads. Movie can be listed in several shards
+/// @param path [in] catalog file or directory of shards
+/// @param threads [in] number of parser threads, 0 or 1 parses in the calling thread
+/// @return Negative on error, -ENOENT if there is no catalog, number of loaded shards on success
+int32_t CBooking::load_files(const std::string &path, uint32_t threads)
+{
+    int32_t rc;
+    std::error_code ec;
+    std::vector<std::string> paths;
+    std::vector<std::thread> workers;
+    std::atomic<std::size_t> next_shard = 0;
+
+    if (std::filesystem::is_directory(path, ec)) {
+        for (const auto &entry : std::filesystem::directory_iterator(path, ec)) {
+            if ((entry.is_regular_file(ec))&&(entry.path().extension() == ".json"))
+                paths.push_back(entry.path().string());
+        }
+        std::sort(paths.begin(), paths.end());
+    }
+    else {
+        paths.push_back(path);
+    }
+
+    if (paths.empty()) {
+        return -ENOENT;
+    }
+
+    std::vector<catalog_config> shards(paths.size());
+    std::vector<int32_t> results(paths.size(), EXIT_SUCCESS);
+
+    /*every thread takes next shard, big shards don't hold the small ones*/
+    auto parse = [this, &paths, &shards, &results, &next_shard]()
+    {
+        for (std::size_t i = next_shard++; i < paths.size(); i = next_shard++) {
+            std::ifstream file(paths[i], std::ios::binary);
+            results[i] = (file.is_open()) ? parse_catalog(file, shards[i]) : -ENOENT;
+        }
+    };
+
+    threads = std::min<uint32_t>(threads, static_cast<uint32_t>(paths.size()));
+    for (uint32_t i = 1; i < threads; ++i) {
+        workers.emplace_back(parse);
+    }
+    parse();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    for (int32_t result : results) {
+        if (result < EXIT_SUCCESS)
+            return result;
+    }
+
+    rc = publish_catalog(shards);
+    if (rc < EXIT_SUCCESS) {
+        return rc;
+    }
+
+    return static_cast<int32_t>(paths.size());
+}
+
+/// @brief Load dynamic configuration from compiled catalog image, or replace loaded one.
+///     Image loaded into empty booking gives shows the handles stored in the image.
+///     Image stays mapped as long as the catalog lives, names and hash tables are used in place
+/// @param path [in] image file
+/// @return Negative on error, -EBADMSG if image is damaged, number of shows on success
+int32_t CBooking::load_image(const std::string &path)
+{
+    int32_t rc;
+
+    auto image = std::make_shared<CCatalogImage>();
+    if (image == nullptr) {
+        return -ENOMEM;
+    }
+
+    rc = image->open(path);
+    if (rc < EXIT_SUCCESS) {
+        return rc;
+    }
+
+    std::lock_guard<std::mutex> lck(m_reload_mutex);
+
+    auto new_catalog = std::make_shared<catalog>();
+    if (new_catalog == nullptr) {
+        return -ENOMEM;
+    }
+
+    rc = map_catalog(image, *m_catalog_owner, *new_catalog);
+    if (rc < EXIT_SUCCESS) {
+        return rc;
+    }
+
+    rc = install_catalog(new_catalog);
+    if (rc < EXIT_SUCCESS) {
+        return rc;
+    }
+
+    return static_cast<int32_t>(image->get_shows());
+}
+
+/// @brief Compile current catalog to image, which is loaded without JSON parsing
+/// @param path [in] image file, replaced atomically
+/// @return Negative on error, -EINVAL if reload left handles out of order, size of the file on success
+int32_t CBooking::save_image(const std::string &path) const
+{
+    std::vector<CCatalogImage::movie> movies;
+
+    /*pointer keeps names alive, reload doesn't wait for the file*/
+    catalog_ptr configuration = get_configuration();
+
+    movies.reserve(configuration->movies_map_.size());
+    for (const auto &[movie_name, movie_item] : configuration->movies_map_) {
+        CCatalogImage::movie image_movie;
+
+        image_movie.movie_ = movie_name;
+        for (const auto &[theatre_name, reservation] : movie_item->theatre_reservations_map_) {
+            CCatalogImage::show image_show;
+
+            image_show.theatre_ = theatre_name;
+            image_show.handle_ = reservation->id_;
+            image_show.capacity_ = reservation->get_seats().free_seats_map_.capacity();
+            for (const auto &row : reservation->layout_) {
+                image_show.layout_.push_back(CCatalogImage::row{row.section_, row.row_, row.first_seat_, row.seats_});
+            }
+
+            image_movie.shows_.push_back(std::move(image_show));
+        }
+
+        movies.push_back(std::move(image_movie));
+    }
+
+    return CCatalogImage::save(path, movies);
+}
+
+/// @brief Publish catalog built from parsed configuration
+///     Open seat store is laid out by ids of the new catalog, journal gets its table of theatres
+/// @param shards [io] parsed configuration, theatres are moved to the catalog
+/// @return Negative on error, >=0 on success
+int32_t CBooking::publish_catalog(std::vector<catalog_config> &shards)
+{
+    int32_t rc;
+
+    std::lock_guard<std::mutex> lck(m_reload_mutex);
+
+    auto new_catalog = std::make_shared<catalog>();
+    if (new_catalog == nullptr) {
+        return -ENOMEM;
+    }
+
+    rc = build_catalog(shards, *m_catalog_owner, *new_catalog);
+    if (rc < EXIT_SUCCESS) {
+        return rc;
+    }
+
+    return install_catalog(new_catalog);
+}
+
+/// @brief Publish built catalog, caller holds m_reload_mutex
+///     Open seat store is laid out by ids of the new catalog, journal gets its table of theatres
+/// @param new_catalog [in] new catalog
+/// @return Negative on error, >=0 on success
+int32_t CBooking::install_catalog(const std::shared_ptr<catalog> &new_catalog)
+{
+    int32_t rc;
+    catalog_ptr old_catalog;
+    CSeatStore old_store;
+    std::vector<std::unique_ptr<seat_state>> retired_seats;
+
+    /*seat store and journal address theatres by ids, new theatres get ids behind the old ones*/
+    if (m_seat_store.is_open()) {
+        rc = move_seat_store(*new_catalog, old_store, retired_seats);
+        if (rc < EXIT_SUCCESS) {
+            return rc;
+        }
+    }
+
+    /*records of new theatres can't get in front of the table, it is appended before they are seen*/
+    if (m_journal.is_open()) {
+        journal_catalog('R', *new_catalog);
+    }
+
+    /*bookings see either the old or the new catalog, nobody waits for the swap*/
+    old_catalog = std::move(m_catalog_owner);
+    m_catalog_owner = new_catalog;
+    m_catalog.store(new_catalog.get(), std::memory_order_seq_cst);
+
+    /*bookings, which started before the swap, can still change removed theatres or read moved seats*/
+    m_epoch.synchronize();
+    retired_seats.clear();
+
+    /*they published their changes to the old catalog, so the new one reads all the counts again*/
+    for (const theatre_reservation *p_reservation : new_catalog->theatres_table_) {
+        if (p_reservation != nullptr)
+            update_availability(*p_reservation);
+    }
+
+    for (std::size_t id = 0; id < old_catalog->theatres_table_.size(); ++id) {
+        if ((old_catalog->theatres_table_[id] != nullptr)&&(new_catalog->theatres_table_[id] == nullptr)) {
+            forget_theatre(*old_catalog->theatres_table_[id]);
+
+            /*holders of the old catalog can still read its seats, the old store goes away*/
+            if (old_store.is_open())
+                detach_seats(*old_catalog->theatres_table_[id]);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/// @brief Read configuration tree
+/// @param pt [in] configuration tree
+/// @param config [out] movies and their theatres
+/// @return Negative on error, >=0 on success
+int32_t CBooking::read_config
+(
+    const boost::property_tree::ptree &pt,
+    catalog_config &config
+)
 {
     int32_t rc;
 
@@ -70,10 +543,7 @@ int32_t CBooking::load_data(const boost::property_tree::ptree &pt)
 
     for (auto it = movies->second.begin(); it != movies->second.end(); ++it) {
         /*loop troug all the movies*/
-        auto new_movie = std::make_unique<movie>();
-        if (new_movie == nullptr) {
-            return -ENOMEM;
-        }
+        movie_config new_movie;
 
         auto movie_pt = it->second.find("movie");
         if (movie_pt == it->second.not_found()) {
@@ -85,390 +555,3211 @@ int32_t CBooking::load_data(const boost::property_tree::ptree &pt)
             return -EBADMSG;
         }
 
-        for (auto it2 = theatres->second.begin(); it2 != theatres->second.end(); ++it2) {
-            theatre_reservation new_theatre;
-            /*loop trough all the theatres within a movie*/
+        new_movie.movie_ = movie_pt->second.get_value<std::string>();
+
+        for (auto it2 = theatres->second.begin(); it2 != theatres->second.end(); ++it2) {
+            /*loop trough all the theatres within a movie*/
+            theatre_config new_theatre;
+
+            new_theatre.reservation_ = std::make_shared<theatre_reservation>(m_mutations);
+            if (new_theatre.reservation_ == nullptr) {
+                return -ENOMEM;
+            }
+
+            rc = load_theatre(it2->second, new_theatre.theatre_, *new_theatre.reservation_);
+            if (rc < 0) {
+                return rc;
+            }
+
+            new_movie.theatres_.push_back(std::move(new_theatre));
+        }
+
+        config.push_back(std::move(new_movie));
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/// @brief Parse JSON configuration document as it is read
+///     {"movies": [{"movie": "Matrix", "theatres": ["Tokyo", {"theatre": "Delhi", "seats": 30}, ...]}, ...]}
+///     Unknown members are skipped
+/// @param stream [in] configuration document
+/// @param config [out] movies and their theatres
+/// @return Negative on error, -EBADMSG if document is malformed, >=0 on success
+int32_t CBooking::parse_catalog
+(
+    std::istream &stream,
+    catalog_config &config
+)
+{
+    int32_t rc;
+    bool movies;
+    bool found;
+    CJsonReader reader(stream);
+    CJsonReader::token_t token;
+
+    rc = reader.next(token);
+    if (rc < EXIT_SUCCESS) {
+        return rc;
+    }
+    if (token != CJsonReader::token_t::begin_object) {
+        return -EBADMSG;
+    }
+
+    found = false;
+    for (;;) {
+        rc = reader.next(token);
+        if (rc < EXIT_SUCCESS) {
+            return rc;
+        }
+        if (token == CJsonReader::token_t::end_object) {
+            break;
+        }
+
+        movies = (reader.get_text() == "movies");
+        rc = reader.next(token);
+        if (rc < EXIT_SUCCESS) {
+            return rc;
+        }
+        if (movies != true) {
+            rc = reader.skip(token);
+            if (rc < EXIT_SUCCESS) {
+                return rc;
+            }
+            continue;
+        }
+        if (token != CJsonReader::token_t::begin_array) {
+            return -EBADMSG;
+        }
+
+        found = true;
+        for (;;) {
+            /*loop troug all the movies*/
+            movie_config new_movie;
+
+            rc = reader.next(token);
+            if (rc < EXIT_SUCCESS) {
+                return rc;
+            }
+            if (token == CJsonReader::token_t::end_array) {
+                break;
+            }
+            if (token != CJsonReader::token_t::begin_object) {
+                return -EBADMSG;
+            }
+
+            rc = parse_movie(reader, new_movie);
+            if (rc < EXIT_SUCCESS) {
+                return rc;
+            }
+
+            config.push_back(std::move(new_movie));
+        }
+    }
+
+    /*nothing may follow the document*/
+    rc = reader.next(token);
+    if (rc < EXIT_SUCCESS) {
+        return rc;
+    }
+    if (token != CJsonReader::token_t::end) {
+        return -EBADMSG;
+    }
+
+    return (found) ? EXIT_SUCCESS : -EBADMSG;
+}
+
+/// @brief Parse single movie, opening brace is read already
+/// @param reader [io] configuration document
+/// @param config [out] movie and its theatres
+/// @return Negative on error, >=0 on success
+int32_t CBooking::parse_movie
+(
+    CJsonReader &reader,
+    movie_config &config
+)
+{
+    int32_t rc;
+    bool named;
+    bool listed;
+    CJsonReader::token_t token;
+
+    named = false;
+    listed = false;
+    for (;;) {
+        rc = reader.next(token);
+        if (rc < EXIT_SUCCESS) {
+            return rc;
+        }
+        if (token == CJsonReader::token_t::end_object) {
+            break;
+        }
+
+        if (reader.get_text() == "movie") {
+            rc = reader.next(token);
+            if ((rc < EXIT_SUCCESS)||(token != CJsonReader::token_t::string)) {
+                return -EBADMSG;
+            }
+            config.movie_ = reader.get_text();
+            named = true;
+        }
+        else if (reader.get_text() == "theatres") {
+            rc = reader.next(token);
+            if ((rc < EXIT_SUCCESS)||(token != CJsonReader::token_t::begin_array)) {
+                return -EBADMSG;
+            }
+
+            for (;;) {
+                /*loop trough all the theatres within a movie*/
+                theatre_config new_theatre;
+
+                rc = reader.next(token);
+                if (rc < EXIT_SUCCESS) {
+                    return rc;
+                }
+                if (token == CJsonReader::token_t::end_array) {
+                    break;
+                }
+
+                rc = parse_theatre(reader, token, new_theatre);
+                if (rc < EXIT_SUCCESS) {
+                    return rc;
+                }
+
+                config.theatres_.push_back(std::move(new_theatre));
+            }
+            listed = true;
+        }
+        else {
+            rc = reader.next(token);
+            if (rc < EXIT_SUCCESS) {
+                return rc;
+            }
+            rc = reader.skip(token);
+            if (rc < EXIT_SUCCESS) {
+                return rc;
+            }
+        }
+    }
+
+    return ((named)&&(listed)) ? EXIT_SUCCESS : -EBADMSG;
+}
+
+/// @brief Parse single theatre, the same forms as load_theatre takes
+/// @param reader [io] configuration document
+/// @param token [in] first token of the theatre, already read
+/// @param config [out] theatre with empty seats
+/// @return Negative on error, >=0 on success
+int32_t CBooking::parse_theatre
+(
+    CJsonReader &reader,
+    CJsonReader::token_t token,
+    theatre_config &config
+)
+{
+    int32_t rc;
+    bool sized;
+    bool laid_out;
+    uint32_t seats;
+    uint32_t capacity;
+
+    config.reservation_ = std::make_shared<theatre_reservation>(m_mutations);
+    if (config.reservation_ == nullptr) {
+        return -ENOMEM;
+    }
+
+    if (token == CJsonReader::token_t::string) {
+        /*just a name, theatre has default capacity*/
+        config.theatre_ = reader.get_text();
+        if (config.theatre_.empty()) {
+            return -EBADMSG;
+        }
+        return prepare_reservation(*config.reservation_, m_default_seats_capacity);
+    }
+    if (token != CJsonReader::token_t::begin_object) {
+        return -EBADMSG;
+    }
+
+    sized = false;
+    laid_out = false;
+    seats = 0;
+    capacity = 0;
+    for (;;) {
+        rc = reader.next(token);
+        if (rc < EXIT_SUCCESS) {
+            return rc;
+        }
+        if (token == CJsonReader::token_t::end_object) {
+            break;
+        }
+
+        if (reader.get_text() == "theatre") {
+            rc = reader.next(token);
+            if ((rc < EXIT_SUCCESS)||(token != CJsonReader::token_t::string)) {
+                return -EBADMSG;
+            }
+            config.theatre_ = reader.get_text();
+        }
+        else if (reader.get_text() == "seats") {
+            rc = reader.next(token);
+            if ((rc < EXIT_SUCCESS)||((token != CJsonReader::token_t::number)&&(token != CJsonReader::token_t::string))||
+                (reader.get_uint32(seats) < EXIT_SUCCESS)) {
+                return -EBADMSG;
+            }
+            sized = true;
+        }
+        else if (reader.get_text() == "layout") {
+            rc = reader.next(token);
+            if ((rc < EXIT_SUCCESS)||(token != CJsonReader::token_t::begin_array)) {
+                return -EBADMSG;
+            }
+            rc = parse_layout(reader, *config.reservation_, capacity);
+            if (rc < EXIT_SUCCESS) {
+                return rc;
+            }
+            laid_out = true;
+        }
+        else {
+            rc = reader.next(token);
+            if (rc < EXIT_SUCCESS) {
+                return rc;
+            }
+            rc = reader.skip(token);
+            if (rc < EXIT_SUCCESS) {
+                return rc;
+            }
+        }
+    }
+
+    if (config.theatre_.empty()) {
+        /*theatre without name can't be booked*/
+        return -EBADMSG;
+    }
+
+    if (sized) {
+        if ((laid_out)&&(seats != capacity)) {
+            /*layout doesn't match the capacity*/
+            return -EBADMSG;
+        }
+        capacity = seats;
+    }
+    else if (laid_out != true) {
+        capacity = m_default_seats_capacity;
+    }
+
+    return prepare_reservation(*config.reservation_, capacity);
+}
+
+/// @brief Parse rows of the theatre, opening bracket is read already
+///     [{"section": "Stalls", "row": "A", "seats": 10}, ...]
+/// @param reader [io] configuration document
+/// @param reservations [out] theatre, rows are appended to its layout
+/// @param capacity [out] number of seats in all the rows
+/// @return Negative on error, >=0 on success
+int32_t CBooking::parse_layout
+(
+    CJsonReader &reader,
+    theatre_reservation &reservations,
+    uint32_t &capacity
+)
+{
+    int32_t rc;
+    bool sized;
+    bool named;
+    uint32_t seats;
+    CJsonReader::token_t token;
+
+    capacity = 0;
+    for (;;) {
+        /*rows are numbered one after another*/
+        seat_row new_row;
+
+        rc = reader.next(token);
+        if (rc < EXIT_SUCCESS) {
+            return rc;
+        }
+        if (token == CJsonReader::token_t::end_array) {
+            break;
+        }
+        if (token != CJsonReader::token_t::begin_object) {
+            return -EBADMSG;
+        }
+
+        sized = false;
+        named = false;
+        seats = 0;
+        for (;;) {
+            rc = reader.next(token);
+            if (rc < EXIT_SUCCESS) {
+                return rc;
+            }
+            if (token == CJsonReader::token_t::end_object) {
+                break;
+            }
+
+            if (reader.get_text() == "section") {
+                rc = reader.next(token);
+                if ((rc < EXIT_SUCCESS)||(token != CJsonReader::token_t::string)) {
+                    return -EBADMSG;
+                }
+                new_row.section_ = reader.get_text();
+            }
+            else if (reader.get_text() == "row") {
+                rc = reader.next(token);
+                if ((rc < EXIT_SUCCESS)||((token != CJsonReader::token_t::string)&&(token != CJsonReader::token_t::number))) {
+                    return -EBADMSG;
+                }
+                new_row.row_ = reader.get_text();
+                named = true;
+            }
+            else if (reader.get_text() == "seats") {
+                rc = reader.next(token);
+                if ((rc < EXIT_SUCCESS)||((token != CJsonReader::token_t::number)&&(token != CJsonReader::token_t::string))||
+                    (reader.get_uint32(seats) < EXIT_SUCCESS)) {
+                    return -EBADMSG;
+                }
+                sized = true;
+            }
+            else {
+                rc = reader.next(token);
+                if (rc < EXIT_SUCCESS) {
+                    return rc;
+                }
+                rc = reader.skip(token);
+                if (rc < EXIT_SUCCESS) {
+                    return rc;
+                }
+            }
+        }
+
+        if ((sized != true)||(seats == 0)||(seats > m_max_seats_capacity - capacity)) {
+            return -EBADMSG;
+        }
+
+        if (named != true) {
+            new_row.row_ = std::to_string(reservations.layout_.size() + 1);
+        }
+        new_row.first_seat_ = capacity;
+        new_row.seats_ = seats;
+        capacity += seats;
+
+        reservations.layout_.push_back(std::move(new_row));
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/// @brief Build catalog from parsed configuration, unchanged theatres are taken from the current one
+///     Movie listed several times gets theatres of all the listings
+/// @param shards [io] parsed configuration, theatres are moved to the catalog
+/// @param current [in] current catalog
+/// @param next [out] new catalog
+/// @return Negative on error, -EEXIST if theatre of the movie is listed twice, >=0 on success
+int32_t CBooking::build_catalog
+(
+    std::vector<catalog_config> &shards,
+    const catalog &current,
+    catalog &next
+)
+{
+    std::vector<std::vector<uint32_t>> theatre_shows;
+
+    /*ids of removed theatres are never given again, so stale handles find nothing*/
+    next.theatres_table_.assign(current.theatres_table_.size(), nullptr);
+    next.version_ = current.version_ + 1;
+
+    for (auto &shard : shards) {
+        for (auto &movie_item : shard) {
+            auto current_movie = current.movies_map_.find(movie_item.movie_);
+
+            /*maps and index refer to the same copy of every name*/
+            std::string_view movie_name = next.names_.intern(movie_item.movie_);
+            auto new_movie = next.movies_map_.find(movie_name);
+            if (new_movie == next.movies_map_.end()) {
+                auto movie_rc = next.movies_map_.insert(movie_name, std::make_unique<movie>());
+                new_movie = movie_rc.first;
+            }
+            movie &movie_entry = *new_movie->second;
+
+            for (auto &theatre_item : movie_item.theatres_) {
+                if (theatre_item.theatre_.empty()) {
+                    return -EBADMSG;
+                }
+
+                /*unchanged theatre keeps its seats and its id*/
+                std::shared_ptr<theatre_reservation> reservation = theatre_item.reservation_;
+                if (current_movie != current.movies_map_.end()) {
+                    auto current_theatre = current_movie->second->theatre_reservations_map_.find(theatre_item.theatre_);
+                    if ((current_theatre != current_movie->second->theatre_reservations_map_.end())&&
+                        (current_theatre->second->get_seats().free_seats_map_.capacity() == reservation->get_seats().free_seats_map_.capacity())&&
+                        (current_theatre->second->layout_ == reservation->layout_)) {
+                        reservation = current_theatre->second;
+                    }
+                }
+
+                std::string_view theatre_name = next.names_.intern(theatre_item.theatre_);
+                auto map_rc = movie_entry.theatre_reservations_map_.insert(theatre_name, reservation);
+                if (map_rc.second != true) {
+                    return -EEXIST;
+                }
+
+                if (reservation != theatre_item.reservation_) {
+                    next.theatres_table_[reservation->id_] = reservation.get();
+                }
+                else {
+                    reservation->id_ = static_cast<uint32_t>(next.theatres_table_.size());
+                    next.theatres_table_.push_back(reservation.get());
+                }
+
+                auto index_rc = next.theatres_index_.insert(theatre_name, std::span<const uint32_t>());
+                if (index_rc.second) {
+                    theatre_shows.emplace_back();
+                }
+                theatre_shows[index_rc.first - next.theatres_index_.begin()].push_back(reservation->id_);
+            }
+        }
+    }
+
+    /*handles of all the theatres are kept in one vector, index refers to its parts*/
+    next.theatre_shows_.reserve(next.theatres_table_.size());
+    auto index_it = next.theatres_index_.begin();
+    for (const auto &shows : theatre_shows) {
+        std::size_t first = next.theatre_shows_.size();
+
+        next.theatre_shows_.insert(next.theatre_shows_.end(), shows.begin(), shows.end());
+        (index_it++)->second = std::span<const uint32_t>(next.theatre_shows_.data() + first, shows.size());
+    }
+
+    index_shows(next);
+
+    return EXIT_SUCCESS;
+}
+
+/// @brief Build catalog over mapped image, unchanged theatres are taken from the current one
+///     Names and hash tables stay in the image, only theatres and their layouts are created
+/// @param image [in] mapped image, the catalog keeps it
+/// @param current [in] current catalog
+/// @param next [out] new catalog
+/// @return Negative on error, -EBADMSG if image is damaged, >=0 on success
+int32_t CBooking::map_catalog
+(
+    const std::shared_ptr<const CCatalogImage> &image,
+    const catalog &current,
+    catalog &next
+)
+{
+    int32_t rc;
+    bool same_handles;
+    CCatalogImage::movie image_movie;
+    CCatalogImage::theatre image_theatre;
+    std::span<const catalog_slot> slots;
+    std::vector<uint32_t> ids(image->get_shows(), m_no_theatre);
+
+    /*ids of removed theatres are never given again, so stale handles find nothing*/
+    next.image_ = image;
+    next.theatres_table_.assign(current.theatres_table_.size(), nullptr);
+    next.version_ = current.version_ + 1;
+
+    /*entries are appended in the order of the image, its hash tables refer to them*/
+    next.movies_map_.attach(image->get_movie_slots());
+    next.movies_map_.reserve(image->get_movies());
+    for (uint32_t i = 0; i < image->get_movies(); ++i) {
+        rc = image->get_movie(i, image_movie);
+        if (rc < EXIT_SUCCESS) {
+            return rc;
+        }
+        rc = image->get_show_slots(i, slots);
+        if (rc < EXIT_SUCCESS) {
+            return rc;
+        }
+
+        auto current_movie = current.movies_map_.find(image_movie.movie_);
+        auto new_movie = std::make_unique<movie>();
+        new_movie->theatre_reservations_map_.attach(slots);
+        new_movie->theatre_reservations_map_.reserve(image_movie.shows_.size());
+
+        for (const auto &image_show : image_movie.shows_) {
+            uint32_t capacity = 0;
+            std::vector<seat_row> layout;
+
+            if ((image_show.theatre_.empty())||(ids[image_show.handle_] != m_no_theatre)) {
+                return -EBADMSG;
+            }
+
+            layout.reserve(image_show.layout_.size());
+            for (const auto &image_row : image_show.layout_) {
+                /*rows follow one another, the same as parsed layout*/
+                if ((image_row.first_seat_ != capacity)||(image_row.seats_ == 0)||(image_row.seats_ > m_max_seats_capacity - capacity)) {
+                    return -EBADMSG;
+                }
+                layout.push_back(seat_row{std::string(image_row.section_), std::string(image_row.row_), image_row.first_seat_, image_row.seats_});
+                capacity += image_row.seats_;
+            }
+            if ((layout.empty() != true)&&(capacity != image_show.capacity_)) {
+                return -EBADMSG;
+            }
+
+            /*unchanged theatre keeps its seats and its id*/
+            std::shared_ptr<theatre_reservation> reservation;
+            if (current_movie != current.movies_map_.end()) {
+                auto current_theatre = current_movie->second->theatre_reservations_map_.find(image_show.theatre_);
+                if ((current_theatre != current_movie->second->theatre_reservations_map_.end())&&
+                    (current_theatre->second->get_seats().free_seats_map_.capacity() == image_show.capacity_)&&
+                    (current_theatre->second->layout_ == layout)) {
+                    reservation = current_theatre->second;
+                    next.theatres_table_[reservation->id_] = reservation.get();
+                }
+            }
+
+            if (reservation == nullptr) {
+                reservation = std::make_shared<theatre_reservation>(m_mutations);
+                if (reservation == nullptr) {
+                    return -ENOMEM;
+                }
+
+                rc = prepare_reservation(*reservation, image_show.capacity_);
+                if (rc < EXIT_SUCCESS) {
+                    return rc;
+                }
+
+                reservation->layout_ = std::move(layout);
+                reservation->id_ = static_cast<uint32_t>(next.theatres_table_.size());
+                next.theatres_table_.push_back(reservation.get());
+            }
+
+            ids[image_show.handle_] = reservation->id_;
+            new_movie->theatre_reservations_map_.append(image_show.theatre_, std::move(reservation));
+        }
+
+        next.movies_map_.append(image_movie.movie_, std::move(new_movie));
+    }
+
+    /*shows of every movie are checked, so every handle got its id*/
+    same_handles = true;
+    for (uint32_t handle = 0; handle < ids.size(); ++handle) {
+        if (ids[handle] == m_no_theatre) {
+            return -EBADMSG;
+        }
+        same_handles = ((same_handles)&&(ids[handle] == handle));
+    }
+
+    /*index uses handles of the image, unless reload gave the shows other ids*/
+    next.theatres_index_.attach(image->get_theatre_slots());
+    next.theatres_index_.reserve(image->get_theatres());
+    if (same_handles != true) {
+        next.theatre_shows_.reserve(ids.size());
+    }
+    for (uint32_t i = 0; i < image->get_theatres(); ++i) {
+        rc = image->get_theatre(i, image_theatre);
+        if (rc < EXIT_SUCCESS) {
+            return rc;
+        }
+
+        if (same_handles != true) {
+            std::size_t first = next.theatre_shows_.size();
+
+            for (uint32_t handle : image_theatre.shows_) {
+                next.theatre_shows_.push_back(ids[handle]);
+            }
+            image_theatre.shows_ = std::span<const uint32_t>(next.theatre_shows_.data() + first, image_theatre.shows_.size());
+        }
+
+        next.theatres_index_.append(image_theatre.theatre_, image_theatre.shows_);
+    }
+
+    index_shows(next);
+
+    return EXIT_SUCCESS;
+}
+
+/// @brief Index shows of built catalog by handles and count their free seats
+/// @param next [io] new catalog, its maps are complete
+void CBooking::index_shows(catalog &next)
+{
+    /*removed shows stay at 0 free seats, so availability never reports them*/
+    next.shows_.assign(next.theatres_table_.size(), show_ref());
+    next.availability_.resize(static_cast<uint32_t>(next.theatres_table_.size()));
+    for (const auto &[movie_name, movie_item] : next.movies_map_) {
+        uint32_t position = 0;
+
+        movie_item->availability_.resize(static_cast<uint32_t>(movie_item->theatre_reservations_map_.size()));
+        for (const auto &[theatre_name, reservation] : movie_item->theatre_reservations_map_) {
+            uint32_t free_seats = reservation->get_seats().free_seats_map_.marked();
+
+            next.shows_[reservation->id_] = show_ref{movie_name, theatre_name, movie_item.get(), position};
+            next.availability_.set(reservation->id_, free_seats);
+            movie_item->availability_.set(position, free_seats);
+            position++;
+        }
+    }
+}
+
+/// @brief Keep seats in memory mapped file, must be called after load_data and before anything is booked
+///     Seats of cleanly closed file are restored at once, otherwise all the seats are free.
+///     Restored seats are owned by bookers of the previous run, they have no session anymore
+/// @param path [in] seat store file
+/// @return Negative on error, -EBUSY if catalog was reloaded, 0 if seats were rebuilt, 1 if seats were restored
+int32_t CBooking::open_seat_store(const std::string &path)
+{
+    int32_t rc;
+    uint32_t max_owner;
+    uint32_t capacity;
+    std::vector<uint32_t> capacities;
+
+    std::lock_guard<std::mutex> lck(m_reload_mutex);
+    const catalog &current = *m_catalog_owner;
+
+    if (m_seat_store.is_open()) {
+        return -EALREADY;
+    }
+
+    if (current.version_ > 1) {
+        /*sections are given by ids of the first catalog*/
+        return -EBUSY;
+    }
+
+    for (const theatre_reservation *p_reservation : current.theatres_table_) {
+        capacities.push_back(p_reservation->get_seats().free_seats_map_.capacity());
+    }
+
+    rc = m_seat_store.open(path, catalog_hash(current), capacities);
+    if (rc < EXIT_SUCCESS) {
+        return rc;
+    }
+
+    /*seats are used in place, nothing is parsed or copied*/
+    max_owner = 0;
+    for (theatre_reservation *p_reservation : current.theatres_table_) {
+        const CSeatStore::section &section = m_seat_store.get_section(p_reservation->id_);
+        auto own_seats = std::make_unique<seat_state>();
+
+        capacity = p_reservation->get_seats().free_seats_map_.capacity();
+        own_seats->free_seats_map_.attach(section.words_, capacity);
+        own_seats->owners_ = section.owners_;
+        /*run index is built by the first best seats request of the theatre*/
+
+        for (uint32_t seat = 0; (rc > 0)&&(seat < capacity); ++seat) {
+            max_owner = std::max(max_owner, own_seats->owners_[seat].load(std::memory_order_relaxed));
+        }
+
+        /*every theatre has its section in the file, so nobody uses the sentinel anymore*/
+        p_reservation->seats_.store(own_seats.get(), std::memory_order_release);
+        p_reservation->own_seats_ = std::move(own_seats);
+        update_availability(*p_reservation);
+    }
+
+    /*handles of the previous run still mark restored seats*/
+    m_bookers.retire(max_owner);
+    m_journal_offset = m_seat_store.get_journal_offset();
+
+    return rc;
+}
+
+/// @brief Release held seats, close the journal and mark seat store clean
+///     Seats are copied back to memory, nothing must be booked meanwhile
+/// @return Negative on error, >=0 on success
+int32_t CBooking::close_seat_store(void)
+{
+    bool journaled;
+    std::vector<seat_hold> holds;
+
+    std::lock_guard<std::mutex> lck(m_reload_mutex);
+
+    if (m_seat_store.is_open() != true) {
+        return -EBADF;
+    }
+
+    /*sessions are gone, so holds can't be confirmed anymore*/
+    {
+        std::lock_guard<std::mutex> lck(m_holds_mutex);
+
+        for (auto &hold : m_holds) {
+            holds.push_back(std::move(hold.second));
+        }
+        m_holds.clear();
+        m_booker_holds.clear();
+    }
+    release_holds(holds);
+
+    /*everything journaled so far is contained in the seats*/
+    journaled = m_journal.is_open();
+    m_journal.close();
+    if (journaled) {
+        m_journal_offset = m_journal.get_size();
+    }
+
+    /*ids of removed theatres are holes in the table*/
+    for (theatre_reservation *p_reservation : m_catalog_owner->theatres_table_) {
+        if (p_reservation != nullptr)
+            detach_seats(*p_reservation);
+    }
+
+    return m_seat_store.close(m_journal_offset);
+}
+
+/// @brief Copy seats of the theatre from seat store back to memory
+///     Nobody changes the seats meanwhile
+/// @param reservation [in] theatre
+void CBooking::detach_seats(theatre_reservation &reservation)
+{
+    uint32_t capacity;
+    seat_state &seats = materialize(reservation);
+
+    capacity = seats.free_seats_map_.capacity();
+    seats.free_seats_map_.detach();
+
+    seats.owners_storage_ = std::make_unique<seat_state::owner_t[]>(capacity);
+    for (uint32_t seat = 0; seat < capacity; ++seat) {
+        seats.owners_storage_[seat].store(seats.owners_[seat].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    seats.owners_ = seats.owners_storage_.get();
+}
+
+/// @brief Move seats of all the theatres to new seat store, laid out by ids of the catalog.
+///     Caller holds reload mutex, theatres are moved one by one under their locks
+/// @param next [in] catalog, which is going to be published
+/// @param old_store [out] store, which was used so far. It is unmapped once nobody uses its seats
+/// @param retired [out] seats, which were used so far
+/// @return Negative on error, >=0 on success
+int32_t CBooking::move_seat_store
+(
+    const catalog &next,
+    CSeatStore &old_store,
+    std::vector<std::unique_ptr<seat_state>> &retired
+)
+{
+    int32_t rc;
+    uint32_t capacity;
+    std::string path;
+    std::string new_path;
+    std::error_code ec;
+    std::vector<uint32_t> capacities;
+    std::vector<CSeatMap::word_t> free_words;
+
+    /*removed theatres keep their ids, they have no seats in the file*/
+    for (const theatre_reservation *p_reservation : next.theatres_table_) {
+        capacities.push_back((p_reservation != nullptr) ? p_reservation->get_seats().free_seats_map_.capacity() : 0);
+    }
+
+    /*new file is complete before it replaces the old one, it is dirty until close anyway*/
+    path = m_seat_store.get_path();
+    new_path = path + ".new";
+    std::filesystem::remove(new_path, ec);
+    rc = old_store.open(new_path, catalog_hash(next), capacities);
+    if (rc < EXIT_SUCCESS) {
+        return rc;
+    }
+    rc = old_store.rename(path);
+    if (rc < EXIT_SUCCESS) {
+        /*nothing was moved yet, the new file is unmapped with the store*/
+        std::filesystem::remove(new_path, ec);
+        return rc;
+    }
+
+    for (theatre_reservation *p_reservation : next.theatres_table_) {
+        if (p_reservation == nullptr)
+            continue;
+
+        const CSeatStore::section &section = old_store.get_section(p_reservation->id_);
+        auto own_seats = std::make_unique<seat_state>();
+
+        /*nobody books the theatre, while it is moved. New theatre isn't seen by anybody yet*/
+        theatre_access access(*p_reservation, false);
+        CSeqGate::writer gate(p_reservation->seq_);
+
+        const seat_state &seats = p_reservation->get_seats();
+        capacity = seats.free_seats_map_.capacity();
+        seats.free_seats_map_.snapshot(free_words);
+        for (std::size_t i = 0; i < free_words.size(); ++i) {
+            section.words_[i].store(free_words[i], std::memory_order_relaxed);
+        }
+        for (uint32_t seat = 0; seat < capacity; ++seat) {
+            section.owners_[seat].store(seats.owners_[seat].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+
+        own_seats->free_seats_map_.attach(section.words_, capacity);
+        own_seats->owners_ = section.owners_;
+        /*run index is built by the first best seats request of the theatre*/
+
+        /*readers, which still use the old seats, are waited for before they go away*/
+        p_reservation->seats_.store(own_seats.get(), std::memory_order_release);
+        if (p_reservation->own_seats_ != nullptr)
+            retired.push_back(std::move(p_reservation->own_seats_));
+        p_reservation->own_seats_ = std::move(own_seats);
+    }
+
+    /*the old file is replaced already, it stays mapped until old seats go away*/
+    m_seat_store.swap(old_store);
+
+    return EXIT_SUCCESS;
+}
+
+/// @brief Get hash of the catalog, seat store fits only the same catalog
+///     Caller holds reload mutex
+/// @param hashed [in] the catalog
+/// @return hash of names and capacities of all the theatres
+uint64_t CBooking::catalog_hash(const catalog &hashed) const
+{
+    uint64_t hash;
+    std::vector<std::string> keys(hashed.theatres_table_.size());
+
+    for (auto it = hashed.movies_map_.begin(); it != hashed.movies_map_.end(); ++it) {
+        for (auto it2 = it->second->theatre_reservations_map_.begin(); it2 != it->second->theatre_reservations_map_.end(); ++it2) {
+            keys[it2->second->id_] = std::string(it->first) + '/' + std::string(it2->first) + ':' + std::to_string(it2->second->get_seats().free_seats_map_.capacity()) + ';';
+        }
+    }
+
+    /*FNV-1a, theatres are hashed in the order of their ids*/
+    hash = 14695981039346656037ull;
+    for (const std::string &key : keys) {
+        for (char ch : key) {
+            hash = (hash ^ static_cast<uint8_t>(ch)) * 1099511628211ull;
+        }
+    }
+
+    return hash;
+}
+
+/// @brief Write point-in-time image of all the seats, bookings keep on running meanwhile
+///     Every theatre is copied without its lock, copy is taken again if batch booking ran meanwhile
+/// @param path [in] snapshot file, replaced atomically
+/// @return Negative on error, -EBUSY if no consistent copy was taken, size of the snapshot on success
+int32_t CBooking::save_snapshot(const std::string &path) const
+{
+    bool consistent;
+    uint64_t ticket;
+    CSnapshot snapshot;
+    std::vector<const theatre_reservation *> reservations;
+
+    {
+        CEpoch::reader reader(m_epoch);
+        const catalog &current = get_catalog();
+
+        for (auto it = current.movies_map_.begin(); it != current.movies_map_.end(); ++it) {
+            for (auto it2 = it->second->theatre_reservations_map_.begin(); it2 != it->second->theatre_reservations_map_.end(); ++it2) {
+                CSnapshot::theatre item;
+
+                item.movie_ = it->first;
+                item.theatre_ = it2->first;
+                item.capacity_ = it2->second->get_seats().free_seats_map_.capacity();
+                snapshot.theatres_.push_back(std::move(item));
+                reservations.push_back(it2->second.get());
+            }
+        }
+
+        for (uint32_t attempt = 0; ; ++attempt) {
+            /*single theatre changes are atomic per theatre, only batches span more of them*/
+            ticket = m_batch_seq.read_begin();
+
+            consistent = true;
+            for (std::size_t i = 0; i < reservations.size(); ++i) {
+                CSnapshot::theatre &item = snapshot.theatres_[i];
+
+                item.version_ = reservations[i]->seq_.version();
+                if (read_theatre(*reservations[i], item.free_words_, &item.owners_) != true) {
+                    consistent = false;
+                    break;
+                }
+            }
+
+            if ((consistent)&&(m_batch_seq.read_valid(ticket))) {
+                break;
+            }
+            if (attempt >= m_read_retries) {
+                return -EBUSY;
+            }
+
+            std::this_thread::yield();
+        }
+    }
+
+    /*copy is private, slow disk doesn't hold anybody*/
+    return snapshot.save(path);
+}
+
+/// @brief Restore seats from snapshot, must be called after load_data and before anything is booked
+///     Theatres are matched by names, theatres with other capacity or not in the catalog are skipped.
+///     Restored seats are owned by bookers of the previous run, they have no session anymore.
+///     Journal is not replayed on top of the snapshot
+/// @param path [in] snapshot file
+/// @return Negative on error, -ESTALE if no theatre of the snapshot fits the catalog, number of restored theatres on success
+int32_t CBooking::load_snapshot(const std::string &path)
+{
+    int32_t rc;
+    int32_t restored;
+    uint32_t max_owner;
+    CSnapshot snapshot;
+    theatre_reservation *p_reservation;
+
+    rc = snapshot.load(path);
+    if (rc < EXIT_SUCCESS) {
+        return rc;
+    }
+
+    std::lock_guard<std::mutex> lck(m_reload_mutex);
+
+    restored = 0;
+    max_owner = 0;
+    for (const CSnapshot::theatre &item : snapshot.theatres_) {
+        p_reservation = find_theatre(item.movie_, item.theatre_);
+        if ((p_reservation == nullptr)||(p_reservation->get_seats().free_seats_map_.capacity() != item.capacity_)) {
+            /*theatre was removed or rebuilt meanwhile*/
+            continue;
+        }
+
+        if ((item.owners_.empty())&&(p_reservation->get_seats().shared_)) {
+            /*nothing was booked there, theatre keeps sharing free seats*/
+            restored++;
+            continue;
+        }
+
+        seat_state &seats = materialize(*p_reservation);
+        CSeqGate::writer gate(p_reservation->seq_);
+
+        seats.free_seats_map_.assign(item.free_words_);
+        for (uint32_t seat = 0; seat < item.capacity_; ++seat) {
+            seats.owners_[seat].store(0, std::memory_order_relaxed);
+        }
+        for (const auto &[seat, owner] : item.owners_) {
+            seats.owners_[seat].store(owner, std::memory_order_relaxed);
+            max_owner = std::max(max_owner, owner);
+        }
+        seats.runs_.build(seats.free_seats_map_);
+        update_availability(*p_reservation);
+        restored++;
+    }
+
+    if ((restored == 0)&&(snapshot.theatres_.empty() != true)) {
+        return -ESTALE;
+    }
+
+    /*handles of the previous run still mark restored seats*/
+    m_bookers.retire(max_owner);
+
+    return restored;
+}
+
+/// @brief Replay journal on top of loaded configuration and journal all the changes since then
+///     If seats were restored from seat store, only the records behind them are replayed
+///     Bookers of the journal have no session anymore, they leave as closed sessions
+/// @param path [in] journal file
+/// @param durability [in] when the booking is on disk
+/// @return Negative on error, -EBUSY if catalog was reloaded, number of replayed records on success
+int32_t CBooking::open_journal(const std::string &path, CJournal::durability_t durability)
+{
+    int32_t rc;
+    int32_t records;
+    int64_t now_ms;
+    journal_replay replay;
+    std::set<uint32_t> owned_seats;
+    std::map<int64_t, std::set<uint32_t>> held_seats;
+
+    std::unique_lock<std::mutex> lck(m_reload_mutex);
+
+    if (m_journal.is_open()) {
+        return -EALREADY;
+    }
+
+    if (m_catalog_owner->version_ > 1) {
+        /*records address theatres by ids of the first catalog*/
+        return -EBUSY;
+    }
+
+    /*journal is not open yet, so replayed changes are not journaled again*/
+    records = CJournal::replay(path, [this, &replay](const std::string &record) {return replay_record(record, replay);}, m_journal_offset);
+    if (records < EXIT_SUCCESS) {
+        return records;
+    }
+
+    rc = m_journal.open(path, durability);
+    if (rc < EXIT_SUCCESS) {
+        return rc;
+    }
+
+    /*records of this run address theatres by our ids, the next run may load other catalog*/
+    journal_catalog('T', *m_catalog_owner);
+
+    /*holds continue with the rest of their ttl, the ones over ttl expire with the next tick*/
+    now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    for (auto &booker : replay.bookers_) {
+        for (auto it = replay.holds_.lower_bound({booker.second->get_booker_id(), 0}); it != replay.holds_.end(); ++it) {
+            if (it->first.first != booker.second->get_booker_id())
+                break;
+
+            /*seats of single hold request share the deadline*/
+            booker.second->get_owned_seats(it->first.second, owned_seats);
+            held_seats.clear();
+            for (auto &seat : it->second) {
+                if (owned_seats.count(seat.first) != 0)
+                    held_seats[seat.second].insert(seat.first);
+            }
+
+            for (auto &hold : held_seats) {
+                add_hold(booker.second, it->first.second, std::move(hold.second),
+                    std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max<int64_t>(hold.first - now_ms, 0)));
+            }
+        }
+    }
+
+    /*sessions are gone, seats follow release policy. Released seats are journaled already*/
+    lck.unlock();
+    for (auto &booker : replay.bookers_) {
+        leave_booker(booker.second);
+    }
+
+    return records;
+}
+
+/// @brief Apply single journal record
+/// @param record [in] journal record
+/// @param replay [io] state of the replay
+/// @return Negative on error, >=0 on success
+int32_t CBooking::replay_record(const std::string &record, journal_replay &replay)
+{
+    int32_t rc;
+    char op;
+    uint32_t theatre_id;
+    int64_t deadline;
+    std::string seats_text;
+    std::string uid;
+    std::set<uint32_t> seats;
+    std::vector<uint32_t> invalid_seats;
+    CBooker::booker_ptr booker;
+
+    if ((record.empty() != true)&&((record.front() == 'T')||(record.front() == 'R'))) {
+        return replay_catalog(record, replay);
+    }
+
+    std::istringstream iss(record);
+    deadline = 0;
+    if (!(iss >> op >> theatre_id >> seats_text)) {
+        return -EBADMSG;
+    }
+    if ((op == 'H')&&(!(iss >> deadline))) {
+        return -EBADMSG;
+    }
+    std::getline(iss >> std::ws, uid);
+    if (uid.empty()) {
+        return -EBADMSG;
+    }
+
+    /*journal without table of theatres belongs to the same catalog, ids are given by catalog order*/
+    if (replay.mapped_) {
+        if (theatre_id >= replay.journaled_) {
+            return -ERANGE;
+        }
+
+        auto mapped = replay.theatres_.find(theatre_id);
+        if (mapped == replay.theatres_.end()) {
+            /*theatre was removed by reload of the journaled run, or we don't have it*/
+            return EXIT_SUCCESS;
+        }
+        theatre_id = mapped->second;
+    }
+    if (find_theatre(theatre_id) == nullptr) {
+        return -ERANGE;
+    }
+    theatre_reservation &reservation = *find_theatre(theatre_id);
+
+    seats = get_seats(seats_text, reservation.get_seats().free_seats_map_.capacity());
+    if (seats.empty()) {
+        return -EBADMSG;
+    }
+
+    auto it = replay.bookers_.find(uid);
+    if (it == replay.bookers_.end()) {
+        booker = std::make_shared<CBooker>();
+        booker->set_uid(uid);
+        rc = join_booker(booker);
+        if (rc < EXIT_SUCCESS) {
+            return rc;
+        }
+        it = replay.bookers_.emplace(uid, booker).first;
+    }
+    booker = it->second;
+
+    auto &held = replay.holds_[{booker->get_booker_id(), theatre_id}];
+    switch (op) {
+    case 'B':
+        rc = book_seats(booker, theatre_access(reservation, false), reservation, seats, invalid_seats, false);
+        if ((rc >= EXIT_SUCCESS)&&(invalid_seats.empty() != true)) {
+            /*seat is owned by somebody else, journal doesn't fit the catalog*/
+            rc = -EBADMSG;
+        }
+        break;
+    case 'U':
+        rc = unbook_seats(booker, reservation, seats, invalid_seats);
+        for (uint32_t seat : seats) {
+            held.erase(seat);
+        }
+        break;
+    case 'H':
+        rc = EXIT_SUCCESS;
+        for (uint32_t seat : seats) {
+            held[seat] = deadline;
+        }
+        break;
+    case 'C':
+        rc = EXIT_SUCCESS;
+        for (uint32_t seat : seats) {
+            held.erase(seat);
+        }
+        break;
+    default:
+        rc = -EBADMSG;
+        break;
+    }
+
+    return rc;
+}
+
+/// @brief Apply table of theatres of the journaled catalog. Theatres are matched by names and capacity,
+///     seats of theatres, which the journaled catalog doesn't have anymore, are freed
+/// @param record [in] journal record
+/// @param replay [io] state of the replay
+/// @return Negative on error, number of matched theatres on success
+int32_t CBooking::replay_catalog(const std::string &record, journal_replay &replay)
+{
+    char op;
+    char separator[4];
+    int32_t show;
+    uint32_t journaled;
+    uint32_t theatre_id;
+    uint32_t capacity;
+    std::size_t movie_size;
+    std::size_t theatre_size;
+    std::string names;
+    std::set<uint32_t> kept;
+    std::unordered_map<uint32_t, uint32_t> theatres;
+    std::unordered_map<uint32_t, uint32_t> previous;
+
+    std::istringstream iss(record);
+    if ((!(iss >> op >> journaled))||((op != 'T')&&(op != 'R'))) {
+        return -EBADMSG;
+    }
+
+    while (iss >> theatre_id) {
+        if (!(iss >> separator[0] >> capacity >> separator[1] >> movie_size >> separator[2] >> theatre_size >> separator[3])) {
+            return -EBADMSG;
+        }
+        if ((std::count(std::begin(separator), std::end(separator), ':') != 4)||
+            (theatre_id >= journaled)||(movie_size > record.size())||(theatre_size > record.size() - movie_size)) {
+            return -EBADMSG;
+        }
+
+        /*names are stored with their sizes, so they can contain anything but new line*/
+        names.resize(movie_size + theatre_size);
+        if (!iss.read(names.data(), static_cast<std::streamsize>(names.size()))) {
+            return -EBADMSG;
+        }
+
+        show = find_show(std::string_view(names).substr(0, movie_size), std::string_view(names).substr(movie_size));
+        if ((show >= EXIT_SUCCESS)&&(find_theatre(static_cast<uint32_t>(show))->get_seats().free_seats_map_.capacity() == capacity)) {
+            theatres[theatre_id] = static_cast<uint32_t>(show);
+        }
+    }
+    if (iss.eof() != true) {
+        return -EBADMSG;
+    }
+
+    previous = replay.theatres_;
+    if (replay.mapped_ != true) {
+        for (uint32_t id = 0; id < get_catalog().theatres_table_.size(); ++id) {
+            if (find_theatre(id) != nullptr)
+                previous[id] = id;
+        }
+    }
+
+    for (const auto &[id, our_id] : theatres) {
+        kept.insert(our_id);
+    }
+
+    for (const auto &[id, our_id] : previous) {
+        /*reload keeps ids of the run, theatre which lost its id was removed with its seats.
+          Next run gives ids again, it keeps seats of the theatres it has*/
+        if ((op == 'R') ? (theatres.count(id) == 0) : (kept.count(our_id) == 0))
+            replay_forget(*find_theatre(our_id), replay);
+    }
+
+    replay.mapped_ = true;
+    replay.journaled_ = journaled;
+    replay.theatres_ = std::move(theatres);
+
+    return static_cast<int32_t>(replay.theatres_.size());
+}
+
+/// @brief Free all the seats and holds of the theatre, which was removed from the journaled catalog
+/// @param reservation [in] our theatre
+/// @param replay [io] state of the replay
+void CBooking::replay_forget(theatre_reservation &reservation, journal_replay &replay)
+{
+    uint32_t owner;
+    std::set<uint32_t> taken_seats;
+    std::map<uint32_t, std::vector<uint32_t>> owned_seats;
+    CSeatMap::mask_t mask;
+
+    seat_state &seats = materialize(reservation);
+    for (uint32_t seat = 0; seat < seats.free_seats_map_.capacity(); ++seat) {
+        owner = seats.owners_[seat].load(std::memory_order_relaxed);
+        if (owner != 0) {
+            owned_seats[owner].push_back(seat);
+            taken_seats.insert(seat);
+        }
+    }
+
+    /*seats of bookers of previous runs are freed too, they were restored from seat store*/
+    if ((taken_seats.empty() != true)&&(CSeatMap::make_mask(taken_seats, seats.free_seats_map_.capacity(), mask) >= EXIT_SUCCESS)) {
+        CSeqGate::writer gate(reservation.seq_);
+
+        for (uint32_t seat : taken_seats) {
+            seats.owners_[seat].store(0, std::memory_order_release);
+        }
+        seats.free_seats_map_.release(mask);
+    }
+
+    for (auto &booker : replay.bookers_) {
+        auto it = owned_seats.find(booker.second->get_booker_id());
+        if (it != owned_seats.end())
+            booker.second->remove_seats(reservation.id_, it->second);
+    }
+
+    for (auto it = replay.holds_.begin(); it != replay.holds_.end();) {
+        if (it->first.second == reservation.id_)
+            it = replay.holds_.erase(it);
+        else
+            ++it;
+    }
+
+    update_availability(reservation);
+}
+
+/// @brief Append table of theatres of the catalog to the journal, records behind it use its ids
+///     "<op> <theatre ids> <id>:<capacity>:<movie size>:<theatre size>:<movie><theatre> ..."
+/// @param op [in] T - catalog the run starts with, R - catalog of reload, it keeps ids of the run
+/// @param journaled [in] the catalog
+void CBooking::journal_catalog(char op, const catalog &journaled)
+{
+    std::string record;
+
+    record += op;
+    record += ' ';
+    record += std::to_string(journaled.theatres_table_.size());
+    for (const auto &[movie_name, movie_item] : journaled.movies_map_) {
+        for (const auto &[theatre_name, reservation] : movie_item->theatre_reservations_map_) {
+            record += ' ';
+            record += std::to_string(reservation->id_);
+            record += ':';
+            record += std::to_string(reservation->get_seats().free_seats_map_.capacity());
+            record += ':';
+            record += std::to_string(movie_name.size());
+            record += ':';
+            record += std::to_string(theatre_name.size());
+            record += ':';
+            record += movie_name;
+            record += theatre_name;
+        }
+    }
+
+    m_journal.append(record);
+}
+
+/// @brief Append change of seats to the journal
+///     "<op> <theatre id> <seats> [<deadline>] <booker uid>"
+/// @param op [in] B - booked, U - released, H - held, C - confirmed
+/// @param booker [in] owner of the seats
+/// @param theatre_id [in] theatre id
+/// @param seats [in] list of seats
+/// @param deadline [in] end of hold, milliseconds of system clock. Used by H only
+void CBooking::journal_seats
+(
+    char op,
+    const CBooker &booker,
+    uint32_t theatre_id,
+    const std::vector<uint32_t> &seats,
+    int64_t deadline
+)
+{
+    std::string record;
+
+    record += op;
+    record += ' ';
+    record += std::to_string(theatre_id);
+    record += ' ';
+    for (std::size_t i = 0; i < seats.size(); ++i) {
+        if (i != 0)
+            record += ',';
+        record += std::to_string(seats[i]);
+    }
+    if (op == 'H') {
+        record += ' ';
+        record += std::to_string(deadline);
+    }
+    record += ' ';
+    /*booker without uid is still told apart from the others*/
+    record += booker.get_booker_uid().empty() ? "#" + std::to_string(booker.get_booker_id()) : booker.get_booker_uid();
+
+    m_journal.append(record);
+}
+
+/// @brief Book the list of seats
+/// @param booker [in] booker uid
+/// @param movie [in] movie, which gets booked
+/// @param theatre [in] theatre where movie is played
+/// @param seats [in] array of booking seats
+/// @param unavalable_seats [out] list of seats, which are already taken.
+///                     But were in our request
+/// @param best_effort [in] true, to skip already booked seats
+/// @return Negative on error, >=0 on success
+int32_t CBooking::book_seats 
+(
+    CBooker::booker_ptr booker, 
+    std::string_view movie,
+    std::string_view theatre,
+    const std::set<uint32_t> &seats,
+    std::vector<uint32_t> &unavalable_seats,
+    bool best_effort
+)
+{
+    int32_t show;
+
+    show = find_show(movie, theatre);
+    if (show < EXIT_SUCCESS) {
+        return show;
+    }
+
+    return book_seats(booker, static_cast<uint32_t>(show), seats, unavalable_seats, best_effort);
+}
+
+/// @brief Book the list of seats of the show
+/// @param booker [in] booker uid
+/// @param show [in] show handle
+/// @param seats [in] array of booking seats
+/// @param unavalable_seats [out] list of seats, which are already taken.
+///                     But were in our request
+/// @param best_effort [in] true, to skip already booked seats
+/// @return Negative on error, >=0 on success
+int32_t CBooking::book_seats 
+(
+    CBooker::booker_ptr booker, 
+    uint32_t show,
+    const std::set<uint32_t> &seats,
+    std::vector<uint32_t> &unavalable_seats,
+    bool best_effort
+)
+{
+    int32_t rc;
+    theatre_reservation *p_reservation;
+
+    assert(booker != nullptr);
+
+    /*declared before the reader and the lock, so flush is awaited without them*/
+    CJournal::commit commit(m_journal);
+
+    /*theatre is not freed by reload, as long as we use it*/
+    CEpoch::reader reader(m_epoch);
+
+    p_reservation = find_theatre(show);
+    if (p_reservation == nullptr) {
+        return -EEXIST;
+    }
+
+    /*only bookings of the same theatre wait for each other.
+      Requests within few words in lock free engine are committed with CAS*/
+    theatre_access access(*p_reservation, (m_engine == engine_t::lock_free)&&(CSeatMap::mask_words(seats) <= m_lock_free_max_words));
+
+    rc = book_seats(booker, access, *p_reservation, seats, unavalable_seats, best_effort);
+    access.release();
+    reader.leave();
+
+    /*booking is reported, once it is durable*/
+    return commit.wait(rc);
+}
+
+/// @brief Book seats of several shows, all or nothing
+///     Theatres are locked in ascending id order and only for the commit.
+///     Seats are journaled once all the theatres are booked, failed batch leaves no record
+/// @param booker [in] booker uid
+/// @param requests [in] seats per show, show can be listed more times
+/// @param unavalable_seats [out] per request, list of seats which are already taken
+/// @return Negative on error, 0 if nothing was booked, number of distinct requested seats on success
+int32_t CBooking::book_batch
+(
+    CBooker::booker_ptr booker,
+    const std::vector<show_request> &requests,
+    std::vector<std::vector<uint32_t>> &unavalable_seats
+)
+{
+    struct batch_theatre
+    { /*!< All the seats of single theatre within batch */
+        theatre_reservation *reservation_ = nullptr; /*!< the theatre */
+        std::set<uint32_t> seats_; /*!< requested seats */
+        std::vector<uint32_t> booked_seats_; /*!< seats booked by this batch, for rollback */
+        std::vector<uint32_t> unavalable_seats_; /*!< seats taken by somebody else */
+    };
+
+    int32_t rc;
+    bool booked;
+    uint32_t requested;
+    theatre_reservation *p_reservation;
+    std::map<uint32_t, batch_theatre> theatres;
+    CJournal::commit commit(m_journal); /*before the reader and the locks, so flush is awaited without them*/
+    std::deque<theatre_access> accesses;
+    std::vector<uint32_t> invalid_seats;
+
+    assert(booker != nullptr);
+
+    unavalable_seats.assign(requests.size(), std::vector<uint32_t>());
+
+    if (booker->get_booker_id() == 0) {
+        /*booker has not joined*/
+        return -EINVAL;
+    }
+
+    /*theatres are not freed by reload, as long as we use them*/
+    CEpoch::reader reader(m_epoch);
+
+    /*resolve all the shows first, so nothing is locked for invalid batch*/
+    requested = 0;
+    for (const show_request &request : requests) {
+        p_reservation = find_theatre(request.movie_, request.theatre_);
+        if (p_reservation == nullptr) {
+            return -EEXIST;
+        }
+
+        if ((request.seats_.empty() != true)&&(*request.seats_.rbegin() >= p_reservation->get_seats().free_seats_map_.capacity())) {
+            return -ERANGE;
+        }
+
+        batch_theatre &entry = theatres[p_reservation->id_];
+        entry.reservation_ = p_reservation;
+        entry.seats_.insert(request.seats_.begin(), request.seats_.end());
+    }
+
+    /*seat listed for the same show more times is requested once*/
+    for (const auto &entry : theatres) {
+        requested += static_cast<uint32_t>(entry.second.seats_.size());
+    }
+
+    /*map is ordered by theatre id, which is the global lock order.
+      Locks close claim gates too, so lock free bookings wait for the commit*/
+    for (auto &entry : theatres) {
+        accesses.emplace_back(*entry.second.reservation_, false);
+    }
+
+    {
+        CSeqGate::writer batch_gate(m_batch_seq);
+
+        rc = EXIT_SUCCESS;
+        auto access = accesses.begin();
+        for (auto &entry : theatres) {
+            std::set<uint32_t> owned_seats;
+
+            /*seats, which are already ours, must survive rollback*/
+            booker->get_owned_seats(entry.first, owned_seats);
+
+            rc = book_seats(booker, *access++, *entry.second.reservation_, entry.second.seats_, entry.second.unavalable_seats_, false, false);
+            if ((rc < EXIT_SUCCESS)||(entry.second.unavalable_seats_.empty() != true)) {
+                break;
+            }
+
+            std::set_difference(
+                entry.second.seats_.begin(), entry.second.seats_.end(),
+                owned_seats.begin(), owned_seats.end(),
+                std::back_inserter(entry.second.booked_seats_));
+        }
+
+        booked = ((rc >= EXIT_SUCCESS)&&(std::all_of(theatres.begin(), theatres.end(), [](const auto &entry) {return entry.second.unavalable_seats_.empty();})));
+        if (booked != true) {
+            /*roll back theatres, which were already booked. Nothing was journaled yet*/
+            for (auto &entry : theatres) {
+                if (entry.second.booked_seats_.empty())
+                    continue;
+
+                std::set<uint32_t> booked_seats(entry.second.booked_seats_.begin(), entry.second.booked_seats_.end());
+                unbook_seats(booker, *entry.second.reservation_, booked_seats, invalid_seats, false);
+            }
+        }
+        else if (m_journal.is_open()) {
+            /*theatres are still locked, so nobody journals these seats before us*/
+            for (const auto &entry : theatres) {
+                if (entry.second.booked_seats_.empty() != true)
+                    journal_seats('B', *booker, entry.first, entry.second.booked_seats_);
+            }
+        }
+    }
+
+    accesses.clear();
+    if (booked) {
+        rc = static_cast<int32_t>(requested);
+    }
+    else if (rc >= EXIT_SUCCESS) {
+        /*report unavailable seats per request*/
+        for (std::size_t i = 0; i < requests.size(); ++i) {
+            const batch_theatre &entry = theatres.at(find_theatre(requests[i].movie_, requests[i].theatre_)->id_);
+            for (uint32_t seat : entry.unavalable_seats_) {
+                if (requests[i].seats_.count(seat) != 0)
+                    unavalable_seats[i].push_back(seat);
+            }
+        }
+        rc = EXIT_SUCCESS;
+    }
+
+    /*flush is awaited without the locks and without the reader*/
+    reader.leave();
+    return commit.wait(rc);
+}
+
+/// @brief Find and book the first run of contiguous free seats
+/// @param booker [in] booker uid
+/// @param movie [in] movie, which gets booked
+/// @param theatre [in] theatre where movie is played
+/// @param n [in] number of seats
+/// @param row [in] name of the row, where seats are searched. Empty for whole theatre
+/// @param seats [out] booked seats
+/// @return Negative on error, -ENOSPC if there is no such run, >=0 on success
+int32_t CBooking::book_best_seats
+(
+    CBooker::booker_ptr booker,
+    std::string_view movie,
+    std::string_view theatre,
+    uint32_t n,
+    const std::string &row,
+    std::set<uint32_t> &seats
+)
+{
+    int32_t rc;
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    theatre_reservation *p_reservation;
+
+    assert(booker != nullptr);
+
+    seats.clear();
+
+    if (n == 0) {
+        return -EINVAL;
+    }
+
+    /*declared before the reader, so flush is awaited without it*/
+    CJournal::commit commit(m_journal);
+    CEpoch::reader reader(m_epoch);
+
+    p_reservation = find_theatre(movie, theatre);
+    if (p_reservation == nullptr) {
+        return -EEXIST;
+    }
+
+    if (row.empty()) {
+        ranges.emplace_back(0, p_reservation->get_seats().free_seats_map_.capacity());
+    }
+    else {
+        /*the same row name can be used in more sections*/
+        for (const seat_row &layout_row : p_reservation->layout_) {
+            if (layout_row.row_ == row)
+                ranges.emplace_back(layout_row.first_seat_, layout_row.first_seat_ + layout_row.seats_);
+        }
+
+        if (ranges.empty()) {
+            return -ENOENT;
+        }
+    }
+
+    rc = book_best_seats(booker, *p_reservation, n, ranges, seats);
+    reader.leave();
+
+    return commit.wait(rc);
+}
+
+/// @brief Find and book run of contiguous free seats in any theatre of the movie
+///     Only theatres with enough free seats are tried, in the order of the catalog
+/// @param booker [in] booker uid
+/// @param movie [in] movie, which gets booked
+/// @param n [in] number of seats
+/// @param seats [out] booked seats
+/// @return Negative on error, -EEXIST if movie doesn't exist, -ENOSPC if no theatre has such run, show handle on success
+int32_t CBooking::book_any_seats
+(
+    CBooker::booker_ptr booker,
+    std::string_view movie,
+    uint32_t n,
+    std::set<uint32_t> &seats
+)
+{
+    int32_t rc;
+    std::vector<uint32_t> candidates;
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+
+    assert(booker != nullptr);
+
+    seats.clear();
+
+    if (n == 0) {
+        return -EINVAL;
+    }
+
+    /*declared before the reader, so flush is awaited without it*/
+    CJournal::commit commit(m_journal);
+    CEpoch::reader reader(m_epoch);
+    const catalog &current = get_catalog();
+
+    auto it = current.movies_map_.find(movie);
+    if (it == current.movies_map_.end()) {
+        return -EEXIST;
+    }
+
+    /*free seat counts rule out full theatres at once, none of them is locked*/
+    it->second->availability_.find_at_least(n, candidates);
+
+    rc = -ENOSPC;
+    for (uint32_t position : candidates) {
+        theatre_reservation &reservation = *(it->second->theatre_reservations_map_.begin() + position)->second;
+
+        ranges.assign(1, std::make_pair(0u, reservation.get_seats().free_seats_map_.capacity()));
+        rc = book_best_seats(booker, reservation, n, ranges, seats);
+        if (rc >= EXIT_SUCCESS) {
+            rc = static_cast<int32_t>(reservation.id_);
+            break;
+        }
+
+        /*seats are scattered or were taken meanwhile, next theatre is tried*/
+        if (rc != -ENOSPC) {
+            break;
+        }
+    }
+    reader.leave();
+
+    return commit.wait(rc);
+}
+
+/// @brief Book the first run of contiguous free seats within the ranges
+/// @param booker [in] booker uid
+/// @param reservation [in] theatre
+/// @param n [in] number of seats
+/// @param ranges [in] ranges of seats, where the run is searched
+/// @param seats [out] booked seats
+/// @return Negative on error, -ENOSPC if there is no such run, >=0 on success
+int32_t CBooking::book_best_seats
+(
+    CBooker::booker_ptr booker,
+    theatre_reservation &reservation,
+    uint32_t n,
+    const std::vector<std::pair<uint32_t, uint32_t>> &ranges,
+    std::set<uint32_t> &seats
+)
+{
+    int32_t rc;
+    int64_t first_seat;
+    std::vector<uint32_t> unavalable_seats;
+
+    /*index is not thread safe, so it is used under theatre lock in both engines.
+      Lock free bookings are kept out, so the found run can't be taken meanwhile.
+      Caller awaits the flush, once it leaves the reader*/
+    theatre_access access(reservation, false);
+    seat_state &own_seats = materialize(reservation);
+
+    own_seats.runs_.refresh(own_seats.free_seats_map_);
+
+    first_seat = -1;
+    for (auto &range : ranges) {
+        first_seat = own_seats.runs_.find(n, range.first, range.second);
+        if (first_seat >= 0)
+            break;
+    }
+
+    rc = -ENOSPC;
+    if (first_seat >= 0) {
+        for (uint32_t i = 0; i < n; ++i) {
+            seats.insert(seats.end(), static_cast<uint32_t>(first_seat) + i);
+        }
+
+        rc = book_seats(booker, access, reservation, seats, unavalable_seats, false);
+        assert(unavalable_seats.empty());
+        if ((rc < EXIT_SUCCESS)||(unavalable_seats.empty() != true)) {
+            seats.clear();
+            rc = (rc < EXIT_SUCCESS) ? rc : -ENOSPC;
+        }
+    }
+    access.release();
+
+    return rc;
+}
+
+/// @brief Hold the list of seats for limited time
+///     Seats are booked as with book_seats, but they are released
+///     automatically, unless they are confirmed before ttl is over
+/// @param booker [in] booker uid
+/// @param movie [in] movie, which gets booked
+/// @param theatre [in] theatre where movie is played
+/// @param seats [in] array of holding seats
+/// @param unavalable_seats [out] list of seats, which are already taken.
+///                     But were in our request
+/// @param ttl [in] how long seats are held
+/// @return Negative on error, >=0 on success
+int32_t CBooking::hold_seats
+(
+    CBooker::booker_ptr booker,
+    std::string_view movie,
+    std::string_view theatre,
+    const std::set<uint32_t> &seats,
+    std::vector<uint32_t> &unavalable_seats,
+    std::chrono::milliseconds ttl
+)
+{
+    int32_t rc;
+    std::set<uint32_t> held_seats;
+    std::set<uint32_t> owned_seats;
+    theatre_reservation *p_reservation;
+
+    assert(booker != nullptr);
+
+    if (ttl.count() <= 0) {
+        return -EINVAL;
+    }
+
+    /*declared before the reader and the lock, so flush is awaited without them*/
+    CJournal::commit commit(m_journal);
+    CEpoch::reader reader(m_epoch);
+
+    p_reservation = find_theatre(movie, theatre);
+    if (p_reservation == nullptr) {
+        return -EEXIST;
+    }
+
+    theatre_access access(*p_reservation, (m_engine == engine_t::lock_free)&&(CSeatMap::mask_words(seats) <= m_lock_free_max_words));
+
+    /*seats, which are already ours, are not held again*/
+    booker->get_owned_seats(p_reservation->id_, owned_seats);
+
+    rc = book_seats(booker, access, *p_reservation, seats, unavalable_seats, false);
+    if ((rc >= EXIT_SUCCESS)&&(unavalable_seats.empty())) {
+        std::set_difference(seats.begin(), seats.end(), owned_seats.begin(), owned_seats.end(), std::inserter(held_seats, held_seats.end()));
+    }
+
+    if (held_seats.empty() != true) {
+        if (m_journal.is_open()) {
+            /*wall clock deadline, steady clock doesn't survive restart*/
+            journal_seats('H', *booker, p_reservation->id_, std::vector<uint32_t>(held_seats.begin(), held_seats.end()),
+                std::chrono::duration_cast<std::chrono::milliseconds>((std::chrono::system_clock::now() + ttl).time_since_epoch()).count());
+        }
+
+        add_hold(booker, p_reservation->id_, std::move(held_seats), std::chrono::steady_clock::now() + ttl);
+    }
+
+    access.release();
+    reader.leave();
+
+    return commit.wait(rc);
+}
+
+/// @brief Schedule release of held seats
+/// @param booker [in] holder
+/// @param theatre_id [in] theatre id
+/// @param seats [in] held seats, already booked by the holder
+/// @param deadline [in] when the seats are released
+void CBooking::add_hold
+(
+    CBooker::booker_ptr booker,
+    uint32_t theatre_id,
+    std::set<uint32_t> seats,
+    std::chrono::steady_clock::time_point deadline
+)
+{
+    uint64_t hold_id;
+    uint64_t tick;
+
+    /*rounded up, hold never expires earlier than requested*/
+    tick = 0;
+    if (deadline > m_holds_epoch) {
+        tick = static_cast<uint64_t>((deadline - m_holds_epoch + m_hold_tick - std::chrono::milliseconds(1)) / m_hold_tick);
+    }
+
+    std::lock_guard<std::mutex> holds_lck(m_holds_mutex);
+
+    hold_id = ++m_holds_ctx;
+    m_booker_holds[booker->get_booker_id()].insert(hold_id);
+    m_holds.emplace(hold_id, seat_hold{std::move(booker), theatre_id, std::move(seats)});
+    m_holds_wheel.schedule(hold_id, tick);
+}
+
+/// @brief Make held seats permanent
+/// @param booker [in] booker uid
+/// @param movie [in] movie
+/// @param theatre [in] theatre where movie is played
+/// @param seats [in] array of held seats
+/// @param invalid_seats [out] list of seats, which are not held by us
+/// @return Negative on error, number of confirmed seats on success
+int32_t CBooking::confirm_seats
+(
+    CBooker::booker_ptr booker,
+    std::string_view movie,
+    std::string_view theatre,
+    const std::set<uint32_t> &seats,
+    std::vector<uint32_t> &invalid_seats
+)
+{
+    std::set<uint32_t> confirmed;
+    const theatre_reservation *p_reservation;
+
+    assert(booker != nullptr);
+
+    invalid_seats.clear();
+
+    /*declared before the reader, so flush is awaited without it*/
+    CJournal::commit commit(m_journal);
+    CEpoch::reader reader(m_epoch);
+
+    p_reservation = find_theatre(movie, theatre);
+    if (p_reservation == nullptr) {
+        return -EEXIST;
+    }
+
+    {
+        std::lock_guard<std::mutex> lck(m_holds_mutex);
+
+        auto it = m_booker_holds.find(booker->get_booker_id());
+        if (it != m_booker_holds.end()) {
+            for (auto it2 = it->second.begin(); it2 != it->second.end();) {
+                seat_hold &hold = m_holds.at(*it2);
+                if (hold.theatre_ == p_reservation->id_) {
+                    for (uint32_t seat : seats) {
+                        if (hold.seats_.erase(seat) != 0)
+                            confirmed.insert(seat);
+                    }
+                }
+
+                if (hold.seats_.empty()) {
+                    /*timer is left in the wheel, it will find nothing*/
+                    m_holds.erase(*it2);
+                    it2 = it->second.erase(it2);
+                }
+                else {
+                    ++it2;
+                }
+            }
+
+            if (it->second.empty())
+                m_booker_holds.erase(it);
+        }
+    }
+
+    std::set_difference(seats.begin(), seats.end(), confirmed.begin(), confirmed.end(), std::back_inserter(invalid_seats));
+
+    if ((m_journal.is_open())&&(confirmed.empty() != true)) {
+        journal_seats('C', *booker, p_reservation->id_, std::vector<uint32_t>(confirmed.begin(), confirmed.end()));
+    }
+    reader.leave();
+
+    return commit.wait(static_cast<int32_t>(confirmed.size()));
+}
+
+/// @brief Get the list of seats held by booker, which are not confirmed yet
+/// @param booker [in] booker uid
+/// @param movie [in] movie
+/// @param theatre [in] theatre where movie is played
+/// @param seats [out] array of held seats
+/// @return Negative on error, >=0 on success
+int32_t CBooking::get_held_seats
+(
+    CBooker::booker_ptr booker,
+    std::string_view movie,
+    std::string_view theatre,
+    std::set<uint32_t> &seats
+) const
+{
+    const theatre_reservation *p_reservation;
+
+    seats.clear();
+
+    CEpoch::reader reader(m_epoch);
+
+    p_reservation = find_theatre(movie, theatre);
+    if (p_reservation == nullptr) {
+        return -EEXIST;
+    }
+
+    std::lock_guard<std::mutex> lck(m_holds_mutex);
+
+    auto it = m_booker_holds.find(booker->get_booker_id());
+    if (it != m_booker_holds.end()) {
+        for (uint64_t hold_id : it->second) {
+            const seat_hold &hold = m_holds.at(hold_id);
+            if (hold.theatre_ == p_reservation->id_)
+                seats.insert(hold.seats_.begin(), hold.seats_.end());
+        }
+    }
+
+    return static_cast<int32_t>(seats.size());
+}
+
+/// @brief Release held seats, which ttl is over
+/// @param now [in] current time
+/// @return number of released seats
+uint32_t CBooking::expire_holds(std::chrono::steady_clock::time_point now)
+{
+    std::vector<uint64_t> expired_ids;
+    std::vector<seat_hold> expired;
+
+    if (now < m_holds_epoch) {
+        return 0;
+    }
+
+    {
+        std::lock_guard<std::mutex> lck(m_holds_mutex);
+
+        m_holds_wheel.advance(static_cast<uint64_t>((now - m_holds_epoch) / m_hold_tick), expired_ids);
+        for (uint64_t hold_id : expired_ids) {
+            auto it = m_holds.find(hold_id);
+            if (it == m_holds.end()) {
+                /*confirmed or released meanwhile*/
+                continue;
+            }
+
+            auto it2 = m_booker_holds.find(it->second.booker_->get_booker_id());
+            if (it2 != m_booker_holds.end()) {
+                it2->second.erase(hold_id);
+                if (it2->second.empty())
+                    m_booker_holds.erase(it2);
+            }
+
+            expired.push_back(std::move(it->second));
+            m_holds.erase(it);
+        }
+    }
+
+    /*theatre locks are taken after holds lock is released*/
+    return release_holds(expired);
+}
+
+/// @brief Release seats of the holds
+/// @param holds [in] holds, which are not in the table of holds anymore
+/// @return number of released seats
+uint32_t CBooking::release_holds(std::vector<seat_hold> &holds)
+{
+    int32_t rc;
+    uint32_t released;
+    std::vector<uint32_t> invalid_seats;
+
+    CEpoch::reader reader(m_epoch);
+
+    released = 0;
+    for (seat_hold &hold : holds) {
+        theatre_reservation *p_reservation = find_theatre(hold.theatre_);
+        if (p_reservation == nullptr) {
+            /*theatre was removed, reload forgets its seats*/
+            continue;
+        }
+
+        theatre_access access(*p_reservation, m_engine == engine_t::lock_free);
+
+        rc = unbook_seats(hold.booker_, *p_reservation, hold.seats_, invalid_seats);
+        if (rc > 0) {
+            released += static_cast<uint32_t>(rc);
+        }
+    }
+
+    return released;
+}
+
+/// @brief Forget released seats in holds of the booker
+/// @param booker_id [in] booker handle
+/// @param theatre_id [in] theatre id
+/// @param seats [in] list of released seats
+void CBooking::drop_holds
+(
+    uint32_t booker_id,
+    uint32_t theatre_id,
+    const std::vector<uint32_t> &seats
+)
+{
+    if (seats.empty())
+        return;
+
+    std::lock_guard<std::mutex> lck(m_holds_mutex);
+
+    auto it = m_booker_holds.find(booker_id);
+    if (it == m_booker_holds.end())
+        return;
+
+    for (auto it2 = it->second.begin(); it2 != it->second.end();) {
+        seat_hold &hold = m_holds.at(*it2);
+        if (hold.theatre_ == theatre_id) {
+            for (uint32_t seat : seats) {
+                hold.seats_.erase(seat);
+            }
+        }
+
+        if (hold.seats_.empty()) {
+            m_holds.erase(*it2);
+            it2 = it->second.erase(it2);
+        }
+        else {
+            ++it2;
+        }
+    }
+
+    if (it->second.empty())
+        m_booker_holds.erase(it);
+}
+
+/// @brief Forget seats and holds of removed theatre, nobody can see the theatre anymore
+/// @param reservation [in] removed theatre
+void CBooking::forget_theatre(const theatre_reservation &reservation)
+{
+    uint32_t owner;
+    std::map<uint32_t, std::vector<uint32_t>> owned_seats;
+
+    {
+        std::lock_guard<std::mutex> lck(m_holds_mutex);
+
+        /*timers are left in the wheel, they will find nothing*/
+        for (auto it = m_holds.begin(); it != m_holds.end();) {
+            if (it->second.theatre_ != reservation.id_) {
+                ++it;
+                continue;
+            }
+
+            auto it2 = m_booker_holds.find(it->second.booker_->get_booker_id());
+            if (it2 != m_booker_holds.end()) {
+                it2->second.erase(it->first);
+                if (it2->second.empty())
+                    m_booker_holds.erase(it2);
+            }
+            it = m_holds.erase(it);
+        }
+    }
+
+    const seat_state &seats = reservation.get_seats();
+    for (uint32_t seat = 0; seat < seats.free_seats_map_.capacity(); ++seat) {
+        owner = seats.owners_[seat].load(std::memory_order_relaxed);
+        if (owner != 0)
+            owned_seats[owner].push_back(seat);
+    }
+
+    /*reverse indexes of the bookers don't point to the theatre anymore*/
+    for (auto &owned : owned_seats) {
+        CBooker::booker_ptr booker = m_bookers.find(owned.first);
+        if (booker != nullptr)
+            booker->remove_seats(reservation.id_, owned.second);
+    }
+}
+
+/// @brief Book the list of seats of the theatre
+/// @param booker [in] booker uid
+/// @param access [in] access to the theatre, lock free or exclusive
+/// @param reservation [in] ptr to reservation ctx
+/// @param seats [in] array of booking seats
+/// @param unavalable_seats [out] list of seats, which are already taken.
+///                     But were in our request
+/// @param best_effort [in] true, to skip already booked seats
+/// @param journal [in] false, if caller journals the booked seats itself
+/// @return Negative on error, >=0 on success
+int32_t CBooking::book_seats 
+(
+    CBooker::booker_ptr booker, 
+    const theatre_access &access,
+    theatre_reservation &reservation,
+    const std::set<uint32_t> &seats,
+    std::vector<uint32_t> &unavalable_seats,
+    bool best_effort,
+    bool journal
+)
+{
+    int32_t rc;
+    CSeatMap::mask_t request;
+
+    unavalable_seats.clear();
+
+    rc = CSeatMap::make_mask(seats, reservation.get_seats().free_seats_map_.capacity(), request);
+    if (rc < 0) {
+        return rc;
+    }
+
+    if (booker->get_booker_id() == 0) {
+        /*booker has not joined*/
+        return -EINVAL;
+    }
+
+    if (access.exclusive()) {
+        rc = take_seats(booker, reservation, request, unavalable_seats, best_effort, journal);
+    }
+    else {
+        /*claims are journaled under their gate, callers journaling themselves hold the theatre*/
+        assert(journal);
+        assert(request.words_.size() <= m_lock_free_max_words);
+        rc = claim_seats(booker, reservation, request, unavalable_seats, best_effort);
+    }
+    if (rc < EXIT_SUCCESS) {
+        return rc;
+    }
+
+    return static_cast<int32_t>(booker->get_seats_count(reservation.id_));
+}
+
+/// @brief Book the list of seats within few seat words with CAS, without lock
+/// @param booker [in] booker uid
+/// @param reservation [in] ptr to reservation ctx
+/// @param request [in] request mask
+/// @param unavalable_seats [out] list of seats, which are already taken.
+///                     But were in our request
+/// @param best_effort [in] true, to skip already booked seats
+/// @return Negative on error, >=0 on success
+int32_t CBooking::claim_seats 
+(
+    CBooker::booker_ptr booker, 
+    theatre_reservation &reservation,
+    CSeatMap::mask_t &request,
+    std::vector<uint32_t> &unavalable_seats,
+    bool best_effort
+)
+{
+    uint32_t booker_id;
+    std::size_t n;
+    bool claimed_all;
+    CSeatMap::mask_t claimed;
+    std::vector<CSeatMap::word_t> free_words;
+    std::vector<uint32_t> taken_seats;
+
+    booker_id = booker->get_booker_id();
+
+    /*sentinel is shared by other theatres, it is never changed*/
+    seat_state &own_seats = materialize(reservation);
+
+    n = request.words_.size();
+
+    /*requested seats, which are not free, are either already ours or unavailable*/
+    own_seats.free_seats_map_.snapshot(request.first_word_, n, free_words);
+    if (CSeatMap::kernel_any_andnot(request.words_.data(), free_words.data(), n)) {
+        CSeatMap::kernel_extract_andnot(request.words_.data(), free_words.data(), n, request.first_word_ * CSeatMap::m_word_bits, taken_seats);
+        for (uint32_t seat : taken_seats) {
+            request.words_[seat / CSeatMap::m_word_bits - request.first_word_] &= ~(static_cast<CSeatMap::word_t>(1) << (seat % CSeatMap::m_word_bits));
+            if (own_seats.owners_[seat].load(std::memory_order_acquire) != booker_id) {
+                unavalable_seats.push_back(seat);
+            }
+        }
+
+        if ((unavalable_seats.empty() != true)&&(best_effort == false)) {
+            /*we failed to book all the required seats*/
+            return EXIT_SUCCESS;
+        }
+    }
+
+    taken_seats.clear();
+    {
+        /*readers see seats either before the claim, or with the owners already stored*/
+        CSeqGate::writer gate(reservation.seq_);
+
+        /*CAS per word takes the whole request, or nothing at all*/
+        claimed_all = own_seats.free_seats_map_.claim(request, claimed, best_effort);
+        if (claimed_all) {
+            /*claimed seats belong to us only, so owner can be stored without CAS*/
+            CSeatMap::mask_to_vector(claimed, taken_seats);
+            for (uint32_t seat : taken_seats) {
+                own_seats.owners_[seat].store(booker_id, std::memory_order_release);
+            }
+
+            /*seats are ours, so nobody else journals them before us*/
+            if ((m_journal.is_open())&&(taken_seats.empty() != true)) {
+                journal_seats('B', *booker, reservation.id_, taken_seats);
+            }
+        }
+    }
+
+    /*seats, which were taken by somebody else after the check. Ours were left out of the request*/
+    std::size_t size = unavalable_seats.size();
+    CSeatMap::kernel_extract_andnot(request.words_.data(), claimed.words_.data(), n, request.first_word_ * CSeatMap::m_word_bits, unavalable_seats);
+    if (size != unavalable_seats.size()) {
+        std::sort(unavalable_seats.begin(), unavalable_seats.end());
+    }
+
+    if (claimed_all != true) {
+        return EXIT_SUCCESS;
+    }
+
+    update_availability(reservation);
+    booker->add_seats(reservation.id_, taken_seats);
+
+    return EXIT_SUCCESS;
+}
+
+/// @brief Book the list of seats with seat map kernels, theatre is locked and gate closed
+/// @param booker [in] booker uid
+/// @param reservation [in] ptr to reservation ctx
+/// @param request [in] request mask
+/// @param unavalable_seats [out] list of seats, which are already taken.
+///                     But were in our request
+/// @param best_effort [in] true, to skip already booked seats
+/// @param journal [in] false, if caller journals the booked seats itself
+/// @return Negative on error, >=0 on success
+int32_t CBooking::take_seats 
+(
+    CBooker::booker_ptr booker, 
+    theatre_reservation &reservation,
+    const CSeatMap::mask_t &request,
+    std::vector<uint32_t> &unavalable_seats,
+    bool best_effort,
+    bool journal
+)
+{
+    uint32_t booker_id;
+    std::size_t n;
+    bool booked;
+    CSeatMap::mask_t owned;
+    CSeatMap::mask_t taken;
+    std::vector<CSeatMap::word_t> free_words;
+    std::vector<uint32_t> taken_seats;
+
+    booker_id = booker->get_booker_id();
+
+    /*sentinel is shared by other theatres, it is never changed*/
+    seat_state &own_seats = materialize(reservation);
+
+    n = request.words_.size();
+
+    /*requested seats, which are not free, might be ours already*/
+    owned.first_word_ = request.first_word_;
+    owned.words_.assign(n, 0);
+    own_seats.free_seats_map_.snapshot(request.first_word_, n, free_words);
+    CSeatMap::kernel_extract_andnot(request.words_.data(), free_words.data(), n, request.first_word_ * CSeatMap::m_word_bits, taken_seats);
+    for (uint32_t seat : taken_seats) {
+        if (own_seats.owners_[seat].load(std::memory_order_relaxed) == booker_id)
+            owned.words_[seat / CSeatMap::m_word_bits - request.first_word_] |= static_cast<CSeatMap::word_t>(1) << (seat % CSeatMap::m_word_bits);
+    }
+
+    taken_seats.clear();
+    {
+        CSeqGate::writer gate(reservation.seq_);
+
+        /*nobody else changes the seats, so the whole request is booked at once*/
+        booked = own_seats.free_seats_map_.book(request, owned, taken, unavalable_seats, best_effort);
+        if (booked) {
+            CSeatMap::mask_to_vector(taken, taken_seats);
+            for (uint32_t seat : taken_seats) {
+                own_seats.owners_[seat].store(booker_id, std::memory_order_release);
+            }
+
+            if ((journal)&&(m_journal.is_open())&&(taken_seats.empty() != true)) {
+                journal_seats('B', *booker, reservation.id_, taken_seats);
+            }
+        }
+    }
+
+    if (booked != true) {
+        /*we failed to book all the required seats*/
+        return EXIT_SUCCESS;
+    }
+
+    update_availability(reservation);
+    booker->add_seats(reservation.id_, taken_seats);
+
+    return EXIT_SUCCESS;
+}
+
+/// @brief Release already taken seats
+/// @param booker [in] booker uid
+/// @param movie [in] movie, which gets booked
+/// @param theatre [in] theatre where movie is played
+/// @param seats [in] array of booking seats
+/// @param invalid_seats [out] list of seats, which are not tkaen taken by us
+/// @return Negative on error, >=0 on success
+int32_t CBooking::unbook_seats 
+(
+    CBooker::booker_ptr booker, 
+    std::string_view movie,
+    std::string_view theatre,
+    const std::set<uint32_t> &seats,
+    std::vector<uint32_t> &invalid_seats
+)
+{
+    int32_t show;
+
+    show = find_show(movie, theatre);
+    if (show < EXIT_SUCCESS) {
+        return show;
+    }
+
+    return unbook_seats(booker, static_cast<uint32_t>(show), seats, invalid_seats);
+}
+
+/// @brief Release already taken seats of the show
+/// @param booker [in] booker uid
+/// @param show [in] show handle
+/// @param seats [in] array of booking seats
+/// @param invalid_seats [out] list of seats, which are not tkaen taken by us
+/// @return Negative on error, >=0 on success
+int32_t CBooking::unbook_seats 
+(
+    CBooker::booker_ptr booker, 
+    uint32_t show,
+    const std::set<uint32_t> &seats,
+    std::vector<uint32_t> &invalid_seats
+)
+{
+    int32_t rc;
+    theatre_reservation *p_reservation;
+
+    assert(booker != nullptr);
+
+    /*declared before the reader and the lock, so flush is awaited without them*/
+    CJournal::commit commit(m_journal);
+    CEpoch::reader reader(m_epoch);
+
+    p_reservation = find_theatre(show);
+    if (p_reservation == nullptr) {
+        return -EEXIST;
+    }
+
+    /*release is per seat CAS on the owner, so lock free engine needs the lock
+      only while somebody else books the theatre with kernels*/
+    theatre_access access(*p_reservation, m_engine == engine_t::lock_free);
+
+    rc = unbook_seats(booker, *p_reservation, seats, invalid_seats);
+    access.release();
+    reader.leave();
+
+    return commit.wait(rc);
+}
+
+/// @brief Release seats and book other seats of the theatre at once, all or nothing
+/// @param booker [in] booker uid
+/// @param movie [in] movie
+/// @param theatre [in] theatre where movie is played
+/// @param release_seats [in] seats taken by us, which are released
+/// @param take_seats [in] seats, which are booked instead
+/// @param unavalable_seats [out] seats to be booked, which are taken by others
+/// @param invalid_seats [out] seats to be released, which are not taken by us
+/// @return Negative on error, 0 if nothing was changed, number of booked seats of the theatre on success
+int32_t CBooking::exchange_seats
+(
+    CBooker::booker_ptr booker,
+    std::string_view movie,
+    std::string_view theatre,
+    const std::set<uint32_t> &release_seats,
+    const std::set<uint32_t> &take_seats,
+    std::vector<uint32_t> &unavalable_seats,
+    std::vector<uint32_t> &invalid_seats
+)
+{
+    int32_t show;
+
+    show = find_show(movie, theatre);
+    if (show < EXIT_SUCCESS) {
+        return show;
+    }
+
+    return exchange_seats(booker, static_cast<uint32_t>(show), release_seats, take_seats, unavalable_seats, invalid_seats);
+}
+
+/// @brief Release seats and book other seats of the show at once, all or nothing
+/// @param booker [in] booker uid
+/// @param show [in] show handle
+/// @param release_seats [in] seats taken by us, which are released
+/// @param take_seats [in] seats, which are booked instead
+/// @param unavalable_seats [out] seats to be booked, which are taken by others
+/// @param invalid_seats [out] seats to be released, which are not taken by us
+/// @return Negative on error, 0 if nothing was changed, number of booked seats of the theatre on success
+int32_t CBooking::exchange_seats
+(
+    CBooker::booker_ptr booker,
+    uint32_t show,
+    const std::set<uint32_t> &release_seats,
+    const std::set<uint32_t> &take_seats,
+    std::vector<uint32_t> &unavalable_seats,
+    std::vector<uint32_t> &invalid_seats
+)
+{
+    int32_t rc;
+    uint32_t capacity;
+    theatre_reservation *p_reservation;
+
+    assert(booker != nullptr);
+
+    unavalable_seats.clear();
+    invalid_seats.clear();
+
+    /*declared before the reader and the lock, so flush is awaited without them*/
+    CJournal::commit commit(m_journal);
+    CEpoch::reader reader(m_epoch);
+
+    p_reservation = find_theatre(show);
+    if (p_reservation == nullptr) {
+        return -EEXIST;
+    }
+
+    capacity = p_reservation->get_seats().free_seats_map_.capacity();
+    if (((release_seats.empty() != true)&&(*release_seats.rbegin() >= capacity))||
+        ((take_seats.empty() != true)&&(*take_seats.rbegin() >= capacity))) {
+        return -ERANGE;
+    }
+
+    /*both halves are journaled within single commit and done under single lock in both engines*/
+    theatre_access access(*p_reservation, false);
+
+    rc = exchange_seats(booker, access, *p_reservation, release_seats, take_seats, unavalable_seats, invalid_seats);
+    access.release();
+    reader.leave();
+
+    return commit.wait(rc);
+}
+
+/// @brief Release seats and book other seats of the theatre at once, all or nothing
+/// @param booker [in] booker uid
+/// @param access [in] exclusive access to the theatre
+/// @param reservation [in] theatre
+/// @param release_seats [in] seats taken by us, which are released
+/// @param take_seats [in] seats, which are booked instead
+/// @param unavalable_seats [out] seats to be booked, which are taken by others
+/// @param invalid_seats [out] seats to be released, which are not taken by us
+/// @return Negative on error, 0 if nothing was changed, number of booked seats of the theatre on success
+int32_t CBooking::exchange_seats
+(
+    CBooker::booker_ptr booker,
+    const theatre_access &access,
+    theatre_reservation &reservation,
+    const std::set<uint32_t> &release_seats,
+    const std::set<uint32_t> &take_seats,
+    std::vector<uint32_t> &unavalable_seats,
+    std::vector<uint32_t> &invalid_seats
+)
+{
+    int32_t rc;
+    uint32_t booker_id;
+    std::set<uint32_t> new_seats;
+    std::set<uint32_t> old_seats;
+    std::vector<uint32_t> released_invalid;
+
+    assert(access.exclusive());
+
+    /*seat listed on both sides is kept as it is*/
+    std::set_difference(take_seats.begin(), take_seats.end(), release_seats.begin(), release_seats.end(), std::inserter(new_seats, new_seats.end()));
+    std::set_difference(release_seats.begin(), release_seats.end(), take_seats.begin(), take_seats.end(), std::inserter(old_seats, old_seats.end()));
+
+    /*nothing is changed, unless all the released seats are ours*/
+    booker_id = booker->get_booker_id();
+    for (uint32_t seat : release_seats) {
+        if ((booker_id == 0)||(reservation.get_seats().owners_[seat].load(std::memory_order_acquire) != booker_id))
+            invalid_seats.push_back(seat);
+    }
+    if (invalid_seats.empty() != true) {
+        return EXIT_SUCCESS;
+    }
+
+    /*new seats are taken first, so released seats are never free, while the exchange can still fail*/
+    if (new_seats.empty() != true) {
+        rc = book_seats(booker, access, reservation, new_seats, unavalable_seats, false);
+        if ((rc < EXIT_SUCCESS)||(unavalable_seats.empty() != true)) {
+            return (rc < EXIT_SUCCESS) ? rc : EXIT_SUCCESS;
+        }
+    }
+
+    if (old_seats.empty() != true) {
+        rc = unbook_seats(booker, reservation, old_seats, released_invalid);
+        if (rc < EXIT_SUCCESS) {
+            return rc;
+        }
+    }
+
+    return static_cast<int32_t>(booker->get_seats_count(reservation.id_));
+}
+
+/// @brief Release already taken seats
+/// @param booker [in] booker uid
+/// @param reservation [in] ptr to reservation ctx
+/// @param seats [in] array of booking seats
+/// @param invalid_seats [out] list of seats, which are not tkaen taken by us
+/// @param journal [in] false for rollback of seats, which were never journaled
+/// @return Negative on error, >=0 on success
+int32_t CBooking::unbook_seats 
+(
+    CBooker::booker_ptr booker, 
+    theatre_reservation &reservation,
+    const std::set<uint32_t> &seats,
+    std::vector<uint32_t> &invalid_seats,
+    bool journal
+)
+{
+    int32_t rc;
+    uint32_t booker_id;
+    CSeatMap::mask_t request;
+    std::vector<uint32_t> released_seats;
+
+    invalid_seats.clear();
+    booker_id = booker->get_booker_id();
+    if ((booker_id == 0)||(booker->get_seats_count(reservation.id_) == 0)) {
+        for (uint32_t seat : seats) {
+            invalid_seats.push_back(seat);
+        }
+        return static_cast<int32_t>(invalid_seats.size());
+    }
+
+    rc = CSeatMap::make_mask(seats, reservation.get_seats().free_seats_map_.capacity(), request);
+    if (rc < 0) {
+        return rc;
+    }
+
+    /*booker has seats here, so theatre has its own seats already*/
+    seat_state &own_seats = materialize(reservation);
+
+    {
+        CSeqGate::writer gate(reservation.seq_);
+
+        for (uint32_t seat : seats) {
+            uint32_t expected = booker_id;
+            /*only the owner clears the owner, seat is freed afterwards*/
+            if (own_seats.owners_[seat].compare_exchange_strong(expected, 0, std::memory_order_acq_rel) != true) {
+                invalid_seats.push_back(seat);
+                request.words_[seat / CSeatMap::m_word_bits - request.first_word_] &= ~(static_cast<CSeatMap::word_t>(1) << (seat % CSeatMap::m_word_bits));
+            }
+            else {
+                released_seats.push_back(seat);
+            }
+        }
+
+        /*seats are journaled before anybody else can take them*/
+        if ((journal)&&(m_journal.is_open())&&(released_seats.empty() != true)) {
+            journal_seats('U', *booker, reservation.id_, released_seats);
+        }
+
+        own_seats.free_seats_map_.release(request);
+    }
+    update_availability(reservation);
+    booker->remove_seats(reservation.id_, released_seats);
+
+    /*released seats can't expire later anymore, they might be booked again meanwhile*/
+    drop_holds(booker_id, reservation.id_, released_seats);
+
+    return static_cast<int32_t>(released_seats.size());
+}
+
+/// @brief Get the list of free seats
+/// @param booker [in] booker uid
+/// @param movie [in] movie
+/// @param theatre [in] theatre
+/// @param free_seats [out] list of free seats
+/// @return Negative on error, >=0 on success
+int32_t CBooking::get_free_seats (
+    std::string_view movie,
+    std::string_view theatre,
+    std::set<uint32_t> &free_seats
+)
+{
+    int32_t show;
+
+    show = find_show(movie, theatre);
+    if (show < EXIT_SUCCESS) {
+        return show;
+    }
+
+    return get_free_seats(static_cast<uint32_t>(show), free_seats);
+}
+
+/// @brief Get the list of free seats of the show
+/// @param show [in] show handle
+/// @param free_seats [out] list of free seats
+/// @return Negative on error, >=0 on success
+int32_t CBooking::get_free_seats (
+    uint32_t show,
+    std::set<uint32_t> &free_seats
+)
+{
+    const theatre_reservation *p_reservation;
+    std::vector<CSeatMap::word_t> free_words;
+    std::vector<uint32_t> seats;
+
+    CEpoch::reader reader(m_epoch);
+
+    p_reservation = find_theatre(show);
+    if (p_reservation == nullptr) {
+        return -EEXIST;
+    }
+
+    if (read_theatre(*p_reservation, free_words, nullptr) != true) {
+        /*torn copy is never returned*/
+        return -EBUSY;
+    }
+
+    CSeatMap::kernel_extract(free_words.data(), free_words.size(), 0, seats);
+    free_seats.clear();
+    /*vector is sorted, so every insert is amortized O(1)*/
+    for (uint32_t seat : seats) {
+        free_seats.insert(free_seats.end(), seat);
+    }
+    return EXIT_SUCCESS;
+}
+
+/// @brief Get the list of booked seats per booker
+/// @param booker [in] booker uid
+/// @param movie [in] movie
+/// @param theatre [in] theatre where movie is played
+/// @param seats [out] array of booked seats
+/// @return Negative on error, >=0 on success
+int32_t CBooking::get_booked_seats 
+(
+    CBooker::booker_ptr booker, 
+    std::string_view movie,
+    std::string_view theatre,
+    std::set<uint32_t> &seats
+)
+{
+    int32_t show;
+
+    seats.clear();
+
+    show = find_show(movie, theatre);
+    if (show < EXIT_SUCCESS) {
+        return show;
+    }
+
+    return get_booked_seats(booker, static_cast<uint32_t>(show), seats);
+}
+
+/// @brief Get the list of booked seats of the show per booker
+/// @param booker [in] booker uid
+/// @param show [in] show handle
+/// @param seats [out] array of booked seats
+/// @return Negative on error, >=0 on success
+int32_t CBooking::get_booked_seats 
+(
+    CBooker::booker_ptr booker, 
+    uint32_t show,
+    std::set<uint32_t> &seats
+)
+{
+    const theatre_reservation *p_reservation;
+
+    seats.clear();
+
+    CEpoch::reader reader(m_epoch);
+
+    p_reservation = find_theatre(show);
+    if (p_reservation == nullptr) {
+        return -EEXIST;
+    }
+
+    /*reverse index of the booker has its own lock*/
+    booker->get_owned_seats(p_reservation->id_, seats);
+    return static_cast<int32_t>(seats.size());
+}
+
+/// @brief Find theatre of the movie, caller is within epoch read section or holds reload mutex
+/// @param movie [in] movie
+/// @param theatre [in] theatre
+/// @return pointer to the theatre, nullptr if it doesn't exist
+const CBooking::theatre_reservation *CBooking::find_theatre
+(
+    std::string_view movie,
+    std::string_view theatre
+) const
+{
+    const catalog &current = get_catalog();
+
+    auto it_movie = current.movies_map_.find(movie);
+    if (it_movie == current.movies_map_.end()) {
+        return nullptr;
+    }
+
+    /*catalog is not changed after it was published, so no lock is needed*/
+    auto it_theatre = it_movie->second->theatre_reservations_map_.find(theatre);
+    if (it_theatre == it_movie->second->theatre_reservations_map_.end()) {
+        return nullptr;
+    }
+
+    return it_theatre->second.get();
+}
+
+/// @brief Find theatre of the movie, caller is within epoch read section or holds reload mutex
+/// @param movie [in] movie
+/// @param theatre [in] theatre
+/// @return pointer to the theatre, nullptr if it doesn't exist
+CBooking::theatre_reservation *CBooking::find_theatre
+(
+    std::string_view movie,
+    std::string_view theatre
+)
+{
+    return const_cast<theatre_reservation *>(std::as_const(*this).find_theatre(movie, theatre));
+}
+
+/// @brief Find theatre of the show, caller is within epoch read section or holds reload mutex
+/// @param show [in] show handle
+/// @return pointer to the theatre, nullptr if it doesn't exist
+const CBooking::theatre_reservation *CBooking::find_theatre (uint32_t show) const
+{
+    const catalog &current = get_catalog();
+
+    /*catalog is not changed after it was published, so no lock is needed*/
+    if (show >= current.theatres_table_.size()) {
+        return nullptr;
+    }
+
+    return current.theatres_table_[show];
+}
+
+/// @brief Find theatre of the show, caller is within epoch read section or holds reload mutex
+/// @param show [in] show handle
+/// @return pointer to the theatre, nullptr if it doesn't exist
+CBooking::theatre_reservation *CBooking::find_theatre (uint32_t show)
+{
+    return const_cast<theatre_reservation *>(std::as_const(*this).find_theatre(show));
+}
+
+/// @brief Get stable handle of the show, commands with handle skip name lookups
+/// @param movie [in] movie
+/// @param theatre [in] theatre where movie is played
+/// @return Negative on error, show handle on success
+int32_t CBooking::find_show
+(
+    std::string_view movie,
+    std::string_view theatre
+) const
+{
+    const theatre_reservation *p_reservation;
+
+    CEpoch::reader reader(m_epoch);
+
+    p_reservation = find_theatre(movie, theatre);
+    if (p_reservation == nullptr) {
+        return -EEXIST;
+    }
+
+    return static_cast<int32_t>(p_reservation->id_);
+}
+
+/// @brief Get number of shows, handles are 0 .. number of shows - 1
+///     Handles of removed shows are never given again
+/// @return number of shows
+std::size_t CBooking::get_shows(void) const
+{
+    CEpoch::reader reader(m_epoch);
+
+    return get_catalog().theatres_table_.size();
+}
 
-            std::string theatre = it2->second.get_value<std::string>();
+/// @brief Get movies played in the theatre, cost is proportional to shows of the theatre
+/// @param theatre [in] theatre
+/// @param shows [out] movie and show handle, in the order of the catalog
+/// @return Negative on error, -EEXIST if theatre doesn't exist, number of shows on success
+int32_t CBooking::get_theatre_shows
+(
+    std::string_view theatre,
+    std::vector<std::pair<std::string, uint32_t>> &shows
+) const
+{
+    CEpoch::reader reader(m_epoch);
+    const catalog &current = get_catalog();
 
-            rc = prepare_reservation(new_theatre);
-            if (rc < 0) {
-                return rc;
-            }
+    shows.clear();
+    auto it = current.theatres_index_.find(theatre);
+    if (it == current.theatres_index_.end()) {
+        return -EEXIST;
+    }
 
-            if (theatre.empty()) {
-                return -EBADMSG;
-            }
+    /*names are copied, catalog may be reloaded after the read section*/
+    for (uint32_t show : it->second) {
+        shows.emplace_back(std::string(current.shows_[show].movie_), show);
+    }
 
-            auto map_rc = new_movie->theatre_reservations_map_.insert(std::pair<std::string, theatre_reservation>(std::move(theatre), std::move(new_theatre)));
-            if (map_rc.second != true) {
-                return -EEXIST;
-            }
-        }
+    return static_cast<int32_t>(shows.size());
+}
 
-        if (movie_pt->first.empty()) {
-            return -EBADMSG;
-        }
+/// @brief Get shows with at least n free seats, answered from free seat counts, seats are not read
+/// @param n [in] minimal number of free seats, at least 1
+/// @param shows [out] shows, in the order of handles
+/// @return Negative on error, number of shows on success
+int32_t CBooking::get_available
+(
+    uint32_t n,
+    std::vector<show_availability> &shows
+) const
+{
+    std::vector<uint32_t> entries;
 
-        std::string movie_name = movie_pt->second.get_value<std::string>();
+    CEpoch::reader reader(m_epoch);
+    const catalog &current = get_catalog();
 
-        auto map_rc = m_movies_map.insert(std::pair<std::string, std::unique_ptr<movie>>(std::move(movie_name), std::move(new_movie)));
-        if (map_rc.second != true) {
-            return -EEXIST;
-        }
-    }
+    current.availability_.find_at_least(n, entries);
+    get_show_availability(current, entries, shows);
 
-    return EXIT_SUCCESS;
+    return static_cast<int32_t>(shows.size());
 }
 
-/// @brief Book the list of seats
-/// @param booker [in] booker uid
-/// @param movie [in] movie, which gets booked
-/// @param theatre [in] theatre where movie is played
-/// @param seats [in] array of booking seats
-/// @param unavalable_seats [out] list of seats, which are already taken.
-///                     But were in our request
-/// @param best_effort [in] true, to skip already booked seats
-/// @return Negative on error, >=0 on success
-int32_t CBooking::book_seats 
+/// @brief Get shows of the movie with at least n free seats, answered from free seat counts
+/// @param movie [in] movie
+/// @param n [in] minimal number of free seats, at least 1
+/// @param shows [out] shows, in the order of the catalog
+/// @return Negative on error, -EEXIST if movie doesn't exist, number of shows on success
+int32_t CBooking::get_available
 (
-    CBooker::booker_ptr booker, 
-    const std::string &movie,
-    const std::string &theatre,
-    const std::set<uint32_t> &seats,
-    std::vector<uint32_t> &unavalable_seats,
-    bool best_effort
-)
+    std::string_view movie,
+    uint32_t n,
+    std::vector<show_availability> &shows
+) const
 {
-    assert(booker != nullptr);
+    std::vector<uint32_t> entries;
+
+    CEpoch::reader reader(m_epoch);
+    const catalog &current = get_catalog();
 
-    auto it_movie = m_movies_map.find(movie);
-    if (it_movie == m_movies_map.end()) {
+    shows.clear();
+    auto it = current.movies_map_.find(movie);
+    if (it == current.movies_map_.end()) {
         return -EEXIST;
     }
 
-    std::lock_guard<std::mutex> lck(it_movie->second->mutex_);
+    /*positions within the movie are turned to show handles*/
+    it->second->availability_.find_at_least(n, entries);
+    for (uint32_t &entry : entries) {
+        entry = (it->second->theatre_reservations_map_.begin() + entry)->second->id_;
+    }
+    get_show_availability(current, entries, shows);
 
-    return book_seats(booker, it_movie->second.get(), theatre, seats, unavalable_seats, best_effort);
+    return static_cast<int32_t>(shows.size());
 }
 
-/// @brief Book the list of seats
-/// @param booker [in] booker uid
-/// @param movie [in] ptr to movie ctx
-/// @param theatre [in] theatre where movie is played
-/// @param seats [in] array of booking seats
-/// @param unavalable_seats [out] list of seats, which are already taken.
-///                     But were in our request
-/// @param best_effort [in] true, to skip already booked seats
-/// @return Negative on error, >=0 on success
-int32_t CBooking::book_seats 
+/// @brief Get shows with the most free seats, answered from free seat counts
+/// @param k [in] maximal number of shows
+/// @param shows [out] shows, from the most free seats, sold out shows are not listed
+/// @return Negative on error, number of shows on success
+int32_t CBooking::get_top
 (
-    CBooker::booker_ptr booker,
-    movie *p_movie,
-    const std::string &theatre,
-    const std::set<uint32_t> &seats,
-    std::vector<uint32_t> &unavalable_seats,
-    bool best_effort
-)
+    uint32_t k,
+    std::vector<show_availability> &shows
+) const
 {
-    assert(p_movie != nullptr);
-    assert(p_movie->mutex_.try_lock() != true);
+    std::vector<uint32_t> entries;
 
-    auto it_theatre = p_movie->theatre_reservations_map_.find(theatre);
-    if (it_theatre == p_movie->theatre_reservations_map_.end()) {
-        return -EEXIST;
+    CEpoch::reader reader(m_epoch);
+    const catalog &current = get_catalog();
+
+    current.availability_.find_top(k, entries);
+    get_show_availability(current, entries, shows);
+
+    return static_cast<int32_t>(shows.size());
+}
+
+/// @brief Get number of shows, which have their own seats. The others share all free sentinel
+/// @return number of shows with own seats
+std::size_t CBooking::get_active_shows(void) const
+{
+    std::size_t active;
+
+    CEpoch::reader reader(m_epoch);
+
+    active = 0;
+    for (const theatre_reservation *p_reservation : get_catalog().theatres_table_) {
+        if ((p_reservation != nullptr)&&(p_reservation->get_seats().shared_ != true))
+            active++;
     }
 
-    return book_seats(booker, it_theatre->second, seats, unavalable_seats, best_effort);
+    return active;
 }
 
-/// @brief Book the list of seats
-/// @param booker [in] booker uid
-/// @param reservation [in] ptr to reservation ctx
-/// @param seats [in] array of booking seats
-/// @param unavalable_seats [out] list of seats, which are already taken.
-///                     But were in our request
-/// @param best_effort [in] true, to skip already booked seats
-/// @return Negative on error, >=0 on success
-int32_t CBooking::book_seats 
+/// @brief Publish free seats of the theatre to availability of the current catalog
+///     Caller is within epoch read section or holds reload mutex
+/// @param reservation [in] theatre, which seats changed
+void CBooking::update_availability(const theatre_reservation &reservation) const
+{
+    uint32_t free_seats;
+    const catalog &current = get_catalog();
+
+    if ((reservation.id_ >= current.theatres_table_.size())||(current.theatres_table_[reservation.id_] != &reservation)) {
+        /*theatre was removed by reload, nobody asks for it anymore*/
+        return;
+    }
+    const show_ref &show = current.shows_[reservation.id_];
+
+    /*concurrent booking may publish older count, whoever publishes last reads the count again*/
+    do {
+        free_seats = reservation.get_seats().free_seats_map_.marked();
+        current.availability_.set(reservation.id_, free_seats);
+        show.movie_item_->availability_.set(show.position_, free_seats);
+    } while (reservation.get_seats().free_seats_map_.marked() != free_seats);
+}
+
+/// @brief Convert shows found by availability to the result
+/// @param current [in] catalog
+/// @param entries [in] show handles
+/// @param shows [out] shows with their names and free seats
+void CBooking::get_show_availability
 (
-    CBooker::booker_ptr booker, 
-    theatre_reservation &reservation,
-    const std::set<uint32_t> &seats,
-    std::vector<uint32_t> &unavalable_seats,
-    bool best_effort
+    const catalog &current,
+    const std::vector<uint32_t> &entries,
+    std::vector<show_availability> &shows
 )
 {
-    int32_t rc;
-    bool new_booker;
-    std::set<uint32_t> new_custom_used_seats_set;
-    std::set<uint32_t> *p_custom_used_seats_set;
+    shows.clear();
+    shows.reserve(entries.size());
+    for (uint32_t entry : entries) {
+        const show_ref &show = current.shows_[entry];
 
-    new_booker = false;
-    auto booker_it = reservation.reserved_map_.find(booker->get_booker_uid());
-    if (booker_it == reservation.reserved_map_.end()) {
-        new_booker = true;
-        p_custom_used_seats_set = &new_custom_used_seats_set;
-    }
-    else {
-        p_custom_used_seats_set = &booker_it->second;
-    }
+        if (show.movie_item_ == nullptr)
+            continue;
 
-    rc = book_seats(reservation.free_reservations_set_, *p_custom_used_seats_set, seats, unavalable_seats, best_effort);
-    if (rc < 0) {
-        return rc;
+        shows.push_back(show_availability{std::string(show.movie_), std::string(show.theatre_), entry, current.availability_.get(entry)});
     }
+}
 
-    if (p_custom_used_seats_set->empty()) {
-        return EXIT_SUCCESS;
-    }
+/// @brief get current cinema configuration
+/// @return configuration itself, kept alive by the pointer also after reload
+CBooking::catalog_ptr CBooking::get_configuration(void) const
+{
+    std::lock_guard<std::mutex> lck(m_reload_mutex);
 
-    if (new_booker) {
-        auto it = reservation.reserved_map_.insert(std::pair<std::string, std::set<uint32_t>>(booker->get_booker_uid(), std::move(new_custom_used_seats_set)));
-        if (it.second != true) {
-            return -ENOMEM;
-        }
-    }
+    return m_catalog_owner;
+}
 
-    return rc;
+/// @brief Get version of the catalog, it changes with every load_data
+/// @return catalog version, 0 if nothing is loaded
+uint64_t CBooking::get_catalog_version(void) const
+{
+    CEpoch::reader reader(m_epoch);
+
+    return get_catalog().version_;
 }
 
-/// @brief Book the list of seats
-/// @param free_reservations_set [in] list of free seats
-/// @param custom_reserved_set [in] list of required seats to be booked
-/// @param seats [in] array of booking seats
-/// @param unavalable_seats [out] list of seats, which are already taken.
-///                     But were in our request
-/// @param best_effort [in] true, to skip already booked seats
-/// @return Negative on error, >=0 on success
-int32_t CBooking::book_seats
+/// @brief Copy seats of the theatre, never takes the theatre lock
+///     Copy is consistent with finished bookings, it is retried with backoff if booking ran meanwhile
+/// @param reservation [in] theatre
+/// @param free_words [out] bitmap of free seats
+/// @param owners [out] seat and its owner for all taken seats, in ascending order. Can be nullptr
+/// @return true, if copy is consistent, false if bookings ran during all the retries
+bool CBooking::read_theatre
 (
-    std::set<uint32_t> &free_reservations_set,
-    std::set<uint32_t> &custom_reserved_set,
-    const std::set<uint32_t> &seats,
-    std::vector<uint32_t> &unavalable_seats,
-    bool best_effort
-)
+    const theatre_reservation &reservation,
+    std::vector<CSeatMap::word_t> &free_words,
+    std::vector<std::pair<uint32_t, uint32_t>> *owners
+) const
 {
-    int32_t rc;
-    bool overrange;
-    std::set<uint32_t> new_reserved_seats;
-
-    unavalable_seats.clear();
+    uint64_t ticket;
+    uint32_t capacity;
+
+    capacity = reservation.get_seats().free_seats_map_.capacity();
+
+    for (uint32_t attempt = 0; ; ++attempt) {
+        ticket = reservation.seq_.read_begin();
+
+        /*sentinel can be replaced meanwhile, then the copy is taken again*/
+        const seat_state &seats = reservation.get_seats();
+        seats.free_seats_map_.snapshot(free_words);
+        if (owners != nullptr) {
+            owners->clear();
+            for (std::size_t i = 0; i < free_words.size(); ++i) {
+                CSeatMap::word_t taken = ~free_words[i];
+                while (taken != 0) {
+                    uint32_t seat = static_cast<uint32_t>(i * CSeatMap::m_word_bits) + static_cast<uint32_t>(std::countr_zero(taken));
+                    taken &= taken - 1;
+                    if (seat >= capacity)
+                        break;
+
+                    owners->emplace_back(seat, seats.owners_[seat].load(std::memory_order_relaxed));
+                }
+            }
+        }
 
-    rc = EXIT_SUCCESS;
-    overrange = false;
-    for (uint32_t seat : seats) {
-        if (seat >= m_max_seats_capacity) {
-            overrange = true;
-            rc = -ERANGE;
-            break;
+        if (reservation.seq_.read_valid(ticket)) {
+            return true;
+        }
+        if (attempt >= m_read_retries) {
+            return false;
         }
 
-        auto free_seat_it = free_reservations_set.find(seat);
-        if (free_seat_it == free_reservations_set.end()) {
-            /*OK, seat is already book, is ours?*/
-            auto reserved_seat_it = custom_reserved_set.find(seat);
-            if (reserved_seat_it == custom_reserved_set.end()) {
-                /*no it is not*/
-                unavalable_seats.push_back(seat);
-            }
+        /*bookings keep on running, reader backs off to let them finish*/
+        if (attempt < m_read_spins) {
+            std::this_thread::yield();
         }
         else {
-            auto it = new_reserved_seats.insert(seat);
-            if (it.second != true) {
-                return -ENOMEM;
-            }
-            free_reservations_set.erase(free_seat_it);
+            std::this_thread::sleep_for(std::chrono::microseconds(1u << std::min(attempt - m_read_spins, m_read_backoff_shift)));
         }
     }
+}
 
-    if (((unavalable_seats.empty() != true)&&(best_effort == false))||(overrange)) {
-        /*we failed to book all the required seats*/
-        for (uint32_t seat : new_reserved_seats) {
-            auto it = free_reservations_set.insert(seat);
-            if (it.second != true) {
-                return -ENOMEM;
-            }
-        }
-        return rc;
+/// @brief Get printable name of the booker
+/// @param booker_id [in] booker id
+/// @return booker uid, or id if booker is not active anymore
+std::string CBooking::get_booker_name (uint32_t booker_id) const
+{
+    CBooker::booker_ptr booker = m_bookers.find(booker_id);
+
+    if ((booker == nullptr)||(booker->get_booker_uid().empty())) {
+        return "#" + std::to_string(booker_id);
     }
 
-    custom_reserved_set.insert(new_reserved_seats.begin(), new_reserved_seats.end());
-    return static_cast<int32_t>(custom_reserved_set.size());
+    return booker->get_booker_uid();
 }
 
-/// @brief Release already taken seats
-/// @param booker [in] booker uid
-/// @param movie [in] movie, which gets booked
-/// @param theatre [in] theatre where movie is played
-/// @param seats [in] array of booking seats
-/// @param invalid_seats [out] list of seats, which are not tkaen taken by us
-/// @return Negative on error, >=0 on success
-int32_t CBooking::unbook_seats 
+/// @brief Get the number of seats in theatre
+/// @param movie [in] movie
+/// @param theatre [in] theatre
+/// @return Negative on error, number of seats on success
+int32_t CBooking::get_capacity
 (
-    CBooker::booker_ptr booker, 
-    const std::string &movie,
-    const std::string &theatre,
-    const std::set<uint32_t> &seats,
-    std::vector<uint32_t> &invalid_seats
-)
+    std::string_view movie,
+    std::string_view theatre
+) const
 {
-    assert(booker != nullptr);
+    int32_t show;
 
-    auto it_movie = m_movies_map.find(movie);
-    if (it_movie == m_movies_map.end()) {
-        return -EEXIST;
+    show = find_show(movie, theatre);
+    if (show < EXIT_SUCCESS) {
+        return show;
     }
 
-    std::lock_guard<std::mutex> lck(it_movie->second->mutex_);
-
-    return unbook_seats(booker, it_movie->second.get(), theatre, seats, invalid_seats);    
+    return get_capacity(static_cast<uint32_t>(show));
 }
 
-/// @brief Release already taken seats
-/// @param booker [in] booker uid
-/// @param p_movie [in] ptr to movie
-/// @param theatre [in] theatre where movie is played
-/// @param seats [in] array of booking seats
-/// @param invalid_seats [out] list of seats, which are not tkaen taken by us
-/// @return Negative on error, >=0 on success
-int32_t CBooking::unbook_seats 
-(
-    CBooker::booker_ptr booker, 
-    movie *p_movie,
-    const std::string &theatre,
-    const std::set<uint32_t> &seats,
-    std::vector<uint32_t> &invalid_seats
-)
+/// @brief Get the number of seats of the show
+/// @param show [in] show handle
+/// @return Negative on error, number of seats on success
+int32_t CBooking::get_capacity (uint32_t show) const
 {
-    assert(p_movie != nullptr);
-    assert(p_movie->mutex_.try_lock() != true);
+    const theatre_reservation *p_reservation;
+
+    CEpoch::reader reader(m_epoch);
 
-    auto it_theatre = p_movie->theatre_reservations_map_.find(theatre);
-    if (it_theatre == p_movie->theatre_reservations_map_.end()) {
+    p_reservation = find_theatre(show);
+    if (p_reservation == nullptr) {
         return -EEXIST;
     }
 
-    return unbook_seats(booker, it_theatre->second, seats, invalid_seats);
+    return static_cast<int32_t>(p_reservation->get_seats().free_seats_map_.capacity());
 }
 
-/// @brief Release already taken seats
-/// @param booker [in] booker uid
-/// @param reservation [in] ptr to reservation ctx
-/// @param seats [in] array of booking seats
-/// @param invalid_seats [out] list of seats, which are not tkaen taken by us
+/// @brief Get the seat layout of the theatre
+/// @param movie [in] movie
+/// @param theatre [in] theatre
+/// @param layout [out] list of rows
 /// @return Negative on error, >=0 on success
-int32_t CBooking::unbook_seats 
+int32_t CBooking::get_layout
 (
-    CBooker::booker_ptr booker, 
-    theatre_reservation &reservation,
-    const std::set<uint32_t> &seats,
-    std::vector<uint32_t> &invalid_seats
-)
+    std::string_view movie,
+    std::string_view theatre,
+    std::vector<seat_row> &layout
+) const
 {
-    int32_t rc;
-
-    invalid_seats.clear();
-    auto booker_it = reservation.reserved_map_.find(booker->get_booker_uid());
-    if (booker_it == reservation.reserved_map_.end()) {
-        for (uint32_t seat : seats) {
-            invalid_seats.push_back(seat);
-        }
-        return static_cast<int32_t>(invalid_seats.size());
-    }
+    const theatre_reservation *p_reservation;
 
-    for (uint32_t seat : seats) {
-        if (seat >= m_max_seats_capacity)
-            return -ERANGE;
-    }
+    layout.clear();
 
-    rc = 0;
-    for (uint32_t seat : seats) {
-        auto custom_reservation_it = booker_it->second.find(seat);
-        if (custom_reservation_it != booker_it->second.end()) {
-            rc++;
-            auto it = reservation.free_reservations_set_.insert(seat);
-            if (it.second != true) {
-                return -ENOMEM;
-            }
-            booker_it->second.erase(custom_reservation_it);
-        }
-        else {
-            invalid_seats.push_back(seat);
-        }
-    }
+    CEpoch::reader reader(m_epoch);
 
-    if (booker_it->second.empty()) {
-        reservation.reserved_map_.erase(booker_it);
+    p_reservation = find_theatre(movie, theatre);
+    if (p_reservation == nullptr) {
+        return -EEXIST;
     }
 
-    return rc;
+    layout = p_reservation->layout_;
+    return static_cast<int32_t>(layout.size());
 }
 
-/// @brief Get the list of free seats
-/// @param booker [in] booker uid
+/// @brief Get rendered response about the theatre, shared by all the sessions
+///     Response is rendered again only after seats of the theatre changed
 /// @param movie [in] movie
 /// @param theatre [in] theatre
-/// @param free_seats [out] list of free seats
+/// @param color [in] true, if response is colored
+/// @param render [in] function, which renders the response
+/// @param response [out] rendered response
 /// @return Negative on error, >=0 on success
-int32_t CBooking::get_free_seats (
-    const std::string &movie,
-    const std::string &theatre,
-    std::set<uint32_t> &free_seats
+int32_t CBooking::get_theatre_response
+(
+    std::string_view movie,
+    std::string_view theatre,
+    bool color,
+    const CResponseCache::render_t &render,
+    CResponseCache::response_ptr &response
 )
 {
-    auto it_movie = m_movies_map.find(movie);
-    if (it_movie == m_movies_map.end()) {
-        return -EEXIST;
+    int32_t show;
+
+    show = find_show(movie, theatre);
+    if (show < EXIT_SUCCESS) {
+        return show;
     }
 
-    std::lock_guard<std::mutex> lck(it_movie->second->mutex_);
+    return get_theatre_response(static_cast<uint32_t>(show), color, render, response);
+}
 
-    auto it_theatre = it_movie->second->theatre_reservations_map_.find(theatre);
-    if (it_theatre == it_movie->second->theatre_reservations_map_.end()) {
+/// @brief Get rendered response about the show, shared by all the sessions
+///     Response is rendered again only after seats of the theatre changed
+/// @param show [in] show handle
+/// @param color [in] true, if response is colored
+/// @param render [in] function, which renders the response
+/// @param response [out] rendered response
+/// @return Negative on error, >=0 on success
+int32_t CBooking::get_theatre_response
+(
+    uint32_t show,
+    bool color,
+    const CResponseCache::render_t &render,
+    CResponseCache::response_ptr &response
+)
+{
+    const theatre_reservation *p_reservation;
+
+    CEpoch::reader reader(m_epoch);
+
+    p_reservation = find_theatre(show);
+    if (p_reservation == nullptr) {
         return -EEXIST;
     }
 
-    free_seats = it_theatre->second.free_reservations_set_;
-    return EXIT_SUCCESS;
+    /*version is taken before rendering, so response is never older than it*/
+    return get_response(p_reservation->id_, color, p_reservation->seq_.version(), render, response);
 }
 
-/// @brief Get the list of booked seats per booker
-/// @param booker [in] booker uid
-/// @param movie [in] movie
-/// @param theatre [in] theatre where movie is played
-/// @param seats [out] array of booked seats
+/// @brief Get rendered response about all the theatres, shared by all the sessions
+///     Response is rendered again only after any seat or booker changed
+/// @param color [in] true, if response is colored
+/// @param render [in] function, which renders the response
+/// @param response [out] rendered response
 /// @return Negative on error, >=0 on success
-int32_t CBooking::get_booked_seats 
+int32_t CBooking::get_status_response
 (
-    CBooker::booker_ptr booker, 
-    const std::string &movie,
-    const std::string &theatre,
-    std::set<uint32_t> &seats
+    bool color,
+    const CResponseCache::render_t &render,
+    CResponseCache::response_ptr &response
 )
 {
-    seats.clear();
+    uint64_t version;
 
-    auto it_movie = m_movies_map.find(movie);
-    if (it_movie == m_movies_map.end()) {
-        return -EEXIST;
-    }
+    CEpoch::reader reader(m_epoch);
+    const catalog &current = get_catalog();
 
-    std::lock_guard<std::mutex> lck(it_movie->second->mutex_);
+    /*every change of any theatre is counted, so the sum changes with any of them.
+      Reload drops theatres without a change, so it changes the top bits*/
+    version = m_bookers.version() + m_mutations.load(std::memory_order_acquire) + (current.version_ << m_status_catalog_shift);
 
-    auto it_theatre = it_movie->second->theatre_reservations_map_.find(theatre);
-    if (it_theatre == it_movie->second->theatre_reservations_map_.end()) {
-        return -EEXIST;
-    }
+    return get_response(m_status_response_id, color, version, render, response);
+}
 
-    auto booker_it = it_theatre->second.reserved_map_.find(booker->get_booker_uid());
-    if (booker_it == it_theatre->second.reserved_map_.end()) {
-        return EXIT_SUCCESS;
+/// @brief Get rendered response from the cache, failed rendering is reported as error
+/// @param id [in] id of the rendered object
+/// @param color [in] true, if response is colored
+/// @param version [in] version of the object
+/// @param render [in] function, which renders the response
+/// @param response [out] rendered response
+/// @return Negative on error, >=0 on success
+int32_t CBooking::get_response
+(
+    uint32_t id,
+    bool color,
+    uint64_t version,
+    const CResponseCache::render_t &render,
+    CResponseCache::response_ptr &response
+)
+{
+    /*rendering, ours or the one we waited for, may have thrown*/
+    try {
+        response = m_responses.get(id, color, version, render);
+    }
+    catch (const std::system_error &e) {
+        return (e.code().value() > 0) ? -e.code().value() : -EIO;
+    }
+    catch (const std::bad_alloc &) {
+        return -ENOMEM;
+    }
+    catch (...) {
+        return -EIO;
     }
 
-    seats = booker_it->second;
-    return static_cast<int32_t>(seats.size());
+    return EXIT_SUCCESS;
 }
 
 /// @brief Show current status within movies within theatres
@@ -477,24 +3768,51 @@ int32_t CBooking::get_booked_seats
 void CBooking::dump_status (std::string &buffer) const
 {
     std::string tmp_buffer;
+    std::string booker_name;
+    std::vector<uint32_t> tmp_seats;
+    std::vector<CSeatMap::word_t> free_words;
+    std::vector<std::pair<uint32_t, uint32_t>> owners;
+    std::map<uint32_t, std::set<uint32_t>> reserved_map;
     const char ch_offset[] = "   ";
 
-    for (auto it = m_movies_map.begin(); it != m_movies_map.end(); ++it) {
-        buffer += "Movie: " + it->first;
-        buffer += "\n";
+    CEpoch::reader reader(m_epoch);
+    const catalog &current = get_catalog();
 
-        std::lock_guard<std::mutex> lck(it->second->mutex_);
+    for (auto it = current.movies_map_.begin(); it != current.movies_map_.end(); ++it) {
+        buffer += "Movie: " + std::string(it->first);
+        buffer += "\n";
 
         for (auto it2 = it->second->theatre_reservations_map_.begin(); it2 != it->second->theatre_reservations_map_.end(); ++it2) {
+            const theatre_reservation &reservation = *it2->second;
+
+            /*copy is taken without theatre lock, bookings are not stalled by status*/
+            bool consistent = read_theatre(reservation, free_words, &owners);
+
+            buffer += ch_offset;
+            buffer += "Theater: " + std::string(it2->first);
+            buffer += "\n";
+
+            if (consistent != true) {
+                buffer += ch_offset;
+                buffer += "  ";
+                buffer += "Busy, seats are being booked";
+                buffer += "\n";
+                continue;
+            }
+
             buffer += ch_offset;
-            buffer += "Theater: " + it2->first;
+            buffer += "  ";
+            buffer += "Capacity: ";
+            buffer += std::to_string(reservation.get_seats().free_seats_map_.capacity());
             buffer += "\n";
 
             buffer += ch_offset;
             buffer += "  ";
             buffer += "Free seats: ";
             tmp_buffer.clear();
-            seats_to_string(tmp_buffer, it2->second.free_reservations_set_);
+            tmp_seats.clear();
+            CSeatMap::kernel_extract(free_words.data(), free_words.size(), 0, tmp_seats);
+            seats_to_string(tmp_buffer, tmp_seats);
             buffer += std::move(tmp_buffer);
             buffer += "\n";
 
@@ -503,12 +3821,20 @@ void CBooking::dump_status (std::string &buffer) const
             buffer += "Allocated seats: ";
             buffer += "\n";
 
-            for (auto it3 = it2->second.reserved_map_.begin(); it3 != it2->second.reserved_map_.end(); ++it3) {
+            /*group taken seats by their owners*/
+            reserved_map.clear();
+            for (auto &owner : owners) {
+                if (owner.second != 0)
+                    reserved_map[owner.second].insert(owner.first);
+            }
+
+            for (auto it3 = reserved_map.begin(); it3 != reserved_map.end(); ++it3) {
+                booker_name = get_booker_name(it3->first);
                 buffer += ch_offset;
                 buffer += ch_offset;
-                buffer += it3->first;
+                buffer += booker_name;
 
-                std::size_t size = it3->first.size();
+                std::size_t size = booker_name.size();
                 if (size > 20)
                     size = 0;
                 else
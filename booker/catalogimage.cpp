@@ -0,0 +1,467 @@
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "catalogimage.h"
+
+
+/// @brief Standard destructor, unmaps the file
+CCatalogImage::~CCatalogImage()
+{
+    close();
+}
+
+/// @brief Compile movies to image file
+/// @param path [in] image file, replaced atomically
+/// @param movies [in] movies, handles of their shows must be 0 .. number of shows - 1 in order
+/// @return Negative on error, -EINVAL if handles are not in order or names repeat, size of the file on success
+int32_t CCatalogImage::save(const std::string &path, const std::vector<movie> &movies)
+{
+    int fd;
+    int32_t rc;
+    header head;
+    std::string names;
+    std::string buffer;
+    std::string temp_path;
+    std::vector<movie_entry> movie_table;
+    std::vector<show_entry> show_table;
+    std::vector<row_entry> row_table;
+    std::vector<theatre_entry> theatre_table;
+    std::vector<uint32_t> theatre_shows;
+    std::vector<catalog_slot> show_slots;
+    std::unordered_map<std::string_view, name_ref> interned;
+    CCatalog<uint32_t, std::string_view> movie_index;
+    CCatalog<std::vector<uint32_t>, std::string_view> theatre_index;
+
+    /*every name is stored once, e.g. theatre playing many movies*/
+    auto intern = [&names, &interned](std::string_view name) -> name_ref
+    {
+        auto it = interned.find(name);
+        if (it != interned.end()) {
+            return it->second;
+        }
+
+        name_ref ref = {static_cast<uint32_t>(names.size()), static_cast<uint32_t>(name.size())};
+        names.append(name);
+        interned.emplace(name, ref);
+        return ref;
+    };
+
+    /*hash tables are built the same as CCatalog builds them, catalog attaches them on load*/
+    for (const movie &movie_item : movies) {
+        CCatalog<uint32_t, std::string_view> show_index;
+
+        if (movie_index.insert(movie_item.movie_, static_cast<uint32_t>(movie_table.size())).second != true) {
+            return -EINVAL;
+        }
+        movie_table.push_back(movie_entry{intern(movie_item.movie_), static_cast<uint32_t>(show_table.size()), static_cast<uint32_t>(movie_item.shows_.size()), 0, 0});
+
+        for (const show &show_item : movie_item.shows_) {
+            if ((show_item.handle_ != show_table.size())||(show_item.capacity_ == 0)) {
+                return -EINVAL;
+            }
+            if (show_index.insert(show_item.theatre_, static_cast<uint32_t>(show_index.size())).second != true) {
+                return -EINVAL;
+            }
+            theatre_index.insert(show_item.theatre_, std::vector<uint32_t>()).first->second.push_back(show_item.handle_);
+
+            show_table.push_back(show_entry{intern(show_item.theatre_), show_item.handle_, show_item.capacity_,
+                static_cast<uint32_t>(row_table.size()), static_cast<uint32_t>(show_item.layout_.size())});
+
+            for (const row &row_item : show_item.layout_) {
+                row_table.push_back(row_entry{intern(row_item.section_), intern(row_item.row_), row_item.first_seat_, row_item.seats_});
+            }
+        }
+
+        std::span<const catalog_slot> slots = show_index.get_slots();
+        movie_table.back().first_slot_ = static_cast<uint32_t>(show_slots.size());
+        movie_table.back().slots_ = static_cast<uint32_t>(slots.size());
+        show_slots.insert(show_slots.end(), slots.begin(), slots.end());
+
+        if (names.size() > UINT32_MAX) {
+            /*offsets of names are 32 bits*/
+            return -E2BIG;
+        }
+    }
+
+    for (const auto &[theatre_name, handles] : theatre_index) {
+        theatre_table.push_back(theatre_entry{intern(theatre_name), static_cast<uint32_t>(theatre_shows.size()), static_cast<uint32_t>(handles.size())});
+        theatre_shows.insert(theatre_shows.end(), handles.begin(), handles.end());
+    }
+    if (names.size() > UINT32_MAX) {
+        return -E2BIG;
+    }
+
+    std::span<const catalog_slot> movie_slots = movie_index.get_slots();
+    std::span<const catalog_slot> theatre_slots = theatre_index.get_slots();
+
+    std::memset(&head, 0, sizeof(head));
+    std::memcpy(head.magic_, m_magic, sizeof(m_magic));
+    head.version_ = m_version;
+    head.movies_ = static_cast<uint32_t>(movie_table.size());
+    head.shows_ = static_cast<uint32_t>(show_table.size());
+    head.rows_ = static_cast<uint32_t>(row_table.size());
+    head.theatres_ = static_cast<uint32_t>(theatre_table.size());
+    head.movie_slots_ = static_cast<uint32_t>(movie_slots.size());
+    head.show_slots_ = static_cast<uint32_t>(show_slots.size());
+    head.theatre_slots_ = static_cast<uint32_t>(theatre_slots.size());
+    head.names_size_ = names.size();
+    head.size_ = sizeof(header) + (movie_slots.size() + show_slots.size() + theatre_slots.size()) * sizeof(catalog_slot) +
+        movie_table.size() * sizeof(movie_entry) + show_table.size() * sizeof(show_entry) + row_table.size() * sizeof(row_entry) +
+        theatre_table.size() * sizeof(theatre_entry) + theatre_shows.size() * sizeof(uint32_t) + names.size();
+    if (head.size_ > INT32_MAX) {
+        return -E2BIG;
+    }
+
+    /*slots come first, right behind the header, they are the only 8 byte aligned table*/
+    buffer.reserve(head.size_);
+    buffer.append(reinterpret_cast<const char *>(&head), sizeof(head));
+    buffer.append(reinterpret_cast<const char *>(movie_slots.data()), movie_slots.size() * sizeof(catalog_slot));
+    buffer.append(reinterpret_cast<const char *>(show_slots.data()), show_slots.size() * sizeof(catalog_slot));
+    buffer.append(reinterpret_cast<const char *>(theatre_slots.data()), theatre_slots.size() * sizeof(catalog_slot));
+    buffer.append(reinterpret_cast<const char *>(movie_table.data()), movie_table.size() * sizeof(movie_entry));
+    buffer.append(reinterpret_cast<const char *>(show_table.data()), show_table.size() * sizeof(show_entry));
+    buffer.append(reinterpret_cast<const char *>(row_table.data()), row_table.size() * sizeof(row_entry));
+    buffer.append(reinterpret_cast<const char *>(theatre_table.data()), theatre_table.size() * sizeof(theatre_entry));
+    buffer.append(reinterpret_cast<const char *>(theatre_shows.data()), theatre_shows.size() * sizeof(uint32_t));
+    buffer.append(names);
+
+    /*processes, which map the image, see either the previous or the new file, never a partial one*/
+    temp_path = path + ".tmp";
+    fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return -errno;
+    }
+
+    rc = EXIT_SUCCESS;
+    for (std::size_t written = 0; written < buffer.size();) {
+        ssize_t n = ::write(fd, buffer.data() + written, buffer.size() - written);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            rc = -errno;
+            break;
+        }
+        written += static_cast<std::size_t>(n);
+    }
+
+    if ((rc == EXIT_SUCCESS)&&(::fsync(fd) != 0)) {
+        rc = -errno;
+    }
+    ::close(fd);
+
+    if ((rc == EXIT_SUCCESS)&&(::rename(temp_path.c_str(), path.c_str()) != 0)) {
+        rc = -errno;
+    }
+    if (rc < EXIT_SUCCESS) {
+        ::unlink(temp_path.c_str());
+        return rc;
+    }
+
+    return static_cast<int32_t>(buffer.size());
+}
+
+/// @brief Check if the file is catalog image
+/// @param path [in] file
+/// @return true, if file starts with image header
+bool CCatalogImage::is_image(const std::string &path)
+{
+    int fd;
+    ssize_t n;
+    char magic[sizeof(m_magic)];
+
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    n = ::read(fd, magic, sizeof(magic));
+    ::close(fd);
+
+    return (n == static_cast<ssize_t>(sizeof(magic)))&&(std::memcmp(magic, m_magic, sizeof(m_magic)) == 0);
+}
+
+/// @brief Map image file read-only
+/// @param path [in] image file
+/// @return Negative on error, -EBADMSG if file isn't image of this version, number of shows on success
+int32_t CCatalogImage::open(const std::string &path)
+{
+    int fd;
+    uint64_t size;
+    struct stat st;
+
+    if (is_open()) {
+        return -EALREADY;
+    }
+
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -errno;
+    }
+
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return -EIO;
+    }
+    if (static_cast<uint64_t>(st.st_size) < sizeof(header)) {
+        ::close(fd);
+        return -EBADMSG;
+    }
+
+    /*pages are shared with every process, which maps the same image*/
+    void *base = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        return -errno;
+    }
+    m_base = static_cast<const uint8_t *>(base);
+    m_size = static_cast<std::size_t>(st.st_size);
+
+    /*header and the tables looked up before anything is read are checked, other tables are checked as they are read*/
+    const header &head = get_header();
+    size = sizeof(header) + (static_cast<uint64_t>(head.movie_slots_) + head.show_slots_ + head.theatre_slots_) * sizeof(catalog_slot) +
+        static_cast<uint64_t>(head.movies_) * sizeof(movie_entry) + static_cast<uint64_t>(head.shows_) * sizeof(show_entry) +
+        static_cast<uint64_t>(head.rows_) * sizeof(row_entry) + static_cast<uint64_t>(head.theatres_) * sizeof(theatre_entry) +
+        static_cast<uint64_t>(head.shows_) * sizeof(uint32_t) + head.names_size_;
+    if ((std::memcmp(head.magic_, m_magic, sizeof(m_magic)) != 0)||
+        (head.version_ != m_version)||
+        (head.size_ != m_size)||
+        (head.names_size_ > m_size)||
+        (size != m_size)) {
+        close();
+        return -EBADMSG;
+    }
+
+    m_movie_slots = reinterpret_cast<const catalog_slot *>(m_base + sizeof(header));
+    m_show_slots = m_movie_slots + head.movie_slots_;
+    m_theatre_slots = m_show_slots + head.show_slots_;
+    m_movies = reinterpret_cast<const movie_entry *>(m_theatre_slots + head.theatre_slots_);
+    m_shows = reinterpret_cast<const show_entry *>(m_movies + head.movies_);
+    m_rows = reinterpret_cast<const row_entry *>(m_shows + head.shows_);
+    m_theatres = reinterpret_cast<const theatre_entry *>(m_rows + head.rows_);
+    m_theatre_shows = reinterpret_cast<const uint32_t *>(m_theatres + head.theatres_);
+    m_names = reinterpret_cast<const char *>(m_theatre_shows + head.shows_);
+
+    if ((check_slots(get_movie_slots(), head.movies_) != true)||
+        (check_slots(get_theatre_slots(), head.theatres_) != true)) {
+        close();
+        return -EBADMSG;
+    }
+
+    return static_cast<int32_t>(head.shows_);
+}
+
+/// @brief Unmap the file, names of read movies are not valid anymore
+void CCatalogImage::close(void)
+{
+    if (m_base != nullptr) {
+        ::munmap(const_cast<uint8_t *>(m_base), m_size);
+    }
+
+    m_base = nullptr;
+    m_size = 0;
+    m_movie_slots = nullptr;
+    m_show_slots = nullptr;
+    m_theatre_slots = nullptr;
+    m_movies = nullptr;
+    m_shows = nullptr;
+    m_rows = nullptr;
+    m_theatres = nullptr;
+    m_theatre_shows = nullptr;
+    m_names = nullptr;
+}
+
+/// @brief Get number of movies
+/// @return number of movies
+uint32_t CCatalogImage::get_movies(void) const
+{
+    return (is_open()) ? get_header().movies_ : 0;
+}
+
+/// @brief Get number of shows
+/// @return number of shows
+uint32_t CCatalogImage::get_shows(void) const
+{
+    return (is_open()) ? get_header().shows_ : 0;
+}
+
+/// @brief Get number of theatres
+/// @return number of theatres
+uint32_t CCatalogImage::get_theatres(void) const
+{
+    return (is_open()) ? get_header().theatres_ : 0;
+}
+
+/// @brief Get hash table of movie names, entries are indexes of movies
+/// @return slots of the table, empty if nothing is mapped
+std::span<const catalog_slot> CCatalogImage::get_movie_slots(void) const
+{
+    return (is_open()) ? std::span<const catalog_slot>(m_movie_slots, get_header().movie_slots_) : std::span<const catalog_slot>();
+}
+
+/// @brief Get hash table of theatre names, entries are indexes of theatres
+/// @return slots of the table, empty if nothing is mapped
+std::span<const catalog_slot> CCatalogImage::get_theatre_slots(void) const
+{
+    return (is_open()) ? std::span<const catalog_slot>(m_theatre_slots, get_header().theatre_slots_) : std::span<const catalog_slot>();
+}
+
+/// @brief Get hash table of theatre names of the movie, entries are positions of the shows within the movie
+/// @param index [in] index of the movie
+/// @param slots [out] slots of the table
+/// @return Negative on error, -EBADMSG if the table is damaged, >=0 on success
+int32_t CCatalogImage::get_show_slots(uint32_t index, std::span<const catalog_slot> &slots) const
+{
+    if (is_open() != true) {
+        return -EBADF;
+    }
+
+    const header &head = get_header();
+    if (index >= head.movies_) {
+        return -ERANGE;
+    }
+
+    const movie_entry &movie_item = m_movies[index];
+    if (static_cast<uint64_t>(movie_item.first_slot_) + movie_item.slots_ > head.show_slots_) {
+        return -EBADMSG;
+    }
+
+    slots = std::span<const catalog_slot>(m_show_slots + movie_item.first_slot_, movie_item.slots_);
+    if (check_slots(slots, movie_item.shows_) != true) {
+        return -EBADMSG;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/// @brief Check hash table, every entry is in a slot once and some slots are empty
+/// @param slots [in] slots of the table
+/// @param entries [in] number of entries
+/// @return true, if lookup within the table is safe
+bool CCatalogImage::check_slots(std::span<const catalog_slot> slots, uint32_t entries)
+{
+    uint32_t used = 0;
+    std::vector<bool> seen(entries, false);
+
+    /*lookup probes until it finds the name or an empty slot*/
+    if ((slots.size() <= entries)||((slots.size() & (slots.size() - 1)) != 0)) {
+        return false;
+    }
+
+    for (const catalog_slot &item : slots) {
+        if (item.index_ == 0)
+            continue;
+
+        if ((item.index_ > entries)||(seen[item.index_ - 1])) {
+            return false;
+        }
+        seen[item.index_ - 1] = true;
+        used++;
+    }
+
+    return used == entries;
+}
+
+/// @brief Get name from the pool
+/// @param ref [in] name within the pool
+/// @param name [out] name
+/// @return false, if name is out of the pool
+bool CCatalogImage::get_name(const name_ref &ref, std::string_view &name) const
+{
+    if (static_cast<uint64_t>(ref.offset_) + ref.size_ > get_header().names_size_) {
+        return false;
+    }
+
+    name = std::string_view(m_names + ref.offset_, ref.size_);
+    return true;
+}
+
+/// @brief Read movie, names point to the mapped file
+/// @param index [in] index of the movie
+/// @param item [out] movie and its shows
+/// @return Negative on error, -EBADMSG if tables are damaged, >=0 on success
+int32_t CCatalogImage::get_movie(uint32_t index, movie &item) const
+{
+    if (is_open() != true) {
+        return -EBADF;
+    }
+
+    const header &head = get_header();
+    if (index >= head.movies_) {
+        return -ERANGE;
+    }
+
+    const movie_entry &movie_item = m_movies[index];
+    if ((get_name(movie_item.name_, item.movie_) != true)||
+        (static_cast<uint64_t>(movie_item.first_show_) + movie_item.shows_ > head.shows_)) {
+        return -EBADMSG;
+    }
+
+    item.shows_.resize(movie_item.shows_);
+    for (uint32_t i = 0; i < movie_item.shows_; ++i) {
+        const show_entry &show_item = m_shows[movie_item.first_show_ + i];
+        show &new_show = item.shows_[i];
+
+        if ((get_name(show_item.name_, new_show.theatre_) != true)||
+            (show_item.handle_ != movie_item.first_show_ + i)||
+            (show_item.capacity_ == 0)||
+            (static_cast<uint64_t>(show_item.first_row_) + show_item.rows_ > head.rows_)) {
+            return -EBADMSG;
+        }
+        new_show.handle_ = show_item.handle_;
+        new_show.capacity_ = show_item.capacity_;
+
+        new_show.layout_.resize(show_item.rows_);
+        for (uint32_t j = 0; j < show_item.rows_; ++j) {
+            const row_entry &row_item = m_rows[show_item.first_row_ + j];
+            row &new_row = new_show.layout_[j];
+
+            if ((get_name(row_item.section_, new_row.section_) != true)||
+                (get_name(row_item.row_, new_row.row_) != true)) {
+                return -EBADMSG;
+            }
+            new_row.first_seat_ = row_item.first_seat_;
+            new_row.seats_ = row_item.seats_;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+
+/// @brief Read theatre, name and handles point to the mapped file
+/// @param index [in] index of the theatre
+/// @param item [out] theatre and its shows
+/// @return Negative on error, -EBADMSG if tables are damaged, >=0 on success
+int32_t CCatalogImage::get_theatre(uint32_t index, theatre &item) const
+{
+    if (is_open() != true) {
+        return -EBADF;
+    }
+
+    const header &head = get_header();
+    if (index >= head.theatres_) {
+        return -ERANGE;
+    }
+
+    const theatre_entry &theatre_item = m_theatres[index];
+    if ((get_name(theatre_item.name_, item.theatre_) != true)||
+        (static_cast<uint64_t>(theatre_item.first_show_) + theatre_item.shows_ > head.shows_)) {
+        return -EBADMSG;
+    }
+
+    item.shows_ = std::span<const uint32_t>(m_theatre_shows + theatre_item.first_show_, theatre_item.shows_);
+    for (uint32_t handle : item.shows_) {
+        if (handle >= head.shows_) {
+            return -EBADMSG;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,56 @@
+#include <thread>
+#include <functional>
+
+#include "epoch.h"
+
+
+/// @brief Announce current epoch in a free slot
+/// @return claimed slot
+std::atomic<uint64_t> *CEpoch::enter(void) const
+{
+    uint64_t expected;
+    uint64_t current;
+    std::size_t first;
+
+    /*threads start at different slots, so they rarely compete for the same one*/
+    first = std::hash<std::thread::id>()(std::this_thread::get_id());
+
+    for (std::size_t i = 0; ; ++i) {
+        slot &item = m_slots[(first + i) % m_slots_count];
+
+        if (item.epoch_.load(std::memory_order_relaxed) == 0) {
+            /*announced epoch can be already old, then the writer only waits longer*/
+            expected = 0;
+            current = m_epoch.load(std::memory_order_seq_cst);
+            if (item.epoch_.compare_exchange_strong(expected, current, std::memory_order_seq_cst)) {
+                return &item.epoch_;
+            }
+        }
+
+        if ((i + 1) % m_slots_count == 0) {
+            /*all the slots are taken*/
+            std::this_thread::yield();
+        }
+    }
+}
+
+/// @brief Wait, until all the readers, which started before the call, are gone
+///     Data unpublished before the call can be freed afterwards
+void CEpoch::synchronize(void)
+{
+    uint64_t target;
+    uint64_t announced;
+
+    /*readers, which announce the new epoch, load the pointer after it was swapped*/
+    target = m_epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+
+    for (slot &item : m_slots) {
+        for (;;) {
+            announced = item.epoch_.load(std::memory_order_seq_cst);
+            if ((announced == 0)||(announced >= target))
+                break;
+
+            std::this_thread::yield();
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+/*! \brief CAvailability class.
+ *         Maximum tree of free seats, answers availability queries without seat maps
+ *
+ *  Every entry (show) is a leaf of a complete binary tree and every inner node
+ *  keeps the maximum of its children, so the root is the largest value. Shows
+ *  with at least n free seats are found by visiting only subtrees, which
+ *  have such a show, and the k largest shows by best-first walk from the root,
+ *  both in O(log n) per reported show. Values are set concurrently without
+ *  lock: writer refreshes ancestors of the leaf and checks each of them once
+ *  more after writing it, so the last writer of every node leaves it matching
+ *  its children. Readers may see a value, which is just being changed.
+ */
+class CAvailability
+{
+public:
+    /// @brief Standard constructor, empty tree
+    CAvailability() = default;
+
+    CAvailability(const CAvailability &) = delete;
+    CAvailability &operator=(const CAvailability &) = delete;
+
+    /// @brief Size the tree, all the values are 0
+    ///     Tree must not be used concurrently while resizing
+    /// @param size [in] number of entries
+    void resize(uint32_t size);
+
+    /// @brief Get number of entries
+    /// @return number of entries
+    uint32_t size(void) const {return m_size;};
+
+    /// @brief Set value of the entry and refresh its ancestors
+    /// @param index [in] index of the entry
+    /// @param value [in] new value
+    void set(uint32_t index, uint32_t value);
+
+    /// @brief Get value of the entry
+    /// @param index [in] index of the entry
+    /// @return value, 0 if entry doesn't exist
+    uint32_t get(uint32_t index) const;
+
+    /// @brief Get the largest value
+    /// @return the largest value, 0 if tree is empty
+    uint32_t get_max(void) const {return (m_size == 0) ? 0 : m_nodes[1].load(std::memory_order_acquire);};
+
+    /// @brief Find entries with value at least n
+    /// @param n [in] minimal value, at least 1
+    /// @param entries [out] indexes of the entries, in ascending order
+    void find_at_least(uint32_t n, std::vector<uint32_t> &entries) const;
+
+    /// @brief Find entries with the largest values, entries with value 0 are not reported
+    /// @param k [in] maximal number of entries
+    /// @param entries [out] indexes of the entries, from the largest value, equal values in ascending order
+    void find_top(uint32_t k, std::vector<uint32_t> &entries) const;
+
+private:
+    /// @brief Get the larger value of node children
+    /// @param node [in] inner node
+    /// @return maximum of the children
+    uint32_t children_max(std::size_t node) const
+    {
+        return std::max(m_nodes[2 * node].load(std::memory_order_acquire), m_nodes[2 * node + 1].load(std::memory_order_acquire));
+    };
+
+private:
+    uint32_t m_size = 0; /*!< number of entries */
+    std::size_t m_leaves = 0; /*!< number of leaves, power of two, leaves follow inner nodes */
+    std::unique_ptr<std::atomic<uint32_t>[]> m_nodes; /*!< node 1 is the root, children of node i are 2i and 2i+1 */
+};
@@ -1,18 +1,33 @@
 #pragma once
 
+#include <set>
+#include <map>
+#include <mutex>
+#include <vector>
 #include <memory>
+#include <string>
+#include <cstdint>
 
 
 /*! \brief CBooker class.
  *         Simple class to hold booker or session ID
  *
+ *  Booking refers to bookers by a compact integer handle only,
+ *  the uid string is kept here once for printing purposes.
+ *  Booker also keeps reverse index of its seats per theatre, so everything
+ *  it holds can be found without walking the catalog.
+ *
  */
 class CBooker
 {
 public:
     using booker_ptr = std::shared_ptr<CBooker>;
+    using holdings_t = std::map<uint32_t, std::set<uint32_t>>; /*!< theatre id -> owned seats */
 
 public:
+    /// @brief Standard constructor
+    CBooker() {};
+
     /// @brief Standard destructor
     virtual ~CBooker() {};
 
@@ -23,8 +38,47 @@ public:
     /// @param [in] booker uid
     void set_uid(const std::string &uid) {m_uid = uid;};
 
-private:
-    std::string m_uid;
-};
+    /// @brief get the booker handle, used to mark owned seats
+    /// @return handle assigned by booking, 0 if booker has not joined
+    uint32_t get_booker_id(void) const {return m_id;};
+
+    /// @brief set the booker handle
+    /// @param id [in] handle assigned by booking
+    void set_booker_id(uint32_t id) {m_id = id;};
+
+    /// @brief get number of seats owned by the booker, over all theatres
+    /// @return number of owned seats
+    uint32_t get_seats_count(void) const;
+
+    /// @brief get number of seats owned by the booker in theatre
+    /// @param theatre [in] theatre id
+    /// @return number of owned seats
+    uint32_t get_seats_count(uint32_t theatre) const;
 
+    /// @brief get seats owned by the booker in theatre
+    /// @param theatre [in] theatre id
+    /// @param seats [out] owned seats
+    void get_owned_seats(uint32_t theatre, std::set<uint32_t> &seats) const;
 
+    /// @brief get seats owned by the booker in all theatres
+    /// @param holdings [out] owned seats per theatre
+    void get_holdings(holdings_t &holdings) const;
+
+    /// @brief Account newly owned seats
+    /// @param theatre [in] theatre id
+    /// @param seats [in] list of seats
+    void add_seats(uint32_t theatre, const std::vector<uint32_t> &seats);
+
+    /// @brief Account released seats
+    /// @param theatre [in] theatre id
+    /// @param seats [in] list of seats
+    void remove_seats(uint32_t theatre, const std::vector<uint32_t> &seats);
+
+private:
+    std::string m_uid; /*!< printable session id, the only copy of it */
+    uint32_t m_id = 0; /*!< compact handle, assigned when booker joins */
+
+    mutable std::mutex m_mutex; /*!< protects the reverse index */
+    holdings_t m_holdings; /*!< reverse index of owned seats, per theatre */
+    uint32_t m_seats_count = 0; /*!< number of seats owned over all theatres */
+};
@@ -4,7 +4,15 @@
 #include <map>
 #include <string>
 #include <mutex>
+#include <deque>
+#include <istream>
+#include <chrono>
 #include <atomic>
+#include <memory>
+#include <vector>
+#include <span>
+#include <string_view>
+#include <unordered_map>
 
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
@@ -12,6 +20,22 @@
 #include <cli/cli.h>
 
 #include "booker.h"
+#include "seatmap.h"
+#include "epoch.h"
+#include "jsonreader.h"
+#include "catalog.h"
+#include "availability.h"
+#include "catalogimage.h"
+#include "claimgate.h"
+#include "namepool.h"
+#include "runindex.h"
+#include "seqgate.h"
+#include "journal.h"
+#include "registry.h"
+#include "respcache.h"
+#include "seatstore.h"
+#include "snapshot.h"
+#include "timingwheel.h"
 
 
 /*! \brief CBooking class.
@@ -20,50 +44,340 @@
  *  Main class which controls the entire booking functions
  *  Also hold the list of all the movies and list of all the theatres
  *  were each movie is being played.
+ *  Catalog of movies and theatres is immutable, reload publishes a new one
+ *  with atomic pointer swap. Bookings read the catalog within epoch read
+ *  section, so they never wait for reload and old catalog is freed
+ *  only after all of them are gone.
  */
 class CBooking
 {
 public:
+    struct seat_row
+    { /*!< Single row of seats within a theatre */
+        std::string section_; /*!< Section name, can be empty */
+        std::string row_; /*!< Row name */
+        uint32_t first_seat_; /*!< Number of the first seat in the row */
+        uint32_t seats_; /*!< Number of seats in the row */
+
+        bool operator==(const seat_row &) const = default;
+    };
+
+    struct seat_state
+    { /*!< Seats of single theatre */
+        using owner_t = std::atomic<uint32_t>;
+
+        CSeatMap free_seats_map_; /*!< bitmap of free seats, sized to theatre capacity */
+        std::unique_ptr<owner_t[]> owners_storage_; /*!< own owners, empty if they are in seat store */
+        owner_t *owners_ = nullptr; /*!< booker id per seat, 0 if seat is not owned */
+        CRunIndex runs_; /*!< free runs of seats, built and refreshed lazily under theatre mutex */
+        bool shared_ = false; /*!< all free sentinel of theatres nobody changed yet, it never changes */
+    };
+
     struct theatre_reservation
     {
-        using reserved_map_t = std::map<std::string, std::set<uint32_t>>;
+        using owner_t = seat_state::owner_t;
+
+        uint32_t id_ = 0; /*!< compact theatre id, used by reverse indexes of bookers */
+        mutable std::mutex mutex_; /*!< serializes bookings within the theatre */
+        std::vector<seat_row> layout_; /*!< rows of seats, empty if not configured */
+        std::atomic<seat_state *> seats_ = nullptr; /*!< seats, shared all free sentinel until the first change */
+        std::unique_ptr<seat_state> own_seats_; /*!< seats of the theatre, empty while it uses the sentinel */
+        CSeqGate seq_; /*!< every change of seats and owners is written through, readers don't lock */
+        CClaimGate gate_; /*!< lock free changes pass it, holder of mutex_ closes it */
 
-        std::set<uint32_t> free_reservations_set_;
-        reserved_map_t reserved_map_;
+        /// @brief Constructor
+        /// @param mutations [in] counter of changes of all the theatres
+        explicit theatre_reservation(std::atomic<uint64_t> &mutations) : seq_(mutations) {};
+
+        /// @brief Get seats for reading, they are all free while sentinel is used
+        /// @return seats
+        const seat_state &get_seats(void) const {return *seats_.load(std::memory_order_acquire);};
+    };
+
+    /*! \brief Access to seats of the theatre for a change
+     *         Lock free change passes the claim gate. Otherwise, or when the gate is closed,
+     *         the theatre lock is taken and the gate is closed, so the change has
+     *         the seats for itself and it is applied with seat map kernels as a whole
+     */
+    class theatre_access
+    {
+    public:
+        /// @brief Get access to the seats
+        /// @param reservation [in] theatre
+        /// @param lock_free [in] true, to pass the gate without lock, if it is open
+        theatre_access(theatre_reservation &reservation, bool lock_free) :
+            m_gate(reservation.gate_), m_lock(reservation.mutex_, std::defer_lock)
+        {
+            m_passed = ((lock_free)&&(m_gate.enter()));
+            if (m_passed != true) {
+                m_lock.lock();
+                m_gate.close();
+            }
+        };
+
+        /// @brief Release the access
+        ~theatre_access() {release();};
+
+        theatre_access(const theatre_access &) = delete;
+        theatre_access &operator=(const theatre_access &) = delete;
+
+        /// @brief Check if the seats are changed by us only
+        /// @return true, if theatre is locked, false if change passed the gate
+        bool exclusive(void) const {return m_lock.owns_lock();};
+
+        /// @brief Release the access before the object goes away
+        void release(void)
+        {
+            if (m_passed) {
+                m_passed = false;
+                m_gate.leave();
+            }
+            else if (m_lock.owns_lock()) {
+                /*gate is opened before the next lock holder can close it*/
+                m_gate.open();
+                m_lock.unlock();
+            }
+        };
+
+    private:
+        CClaimGate &m_gate;
+        std::unique_lock<std::mutex> m_lock;
+        bool m_passed = false;
+    };
+
+    enum class engine_t
+    { /*!< Booking engine */
+        locked, /*!< every booking takes the theatre lock */
+        lock_free /*!< bookings within few seat words are committed with CAS, without lock */
+    };
+
+    enum class release_policy_t
+    { /*!< What happens with seats of closed session */
+        keep, /*!< seats stay booked */
+        release /*!< seats are released, after grace period */
     };
 
     struct movie
     {
-        using theatres_map_t = std::map<std::string, theatre_reservation>;
+        using theatres_map_t = CCatalog<std::shared_ptr<theatre_reservation>, std::string_view>;
+
+        theatres_map_t theatre_reservations_map_; /*!< immutable after load, unchanged theatres are shared with the next catalog */
+        mutable CAvailability availability_; /*!< free seats of the theatres, in the order of the map */
+    };
+
+    struct show_request
+    { /*!< Seats of single show, booked within batch */
+        std::string_view movie_; /*!< movie, name must outlive the request */
+        std::string_view theatre_; /*!< theatre where movie is played, name must outlive the request */
+        std::set<uint32_t> seats_; /*!< requested seats */
+    };
+
+    struct show_ref
+    { /*!< Show within the catalog, indexed by show handle */
+        std::string_view movie_; /*!< movie name, kept by names of the catalog */
+        std::string_view theatre_; /*!< theatre name, kept by names of the catalog */
+        const movie *movie_item_ = nullptr; /*!< movie, nullptr if show was removed by reload */
+        uint32_t position_ = 0; /*!< position of the theatre within the movie */
+    };
 
-        std::mutex mutex_;
-        theatres_map_t theatre_reservations_map_;
+    struct show_availability
+    { /*!< Show and its free seats */
+        std::string movie_; /*!< movie name */
+        std::string theatre_; /*!< theatre name */
+        uint32_t show_; /*!< show handle */
+        uint32_t free_; /*!< number of free seats */
     };
 
-    using movies_map_t = std::map<std::string, std::unique_ptr<movie>>;
+    using movies_map_t = CCatalog<std::unique_ptr<movie>, std::string_view>;
     using movies_map_it_t = movies_map_t::iterator;
+    using theatres_index_t = CCatalog<std::span<const uint32_t>, std::string_view>;
+
+    struct catalog
+    { /*!< Movies and theatres, immutable once published */
+        std::shared_ptr<const CCatalogImage> image_; /*!< mapped image of image loaded catalog, names and hash tables are used in place, so it is unmapped last */
+        CNamePool names_; /*!< movie and theatre names of catalog built from configuration, maps and index refer to them */
+        movies_map_t movies_map_; /*!< configuration movies & theatres and ocupation */
+        theatres_index_t theatres_index_; /*!< show handles of every theatre, theatre-major view of the movies */
+        std::vector<uint32_t> theatre_shows_; /*!< show handles, which index refers to, unless they are taken from the image */
+        std::vector<theatre_reservation *> theatres_table_; /*!< all the theatres, indexed by theatre id, nullptr if removed by reload */
+        std::vector<show_ref> shows_; /*!< names and movie of every show, indexed by show handle */
+        mutable CAvailability availability_; /*!< free seats of all the shows, indexed by show handle */
+        uint64_t version_ = 0; /*!< number of loads, which built this catalog */
+    };
+
+    using catalog_ptr = std::shared_ptr<const catalog>;
 
 public:
     /// @brief Standard constructor
     CBooking();
 
-    /// @brief Load dynamic configuration
+    /// @brief Select booking engine. Must be selected before sessions are started
+    /// @param engine [in] booking engine
+    void set_engine(engine_t engine) {m_engine = engine;};
+
+    /// @brief Get selected booking engine
+    /// @return booking engine
+    engine_t get_engine(void) const {return m_engine;};
+
+    /// @brief Select what happens with seats of closed sessions
+    /// @param policy [in] release policy
+    /// @param grace [in] how long seats are kept after session is closed
+    void set_release_policy(release_policy_t policy, std::chrono::seconds grace = std::chrono::seconds(0)) {m_release_policy = policy; m_release_grace = grace;};
+
+    /// @brief Get selected release policy
+    /// @return release policy
+    release_policy_t get_release_policy(void) const {return m_release_policy;};
+
+    /// @brief Release seats of closed sessions, which grace period is over
+    /// @param now [in] current time
+    /// @return number of released seats
+    uint32_t release_departed(std::chrono::steady_clock::time_point now);
+
+    /// @brief Load dynamic configuration, or replace loaded one while bookings keep on running
+    ///     Theatre with the same movie, name, capacity and layout keeps its seats and show handle.
+    ///     Seats and holds of removed theatres are dropped, new theatres get new handles
     /// @param pt [in] configuration tree
     /// @return Negative on error, >=0 on success
     int32_t load_data(const boost::property_tree::ptree &pt);
 
-    /// @brief Join new session as booker
-    /// @param booker [in] new bookr
+    /// @brief Load dynamic configuration from JSON document, or replace loaded one.
+    ///     Document is parsed as it is read, theatres are built without configuration tree
+    /// @param stream [in] configuration document
+    /// @return Negative on error, >=0 on success
+    int32_t load_data(std::istream &stream);
+
+    /// @brief Load dynamic configuration from JSON file, or from all the *.json shards of the directory.
+    ///     Shards are parsed in parallel, then merged in the order of file names,
+    ///     so handles don't depend on the number of threads. Movie can be listed in several shards
+    /// @param path [in] catalog file or directory of shards
+    /// @param threads [in] number of parser threads, 0 or 1 parses in the calling thread
+    /// @return Negative on error, -ENOENT if there is no catalog, number of loaded shards on success
+    int32_t load_files(const std::string &path, uint32_t threads);
+
+    /// @brief Load dynamic configuration from compiled catalog image, or replace loaded one.
+    ///     Image loaded into empty booking gives shows the handles stored in the image.
+    ///     Image stays mapped as long as the catalog lives, names and hash tables are used in place
+    /// @param path [in] image file
+    /// @return Negative on error, -EBADMSG if image is damaged, number of shows on success
+    int32_t load_image(const std::string &path);
+
+    /// @brief Compile current catalog to image, which is loaded without JSON parsing
+    /// @param path [in] image file, replaced atomically
+    /// @return Negative on error, -EINVAL if reload left handles out of order, size of the file on success
+    int32_t save_image(const std::string &path) const;
+
+    /// @brief Get version of the catalog, it changes with every load_data
+    /// @return catalog version, 0 if nothing is loaded
+    uint64_t get_catalog_version(void) const;
+
+    /// @brief Keep seats in memory mapped file, must be called after load_data and before anything is booked
+    ///     Seats of cleanly closed file are restored at once, otherwise all the seats are free.
+    ///     Restored seats are owned by bookers of the previous run, they have no session anymore
+    /// @param path [in] seat store file
+    /// @return Negative on error, -EBUSY if catalog was reloaded, 0 if seats were rebuilt, 1 if seats were restored
+    int32_t open_seat_store(const std::string &path);
+
+    /// @brief Release held seats, close the journal and mark seat store clean
+    ///     Seats are copied back to memory, nothing must be booked meanwhile
     /// @return Negative on error, >=0 on success
+    int32_t close_seat_store(void);
+
+    /// @brief Write point-in-time image of all the seats, bookings keep on running meanwhile
+    ///     Every theatre is copied without its lock, copy is taken again if batch booking ran meanwhile
+    /// @param path [in] snapshot file, replaced atomically
+    /// @return Negative on error, -EBUSY if no consistent copy was taken, size of the snapshot on success
+    int32_t save_snapshot(const std::string &path) const;
+
+    /// @brief Restore seats from snapshot, must be called after load_data and before anything is booked
+    ///     Theatres are matched by names, theatres with other capacity or not in the catalog are skipped.
+    ///     Restored seats are owned by bookers of the previous run, they have no session anymore.
+    ///     Journal is not replayed on top of the snapshot
+    /// @param path [in] snapshot file
+    /// @return Negative on error, -ESTALE if no theatre of the snapshot fits the catalog, number of restored theatres on success
+    int32_t load_snapshot(const std::string &path);
+
+    /// @brief Replay journal on top of loaded configuration and journal all the changes since then
+    ///     If seats were restored from seat store, only the records behind them are replayed
+    ///     Bookers of the journal have no session anymore, they leave as closed sessions
+    /// @param path [in] journal file
+    /// @param durability [in] when the booking is on disk
+    /// @return Negative on error, -EBUSY if catalog was reloaded, number of replayed records on success
+    int32_t open_journal(const std::string &path, CJournal::durability_t durability);
+
+    /// @brief Write pending journal records and stop journaling
+    void close_journal(void) {m_journal.close();};
+
+    /// @brief Get journal, for monitoring
+    /// @return the journal
+    CJournal &get_journal(void) {return m_journal;};
+
+    /// @brief Join new session as booker, booker gets compact handle
+    /// @param booker [in] new bookr
+    /// @return Negative on error, booker handle on success
     int32_t join_booker(CBooker::booker_ptr booker);
 
     /// @brief Leave us(booker) from booking. Session was closed
     /// @param booker [in] Removing booker
     void leave_booker(CBooker::booker_ptr booker);
 
+    /// @brief Get number of active bookers, without taking any lock
+    /// @return number of bookers
+    std::size_t get_active_bookers(void) const {return m_bookers.size();};
+
     /// @brief get current cinema configuration
-    /// @return configuration itself
-    const movies_map_t &get_configuration(void) const {return m_movies_map;};
+    /// @return configuration itself, kept alive by the pointer also after reload
+    catalog_ptr get_configuration(void) const;
+
+    /// @brief Get stable handle of the show, commands with handle skip name lookups
+    /// @param movie [in] movie
+    /// @param theatre [in] theatre where movie is played
+    /// @return Negative on error, show handle on success
+    int32_t find_show (
+        std::string_view movie,
+        std::string_view theatre) const;
+
+    /// @brief Get number of shows, handles are 0 .. number of shows - 1
+    ///     Handles of removed shows are never given again
+    /// @return number of shows
+    std::size_t get_shows(void) const;
+
+    /// @brief Get movies played in the theatre, cost is proportional to shows of the theatre
+    /// @param theatre [in] theatre
+    /// @param shows [out] movie and show handle, in the order of the catalog
+    /// @return Negative on error, -EEXIST if theatre doesn't exist, number of shows on success
+    int32_t get_theatre_shows (
+        std::string_view theatre,
+        std::vector<std::pair<std::string, uint32_t>> &shows) const;
+
+    /// @brief Get shows with at least n free seats, answered from free seat counts, seats are not read
+    /// @param n [in] minimal number of free seats, at least 1
+    /// @param shows [out] shows, in the order of handles
+    /// @return Negative on error, number of shows on success
+    int32_t get_available (
+        uint32_t n,
+        std::vector<show_availability> &shows) const;
+
+    /// @brief Get shows of the movie with at least n free seats, answered from free seat counts
+    /// @param movie [in] movie
+    /// @param n [in] minimal number of free seats, at least 1
+    /// @param shows [out] shows, in the order of the catalog
+    /// @return Negative on error, -EEXIST if movie doesn't exist, number of shows on success
+    int32_t get_available (
+        std::string_view movie,
+        uint32_t n,
+        std::vector<show_availability> &shows) const;
+
+    /// @brief Get shows with the most free seats, answered from free seat counts
+    /// @param k [in] maximal number of shows
+    /// @param shows [out] shows, from the most free seats, sold out shows are not listed
+    /// @return Negative on error, number of shows on success
+    int32_t get_top (
+        uint32_t k,
+        std::vector<show_availability> &shows) const;
+
+    /// @brief Get number of shows, which have their own seats. The others share all free sentinel
+    /// @return number of shows with own seats
+    std::size_t get_active_shows(void) const;
 
     /// @brief Book the list of seats
     /// @param booker [in] booker uid
@@ -76,12 +390,129 @@ public:
     /// @return Negative on error, >=0 on success
     int32_t book_seats (
         CBooker::booker_ptr booker, 
-        const std::string &movie,
-        const std::string &theatre,
+        std::string_view movie,
+        std::string_view theatre,
+        const std::set<uint32_t> &seats,
+        std::vector<uint32_t> &unavalable_seats,
+        bool best_effort = false);
+
+    /// @brief Book the list of seats of the show
+    /// @param booker [in] booker uid
+    /// @param show [in] show handle
+    /// @param seats [in] array of booking seats
+    /// @param unavalable_seats [out] list of seats, which are already taken.
+    ///                     But were in our request
+    /// @param best_effort [in] true, to skip already booked seats
+    /// @return Negative on error, >=0 on success
+    int32_t book_seats (
+        CBooker::booker_ptr booker, 
+        uint32_t show,
         const std::set<uint32_t> &seats,
         std::vector<uint32_t> &unavalable_seats,
         bool best_effort = false);
 
+    /// @brief Book seats of several shows, all or nothing
+    ///     Theatres are locked in ascending id order and only for the commit
+    /// @param booker [in] booker uid
+    /// @param requests [in] seats per show, show can be listed more times
+    /// @param unavalable_seats [out] per request, list of seats which are already taken
+    /// @return Negative on error, 0 if nothing was booked, number of requested seats on success
+    int32_t book_batch (
+        CBooker::booker_ptr booker,
+        const std::vector<show_request> &requests,
+        std::vector<std::vector<uint32_t>> &unavalable_seats);
+
+    /// @brief Find and book the first run of contiguous free seats
+    /// @param booker [in] booker uid
+    /// @param movie [in] movie, which gets booked
+    /// @param theatre [in] theatre where movie is played
+    /// @param n [in] number of seats
+    /// @param row [in] name of the row, where seats are searched. Empty for whole theatre
+    /// @param seats [out] booked seats
+    /// @return Negative on error, -ENOSPC if there is no such run, >=0 on success
+    int32_t book_best_seats (
+        CBooker::booker_ptr booker,
+        std::string_view movie,
+        std::string_view theatre,
+        uint32_t n,
+        const std::string &row,
+        std::set<uint32_t> &seats);
+
+    /// @brief Find and book run of contiguous free seats in any theatre of the movie
+    ///     Only theatres with enough free seats are tried, in the order of the catalog
+    /// @param booker [in] booker uid
+    /// @param movie [in] movie, which gets booked
+    /// @param n [in] number of seats
+    /// @param seats [out] booked seats
+    /// @return Negative on error, -EEXIST if movie doesn't exist, -ENOSPC if no theatre has such run, show handle on success
+    int32_t book_any_seats (
+        CBooker::booker_ptr booker,
+        std::string_view movie,
+        uint32_t n,
+        std::set<uint32_t> &seats);
+
+    /// @brief Hold the list of seats for limited time
+    ///     Seats are booked as with book_seats, but they are released
+    ///     automatically, unless they are confirmed before ttl is over
+    /// @param booker [in] booker uid
+    /// @param movie [in] movie, which gets booked
+    /// @param theatre [in] theatre where movie is played
+    /// @param seats [in] array of holding seats
+    /// @param unavalable_seats [out] list of seats, which are already taken.
+    ///                     But were in our request
+    /// @param ttl [in] how long seats are held
+    /// @return Negative on error, >=0 on success
+    int32_t hold_seats (
+        CBooker::booker_ptr booker,
+        std::string_view movie,
+        std::string_view theatre,
+        const std::set<uint32_t> &seats,
+        std::vector<uint32_t> &unavalable_seats,
+        std::chrono::milliseconds ttl);
+
+    /// @brief Make held seats permanent
+    /// @param booker [in] booker uid
+    /// @param movie [in] movie
+    /// @param theatre [in] theatre where movie is played
+    /// @param seats [in] array of held seats
+    /// @param invalid_seats [out] list of seats, which are not held by us
+    /// @return Negative on error, number of confirmed seats on success
+    int32_t confirm_seats (
+        CBooker::booker_ptr booker,
+        std::string_view movie,
+        std::string_view theatre,
+        const std::set<uint32_t> &seats,
+        std::vector<uint32_t> &invalid_seats);
+
+    /// @brief Get the list of seats held by booker, which are not confirmed yet
+    /// @param booker [in] booker uid
+    /// @param movie [in] movie
+    /// @param theatre [in] theatre where movie is played
+    /// @param seats [out] array of held seats
+    /// @return Negative on error, >=0 on success
+    int32_t get_held_seats (
+        CBooker::booker_ptr booker,
+        std::string_view movie,
+        std::string_view theatre,
+        std::set<uint32_t> &seats) const;
+
+    /// @brief Release held seats, which ttl is over
+    /// @param now [in] current time
+    /// @return number of released seats
+    uint32_t expire_holds(std::chrono::steady_clock::time_point now);
+
+    /// @brief Set default time, seats are held for
+    /// @param ttl [in] time to live of holds
+    void set_hold_ttl(std::chrono::milliseconds ttl) {m_hold_ttl = ttl;};
+
+    /// @brief Get default time, seats are held for
+    /// @return time to live of holds
+    std::chrono::milliseconds get_hold_ttl(void) const {return m_hold_ttl;};
+
+    /// @brief Get resolution of hold expiration, expire_holds should be called this often
+    /// @return duration of single tick
+    static constexpr std::chrono::milliseconds get_hold_tick(void) {return m_hold_tick;};
+
     /// @brief Release already taken seats
     /// @param booker [in] booker uid
     /// @param movie [in] movie, which gets booked
@@ -91,11 +522,60 @@ public:
     /// @return Negative on error, >=0 on success
     int32_t unbook_seats (
         CBooker::booker_ptr booker, 
-        const std::string &movie,
-        const std::string &theatre,
+        std::string_view movie,
+        std::string_view theatre,
         const std::set<uint32_t> &seats,
         std::vector<uint32_t> &invalid_seats);
 
+    /// @brief Release already taken seats of the show
+    /// @param booker [in] booker uid
+    /// @param show [in] show handle
+    /// @param seats [in] array of booking seats
+    /// @param invalid_seats [out] list of seats, which are not tkaen taken by us
+    /// @return Negative on error, >=0 on success
+    int32_t unbook_seats (
+        CBooker::booker_ptr booker, 
+        uint32_t show,
+        const std::set<uint32_t> &seats,
+        std::vector<uint32_t> &invalid_seats);
+
+    /// @brief Release seats and book other seats of the theatre at once, all or nothing
+    ///     Both are done within single critical section of the theatre, so nobody
+    ///     sees the released seats free, while the new ones can't be booked.
+    ///     Seats listed in both lists stay booked.
+    /// @param booker [in] booker uid
+    /// @param movie [in] movie
+    /// @param theatre [in] theatre where movie is played
+    /// @param release_seats [in] seats taken by us, which are released
+    /// @param take_seats [in] seats, which are booked instead
+    /// @param unavalable_seats [out] seats to be booked, which are taken by others
+    /// @param invalid_seats [out] seats to be released, which are not taken by us
+    /// @return Negative on error, 0 if nothing was changed, number of booked seats of the theatre on success
+    int32_t exchange_seats (
+        CBooker::booker_ptr booker, 
+        std::string_view movie,
+        std::string_view theatre,
+        const std::set<uint32_t> &release_seats,
+        const std::set<uint32_t> &take_seats,
+        std::vector<uint32_t> &unavalable_seats,
+        std::vector<uint32_t> &invalid_seats);
+
+    /// @brief Release seats and book other seats of the show at once, all or nothing
+    /// @param booker [in] booker uid
+    /// @param show [in] show handle
+    /// @param release_seats [in] seats taken by us, which are released
+    /// @param take_seats [in] seats, which are booked instead
+    /// @param unavalable_seats [out] seats to be booked, which are taken by others
+    /// @param invalid_seats [out] seats to be released, which are not taken by us
+    /// @return Negative on error, 0 if nothing was changed, number of booked seats of the theatre on success
+    int32_t exchange_seats (
+        CBooker::booker_ptr booker, 
+        uint32_t show,
+        const std::set<uint32_t> &release_seats,
+        const std::set<uint32_t> &take_seats,
+        std::vector<uint32_t> &unavalable_seats,
+        std::vector<uint32_t> &invalid_seats);
+
     /// @brief Get the list of booked seats per booker
     /// @param booker [in] booker uid
     /// @param movie [in] movie
@@ -104,8 +584,18 @@ public:
     /// @return Negative on error, >=0 on success
     int32_t get_booked_seats (
         CBooker::booker_ptr booker, 
-        const std::string &movie,
-        const std::string &theatre,
+        std::string_view movie,
+        std::string_view theatre,
+        std::set<uint32_t> &seats);
+
+    /// @brief Get the list of booked seats of the show per booker
+    /// @param booker [in] booker uid
+    /// @param show [in] show handle
+    /// @param seats [out] array of booked seats
+    /// @return Negative on error, >=0 on success
+    int32_t get_booked_seats (
+        CBooker::booker_ptr booker, 
+        uint32_t show,
         std::set<uint32_t> &seats);
 
     /// @brief Get the list of free seats
@@ -115,84 +605,489 @@ public:
     /// @param free_seats [out] list of free seats
     /// @return Negative on error, >=0 on success
     int32_t get_free_seats (
-        const std::string &movie,
-        const std::string &theatre,
+        std::string_view movie,
+        std::string_view theatre,
         std::set<uint32_t> &free_seats);
 
+    /// @brief Get the list of free seats of the show
+    /// @param show [in] show handle
+    /// @param free_seats [out] list of free seats
+    /// @return Negative on error, -EBUSY if bookings kept on changing the seats, >=0 on success
+    int32_t get_free_seats (
+        uint32_t show,
+        std::set<uint32_t> &free_seats);
+
+    /// @brief Get the number of seats in theatre
+    /// @param movie [in] movie
+    /// @param theatre [in] theatre
+    /// @return Negative on error, number of seats on success
+    int32_t get_capacity (
+        std::string_view movie,
+        std::string_view theatre) const;
+
+    /// @brief Get the number of seats of the show
+    /// @param show [in] show handle
+    /// @return Negative on error, number of seats on success
+    int32_t get_capacity (uint32_t show) const;
+
+    /// @brief Get the seat layout of the theatre
+    /// @param movie [in] movie
+    /// @param theatre [in] theatre
+    /// @param layout [out] list of rows
+    /// @return Negative on error, >=0 on success
+    int32_t get_layout (
+        std::string_view movie,
+        std::string_view theatre,
+        std::vector<seat_row> &layout) const;
+
+    /// @brief Get rendered response about the theatre, shared by all the sessions
+    ///     Response is rendered again only after seats of the theatre changed
+    /// @param movie [in] movie
+    /// @param theatre [in] theatre
+    /// @param color [in] true, if response is colored
+    /// @param render [in] function, which renders the response
+    /// @param response [out] rendered response
+    /// @return Negative on error, >=0 on success
+    int32_t get_theatre_response (
+        std::string_view movie,
+        std::string_view theatre,
+        bool color,
+        const CResponseCache::render_t &render,
+        CResponseCache::response_ptr &response);
+
+    /// @brief Get rendered response about the show, shared by all the sessions
+    ///     Response is rendered again only after seats of the theatre changed
+    /// @param show [in] show handle
+    /// @param color [in] true, if response is colored
+    /// @param render [in] function, which renders the response
+    /// @param response [out] rendered response
+    /// @return Negative on error, >=0 on success
+    int32_t get_theatre_response (
+        uint32_t show,
+        bool color,
+        const CResponseCache::render_t &render,
+        CResponseCache::response_ptr &response);
+
+    /// @brief Get rendered response about all the theatres, shared by all the sessions
+    ///     Response is rendered again only after any seat or booker changed
+    /// @param color [in] true, if response is colored
+    /// @param render [in] function, which renders the response
+    /// @param response [out] rendered response
+    /// @return Negative on error, >=0 on success
+    int32_t get_status_response (
+        bool color,
+        const CResponseCache::render_t &render,
+        CResponseCache::response_ptr &response);
+
+    /// @brief Get cache of rendered responses, for monitoring
+    /// @return the cache
+    const CResponseCache &get_response_cache(void) const {return m_responses;};
+
     /// @brief Show current status within movies within theatres
     /// @param buffer [out] Buffer where the status is stored in
     ///         human readable form
     void dump_status (std::string &buffer) const;
     
-    /// @brief Get the maximum number of seats in theatre
+    /// @brief Get the number of seats in theatre, which has no capacity configured
     /// @return value of seats
-    static uint32_t get_max_seats(void) {return m_max_seats_capacity;};
+    static uint32_t get_max_seats(void) {return m_default_seats_capacity;};
 
 private:
+    struct theatre_config
+    { /*!< Parsed theatre, not published yet */
+        std::string theatre_; /*!< theatre name */
+        std::shared_ptr<theatre_reservation> reservation_; /*!< theatre with empty seats */
+    };
+
+    struct movie_config
+    { /*!< Parsed movie, not published yet */
+        std::string movie_; /*!< movie name */
+        std::vector<theatre_config> theatres_; /*!< theatres, where movie is played */
+    };
+
+    using catalog_config = std::vector<movie_config>;
+
+    /// @brief Publish catalog built from parsed configuration
+    ///     Open seat store is laid out by ids of the new catalog, journal gets its table of theatres
+    /// @param shards [io] parsed configuration, theatres are moved to the catalog
+    /// @return Negative on error, >=0 on success
+    int32_t publish_catalog(std::vector<catalog_config> &shards);
+
+    /// @brief Publish built catalog, caller holds m_reload_mutex
+    ///     Open seat store is laid out by ids of the new catalog, journal gets its table of theatres
+    /// @param new_catalog [in] new catalog
+    /// @return Negative on error, >=0 on success
+    int32_t install_catalog(const std::shared_ptr<catalog> &new_catalog);
+
+    /// @brief Read configuration tree
+    /// @param pt [in] configuration tree
+    /// @param config [out] movies and their theatres
+    /// @return Negative on error, >=0 on success
+    int32_t read_config (
+        const boost::property_tree::ptree &pt,
+        catalog_config &config);
+
+    /// @brief Parse JSON configuration document as it is read, unknown members are skipped
+    /// @param stream [in] configuration document
+    /// @param config [out] movies and their theatres
+    /// @return Negative on error, -EBADMSG if document is malformed, >=0 on success
+    int32_t parse_catalog (
+        std::istream &stream,
+        catalog_config &config);
+
+    /// @brief Parse single movie, opening brace is read already
+    /// @param reader [io] configuration document
+    /// @param config [out] movie and its theatres
+    /// @return Negative on error, >=0 on success
+    int32_t parse_movie (
+        CJsonReader &reader,
+        movie_config &config);
+
+    /// @brief Parse single theatre, the same forms as load_theatre takes
+    /// @param reader [io] configuration document
+    /// @param token [in] first token of the theatre, already read
+    /// @param config [out] theatre with empty seats
+    /// @return Negative on error, >=0 on success
+    int32_t parse_theatre (
+        CJsonReader &reader,
+        CJsonReader::token_t token,
+        theatre_config &config);
+
+    /// @brief Parse rows of the theatre, opening bracket is read already
+    /// @param reader [io] configuration document
+    /// @param reservations [out] theatre, rows are appended to its layout
+    /// @param capacity [out] number of seats in all the rows
+    /// @return Negative on error, >=0 on success
+    int32_t parse_layout (
+        CJsonReader &reader,
+        theatre_reservation &reservations,
+        uint32_t &capacity);
+
+    /// @brief Parse single theatre configuration
+    ///     Theatre is either just a name, or an object with name, capacity and layout
+    /// @param pt [in] theatre configuration tree
+    /// @param theatre [out] name of the theatre
+    /// @param reservations [out] Location, where list needs to be stored
+    /// @return Negative on error, >=0 on success
+    int32_t load_theatre (
+        const boost::property_tree::ptree &pt,
+        std::string &theatre,
+        theatre_reservation &reservations);
+
+    /// @brief Build catalog from parsed configuration, unchanged theatres are taken from the current one
+    ///     Movie listed several times gets theatres of all the listings
+    /// @param shards [io] parsed configuration, theatres are moved to the catalog
+    /// @param current [in] current catalog
+    /// @param next [out] new catalog
+    /// @return Negative on error, -EEXIST if theatre of the movie is listed twice, >=0 on success
+    int32_t build_catalog (
+        std::vector<catalog_config> &shards,
+        const catalog &current,
+        catalog &next);
+
+    /// @brief Build catalog over mapped image, unchanged theatres are taken from the current one
+    ///     Names and hash tables stay in the image, only theatres and their layouts are created
+    /// @param image [in] mapped image, the catalog keeps it
+    /// @param current [in] current catalog
+    /// @param next [out] new catalog
+    /// @return Negative on error, -EBADMSG if image is damaged, >=0 on success
+    int32_t map_catalog (
+        const std::shared_ptr<const CCatalogImage> &image,
+        const catalog &current,
+        catalog &next);
+
+    /// @brief Index shows of built catalog by handles and count their free seats
+    /// @param next [io] new catalog, its maps are complete
+    void index_shows(catalog &next);
+
+    /// @brief Forget seats and holds of removed theatre, nobody can see the theatre anymore
+    /// @param reservation [in] removed theatre
+    void forget_theatre(const theatre_reservation &reservation);
+
+    /// @brief Get rendered response from the cache, failed rendering is reported as error
+    /// @param id [in] id of the rendered object
+    /// @param color [in] true, if response is colored
+    /// @param version [in] version of the object
+    /// @param render [in] function, which renders the response
+    /// @param response [out] rendered response
+    /// @return Negative on error, >=0 on success
+    int32_t get_response (
+        uint32_t id,
+        bool color,
+        uint64_t version,
+        const CResponseCache::render_t &render,
+        CResponseCache::response_ptr &response);
+
+    /// @brief Get current catalog, caller is within epoch read section or holds reload mutex
+    /// @return current catalog
+    const catalog &get_catalog(void) const {return *m_catalog.load(std::memory_order_seq_cst);};
+
+    /// @brief Book the first run of contiguous free seats within the ranges
+    /// @param booker [in] booker uid
+    /// @param reservation [in] theatre
+    /// @param n [in] number of seats
+    /// @param ranges [in] ranges of seats, where the run is searched
+    /// @param seats [out] booked seats
+    /// @return Negative on error, -ENOSPC if there is no such run, >=0 on success
+    int32_t book_best_seats (
+        CBooker::booker_ptr booker,
+        theatre_reservation &reservation,
+        uint32_t n,
+        const std::vector<std::pair<uint32_t, uint32_t>> &ranges,
+        std::set<uint32_t> &seats);
+
+    /// @brief Publish free seats of the theatre to availability of the current catalog
+    ///     Caller is within epoch read section or holds reload mutex
+    /// @param reservation [in] theatre, which seats changed
+    void update_availability(const theatre_reservation &reservation) const;
+
+    /// @brief Convert shows found by availability to the result
+    /// @param current [in] catalog
+    /// @param entries [in] show handles
+    /// @param shows [out] shows with their names and free seats
+    static void get_show_availability (
+        const catalog &current,
+        const std::vector<uint32_t> &entries,
+        std::vector<show_availability> &shows);
+
     /// @brief Create list of empty seats
     /// @param reservations [out] Location, where list needs to be stored
+    /// @param capacity [in] number of seats in the theatre
     /// @return Negative on error, >=0 on success
-    int32_t prepare_reservation (theatre_reservation &reservations);
+    int32_t prepare_reservation (theatre_reservation &reservations, uint32_t capacity);
 
-    /// @brief Book the list of seats
+    /// @brief Create empty seats
+    /// @param seats [out] seats, all of them are free
+    /// @param capacity [in] number of seats in the theatre
+    static void prepare_seats (seat_state &seats, uint32_t capacity);
+
+    /// @brief Get all free sentinel of the capacity, shared by all the theatres nobody changed yet
+    /// @param capacity [in] number of seats in the theatre
+    /// @return sentinel, it lives as long as the process
+    static seat_state *get_sentinel(uint32_t capacity);
+
+    /// @brief Give the theatre its own seats, before they are changed for the first time.
+    ///     Concurrent callers agree on the same seats without lock
+    /// @param reservation [io] theatre
+    /// @return seats of the theatre, never the sentinel
+    static seat_state &materialize(theatre_reservation &reservation);
+
+    /// @brief Find theatre of the movie, caller is within epoch read section or holds reload mutex
+    /// @param movie [in] movie
+    /// @param theatre [in] theatre
+    /// @return pointer to the theatre, nullptr if it doesn't exist
+    const theatre_reservation *find_theatre (
+        std::string_view movie,
+        std::string_view theatre) const;
+
+    /// @brief Find theatre of the movie, caller is within epoch read section or holds reload mutex
+    /// @param movie [in] movie
+    /// @param theatre [in] theatre
+    /// @return pointer to the theatre, nullptr if it doesn't exist
+    theatre_reservation *find_theatre (
+        std::string_view movie,
+        std::string_view theatre);
+
+    /// @brief Find theatre of the show, caller is within epoch read section or holds reload mutex
+    /// @param show [in] show handle
+    /// @return pointer to the theatre, nullptr if it doesn't exist
+    const theatre_reservation *find_theatre (uint32_t show) const;
+
+    /// @brief Find theatre of the show, caller is within epoch read section or holds reload mutex
+    /// @param show [in] show handle
+    /// @return pointer to the theatre, nullptr if it doesn't exist
+    theatre_reservation *find_theatre (uint32_t show);
+
+    /// @brief Release all the seats of the booker and forget the booker
+    ///     Cost is proportional to the number of held seats
+    /// @param booker [in] booker
+    /// @return number of released seats
+    uint32_t release_booker(CBooker::booker_ptr booker);
+
+    /// @brief Forget released seats in holds of the booker
+    /// @param booker_id [in] booker handle
+    /// @param theatre_id [in] theatre id
+    /// @param seats [in] list of released seats
+    void drop_holds (
+        uint32_t booker_id,
+        uint32_t theatre_id,
+        const std::vector<uint32_t> &seats);
+
+    struct seat_hold
+    { /*!< Seats held by single hold request */
+        CBooker::booker_ptr booker_; /*!< holder */
+        uint32_t theatre_; /*!< theatre id */
+        std::set<uint32_t> seats_; /*!< seats, which are not confirmed or released yet */
+    };
+
+    struct journal_replay
+    { /*!< State of journal replay */
+        std::map<std::string, CBooker::booker_ptr> bookers_; /*!< bookers by uid */
+        std::map<std::pair<uint32_t, uint32_t>, std::map<uint32_t, int64_t>> holds_; /*!< held seat and deadline, per booker handle and theatre */
+        bool mapped_ = false; /*!< true, once table of theatres was replayed, journaled ids are ours until then */
+        uint32_t journaled_ = 0; /*!< number of theatre ids of the journaled catalog */
+        std::unordered_map<uint32_t, uint32_t> theatres_; /*!< our theatre id per journaled theatre id */
+    };
+
+    /// @brief Get hash of the catalog, seat store fits only the same catalog
+    ///     Caller holds reload mutex
+    /// @param hashed [in] the catalog
+    /// @return hash of names and capacities of all the theatres
+    uint64_t catalog_hash(const catalog &hashed) const;
+
+    /// @brief Copy seats of the theatre from seat store back to memory
+    ///     Nobody changes the seats meanwhile
+    /// @param reservation [in] theatre
+    void detach_seats(theatre_reservation &reservation);
+
+    /// @brief Move seats of all the theatres to new seat store, laid out by ids of the catalog.
+    ///     Caller holds reload mutex, theatres are moved one by one under their locks
+    /// @param next [in] catalog, which is going to be published
+    /// @param old_store [out] store, which was used so far. It is unmapped once nobody uses its seats
+    /// @param retired [out] seats, which were used so far
+    /// @return Negative on error, >=0 on success
+    int32_t move_seat_store (
+        const catalog &next,
+        CSeatStore &old_store,
+        std::vector<std::unique_ptr<seat_state>> &retired);
+
+    /// @brief Release seats of the holds
+    /// @param holds [in] holds, which are not in the table of holds anymore
+    /// @return number of released seats
+    uint32_t release_holds(std::vector<seat_hold> &holds);
+
+    /// @brief Apply single journal record
+    /// @param record [in] journal record
+    /// @param replay [io] state of the replay
+    /// @return Negative on error, >=0 on success
+    int32_t replay_record(const std::string &record, journal_replay &replay);
+
+    /// @brief Apply table of theatres of the journaled catalog. Theatres are matched by names and capacity,
+    ///     seats of theatres, which the journaled catalog doesn't have anymore, are freed
+    /// @param record [in] journal record
+    /// @param replay [io] state of the replay
+    /// @return Negative on error, number of matched theatres on success
+    int32_t replay_catalog(const std::string &record, journal_replay &replay);
+
+    /// @brief Free all the seats and holds of the theatre, which was removed from the journaled catalog
+    /// @param reservation [in] our theatre
+    /// @param replay [io] state of the replay
+    void replay_forget(theatre_reservation &reservation, journal_replay &replay);
+
+    /// @brief Append table of theatres of the catalog to the journal, records behind it use its ids
+    ///     "<op> <theatre ids> <id>:<capacity>:<movie size>:<theatre size>:<movie><theatre> ..."
+    /// @param op [in] T - catalog the run starts with, R - catalog of reload, it keeps ids of the run
+    /// @param journaled [in] the catalog
+    void journal_catalog(char op, const catalog &journaled);
+
+    /// @brief Append change of seats to the journal
+    ///     "<op> <theatre id> <seats> [<deadline>] <booker uid>"
+    /// @param op [in] B - booked, U - released, H - held, C - confirmed
+    /// @param booker [in] owner of the seats
+    /// @param theatre_id [in] theatre id
+    /// @param seats [in] list of seats
+    /// @param deadline [in] end of hold, milliseconds of system clock. Used by H only
+    void journal_seats (
+        char op,
+        const CBooker &booker,
+        uint32_t theatre_id,
+        const std::vector<uint32_t> &seats,
+        int64_t deadline = 0);
+
+    /// @brief Schedule release of held seats
+    /// @param booker [in] holder
+    /// @param theatre_id [in] theatre id
+    /// @param seats [in] held seats, already booked by the holder
+    /// @param deadline [in] when the seats are released
+    void add_hold (
+        CBooker::booker_ptr booker,
+        uint32_t theatre_id,
+        std::set<uint32_t> seats,
+        std::chrono::steady_clock::time_point deadline);
+
+    /// @brief Copy seats of the theatre, never takes the theatre lock
+    ///     Copy is consistent with finished bookings, it is retried with backoff if booking ran meanwhile
+    /// @param reservation [in] theatre
+    /// @param free_words [out] bitmap of free seats
+    /// @param owners [out] seat and its owner for all taken seats, in ascending order. Can be nullptr
+    /// @return true, if copy is consistent, false if bookings ran during all the retries
+    bool read_theatre (
+        const theatre_reservation &reservation,
+        std::vector<CSeatMap::word_t> &free_words,
+        std::vector<std::pair<uint32_t, uint32_t>> *owners) const;
+
+    /// @brief Get printable name of the booker
+    /// @param booker_id [in] booker id
+    /// @return booker uid, or id if booker is not active anymore
+    std::string get_booker_name (uint32_t booker_id) const;
+
+    /// @brief Book the list of seats of the theatre
     /// @param booker [in] booker uid
-    /// @param movie [in] ptr to movie ctx
-    /// @param theatre [in] theatre where movie is played
+    /// @param access [in] access to the theatre, lock free or exclusive
+    /// @param reservation [in] ptr to reservation ctx
     /// @param seats [in] array of booking seats
     /// @param unavalable_seats [out] list of seats, which are already taken.
     ///                     But were in our request
     /// @param best_effort [in] true, to skip already booked seats
+    /// @param journal [in] false, if caller journals the booked seats itself
     /// @return Negative on error, >=0 on success
     int32_t book_seats (
         CBooker::booker_ptr booker, 
-        movie *p_movie,
-        const std::string &theatre,
+        const theatre_access &access,
+        theatre_reservation &reservation,
         const std::set<uint32_t> &seats,
         std::vector<uint32_t> &unavalable_seats,
-        bool best_effort);
+        bool best_effort,
+        bool journal = true);
 
-    /// @brief Book the list of seats
+    /// @brief Book the list of seats within few seat words with CAS, without lock
     /// @param booker [in] booker uid
     /// @param reservation [in] ptr to reservation ctx
-    /// @param seats [in] array of booking seats
+    /// @param request [in] request mask
     /// @param unavalable_seats [out] list of seats, which are already taken.
     ///                     But were in our request
     /// @param best_effort [in] true, to skip already booked seats
     /// @return Negative on error, >=0 on success
-    int32_t book_seats (
+    int32_t claim_seats (
         CBooker::booker_ptr booker, 
         theatre_reservation &reservation,
-        const std::set<uint32_t> &seats,
+        CSeatMap::mask_t &request,
         std::vector<uint32_t> &unavalable_seats,
         bool best_effort);
 
-    /// @brief Book the list of seats
-    /// @param free_reservations_set [in] list of free seats
-    /// @param custom_reserved_set [in] list of required seats to be booked
-    /// @param seats [in] array of booking seats
+    /// @brief Book the list of seats with seat map kernels, theatre is locked and gate closed
+    /// @param booker [in] booker uid
+    /// @param reservation [in] ptr to reservation ctx
+    /// @param request [in] request mask
     /// @param unavalable_seats [out] list of seats, which are already taken.
     ///                     But were in our request
     /// @param best_effort [in] true, to skip already booked seats
+    /// @param journal [in] false, if caller journals the booked seats itself
     /// @return Negative on error, >=0 on success
-    int32_t book_seats (
-        std::set<uint32_t> &free_reservations_set,
-        std::set<uint32_t> &custom_reserved_set,
-        const std::set<uint32_t> &seats,
+    int32_t take_seats (
+        CBooker::booker_ptr booker, 
+        theatre_reservation &reservation,
+        const CSeatMap::mask_t &request,
         std::vector<uint32_t> &unavalable_seats,
-        bool best_effort);
+        bool best_effort,
+        bool journal = true);
 
-    /// @brief Release already taken seats
+    /// @brief Release seats and book other seats of the theatre at once, all or nothing
     /// @param booker [in] booker uid
-    /// @param p_movie [in] ptr to movie
-    /// @param theatre [in] theatre where movie is played
-    /// @param seats [in] array of booking seats
-    /// @param invalid_seats [out] list of seats, which are not tkaen taken by us
-    /// @return Negative on error, >=0 on success
-    int32_t unbook_seats (
+    /// @param access [in] exclusive access to the theatre
+    /// @param reservation [in] theatre
+    /// @param release_seats [in] seats taken by us, which are released
+    /// @param take_seats [in] seats, which are booked instead
+    /// @param unavalable_seats [out] seats to be booked, which are taken by others
+    /// @param invalid_seats [out] seats to be released, which are not taken by us
+    /// @return Negative on error, 0 if nothing was changed, number of booked seats of the theatre on success
+    int32_t exchange_seats (
         CBooker::booker_ptr booker, 
-        movie *p_movie,
-        const std::string &theatre,
-        const std::set<uint32_t> &seats,
+        const theatre_access &access,
+        theatre_reservation &reservation,
+        const std::set<uint32_t> &release_seats,
+        const std::set<uint32_t> &take_seats,
+        std::vector<uint32_t> &unavalable_seats,
         std::vector<uint32_t> &invalid_seats);
 
     /// @brief Release already taken seats
@@ -200,20 +1095,74 @@ private:
     /// @param reservation [in] ptr to reservation ctx
     /// @param seats [in] array of booking seats
     /// @param invalid_seats [out] list of seats, which are not tkaen taken by us
+    /// @param journal [in] false for rollback of seats, which were never journaled
     /// @return Negative on error, >=0 on success
     int32_t unbook_seats (
         CBooker::booker_ptr booker, 
         theatre_reservation &reservation,
         const std::set<uint32_t> &seats,
-        std::vector<uint32_t> &invalid_seats);
+        std::vector<uint32_t> &invalid_seats,
+        bool journal = true);
         
 private:
-    std::atomic<uint32_t> m_connections_ctx;
-    std::set<CBooker::booker_ptr> m_active_bookers_set; /*!< list of currently active sessions - bookers*/
+    engine_t m_engine = engine_t::locked; /*!< selected booking engine */
+
+    CBookerRegistry m_bookers; /*!< active sessions - bookers, indexed by handle */
+
+    struct departed_booker
+    { /*!< Closed session, which seats are released later */
+        std::chrono::steady_clock::time_point deadline_; /*!< end of grace period */
+        CBooker::booker_ptr booker_; /*!< the booker */
+    };
+
+    release_policy_t m_release_policy = release_policy_t::keep; /*!< what happens with seats of closed session */
+    std::chrono::seconds m_release_grace = std::chrono::seconds(0); /*!< how long seats are kept after session is closed */
+    std::mutex m_departed_mutex; /*!< protects list of departed bookers */
+    std::deque<departed_booker> m_departed_bookers; /*!< closed sessions in grace period, ordered by deadline */
+
+    mutable std::mutex m_reload_mutex; /*!< serializes loads of the catalog */
+    std::atomic<uint64_t> m_mutations = 0; /*!< changes of seats of all the theatres, they version the status */
+    catalog_ptr m_catalog_owner; /*!< current catalog, protected by m_reload_mutex */
+    std::atomic<const catalog *> m_catalog; /*!< current catalog, loaded within epoch read section */
+    CEpoch m_epoch; /*!< old catalog is freed after bookings, which can see it, are gone */
 
-    movies_map_t m_movies_map; /*!< configuration movies & theatres and ocupation*/
+    mutable std::mutex m_holds_mutex; /*!< protects holds and the wheel, taken after theatre lock */
+    CTimingWheel m_holds_wheel; /*!< expiration of holds, one tick is m_hold_tick */
+    std::unordered_map<uint64_t, seat_hold> m_holds; /*!< active holds by hold id */
+    std::unordered_map<uint32_t, std::set<uint64_t>> m_booker_holds; /*!< hold ids per booker handle */
+    uint64_t m_holds_ctx = 0; /*!< last assigned hold id */
+    std::chrono::steady_clock::time_point m_holds_epoch = std::chrono::steady_clock::now(); /*!< time of tick 0 */
+    std::chrono::milliseconds m_hold_ttl = std::chrono::minutes(5); /*!< default time to live of holds */
+
+    CJournal m_journal; /*!< journal of seat changes, closed before bookers go away */
+
+    CSeatStore m_seat_store; /*!< memory mapped seats, if enabled */
+    uint64_t m_journal_offset = 0; /*!< journal records before this offset are contained in restored seats */
+
+    CSeqGate m_batch_seq; /*!< batch bookings spanning more theatres, snapshots don't cut through them */
+
+    CResponseCache m_responses; /*!< rendered responses, keyed by theatre id or m_status_response_id */
 
 private:
-    static constexpr uint32_t m_max_seats_capacity = 20;
+    static constexpr uint32_t m_default_seats_capacity = 20; /*!< capacity of theatre without configuration */
+    static constexpr uint32_t m_max_seats_capacity = 1u << 20; /*!< upper limit of configurable capacity */
+
+    /*! Requests within this many seat words are booked with CAS in lock_free engine.
+     *  CAS per word takes the request, failed word gives the words before it back.
+     *  Readers never see it half booked, they retry behind the theatre seq gate.
+     *  Wider requests take the theatre lock and keep lock free bookings out */
+    static constexpr std::size_t m_lock_free_max_words = CSeatMap::m_claim_max_words;
+
+    /*! Readers retry copy of seats this many times and then give up, they never take the theatre lock.
+     *  First retries only yield, then the reader sleeps twice as long every time, up to 1 << m_read_backoff_shift us */
+    static constexpr uint32_t m_read_retries = 24;
+    static constexpr uint32_t m_read_spins = 4; /*!< retries, which only yield */
+    static constexpr uint32_t m_read_backoff_shift = 10; /*!< longest sleep between retries is 1 << shift us */
+
+    static constexpr uint32_t m_status_response_id = UINT32_MAX; /*!< response id of status, never used by theatre */
+    static constexpr uint32_t m_status_catalog_shift = 48; /*!< catalog version is added to status version in the top bits */
+    static constexpr uint32_t m_no_theatre = UINT32_MAX; /*!< journaled theatre, which is not in our catalog */
+
+    static constexpr std::chrono::milliseconds m_hold_tick = std::chrono::milliseconds(100); /*!< resolution of hold expiration */
 };
 
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cassert>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+
+struct catalog_slot
+{ /*!< Single slot of the hash table, the same layout is stored in catalog image */
+    uint64_t hash_ = 0; /*!< hash of the name */
+    uint32_t index_ = 0; /*!< index of the entry + 1, 0 if slot is empty */
+    uint32_t reserved_ = 0; /*!< padding, always 0 */
+};
+
+
+/*! \brief CCatalog class.
+ *         Flat hash table of named entries, looked up by std::string_view
+ *
+ *  Entries are kept in a vector in the order of insertion, open addressing
+ *  table with linear probing holds their indexes. Hash of every name is
+ *  computed once, on insert, and stored next to the index, so lookup compares
+ *  names only when hashes match. Lookup takes std::string_view, so callers
+ *  don't build std::string just to find an entry. Entries are never removed,
+ *  catalog is immutable after load. Names are owned by the catalog, unless
+ *  std::string_view is given as the key type, then they must outlive it,
+ *  e.g. they are kept in CNamePool. Hash table can also be attached from
+ *  outside, e.g. from mapped catalog image, then entries are only appended
+ *  in the order of its indexes and nothing is hashed.
+ */
+template <typename T, typename K = std::string>
+class CCatalog
+{
+public:
+    using value_type = std::pair<K, T>;
+    using iterator = typename std::vector<value_type>::iterator;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+    using slot = catalog_slot;
+
+public:
+    /// @brief Standard constructor, empty catalog
+    CCatalog() = default;
+
+    CCatalog(CCatalog &&) = default;
+    CCatalog &operator=(CCatalog &&) = default;
+
+    /// @brief Insert new entry, iterators are invalidated
+    /// @param name [in] name of the entry
+    /// @param value [in] value of the entry
+    /// @return entry and true if it was inserted, existing entry and false if name is taken
+    std::pair<iterator, bool> insert(K name, T value)
+    {
+        uint64_t hash;
+        std::size_t slot;
+
+        assert(m_attached.empty());
+
+        hash = hash_name(name);
+        slot = find_slot(name, hash);
+        if (m_slots[slot].index_ != 0) {
+            return {m_entries.begin() + (m_slots[slot].index_ - 1), false};
+        }
+
+        m_entries.emplace_back(std::move(name), std::move(value));
+        m_slots[slot] = {hash, static_cast<uint32_t>(m_entries.size())};
+
+        /*load factor stays below one half, probes stay short*/
+        if (m_entries.size() * 2 > m_slots.size()) {
+            rehash(m_slots.size() * 2);
+        }
+
+        return {m_entries.end() - 1, true};
+    };
+
+    /// @brief Use hash table kept outside, it must outlive the catalog. Catalog must be empty
+    /// @param slots [in] hash table, power of two slots, at least one of them empty
+    void attach(std::span<const slot> slots)
+    {
+        assert(m_entries.empty());
+        assert((slots.empty() != true)&&((slots.size() & (slots.size() - 1)) == 0));
+
+        m_attached = slots;
+        std::vector<slot>().swap(m_slots);
+    };
+
+    /// @brief Append entry of attached hash table, entries follow the order of its indexes,
+    ///        all of them must be appended before the first lookup
+    /// @param name [in] name of the entry
+    /// @param value [in] value of the entry
+    void append(K name, T value)
+    {
+        assert(m_attached.empty() != true);
+
+        m_entries.emplace_back(std::move(name), std::move(value));
+    };
+
+    /// @brief Reserve space for entries
+    /// @param size [in] number of entries
+    void reserve(std::size_t size) {m_entries.reserve(size);};
+
+    /// @brief Get hash table, e.g. to store it in catalog image
+    /// @return slots of the table
+    std::span<const slot> get_slots(void) const {return m_attached.empty() ? std::span<const slot>(m_slots) : m_attached;};
+
+    /// @brief Find entry by name
+    /// @param name [in] name of the entry
+    /// @return entry, end() if it doesn't exist
+    iterator find(std::string_view name)
+    {
+        uint32_t index = get_slots()[find_slot(name, hash_name(name))].index_;
+
+        return (index == 0) ? m_entries.end() : m_entries.begin() + (index - 1);
+    };
+
+    /// @brief Find entry by name
+    /// @param name [in] name of the entry
+    /// @return entry, end() if it doesn't exist
+    const_iterator find(std::string_view name) const
+    {
+        uint32_t index = get_slots()[find_slot(name, hash_name(name))].index_;
+
+        return (index == 0) ? m_entries.end() : m_entries.begin() + (index - 1);
+    };
+
+    /// @brief Get number of entries
+    /// @return number of entries
+    std::size_t size(void) const {return m_entries.size();};
+
+    /// @brief Check if catalog has no entry
+    /// @return true, if there is no entry
+    bool empty(void) const {return m_entries.empty();};
+
+    iterator begin(void) {return m_entries.begin();};
+    iterator end(void) {return m_entries.end();};
+    const_iterator begin(void) const {return m_entries.begin();};
+    const_iterator end(void) const {return m_entries.end();};
+
+    /// @brief Hash of the name, FNV-1a
+    /// @param name [in] name
+    /// @return hash
+    static uint64_t hash_name(std::string_view name)
+    {
+        uint64_t hash = 14695981039346656037ull;
+
+        for (char ch : name) {
+            hash = (hash ^ static_cast<uint8_t>(ch)) * 1099511628211ull;
+        }
+
+        return hash;
+    };
+
+private:
+    /// @brief Find slot of the name, or the empty slot, where it belongs
+    /// @param name [in] name of the entry
+    /// @param hash [in] hash of the name
+    /// @return index of the slot
+    std::size_t find_slot(std::string_view name, uint64_t hash) const
+    {
+        std::span<const slot> slots = get_slots();
+        std::size_t mask = slots.size() - 1;
+
+        for (std::size_t i = hash & mask; ; i = (i + 1) & mask) {
+            const slot &item = slots[i];
+            if ((item.index_ == 0)||((item.hash_ == hash)&&(m_entries[item.index_ - 1].first == name))) {
+                return i;
+            }
+        }
+    };
+
+    /// @brief Build the table again with more slots
+    /// @param slots [in] number of slots, power of two
+    void rehash(std::size_t slots)
+    {
+        std::vector<slot> old_slots(slots);
+
+        old_slots.swap(m_slots);
+        for (const slot &item : old_slots) {
+            if (item.index_ == 0)
+                continue;
+
+            std::size_t mask = m_slots.size() - 1;
+            std::size_t i = item.hash_ & mask;
+            while (m_slots[i].index_ != 0) {
+                i = (i + 1) & mask;
+            }
+            m_slots[i] = item;
+        }
+    };
+
+private:
+    std::vector<value_type> m_entries; /*!< entries in the order of insertion */
+    std::vector<slot> m_slots = std::vector<slot>(m_initial_slots); /*!< hash table, power of two slots */
+    std::span<const slot> m_attached; /*!< hash table kept outside, all its entries are appended before lookup */
+
+    static constexpr std::size_t m_initial_slots = 8; /*!< slots of empty catalog */
+};
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+#include "catalog.h"
+
+
+/*! \brief CCatalogImage class.
+ *         Compiled catalog of movies and theatres, mapped read-only from binary file
+ *
+ *  File has versioned header followed by hash tables of movie names, theatre
+ *  names of every movie and theatre names, then fixed size tables of movies,
+ *  shows, rows, theatres and show handles of the theatres, then pool of names.
+ *  Hash tables have the layout of CCatalog, so catalog attaches them and names
+ *  are looked up in the mapped file, nothing is hashed on load. Every name is
+ *  stored once, however many shows use it, and tables refer to it by offset
+ *  within the pool. Nothing within the file is an address, so it is mapped
+ *  anywhere and shared by all the processes, which map it. Opening checks
+ *  the header and the hash tables of movies and theatres, the other tables
+ *  are checked as they are read. Show handles are given in the order of shows,
+ *  the same handles the catalog gets when it is loaded into empty booking.
+ *  Words are stored in native byte order, image is used by the same build,
+ *  which compiled it. File is written next to the target and renamed over it,
+ *  mapped file must never be rewritten in place, its readers would fault.
+ */
+class CCatalogImage
+{
+public:
+    struct row
+    { /*!< Single row of seats within a theatre */
+        std::string_view section_; /*!< section name, can be empty */
+        std::string_view row_; /*!< row name */
+        uint32_t first_seat_ = 0; /*!< number of the first seat in the row */
+        uint32_t seats_ = 0; /*!< number of seats in the row */
+    };
+
+    struct show
+    { /*!< Theatre, where movie is played */
+        std::string_view theatre_; /*!< theatre name */
+        uint32_t handle_ = 0; /*!< show handle */
+        uint32_t capacity_ = 0; /*!< number of seats */
+        std::vector<row> layout_; /*!< rows of seats, empty if not configured */
+    };
+
+    struct movie
+    { /*!< Movie and its shows */
+        std::string_view movie_; /*!< movie name */
+        std::vector<show> shows_; /*!< theatres, where movie is played */
+    };
+
+    struct theatre
+    { /*!< Theatre and its shows */
+        std::string_view theatre_; /*!< theatre name */
+        std::span<const uint32_t> shows_; /*!< show handles, in the order of shows */
+    };
+
+public:
+    /// @brief Standard constructor, nothing is mapped
+    CCatalogImage() = default;
+
+    /// @brief Standard destructor, unmaps the file
+    ~CCatalogImage();
+
+    CCatalogImage(const CCatalogImage &) = delete;
+    CCatalogImage &operator=(const CCatalogImage &) = delete;
+
+    /// @brief Compile movies to image file
+    /// @param path [in] image file, replaced atomically
+    /// @param movies [in] movies, handles of their shows must be 0 .. number of shows - 1 in order
+    /// @return Negative on error, -EINVAL if handles are not in order or names repeat, size of the file on success
+    static int32_t save(const std::string &path, const std::vector<movie> &movies);
+
+    /// @brief Check if the file is catalog image
+    /// @param path [in] file
+    /// @return true, if file starts with image header
+    static bool is_image(const std::string &path);
+
+    /// @brief Map image file read-only
+    /// @param path [in] image file
+    /// @return Negative on error, -EBADMSG if file isn't image of this version, number of shows on success
+    int32_t open(const std::string &path);
+
+    /// @brief Unmap the file, names of read movies are not valid anymore
+    void close(void);
+
+    /// @brief Check if file is mapped
+    /// @return true, if it is mapped
+    bool is_open(void) const {return m_base != nullptr;};
+
+    /// @brief Get number of movies
+    /// @return number of movies
+    uint32_t get_movies(void) const;
+
+    /// @brief Get number of shows
+    /// @return number of shows
+    uint32_t get_shows(void) const;
+
+    /// @brief Read movie, names point to the mapped file
+    /// @param index [in] index of the movie
+    /// @param item [out] movie and its shows
+    /// @return Negative on error, -EBADMSG if tables are damaged, >=0 on success
+    int32_t get_movie(uint32_t index, movie &item) const;
+
+    /// @brief Get number of theatres
+    /// @return number of theatres
+    uint32_t get_theatres(void) const;
+
+    /// @brief Read theatre, name and handles point to the mapped file
+    /// @param index [in] index of the theatre
+    /// @param item [out] theatre and its shows
+    /// @return Negative on error, -EBADMSG if tables are damaged, >=0 on success
+    int32_t get_theatre(uint32_t index, theatre &item) const;
+
+    /// @brief Get hash table of movie names, entries are indexes of movies
+    /// @return slots of the table, empty if nothing is mapped
+    std::span<const catalog_slot> get_movie_slots(void) const;
+
+    /// @brief Get hash table of theatre names of the movie, entries are positions of the shows within the movie
+    /// @param index [in] index of the movie
+    /// @param slots [out] slots of the table
+    /// @return Negative on error, -EBADMSG if the table is damaged, >=0 on success
+    int32_t get_show_slots(uint32_t index, std::span<const catalog_slot> &slots) const;
+
+    /// @brief Get hash table of theatre names, entries are indexes of theatres
+    /// @return slots of the table, empty if nothing is mapped
+    std::span<const catalog_slot> get_theatre_slots(void) const;
+
+public:
+    static constexpr uint32_t m_version = 2; /*!< version of the file layout */
+
+private:
+    struct name_ref
+    { /*!< Name within the pool */
+        uint32_t offset_; /*!< offset within the pool */
+        uint32_t size_; /*!< length of the name */
+    };
+
+    struct header
+    { /*!< Beginning of the file */
+        char magic_[8]; /*!< file type */
+        uint32_t version_; /*!< version of the file layout */
+        uint32_t movies_; /*!< number of movies */
+        uint32_t shows_; /*!< number of shows */
+        uint32_t rows_; /*!< number of rows */
+        uint32_t theatres_; /*!< number of theatres */
+        uint32_t movie_slots_; /*!< slots of the hash table of movies */
+        uint32_t show_slots_; /*!< slots of the hash tables of all the movies */
+        uint32_t theatre_slots_; /*!< slots of the hash table of theatres */
+        uint64_t names_size_; /*!< size of the pool of names */
+        uint64_t size_; /*!< size of the file */
+    };
+
+    struct movie_entry
+    { /*!< Movie within the table of movies */
+        name_ref name_; /*!< movie name */
+        uint32_t first_show_; /*!< index of the first show */
+        uint32_t shows_; /*!< number of shows */
+        uint32_t first_slot_; /*!< index of the first slot of its hash table */
+        uint32_t slots_; /*!< slots of its hash table */
+    };
+
+    struct show_entry
+    { /*!< Show within the table of shows */
+        name_ref name_; /*!< theatre name */
+        uint32_t handle_; /*!< show handle */
+        uint32_t capacity_; /*!< number of seats */
+        uint32_t first_row_; /*!< index of the first row */
+        uint32_t rows_; /*!< number of rows */
+    };
+
+    struct row_entry
+    { /*!< Row within the table of rows */
+        name_ref section_; /*!< section name */
+        name_ref row_; /*!< row name */
+        uint32_t first_seat_; /*!< number of the first seat in the row */
+        uint32_t seats_; /*!< number of seats in the row */
+    };
+
+    struct theatre_entry
+    { /*!< Theatre within the table of theatres */
+        name_ref name_; /*!< theatre name */
+        uint32_t first_show_; /*!< index of the first handle within the table of theatre shows */
+        uint32_t shows_; /*!< number of shows */
+    };
+
+    /// @brief Check hash table, every entry is in a slot once and some slots are empty
+    /// @param slots [in] slots of the table
+    /// @param entries [in] number of entries
+    /// @return true, if lookup within the table is safe
+    static bool check_slots(std::span<const catalog_slot> slots, uint32_t entries);
+
+    /// @brief Get name from the pool
+    /// @param ref [in] name within the pool
+    /// @param name [out] name
+    /// @return false, if name is out of the pool
+    bool get_name(const name_ref &ref, std::string_view &name) const;
+
+    /// @brief Get header of the mapped file
+    /// @return header
+    const header &get_header(void) const {return *reinterpret_cast<const header *>(m_base);};
+
+private:
+    const uint8_t *m_base = nullptr; /*!< mapped file */
+    std::size_t m_size = 0; /*!< size of the mapping */
+    const catalog_slot *m_movie_slots = nullptr; /*!< hash table of movies */
+    const catalog_slot *m_show_slots = nullptr; /*!< hash tables of theatres of every movie */
+    const catalog_slot *m_theatre_slots = nullptr; /*!< hash table of theatres */
+    const movie_entry *m_movies = nullptr; /*!< table of movies */
+    const show_entry *m_shows = nullptr; /*!< table of shows */
+    const row_entry *m_rows = nullptr; /*!< table of rows */
+    const theatre_entry *m_theatres = nullptr; /*!< table of theatres */
+    const uint32_t *m_theatre_shows = nullptr; /*!< show handles of the theatres */
+    const char *m_names = nullptr; /*!< pool of names */
+
+    static constexpr char m_magic[8] = {'P', 'L', 'A', 'Y', 'C', 'A', 'T', 'I'};
+};
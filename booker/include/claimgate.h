@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <cstdint>
+
+
+/*! \brief CClaimGate class.
+ *         Lets holder of the theatre lock keep lock free changes of seats out
+ *
+ *  Lock free booking passes the gate around its compare-and-swap. Lock holder
+ *  closes the gate and waits, until changes which already passed it are done.
+ *  Booking, which finds the gate closed, takes the lock instead, so while
+ *  the gate is closed seat words are changed by the lock holder only.
+ *  Gate is closed only by the lock holder, so passing never waits for
+ *  anything, but the closer.
+ */
+class CClaimGate
+{
+public:
+    /// @brief Standard constructor, gate is open
+    CClaimGate() = default;
+
+    /// @brief Enter the gate
+    /// @return true, if gate is open, then leave must follow. False if gate is closed
+    bool enter(void)
+    {
+        /*closer either sees us inside, or we see the gate closed*/
+        m_inside.fetch_add(1, std::memory_order_seq_cst);
+        if (m_closed.load(std::memory_order_seq_cst) != 0) {
+            m_inside.fetch_sub(1, std::memory_order_release);
+            return false;
+        }
+        return true;
+    };
+
+    /// @brief Leave the gate, after changes are done
+    void leave(void) {m_inside.fetch_sub(1, std::memory_order_release);};
+
+    /// @brief Close the gate and wait for changes, which already passed it.
+    ///     Must be called under the theatre lock
+    void close(void)
+    {
+        m_closed.fetch_add(1, std::memory_order_seq_cst);
+        while (m_inside.load(std::memory_order_seq_cst) != 0) {
+            std::this_thread::yield();
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+    };
+
+    /// @brief Open the gate again, before the theatre lock is released
+    void open(void) {m_closed.fetch_sub(1, std::memory_order_release);};
+
+private:
+    std::atomic<uint32_t> m_closed = 0; /*!< number of closers, non zero while gate is closed */
+    std::atomic<uint32_t> m_inside = 0; /*!< lock free changes, which passed the gate */
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+
+/*! \brief CEpoch class.
+ *         Epoch based reclamation, readers of shared data never wait for writer
+ *
+ *  Reader announces current epoch in a free slot for the time it uses
+ *  the shared data. Writer publishes new data with atomic pointer swap,
+ *  then synchronize() moves the epoch and waits, until all the readers,
+ *  which announced an older epoch, are gone. Nobody can see the old data
+ *  afterwards, so it can be freed. Only the writer ever waits.
+ *  Pointer to the shared data must be loaded with sequentially consistent load.
+ */
+class CEpoch
+{
+public:
+    /*! \brief Read section, as long as the object lives */
+    class reader
+    {
+    public:
+        /// @brief Announce the reader
+        /// @param epoch [in] epoch of read data
+        explicit reader(const CEpoch &epoch) : m_slot(epoch.enter()) {};
+
+        /// @brief Leave read section, unless left already
+        ~reader() {leave();};
+
+        reader(const reader &) = delete;
+        reader &operator=(const reader &) = delete;
+
+        /// @brief Leave read section before the object goes away, read data must not be used afterwards
+        void leave(void)
+        {
+            if (m_slot != nullptr) {
+                m_slot->store(0, std::memory_order_release);
+                m_slot = nullptr;
+            }
+        };
+
+    private:
+        std::atomic<uint64_t> *m_slot;
+    };
+
+public:
+    /// @brief Standard constructor
+    CEpoch() = default;
+
+    CEpoch(const CEpoch &) = delete;
+    CEpoch &operator=(const CEpoch &) = delete;
+
+    /// @brief Wait, until all the readers, which started before the call, are gone
+    ///     Data unpublished before the call can be freed afterwards
+    void synchronize(void);
+
+    /// @brief Get current epoch
+    /// @return epoch
+    uint64_t epoch(void) const {return m_epoch.load(std::memory_order_acquire);};
+
+    /// @brief Get number of readers, which can be in read section at once
+    /// @return number of slots
+    static constexpr std::size_t get_slots(void) {return m_slots_count;};
+
+private:
+    /// @brief Announce current epoch in a free slot
+    /// @return claimed slot
+    std::atomic<uint64_t> *enter(void) const;
+
+private:
+    struct alignas(64) slot
+    { /*!< Announced epoch of single reader, on its own cache line */
+        std::atomic<uint64_t> epoch_ = 0; /*!< announced epoch, 0 if slot is free */
+    };
+
+    static constexpr std::size_t m_slots_count = 128; /*!< more readers at once wait for a free slot */
+
+    std::atomic<uint64_t> m_epoch = 1; /*!< current epoch, 0 marks free slot */
+    mutable std::array<slot, m_slots_count> m_slots; /*!< reader slots */
+};
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <mutex>
+#include <cerrno>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <condition_variable>
+
+
+/*! \brief CJournal class.
+ *         Append-only journal of booking changes, written by its own thread
+ *
+ *  Sessions only append records to the pending buffer, the writer thread
+ *  takes everything appended meanwhile and writes it with a single write
+ *  and a single fsync (group commit). Every record is one text line, line
+ *  without new line at the end of file is a torn write of crashed process
+ *  and it is ignored by replay.
+ */
+class CJournal
+{
+public:
+    enum class durability_t
+    { /*!< When the booking is on disk */
+        none, /*!< records are written, flushing is left to the system */
+        batched, /*!< every batch of records is flushed, sessions don't wait for it */
+        per_op /*!< every batch of records is flushed, sessions wait for their batch */
+    };
+
+    using apply_t = std::function<int32_t(const std::string &record)>;
+
+    /*! \brief Waits for records appended in its scope.
+     *         Declared before locks, operation calls wait once they are released
+     *         and reports its result only then. Scope left without wait, waits too */
+    class commit
+    {
+    public:
+        /// @brief Start scope of journaled operation
+        /// @param journal [in] journal
+        explicit commit(CJournal &journal) : m_journal(journal) {};
+
+        /// @brief Wait for durability of the operation, unless wait was called
+        ~commit() {if (m_waited != true) m_journal.sync();};
+
+        commit(const commit &) = delete;
+        commit &operator=(const commit &) = delete;
+
+        /// @brief Wait for durability of the operation, must not be called under locks
+        /// @param rc [in] result of the operation
+        /// @return rc, if operation failed or its records are durable, -EIO if writer failed to write or flush
+        int32_t wait(int32_t rc)
+        {
+            m_waited = true;
+            if ((m_journal.sync() < EXIT_SUCCESS)&&(rc >= EXIT_SUCCESS)) {
+                return -EIO;
+            }
+            return rc;
+        };
+
+    private:
+        CJournal &m_journal;
+        bool m_waited = false;
+    };
+
+public:
+    /// @brief Standard constructor, closed journal
+    CJournal() = default;
+
+    /// @brief Standard destructor, flushes pending records
+    ~CJournal();
+
+    CJournal(const CJournal &) = delete;
+    CJournal &operator=(const CJournal &) = delete;
+
+    /// @brief Open journal file for appending and start the writer thread
+    /// @param path [in] journal file, created if it doesn't exist
+    /// @param durability [in] durability mode
+    /// @return Negative on error, >=0 on success
+    int32_t open(const std::string &path, durability_t durability);
+
+    /// @brief Write pending records, stop the writer thread and close the file
+    void close(void);
+
+    /// @brief Check if records are journaled
+    /// @return true, if journal is open
+    bool is_open(void) const {return m_open.load(std::memory_order_acquire);};
+
+    /// @brief Get durability mode
+    /// @return durability mode
+    durability_t get_durability(void) const {return m_durability;};
+
+    /// @brief Append record, it is written later by the writer thread
+    /// @param record [in] single line, without new line
+    void append(const std::string &record);
+
+    /// @brief Wait until records appended so far are durable.
+    ///     Returns at once, unless durability is per_op
+    /// @return Negative if writer failed to write or flush, >=0 on success
+    int32_t sync(void);
+
+    /// @brief Get first error of the writer thread
+    /// @return Negative on error, >=0 if everything was written
+    int32_t get_error(void);
+
+    /// @brief Get size of the journal file, when it was closed
+    /// @return size in bytes, 0 if journal was never open
+    uint64_t get_size(void) const {return m_size;};
+
+    /// @brief Get number of writes of the writer thread, for monitoring
+    /// @return number of batches
+    uint64_t get_batches(void) const {return m_batches.load(std::memory_order_relaxed);};
+
+    /// @brief Read all complete records of journal file
+    /// @param path [in] journal file
+    /// @param apply [in] function called per record, negative return value stops replay
+    /// @param offset [in] records before this offset are skipped
+    /// @return Negative on error, number of records on success. Missing file has no records
+    static int32_t replay(const std::string &path, const apply_t &apply, uint64_t offset = 0);
+
+private:
+    /// @brief Writer thread, writes and flushes pending records in batches
+    void writer(void);
+
+    /// @brief Cut off torn record at the end of the file
+    /// @return Negative on error, >=0 on success
+    int32_t trim_torn(void);
+
+private:
+    durability_t m_durability = durability_t::batched; /*!< durability mode */
+    int m_fd = -1; /*!< journal file */
+    std::atomic<bool> m_open = false; /*!< true, if records are accepted */
+    uint64_t m_size = 0; /*!< size of the file, when it was closed */
+
+    std::mutex m_mutex; /*!< protects pending records and counters */
+    std::condition_variable m_pending_cv; /*!< wakes up the writer */
+    std::condition_variable m_durable_cv; /*!< wakes up sessions waiting for their batch */
+    std::string m_pending; /*!< records appended since the last batch */
+    uint64_t m_appended = 0; /*!< number of appended records */
+    uint64_t m_durable = 0; /*!< number of written records, flushed unless durability is none */
+    bool m_stop = false; /*!< writer thread should finish */
+    int32_t m_error = EXIT_SUCCESS; /*!< first error of the writer, records are still counted as written */
+    std::thread m_writer; /*!< writer thread */
+
+    std::atomic<uint64_t> m_batches = 0; /*!< number of batches */
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <istream>
+#include <cstdint>
+#include <cstddef>
+
+
+/*! \brief CJsonReader class.
+ *         Streaming JSON reader, returns one token after another
+ *
+ *  Document is read through fixed buffer, no tree of the document is built,
+ *  so memory doesn't grow with the size of the document. Caller pulls tokens
+ *  and keeps only what it needs, values it doesn't know are skipped.
+ *  Syntax is checked while reading, separators are consumed by the reader.
+ */
+class CJsonReader
+{
+public:
+    enum class token_t
+    { /*!< Token of the document */
+        begin_object, /*!< { */
+        end_object, /*!< } */
+        begin_array, /*!< [ */
+        end_array, /*!< ] */
+        key, /*!< name of object member, text is the name */
+        string, /*!< string value, text is unescaped value */
+        number, /*!< number value, text is the number */
+        literal, /*!< true, false or null, text is the literal */
+        end /*!< end of the document */
+    };
+
+public:
+    /// @brief Standard constructor
+    /// @param stream [in] document, must outlive the reader
+    explicit CJsonReader(std::istream &stream);
+
+    CJsonReader(const CJsonReader &) = delete;
+    CJsonReader &operator=(const CJsonReader &) = delete;
+
+    /// @brief Read next token
+    /// @param token [out] token
+    /// @return Negative on error, -EBADMSG if document is malformed, >=0 on success
+    int32_t next(token_t &token);
+
+    /// @brief Skip value, which starts with the token
+    /// @param token [in] first token of the value
+    /// @return Negative on error, >=0 on success
+    int32_t skip(token_t token);
+
+    /// @brief Get text of the last key, string, number or literal
+    /// @return text
+    const std::string &get_text(void) const {return m_text;};
+
+    /// @brief Convert text of the last number or string to unsigned number
+    /// @param value [out] number
+    /// @return Negative on error, -ERANGE if it doesn't fit, >=0 on success
+    int32_t get_uint32(uint32_t &value) const;
+
+    /// @brief Get number of bytes read so far, position of an error
+    /// @return offset within the document
+    uint64_t get_offset(void) const {return m_offset - (m_size - m_pos);};
+
+private:
+    enum class state_t
+    { /*!< What the document expects next */
+        value, /*!< any value */
+        first_value, /*!< any value or end of array */
+        key, /*!< name of member */
+        first_key, /*!< name of member or end of object */
+        separator, /*!< comma or end of the container */
+        done /*!< only white space */
+    };
+
+    /// @brief Get next character without consuming it, white space is skipped
+    /// @return character, -1 at the end of the document
+    int32_t peek_token(void);
+
+    /// @brief Get next character without consuming it
+    /// @return character, -1 at the end of the document
+    int32_t peek_char(void) {return ((m_pos == m_size)&&(fill() != true)) ? -1 : static_cast<uint8_t>(m_buffer[m_pos]);};
+
+    /// @brief Get next character
+    /// @return character, -1 at the end of the document
+    int32_t get(void);
+
+    /// @brief Read next block of the document into the buffer
+    /// @return false at the end of the document
+    bool fill(void);
+
+    /// @brief Read string into the text, opening quote is consumed
+    /// @return Negative on error, >=0 on success
+    int32_t read_string(void);
+
+    /// @brief Read number into the text
+    /// @return Negative on error, >=0 on success
+    int32_t read_number(void);
+
+    /// @brief Read true, false or null into the text
+    /// @return Negative on error, >=0 on success
+    int32_t read_literal(void);
+
+    /// @brief Read four hex digits of unicode escape
+    /// @param code [out] code unit
+    /// @return Negative on error, >=0 on success
+    int32_t read_hex(uint32_t &code);
+
+    /// @brief Value was completed, find out what follows it
+    void complete_value(void) {m_state = (m_nesting.empty()) ? state_t::done : state_t::separator;};
+
+private:
+    static constexpr std::size_t m_buffer_size = 64 * 1024; /*!< size of single read */
+
+    std::istream &m_stream; /*!< document */
+    std::vector<char> m_buffer; /*!< block of the document */
+    std::size_t m_pos = 0; /*!< next character within the buffer */
+    std::size_t m_size = 0; /*!< valid characters within the buffer */
+    uint64_t m_offset = 0; /*!< characters read from the stream */
+    std::string m_text; /*!< text of the last token */
+    std::vector<char> m_nesting; /*!< open containers, '{' or '[' */
+    state_t m_state = state_t::value; /*!< what the document expects next */
+};
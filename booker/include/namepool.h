@@ -0,0 +1,62 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+#include "catalog.h"
+
+
+/*! \brief CNamePool class.
+ *         Interned names, every distinct name is stored once
+ *
+ *  Names are copied into large blocks, which are never moved nor freed
+ *  before the pool, so returned views stay valid as long as the pool lives.
+ *  The same name interned again returns the view of the first copy, so views
+ *  of equal names have equal pointers. Names aren't removed, pool is dropped
+ *  as a whole with the catalog, which refers to it.
+ */
+class CNamePool
+{
+public:
+    /// @brief Standard constructor, empty pool
+    CNamePool() = default;
+
+    CNamePool(const CNamePool &) = delete;
+    CNamePool &operator=(const CNamePool &) = delete;
+
+    /// @brief Get stored copy of the name, it is stored if it isn't yet
+    /// @param name [in] name
+    /// @return view of the stored name
+    std::string_view intern(std::string_view name);
+
+    /// @brief Find stored name
+    /// @param name [in] name
+    /// @return view of the stored name, empty view with nullptr data if it isn't stored
+    std::string_view find(std::string_view name) const;
+
+    /// @brief Get number of distinct names
+    /// @return number of names
+    std::size_t size(void) const {return m_names.size();};
+
+    /// @brief Get number of bytes taken by the names
+    /// @return number of bytes
+    std::size_t get_bytes(void) const {return m_bytes;};
+
+private:
+    /// @brief Copy the name to the current block, new block is taken when it doesn't fit
+    /// @param name [in] name
+    /// @return view of the copy
+    std::string_view store(std::string_view name);
+
+private:
+    static constexpr std::size_t m_block_size = 64 * 1024; /*!< size of single block, longer names get a block of their own */
+
+    CCatalog<uint32_t, std::string_view> m_names; /*!< stored names, value is order of the name */
+    std::vector<std::unique_ptr<char[]>> m_blocks; /*!< blocks of names */
+    char *m_block = nullptr; /*!< block, where next names are stored */
+    std::size_t m_used = m_block_size; /*!< bytes used within the current block */
+    std::size_t m_bytes = 0; /*!< bytes taken by all the names */
+};
@@ -5,11 +5,48 @@
 #include <vector>
 #include <cstdint>
 
+struct show_seats_t
+{ /*!< Seat selection of single show within batch */
+    std::string movie_; /*!< movie */
+    std::string theatre_; /*!< theatre */
+    std::string seats_; /*!< seat selection text */
+};
+
 /// @brief Convert text to array of numbers
 /// @param seats [in] array in string
 /// @return array of numbers
 std::set<uint32_t> get_seats(const std::string &seats);
 
+/// @brief Convert text to array of numbers
+/// @param seats [in] array in string
+/// @param capacity [in] number of seats in the theatre
+/// @return array of numbers
+std::set<uint32_t> get_seats(const std::string &seats, uint32_t capacity);
+
+/// @brief Parse request for contiguous seats
+///         "4"  -> 4 seats anywhere
+///         "4@B"  -> 4 seats in row B
+/// @param request [in] request in string
+/// @param n [out] number of seats
+/// @param row [out] row name, empty if not requested
+/// @return Negative on error, >=0 on success
+int32_t get_best_request(const std::string &request, uint32_t &n, std::string &row);
+
+/// @brief Split batch request to shows
+///         "Matrix/Tokyo:1-3;Avatar/Delhi:5,6"  -> [Matrix, Tokyo, "1-3"], [Avatar, Delhi, "5,6"]
+/// @param request [in] request in string
+/// @param shows [out] seat selection per show
+/// @return Negative on error, >=0 on success
+int32_t get_batch_request(const std::string &request, std::vector<show_seats_t> &shows);
+
+/// @brief Split exchange request to released and booked seats
+///         "1,2>5-6"  -> "1,2", "5-6"
+/// @param request [in] request in string
+/// @param release [out] seats to be released
+/// @param take [out] seats to be booked instead
+/// @return Negative on error, >=0 on success
+int32_t get_exchange_request(const std::string &request, std::string &release, std::string &take);
+
 /// @brief Convert array back to string
 /// @param seats [out] string
 /// @param seats_set [in] array
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "booker.h"
+
+
+/*! \brief CBookerRegistry class.
+ *         Sharded table of active bookers, indexed by booker handle
+ *
+ *  Handle h lives in shard h % m_shards, slot h / m_shards, so every join,
+ *  leave and lookup locks a single shard only. New handles are taken from one
+ *  atomic counter, so they stay dense, and handles of left bookers are reused
+ *  before the counter grows. Number of active bookers is kept per shard and
+ *  summed on request, so counting never locks anything.
+ *  Handle 0 is never used, it marks free seat.
+ */
+class CBookerRegistry
+{
+public:
+    /// @brief Standard constructor, empty registry
+    CBookerRegistry() = default;
+
+    CBookerRegistry(const CBookerRegistry &) = delete;
+    CBookerRegistry &operator=(const CBookerRegistry &) = delete;
+
+    /// @brief Register booker and assign handle to it
+    /// @param booker [in] new booker
+    /// @return Negative on error, booker handle on success
+    int32_t insert(const CBooker::booker_ptr &booker);
+
+    /// @brief Find booker by handle
+    /// @param handle [in] booker handle
+    /// @return booker, nullptr if handle is not active
+    CBooker::booker_ptr find(uint32_t handle) const;
+
+    /// @brief Unregister booker
+    /// @param booker [in] booker
+    /// @param reuse [in] true, to reuse the handle and reset handle of the booker.
+    ///                   Handle, which still marks seats, must not be reused
+    /// @return true, if the booker was registered
+    bool erase(const CBooker::booker_ptr &booker, bool reuse);
+
+    /// @brief Never assign handles up to the given one, they still mark restored seats
+    ///     Must be called before bookers join
+    /// @param handle [in] the highest used handle
+    void retire(uint32_t handle);
+
+    /// @brief Get number of active bookers
+    /// @return number of bookers
+    std::size_t size(void) const;
+
+    /// @brief Get version of the registry, it grows with every join and leave
+    /// @return version
+    uint64_t version(void) const;
+
+    /// @brief Get number of handles, which were ever assigned
+    /// @return number of handles
+    std::size_t capacity(void) const {return m_next_handle.load(std::memory_order_relaxed) - 1;};
+
+public:
+    static constexpr uint32_t m_shards = 64;
+
+private:
+    struct alignas(64) shard
+    { /*!< Part of the table, own cache line for the lock and counter */
+        mutable std::mutex mutex_; /*!< protects slots and free handles */
+        std::vector<CBooker::booker_ptr> slots_; /*!< bookers by handle / m_shards */
+        std::vector<uint32_t> free_handles_; /*!< handles of this shard, which can be reused */
+        std::atomic<std::size_t> size_ = 0; /*!< number of active bookers */
+        std::atomic<uint64_t> changes_ = 0; /*!< number of joins and leaves */
+    };
+
+    /// @brief Take reusable handle from any shard
+    /// @param booker [in] new booker
+    /// @return handle, 0 if there is none
+    uint32_t reuse_handle(const CBooker::booker_ptr &booker);
+
+private:
+    std::array<shard, m_shards> m_shards_table; /*!< shards */
+    std::atomic<uint32_t> m_next_handle = 1; /*!< next never used handle */
+    std::atomic<uint32_t> m_free_handles = 0; /*!< number of reusable handles over all shards */
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <unordered_map>
+
+
+/*! \brief CResponseCache class.
+ *         Rendered responses shared by all the sessions
+ *
+ *  Response is identified by id of the rendered object (e.g. theatre), color
+ *  mode and version of the object. Only the newest version of every response
+ *  is kept. Concurrent requests for the same response wait for the single
+ *  rendering, responses are immutable, so sessions share them without copying.
+ */
+class CResponseCache
+{
+public:
+    using response_ptr = std::shared_ptr<const std::string>;
+    using render_t = std::function<void(std::string &response)>;
+
+public:
+    /// @brief Standard constructor, empty cache
+    CResponseCache() = default;
+
+    /// @brief Get rendered response, render it if it is not cached yet
+    /// @param id [in] id of the rendered object
+    /// @param color [in] true, if response is colored
+    /// @param version [in] version of the object, newer versions replace older ones
+    /// @param render [in] function, which renders the response
+    /// @return response, at least of the requested version
+    response_ptr get(uint32_t id, bool color, uint64_t version, const render_t &render);
+
+    /// @brief Get number of cached responses
+    /// @return number of responses
+    std::size_t size(void) const;
+
+    /// @brief Get number of renderings, for monitoring
+    /// @return number of renderings
+    uint64_t get_renders(void) const {return m_renders.load(std::memory_order_relaxed);};
+
+private:
+    struct entry
+    { /*!< Newest response of the object */
+        uint64_t version_; /*!< version of the object */
+        std::shared_future<response_ptr> response_; /*!< response, ready once rendered */
+    };
+
+private:
+    mutable std::mutex m_mutex; /*!< protects entries, never held while rendering */
+    std::unordered_map<uint64_t, entry> m_entries; /*!< responses by id and color */
+    std::atomic<uint64_t> m_renders = 0; /*!< number of renderings */
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "seatmap.h"
+
+
+/*! \brief CRunIndex class.
+ *         Segment tree of free seat runs
+ *
+ *  Leaves are the words of a seat map, every node keeps the length of the
+ *  free run at its start, at its end and the longest free run inside it.
+ *  Changing a word costs O(log words), finding the first run of n free seats
+ *  within any range of seats costs O(log words).
+ *  Class is not thread safe.
+ */
+class CRunIndex
+{
+public:
+    /// @brief Standard constructor, empty index
+    CRunIndex() = default;
+
+    /// @brief Build index of the map
+    /// @param map [in] seat map, marked seats are free
+    void build(const CSeatMap &map);
+
+    /// @brief Refresh words changed since the last refresh, index is built by the first refresh
+    /// @param map [in] seat map, marked seats are free
+    /// @return number of refreshed words
+    uint32_t refresh(CSeatMap &map);
+
+    /// @brief Get longest free run in the map
+    /// @return number of seats
+    uint32_t longest(void) const {return m_tree.empty() ? 0 : m_tree[1].best_;};
+
+    /// @brief Find the first run of free seats
+    /// @param n [in] number of seats, the run must have
+    /// @param first [in] first seat of the range, where the run is searched
+    /// @param last [in] seat behind the range
+    /// @return first seat of the run, negative if there is no such run
+    int64_t find(uint32_t n, uint32_t first, uint32_t last) const;
+
+private:
+    struct node
+    { /*!< Summary of seats covered by the node */
+        uint32_t len_ = 0; /*!< number of seats */
+        uint32_t prefix_ = 0; /*!< free seats at the beginning */
+        uint32_t suffix_ = 0; /*!< free seats at the end */
+        uint32_t best_ = 0; /*!< longest free run */
+    };
+
+    /// @brief Summary of single word
+    /// @param word [in] word, set bits are free seats
+    /// @param len [in] number of valid bits
+    /// @return summary
+    static node summary(CSeatMap::word_t word, uint32_t len);
+
+    /// @brief Merge summaries of two neighbours
+    /// @param left [in] left summary
+    /// @param right [in] right summary
+    /// @return merged summary
+    static node merge(const node &left, const node &right);
+
+    /// @brief Change one leaf and all its parents
+    /// @param word [in] index of the word
+    /// @param value [in] new value of the word
+    void update(std::size_t word, CSeatMap::word_t value);
+
+    /// @brief Search within the node, for run which is not covered by carried seats
+    /// @param idx [in] node index
+    /// @param lo [in] first word of the node
+    /// @param hi [in] word behind the node
+    /// @param n [in] number of seats
+    /// @param first [in] first seat of the range
+    /// @param last [in] seat behind the range
+    /// @param carry [io] free seats just in front of the node
+    /// @return first seat of the run, negative if there is no such run
+    int64_t find(std::size_t idx, std::size_t lo, std::size_t hi, uint32_t n, uint32_t first, uint32_t last, uint32_t &carry) const;
+
+    /// @brief Descend to the leftmost run of the node, node must contain it
+    /// @param idx [in] node index
+    /// @param lo [in] first word of the node
+    /// @param hi [in] word behind the node
+    /// @param n [in] number of seats
+    /// @return first seat of the run
+    int64_t descend(std::size_t idx, std::size_t lo, std::size_t hi, uint32_t n) const;
+
+    /// @brief Find the first run of n set bits in word
+    /// @param word [in] word
+    /// @param n [in] length of the run, 1 - 64
+    /// @return bit position, negative if there is no such run
+    static int32_t find_in_word(CSeatMap::word_t word, uint32_t n);
+
+private:
+    uint32_t m_capacity = 0; /*!< number of seats */
+    std::size_t m_words = 0; /*!< number of leaves */
+    std::vector<CSeatMap::word_t> m_leaves; /*!< copy of the map words */
+    std::vector<node> m_tree; /*!< 1 based tree, node i has children 2i and 2i+1 */
+};
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <set>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+
+/*! \brief CSeatMap class.
+ *         Bitmap of seats, one bit per seat
+ *
+ *  Seats are packed into 64 bit atomic words, so every operation on a theatre
+ *  costs O(words) instead of O(seats) tree nodes. Requests within few words
+ *  are claimed with compare-and-swap and released with atomic or, so they can
+ *  run concurrently without any lock. Larger requests are booked by the single
+ *  writer of the map, with kernels on whole request. All heavy loops are
+ *  implemented as kernels, which work on raw word arrays and are vectorized
+ *  when the target supports it (see BUILD_WITH_SIMD option).
+ *  Words are either owned by the map, or attached from outside, e.g. from
+ *  memory mapped file, so the seats outlive the process.
+ */
+class CSeatMap
+{
+public:
+    using word_t = uint64_t;
+    using atomic_word_t = std::atomic<word_t>;
+
+    /*! \brief Sparse request mask
+     *         Bitmap which covers only words touched by the request
+     */
+    struct mask_t
+    {
+        uint32_t first_word_ = 0; /*!< index of the first covered word in the seat map */
+        std::vector<word_t> words_; /*!< request bits, starting with first_word_ */
+    };
+
+public:
+    /// @brief Standard constructor, empty map
+    CSeatMap() = default;
+
+    /// @brief Create map of required size
+    /// @param capacity [in] number of seats
+    /// @param all_set [in] true, to mark all the seats
+    explicit CSeatMap(uint32_t capacity, bool all_set = false) {resize(capacity, all_set);};
+
+    /// @brief Move constructor, moved map is empty afterwards
+    /// @param other [io] map to be moved
+    CSeatMap(CSeatMap &&other) noexcept {*this = std::move(other);};
+
+    /// @brief Move assignment, moved map is empty afterwards
+    ///     Maps must not be used concurrently while moving
+    /// @param other [io] map to be moved
+    /// @return this map
+    CSeatMap &operator=(CSeatMap &&other) noexcept;
+
+    /// @brief Resize the map, previous content is lost
+    ///     Map must not be used concurrently while resizing
+    /// @param capacity [in] number of seats
+    /// @param all_set [in] true, to mark all the seats
+    void resize(uint32_t capacity, bool all_set);
+
+    /// @brief Get number of seats in the map
+    /// @return number of seats
+    uint32_t capacity(void) const {return m_capacity;};
+
+    /// @brief Use external words, their content is kept
+    ///     Map must not be used concurrently while attaching
+    /// @param words [in] words, must outlive the map or detach
+    /// @param capacity [in] number of seats, words must cover them
+    void attach(atomic_word_t *words, uint32_t capacity);
+
+    /// @brief Copy attached words to own storage, so the external ones can go away
+    ///     Map must not be used concurrently while detaching
+    void detach(void);
+
+    /// @brief Overwrite words of the map, capacity is kept
+    ///     Map must not be used concurrently while assigning
+    /// @param words [in] new words, must have the same number of words as the map
+    void assign(const std::vector<word_t> &words);
+
+    /// @brief Get number of words in the map
+    /// @return number of words
+    std::size_t words(void) const {return m_words_count;};
+
+    /// @brief Get number of words needed for the seats
+    /// @param capacity [in] number of seats
+    /// @return number of words
+    static constexpr std::size_t words(uint32_t capacity) {return (capacity + m_word_bits - 1) / m_word_bits;};
+
+    /// @brief Check if seat is marked
+    /// @param seat [in] seat number
+    /// @return true if marked
+    bool test(uint32_t seat) const;
+
+    /// @brief Number of marked seats
+    /// @return number of marked seats
+    uint32_t count(void) const;
+
+    /// @brief Number of marked seats, kept by every change, words are not read
+    ///     Claim, which gives its words back, can lower it for a moment
+    /// @return number of marked seats
+    uint32_t marked(void) const {return m_marked.load(std::memory_order_acquire);};
+
+    /// @brief Check if there is no marked seat
+    /// @return true, if no seat is marked
+    bool none(void) const;
+
+    /// @brief Copy words of the map
+    ///     Each word is read atomically, but the copy as a whole is not
+    /// @param words [out] copy of the words
+    void snapshot(std::vector<word_t> &words) const;
+
+    /// @brief Copy range of words of the map
+    /// @param first_word [in] index of the first word
+    /// @param n [in] number of words
+    /// @param words [out] copy of the words
+    void snapshot(uint32_t first_word, std::size_t n, std::vector<word_t> &words) const;
+
+    /// @brief Extract all marked seats
+    /// @param seats [out] list of marked seats
+    void to_set(std::set<uint32_t> &seats) const;
+
+    /// @brief Extract all marked seats
+    /// @param seats [out] list of marked seats, in ascending order
+    void to_vector(std::vector<uint32_t> &seats) const;
+
+    /// @brief Clear all the marked seats from the request with compare-and-swap per word
+    ///     Request of up to m_claim_max_words words is claimed as a whole or not at all.
+    ///     Words are claimed in ascending order, when a word fails, words claimed before
+    ///     are given back. Concurrent claim can see such seats taken for that short while.
+    ///     The map can be changed concurrently meanwhile
+    /// @param request [in] request mask
+    /// @param claimed [out] requested seats, which were marked. They are cleared on success, nothing is cleared on failure
+    /// @param best_effort [in] true, to claim marked seats only, even if some are not marked
+    /// @return true, if the seats were claimed
+    bool claim(const mask_t &request, mask_t &claimed, bool best_effort);
+
+    /// @brief Clear all the marked seats from the request, with kernels on whole request.
+    ///     Seats which are neither marked nor owned are reported back.
+    ///     Kernels work on a copy of the words, taken seats are then cleared word by word
+    ///     with atomic fetch_and. Seats of the request must not be claimed concurrently
+    /// @param request [in] request mask
+    /// @param owned [in] seats of the request, which are owned by the booker already. Same words as request
+    /// @param taken [out] seats, which were cleared
+    /// @param unavailable [out] list of seats, which are taken by somebody else
+    /// @param best_effort [in] true, to take the rest of the seats, even if some are unavailable
+    /// @return true, if the seats were taken
+    bool book(
+        const mask_t &request,
+        const mask_t &owned,
+        mask_t &taken,
+        std::vector<uint32_t> &unavailable,
+        bool best_effort);
+
+    /// @brief Mark all the seats from the mask
+    /// @param mask [in] seats to be marked
+    void release(const mask_t &mask);
+
+    /// @brief Collect words changed by claim or release since the last call
+    ///     Words are reported once, collecting clears the dirty flags
+    /// @param words [out] indexes of changed words, in ascending order
+    void collect_dirty(std::vector<uint32_t> &words);
+
+    /// @brief Build request mask from the list of seats
+    /// @param seats [in] list of seats
+    /// @param capacity [in] number of seats in theatre
+    /// @param mask [out] request mask
+    /// @return Negative on error, >=0 on success
+    static int32_t make_mask(const std::set<uint32_t> &seats, uint32_t capacity, mask_t &mask);
+
+    /// @brief Get number of words the request would span
+    /// @param seats [in] list of seats
+    /// @return number of words
+    static std::size_t mask_words(const std::set<uint32_t> &seats);
+
+    /// @brief Extract seats of the mask
+    /// @param mask [in] mask
+    /// @param seats [out] extracted seats are appended, in ascending order
+    static void mask_to_vector(const mask_t &mask, std::vector<uint32_t> &seats);
+
+public:
+    /* Kernels, working on raw arrays of words */
+
+    /// @brief Count all set bits
+    /// @param words [in] array of words
+    /// @param n [in] number of words
+    /// @return number of set bits
+    static uint32_t kernel_popcount(const word_t *words, std::size_t n);
+
+    /// @brief Check if any bit of the request is not set in a
+    /// @param req [in] request words
+    /// @param a [in] map words
+    /// @param n [in] number of words
+    /// @return true, if there is at least one such bit
+    static bool kernel_any_andnot(const word_t *req, const word_t *a, std::size_t n);
+
+    /// @brief Check if any bit of the request is neither in a nor in b
+    /// @param req [in] request words
+    /// @param a [in] first map words
+    /// @param b [in] second map words
+    /// @param n [in] number of words
+    /// @return true, if there is at least one such bit
+    static bool kernel_any_andnot2(const word_t *req, const word_t *a, const word_t *b, std::size_t n);
+
+    /// @brief Move requested bits, which are set in src, to dst
+    ///     src &= ~(req & src); dst |= (req & src)
+    /// @param src [io] source words
+    /// @param dst [io] destination words
+    /// @param req [in] request words
+    /// @param n [in] number of words
+    /// @return number of moved bits
+    static uint32_t kernel_move(word_t *src, word_t *dst, const word_t *req, std::size_t n);
+
+    /// @brief Extract positions of the set bits
+    /// @param words [in] array of words
+    /// @param n [in] number of words
+    /// @param base [in] seat number of the first bit
+    /// @param seats [out] extracted positions are appended
+    static void kernel_extract(const word_t *words, std::size_t n, uint32_t base, std::vector<uint32_t> &seats);
+
+    /// @brief Extract positions of the bits set in req, but not in a
+    /// @param req [in] request words
+    /// @param a [in] map words
+    /// @param n [in] number of words
+    /// @param base [in] seat number of the first bit
+    /// @param seats [out] extracted positions are appended
+    static void kernel_extract_andnot(
+        const word_t *req,
+        const word_t *a,
+        std::size_t n,
+        uint32_t base,
+        std::vector<uint32_t> &seats);
+
+    /// @brief Extract positions of the bits set in req, but not in a and not in b
+    /// @param req [in] request words
+    /// @param a [in] first map words
+    /// @param b [in] second map words
+    /// @param n [in] number of words
+    /// @param base [in] seat number of the first bit
+    /// @param seats [out] extracted positions are appended
+    static void kernel_extract_andnot2(
+        const word_t *req,
+        const word_t *a,
+        const word_t *b,
+        std::size_t n,
+        uint32_t base,
+        std::vector<uint32_t> &seats);
+
+public:
+    static constexpr uint32_t m_word_bits = 64;
+    static constexpr std::size_t m_claim_max_words = 4; /*!< widest request claimed without lock */
+
+private:
+    /// @brief Flag word as changed
+    /// @param word [in] index of the word
+    void mark_dirty(std::size_t word);
+
+private:
+    uint32_t m_capacity = 0; /*!< number of seats */
+    std::unique_ptr<atomic_word_t[]> m_storage; /*!< own words, empty if words are attached */
+    atomic_word_t *m_words = nullptr; /*!< bitmap words */
+    std::size_t m_words_count = 0; /*!< number of bitmap words */
+    std::vector<atomic_word_t> m_dirty; /*!< one bit per changed word */
+    std::atomic<uint32_t> m_marked = 0; /*!< number of marked seats */
+
+    static_assert(atomic_word_t::is_always_lock_free, "seat words must be lock free");
+    static_assert(sizeof(atomic_word_t) == sizeof(word_t), "seat words must be plain words in memory");
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "seatmap.h"
+
+
+/*! \brief CSeatStore class.
+ *         Memory mapped file with seat maps and owners of all the theatres
+ *
+ *  File starts with versioned header and table of theatres, followed by
+ *  seat words and owners of every theatre, each aligned to cache line.
+ *  Bookings modify the mapped memory directly, so restarted process maps
+ *  the file and serves at once. Header keeps hash of the catalog, checksum
+ *  of the content and clean flag. Flag is cleared as soon as the file is
+ *  mapped and set only by close, so file of crashed process is never trusted,
+ *  it is created again with all the seats free.
+ */
+class CSeatStore
+{
+public:
+    using owner_t = std::atomic<uint32_t>;
+
+    struct section
+    { /*!< Seats of single theatre within the file */
+        CSeatMap::atomic_word_t *words_ = nullptr; /*!< bitmap of free seats */
+        owner_t *owners_ = nullptr; /*!< booker id per seat */
+    };
+
+public:
+    /// @brief Standard constructor, nothing is mapped
+    CSeatStore() = default;
+
+    /// @brief Standard destructor, unmaps the file without marking it clean
+    ~CSeatStore();
+
+    CSeatStore(const CSeatStore &) = delete;
+    CSeatStore &operator=(const CSeatStore &) = delete;
+
+    /// @brief Map the file, it is created again if it doesn't fit the catalog or it is dirty
+    /// @param path [in] store file
+    /// @param catalog [in] hash of the catalog
+    /// @param capacities [in] number of seats per theatre, indexed by theatre id
+    /// @return Negative on error, 0 if seats were rebuilt, 1 if seats were restored
+    int32_t open(const std::string &path, uint64_t catalog, const std::vector<uint32_t> &capacities);
+
+    /// @brief Checksum content and mark the file clean. Content must not change anymore
+    /// @param journal_offset [in] size of the journal, which is contained in the seats
+    /// @return Negative on error, >=0 on success
+    int32_t close(uint64_t journal_offset);
+
+    /// @brief Check if file is mapped
+    /// @return true, if it is mapped
+    bool is_open(void) const {return m_base != nullptr;};
+
+    /// @brief Get path of the mapped file
+    /// @return path, empty if nothing is mapped
+    const std::string &get_path(void) const {return m_path;};
+
+    /// @brief Exchange mapped files of two stores
+    /// @param other [io] the other store
+    void swap(CSeatStore &other);
+
+    /// @brief Rename the mapped file, it replaces the file of the path
+    /// @param path [in] new path of the file
+    /// @return Negative on error, >=0 on success
+    int32_t rename(const std::string &path);
+
+    /// @brief Get seats of the theatre
+    /// @param theatre [in] theatre id
+    /// @return seats within the mapped file
+    const section &get_section(uint32_t theatre) const {return m_sections.at(theatre);};
+
+    /// @brief Get size of the journal, which was contained in restored seats
+    /// @return journal offset, 0 if seats were rebuilt
+    uint64_t get_journal_offset(void) const {return m_journal_offset;};
+
+public:
+    static constexpr uint32_t m_version = 1; /*!< version of the file layout */
+
+private:
+    struct header
+    { /*!< Beginning of the file */
+        char magic_[8]; /*!< file type */
+        uint32_t version_; /*!< version of the file layout */
+        uint32_t theatres_; /*!< number of theatres */
+        uint64_t catalog_; /*!< hash of the catalog */
+        uint64_t size_; /*!< size of the file */
+        uint64_t journal_offset_; /*!< size of the journal, contained in the seats */
+        uint64_t checksum_; /*!< checksum of everything behind the header */
+        uint32_t clean_; /*!< 1 if content was closed cleanly */
+        uint32_t reserved_; /*!< padding */
+    };
+
+    struct theatre_entry
+    { /*!< Theatre within the table of theatres */
+        uint32_t capacity_; /*!< number of seats */
+        uint32_t reserved_; /*!< padding */
+        uint64_t words_offset_; /*!< offset of seat words */
+        uint64_t owners_offset_; /*!< offset of owners */
+    };
+
+    /// @brief Checksum of everything behind the header
+    /// @return checksum
+    uint64_t checksum(void) const;
+
+    /// @brief Unmap and close the file
+    void unmap(void);
+
+private:
+    std::string m_path; /*!< store file path */
+    int m_fd = -1; /*!< store file */
+    uint8_t *m_base = nullptr; /*!< mapped file */
+    std::size_t m_size = 0; /*!< size of the mapping */
+    uint64_t m_journal_offset = 0; /*!< journal offset of restored seats */
+    std::vector<section> m_sections; /*!< seats per theatre id */
+
+    static constexpr char m_magic[8] = {'P', 'L', 'A', 'Y', 'S', 'E', 'A', 'T'};
+    static constexpr std::size_t m_align = 64; /*!< alignment of sections */
+
+    static_assert(sizeof(owner_t) == sizeof(uint32_t), "owners must be plain words in memory");
+    static_assert(owner_t::is_always_lock_free, "owners must be lock free");
+};
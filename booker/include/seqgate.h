@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+
+/*! \brief CSeqGate class.
+ *         Sequence counters, which let readers copy shared data without lock
+ *
+ *  Writers count started and finished writes, reader copies the data between
+ *  reading the finished counter and the started counter. Copy is consistent,
+ *  if both counters match, then no write was in progress and none started
+ *  meanwhile. Unlike classic seqlock any number of writers can run at once,
+ *  so it works also with CAS bookings of lock free engine.
+ *  Data itself must be read and written with atomic operations.
+ */
+class CSeqGate
+{
+public:
+    /*! \brief Write section, as long as the object lives */
+    class writer
+    {
+    public:
+        /// @brief Start write
+        /// @param gate [in] gate of written data
+        explicit writer(CSeqGate &gate) : m_gate(gate) {m_gate.begin_write();};
+
+        /// @brief Finish write
+        ~writer() {m_gate.end_write();};
+
+        writer(const writer &) = delete;
+        writer &operator=(const writer &) = delete;
+
+    private:
+        CSeqGate &m_gate;
+    };
+
+public:
+    /// @brief Standard constructor
+    CSeqGate() = default;
+
+    /// @brief Constructor, which counts finished writes also in total of several gates
+    /// @param total [in] counter of writes, shared by the gates
+    explicit CSeqGate(std::atomic<uint64_t> &total) : m_total(&total) {};
+
+    /// @brief Start write, must be called before data is changed
+    void begin_write(void)
+    {
+        m_started.fetch_add(1, std::memory_order_relaxed);
+        /*reader, which sees any of our data, sees also the counter*/
+        std::atomic_thread_fence(std::memory_order_release);
+    };
+
+    /// @brief Finish write, must be called after data is changed
+    void end_write(void)
+    {
+        m_finished.fetch_add(1, std::memory_order_release);
+        if (m_total != nullptr)
+            m_total->fetch_add(1, std::memory_order_release);
+    };
+
+    /// @brief Start read
+    /// @return ticket for read_valid
+    uint64_t read_begin(void) const {return m_finished.load(std::memory_order_acquire);};
+
+    /// @brief Check if data read since read_begin is consistent
+    /// @param ticket [in] value returned by read_begin
+    /// @return true, if no write was in progress or started meanwhile
+    bool read_valid(uint64_t ticket) const
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return m_started.load(std::memory_order_relaxed) == ticket;
+    };
+
+    /// @brief Get number of finished writes, data version
+    /// @return version
+    uint64_t version(void) const {return m_finished.load(std::memory_order_acquire);};
+
+private:
+    std::atomic<uint64_t> m_started = 0; /*!< number of started writes */
+    std::atomic<uint64_t> m_finished = 0; /*!< number of finished writes */
+    std::atomic<uint64_t> *m_total = nullptr; /*!< finished writes of all the gates sharing it, if any */
+};
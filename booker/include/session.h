@@ -37,6 +37,9 @@ private:
     /// Function prototype for all booking CLI functions
     using cli_cmd_cb_t = std::function<void(std::ostream& out, const std::string& arg, size_t movie_pos, size_t theatre_pos)>;
 
+    /// Function prototype for flat CLI functions, which address the show by handle
+    using cli_show_cmd_cb_t = std::function<void(std::ostream& out, size_t show, const std::string& arg)>;
+
     struct cli_cmds {
         cli_cmd_cb_t cli_cmd_cb; /*!< Function pointer to callback */
         cli::CmdHandler cmd_handler; /*!< CLI control class */
@@ -44,19 +47,32 @@ private:
 
     struct cli_theatre_cmds {
         std::string theatre; /*!< Theatre name */
+        uint32_t show; /*!< Show handle */
+        uint32_t capacity; /*!< Number of seats in the theatre */
         cli::CmdHandler theatre_menu; /*!< CLI control class */
 
         /*Booking functions*/
         cli_cmds seats;
+        cli_cmds layout;
         cli_cmds book;
         cli_cmds try_book;
+        cli_cmds book_best;
         cli_cmds unbook;
+        cli_cmds exchange;
+        cli_cmds hold;
+        cli_cmds confirm;
         cli_cmds status;
     };
 
+    struct send_msg_t {
+        std::vector<uint8_t> data_; /*!< message of this session */
+        CResponseCache::response_ptr response_; /*!< or shared rendered response, sent without copy */
+    };
+
     struct cli_movie_cmds {
         std::string movie; /*!< Movie name */
         cli::CmdHandler movie_menu; /*!< CLI control class */
+        cli_cmds book_any; /*!< Book seats in any theatre of the movie */
         std::vector<cli_theatre_cmds> theatre_cmd_vector; /*!< vector to theatres in movie*/ 
     };
 
@@ -90,6 +106,10 @@ private:
     /// @param  none
     void init_cli(void);
 
+    /// @brief Rebuild CLI menus from reloaded catalog, session starts again in the root menu
+    /// @param  none
+    void reload_cli(void);
+
     /// @brief Send message directly to socket
     /// @param message [in] message to be send
     void send_raw_msg(const char *message);
@@ -110,6 +130,11 @@ private:
     /// @param message [in] message to be send
     void send_msg(std::vector<uint8_t> &message);
 
+    /// @brief Send shared rendered response, behind everything written to CLI so far
+    ///     Response is queued for the socket as it is, when telnet would not change it
+    /// @param response [in] response with CR LF line ends
+    void send_response(const CResponseCache::response_ptr &response);
+
     /// @brief Hello mesaage to be send to the CLI console
     /// @param out [out] Stream to send message
     void cli_enter_cb(std::ostream &out);
@@ -137,13 +162,25 @@ private:
     boost::asio::awaitable<void> on_send(void);
 
 private:
-    /// @brief Support function to get all the reuierd names
-    /// @param movie [out] Name of the movie
-    /// @param theatre [out] Name of the theatre
+    /// @brief Support function to get all the reuierd names, without copying them
+    /// @param movie [out] Name of the movie, valid as long as the session
+    /// @param theatre [out] Name of the theatre, valid as long as the session
     /// @param movie_pos [in] Position of the movie
     /// @param theatre_pos [in] Position of the theatre
     /// @return Negative on error, >=0 on success
-    int32_t get_names (std::string &movie, std::string &theatre, size_t movie_pos, size_t theatre_pos);
+    int32_t get_names (std::string_view &movie, std::string_view &theatre, size_t movie_pos, size_t theatre_pos);
+
+    /// @brief Support function to get the show handle
+    /// @param movie_pos [in] Position of the movie
+    /// @param theatre_pos [in] Position of the theatre
+    /// @return Negative on error, show handle on success
+    int32_t get_show (size_t movie_pos, size_t theatre_pos) const;
+
+    /// @brief Support function to get the number of seats in the theatre
+    /// @param movie_pos [in] Position of the movie
+    /// @param theatre_pos [in] Position of the theatre
+    /// @return number of seats, 0 if position is invalid
+    uint32_t get_capacity (size_t movie_pos, size_t theatre_pos) const;
 
     /// @brief Default error function, which also terminates the session
     /// @param out [out] leaving message stream
@@ -157,6 +194,11 @@ private:
     /// @param arg [in] unused
     void status_cb (std::ostream& out, const std::string& arg);
 
+    /// @brief Callback function to book seats of several shows, all or nothing
+    /// @param out [out] output stream
+    /// @param arg [in] list of movie/theatre:seats, separated by ;
+    void batch_cb (std::ostream& out, const std::string& arg);
+
     /// @brief Callback function to list free seats
     /// @param out [out] output stream
     /// @param arg [in] unused
@@ -164,6 +206,13 @@ private:
     /// @param theatre_pos [in] theatre position
     void free_seats_cb (std::ostream& out, const std::string& arg, size_t movie_pos, size_t theatre_pos);
 
+    /// @brief Callback function to show seat layout of the theatre
+    /// @param out [out] output stream
+    /// @param arg [in] unused
+    /// @param movie_pos [in] movie position
+    /// @param theatre_pos [in] theatre position
+    void layout_cb (std::ostream& out, const std::string& arg, size_t movie_pos, size_t theatre_pos);
+
     /// @brief Callback function to book the seats
     ///     If any seat from the list is already taken, 
     ///     none of the seats will be taken
@@ -189,8 +238,92 @@ private:
     /// @param movie_pos [in] movie position
     /// @param theatre_pos [in] theatre position
     void unbook_seats_cb (std::ostream& out, const std::string& arg, size_t movie_pos, size_t theatre_pos);
+
+    /// @brief Release booked seats and book other seats at once, all or nothing
+    /// @param out [out] status output stream
+    /// @param arg [in] booking parameters [list of released seats > list of booked seats]
+    /// @param movie_pos [in] movie position
+    /// @param theatre_pos [in] theatre position
+    void exchange_seats_cb (std::ostream& out, const std::string& arg, size_t movie_pos, size_t theatre_pos);
+
+    /// @brief Callback function to book the first contiguous free seats
+    /// @param out [out] status output stream
+    /// @param arg [in] booking parameters [number of seats, optionally @row]
+    /// @param movie_pos [in] movie position
+    /// @param theatre_pos [in] theatre position
+    void bookbest_seats_cb (std::ostream& out, const std::string& arg, size_t movie_pos, size_t theatre_pos);
+
+    /// @brief Callback function to book contiguous free seats in any theatre of the movie
+    /// @param out [out] status output stream
+    /// @param arg [in] booking parameters [number of seats]
+    /// @param movie_pos [in] movie position
+    /// @param theatre_pos [in] not used, movie command has no theatre
+    void bookany_seats_cb (std::ostream& out, const std::string& arg, size_t movie_pos, size_t theatre_pos);
+
+    /// @brief Callback function to hold the seats for limited time
+    ///     If any seat from the list is already taken,
+    ///     none of the seats will be held
+    /// @param out [out] status output stream
+    /// @param arg [in] booking parameters [list of seats]
+    /// @param movie_pos [in] movie position
+    /// @param theatre_pos [in] theatre position
+    void hold_seats_cb (std::ostream& out, const std::string& arg, size_t movie_pos, size_t theatre_pos);
+
+    /// @brief Callback function to make held seats permanent
+    /// @param out [out] status output stream
+    /// @param arg [in] booking parameters [list of seats]
+    /// @param movie_pos [in] movie position
+    /// @param theatre_pos [in] theatre position
+    void confirm_seats_cb (std::ostream& out, const std::string& arg, size_t movie_pos, size_t theatre_pos);
     void book_status_cb (std::ostream& out, const std::string& arg, size_t movie_pos, size_t theatre_pos);
 
+    /// @brief Callback function to list all the shows with their handles
+    /// @param out [out] output stream
+    void shows_cb (std::ostream& out);
+
+    /// @brief Callback function to list movies played in the theatre with their handles
+    /// @param out [out] output stream
+    /// @param theatre [in] theatre
+    void playing_cb (std::ostream& out, const std::string& theatre);
+
+    /// @brief Callback function to list shows with at least n free seats
+    /// @param out [out] output stream
+    /// @param n [in] minimal number of free seats
+    void available_cb (std::ostream& out, size_t n);
+
+    /// @brief Callback function to list shows with the most free seats
+    /// @param out [out] output stream
+    /// @param k [in] maximal number of shows
+    void top_cb (std::ostream& out, size_t k);
+
+    /// @brief Write shows and their free seats
+    /// @param out [out] output stream
+    /// @param shows [in] shows
+    void write_availability (std::ostream& out, const std::vector<CBooking::show_availability> &shows);
+
+    /// @brief List free seats of the show, used by menu and by flat command
+    /// @param out [out] output stream
+    /// @param show [in] show handle
+    void show_free_seats (std::ostream& out, size_t show);
+
+    /// @brief Book seats of the show, used by menu and by flat command
+    /// @param out [out] status output stream
+    /// @param show [in] show handle
+    /// @param arg [in] booking parameters [list of seats]
+    /// @param best_effort [in] true, to skip already booked seats
+    void show_book_seats (std::ostream& out, size_t show, const std::string& arg, bool best_effort);
+
+    /// @brief Release booked seats of the show, used by menu and by flat command
+    /// @param out [out] status output stream
+    /// @param show [in] show handle
+    /// @param arg [in] booking parameters [list of seats]
+    void show_unbook_seats (std::ostream& out, size_t show, const std::string& arg);
+
+    /// @brief Report show handle, which doesn't exist
+    /// @param out [out] output stream
+    /// @param show [in] show handle
+    void unknown_show (std::ostream& out, size_t show);
+
 private:
     bool m_b_exit_done; /*!< variable set, if session was properly unregistered */
     bool m_b_exit_ready; /*!< variable to exit the session, when all messages are send*/
@@ -210,13 +343,25 @@ private:
     boost::asio::ip::tcp::socket m_socket;
     boost::asio::steady_timer m_timer;
     boost::asio::ip::tcp::tcp::tcp::acceptor::endpoint_type m_peer_endpoint;
-    std::deque<std::vector<uint8_t>> m_send_msgs_deque;
+    std::deque<send_msg_t> m_send_msgs_deque;
+    bool m_b_binary = false; /*!< remote end accepted binary transmission, text goes to socket as it is */
 
     CBooking &m_booking;
 
     /*dynamic CLI configuration, based on movies and theatres*/
     cli_cmd_cb_t m_cli_status_cmd_cb;
+    cli_cmd_cb_t m_cli_batch_cmd_cb;
+    std::function<void(std::ostream& out)> m_cli_shows_cmd_cb;
+    std::function<void(std::ostream& out, const std::string& theatre)> m_cli_playing_cmd_cb;
+    std::function<void(std::ostream& out, size_t n)> m_cli_available_cmd_cb;
+    std::function<void(std::ostream& out, size_t k)> m_cli_top_cmd_cb;
+    std::function<void(std::ostream& out, size_t show)> m_cli_show_seats_cmd_cb;
+    cli_show_cmd_cb_t m_cli_show_book_cmd_cb;
+    cli_show_cmd_cb_t m_cli_show_trybook_cmd_cb;
+    cli_show_cmd_cb_t m_cli_show_unbook_cmd_cb;
     std::vector<cli_movie_cmds> m_movie_cmd_vector;
+    uint64_t m_catalog_version = 0; /*!< version of the catalog, menus were built from */
+    bool m_b_cli_idle = true; /*!< no command is being typed, menus can be rebuilt */
 
 private:
     /*default telnet options*/
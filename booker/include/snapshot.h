@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+#include "seatmap.h"
+
+
+/*! \brief CSnapshot class.
+ *         Point-in-time image of seats of all the theatres, in compact binary file
+ *
+ *  File has header with version, then per theatre its movie and theatre names,
+ *  capacity, version, bitmap of free seats and owners of taken seats only,
+ *  and checksum at the end. Theatres are matched by names, so snapshot
+ *  survives reload of the catalog, which gives theatres other ids. Words
+ *  are stored in native byte order, snapshot is loaded by the same build,
+ *  which wrote it. File is written next to the target and renamed over it,
+ *  so the previous snapshot survives a crash.
+ */
+class CSnapshot
+{
+public:
+    struct theatre
+    { /*!< Image of single theatre */
+        std::string movie_; /*!< movie */
+        std::string theatre_; /*!< theatre where movie is played */
+        uint32_t capacity_ = 0; /*!< number of seats */
+        uint64_t version_ = 0; /*!< number of finished writes of the theatre, when it was copied */
+        std::vector<CSeatMap::word_t> free_words_; /*!< bitmap of free seats */
+        std::vector<std::pair<uint32_t, uint32_t>> owners_; /*!< seat and its owner, for taken seats */
+    };
+
+public:
+    /// @brief Standard constructor, empty image
+    CSnapshot() = default;
+
+    /// @brief Write image to the file
+    /// @param path [in] snapshot file, replaced atomically
+    /// @return Negative on error, size of the file on success
+    int32_t save(const std::string &path) const;
+
+    /// @brief Read image from the file
+    /// @param path [in] snapshot file
+    /// @return Negative on error, number of theatres on success
+    int32_t load(const std::string &path);
+
+public:
+    static constexpr uint32_t m_version = 2; /*!< version of the file layout */
+
+    std::vector<theatre> theatres_; /*!< theatres */
+
+private:
+    static constexpr char m_magic[8] = {'P', 'L', 'A', 'Y', 'S', 'N', 'A', 'P'};
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+/*! \brief CTimingWheel class.
+ *         Hierarchical timing wheel
+ *
+ *  Timers are kept in buckets of four wheels with 64 slots each. The first
+ *  wheel has one slot per tick, every next wheel has 64 times coarser slots.
+ *  When the first wheel wraps, one slot of the next wheel is cascaded down.
+ *  Scheduling costs O(1) and every tick costs O(1) plus the expired timers,
+ *  independently of the number of outstanding timers.
+ *  Timers are not cancelled, owner simply ignores ids which are not valid anymore.
+ *  Class is not thread safe.
+ */
+class CTimingWheel
+{
+public:
+    using timer_id_t = uint64_t;
+
+public:
+    /// @brief Standard constructor
+    CTimingWheel() = default;
+
+    /// @brief Get current tick of the wheel
+    /// @return current tick
+    uint64_t now(void) const {return m_now;};
+
+    /// @brief Get number of scheduled timers
+    /// @return number of timers
+    std::size_t size(void) const {return m_size;};
+
+    /// @brief Schedule timer
+    ///     Timers in the past or in the current tick expire on the next tick.
+    ///     Timers beyond the range of the wheel are rescheduled, when they reach the last wheel
+    /// @param id [in] timer id, returned back on expiration
+    /// @param tick [in] tick, when the timer expires
+    void schedule(timer_id_t id, uint64_t tick);
+
+    /// @brief Move wheel forward
+    /// @param tick [in] new current tick, nothing happens if it is not in the future
+    /// @param expired [out] ids of expired timers are appended
+    void advance(uint64_t tick, std::vector<timer_id_t> &expired);
+
+public:
+    static constexpr uint32_t m_slot_bits = 6;
+    static constexpr uint32_t m_slots = 1u << m_slot_bits;
+    static constexpr uint32_t m_levels = 4;
+
+private:
+    struct timer
+    { /*!< Scheduled timer */
+        timer_id_t id_; /*!< timer id */
+        uint64_t tick_; /*!< expiration tick */
+    };
+
+    using slot_t = std::vector<timer>;
+
+    /// @brief Put timer to the slot, which corresponds to its distance from now
+    /// @param entry [in] timer
+    void insert(const timer &entry);
+
+    /// @brief Move timers of the current slot of the level to lower levels
+    /// @param level [in] level to be cascaded
+    void cascade(uint32_t level);
+
+private:
+    uint64_t m_now = 0; /*!< current tick */
+    std::size_t m_size = 0; /*!< number of timers */
+    std::array<std::array<slot_t, m_slots>, m_levels> m_wheels; /*!< slots of all the levels */
+};
@@ -0,0 +1,246 @@
+#include <cerrno>
+#include <algorithm>
+#include <fstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "journal.h"
+
+
+/// @brief Standard destructor, flushes pending records
+CJournal::~CJournal()
+{
+    close();
+}
+
+/// @brief Open journal file for appending and start the writer thread
+/// @param path [in] journal file, created if it doesn't exist
+/// @param durability [in] durability mode
+/// @return Negative on error, >=0 on success
+int32_t CJournal::open(const std::string &path, durability_t durability)
+{
+    int32_t rc;
+
+    if (is_open()) {
+        return -EALREADY;
+    }
+
+    m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0640);
+    if (m_fd < 0) {
+        return -errno;
+    }
+
+    /*new records must not be glued to a torn one*/
+    rc = trim_torn();
+    if (rc < EXIT_SUCCESS) {
+        ::close(m_fd);
+        m_fd = -1;
+        return rc;
+    }
+
+    m_durability = durability;
+    m_stop = false;
+    m_error = EXIT_SUCCESS;
+    m_writer = std::thread(&CJournal::writer, this);
+    m_open.store(true, std::memory_order_release);
+
+    return EXIT_SUCCESS;
+}
+
+/// @brief Write pending records, stop the writer thread and close the file
+void CJournal::close(void)
+{
+    if (m_writer.joinable() != true) {
+        return;
+    }
+
+    m_open.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        m_stop = true;
+    }
+    m_pending_cv.notify_one();
+    m_writer.join();
+
+    off_t end = ::lseek(m_fd, 0, SEEK_END);
+    m_size = (end < 0) ? 0 : static_cast<uint64_t>(end);
+    ::close(m_fd);
+    m_fd = -1;
+}
+
+/// @brief Append record, it is written later by the writer thread
+/// @param record [in] single line, without new line
+void CJournal::append(const std::string &record)
+{
+    bool wakeup;
+
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+
+        /*writer is busy with the previous batch, if something is pending already*/
+        wakeup = m_pending.empty();
+        m_pending += record;
+        m_pending += '\n';
+        m_appended++;
+    }
+
+    if (wakeup) {
+        m_pending_cv.notify_one();
+    }
+}
+
+/// @brief Wait until records appended so far are durable.
+///     Returns at once, unless durability is per_op
+/// @return Negative if writer failed to write or flush, >=0 on success
+int32_t CJournal::sync(void)
+{
+    uint64_t target;
+
+    if ((is_open() != true)||(m_durability != durability_t::per_op)) {
+        return EXIT_SUCCESS;
+    }
+
+    std::unique_lock<std::mutex> lck(m_mutex);
+
+    /*records of other sessions appended meanwhile share the same flush*/
+    target = m_appended;
+    m_durable_cv.wait(lck, [this, target]() {return m_durable >= target;});
+
+    return m_error;
+}
+
+/// @brief Get first error of the writer thread
+/// @return Negative on error, >=0 if everything was written
+int32_t CJournal::get_error(void)
+{
+    std::lock_guard<std::mutex> lck(m_mutex);
+
+    return m_error;
+}
+
+/// @brief Writer thread, writes and flushes pending records in batches
+void CJournal::writer(void)
+{
+    int32_t rc;
+    uint64_t target;
+    std::string batch;
+
+    std::unique_lock<std::mutex> lck(m_mutex);
+
+    for (;;) {
+        m_pending_cv.wait(lck, [this]() {return (m_pending.empty() != true)||(m_stop);});
+        if (m_pending.empty()) {
+            /*stopped and everything is written*/
+            break;
+        }
+
+        /*everything appended while the previous batch was flushed goes at once*/
+        batch.clear();
+        batch.swap(m_pending);
+        target = m_appended;
+        lck.unlock();
+
+        rc = EXIT_SUCCESS;
+        for (std::size_t written = 0; written < batch.size();) {
+            ssize_t n = ::write(m_fd, batch.data() + written, batch.size() - written);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                rc = -errno;
+                break;
+            }
+            written += static_cast<std::size_t>(n);
+        }
+
+        if ((rc == EXIT_SUCCESS)&&(m_durability != durability_t::none)&&(::fdatasync(m_fd) != 0)) {
+            rc = -errno;
+        }
+        m_batches.fetch_add(1, std::memory_order_relaxed);
+
+        lck.lock();
+        if ((rc < EXIT_SUCCESS)&&(m_error == EXIT_SUCCESS)) {
+            m_error = rc;
+        }
+        /*failed batch is counted too, so nobody waits for it forever*/
+        m_durable = target;
+        m_durable_cv.notify_all();
+    }
+}
+
+/// @brief Cut off torn record at the end of the file
+/// @return Negative on error, >=0 on success
+int32_t CJournal::trim_torn(void)
+{
+    off_t end;
+    ssize_t n;
+    char buffer[4096];
+
+    end = ::lseek(m_fd, 0, SEEK_END);
+    if (end < 0) {
+        return -errno;
+    }
+
+    /*search backwards for the new line of the last complete record*/
+    for (off_t pos = end; pos > 0; pos -= n) {
+        n = static_cast<ssize_t>(std::min<off_t>(pos, sizeof(buffer)));
+        if (::pread(m_fd, buffer, static_cast<std::size_t>(n), pos - n) != n) {
+            return -EIO;
+        }
+
+        for (ssize_t i = n; i > 0; --i) {
+            if (buffer[i - 1] == '\n') {
+                if (pos - n + i == end)
+                    return EXIT_SUCCESS;
+                return (::ftruncate(m_fd, pos - n + i) == 0) ? EXIT_SUCCESS : -errno;
+            }
+        }
+    }
+
+    /*not even single complete record*/
+    return (::ftruncate(m_fd, 0) == 0) ? EXIT_SUCCESS : -errno;
+}
+
+/// @brief Read all complete records of journal file
+/// @param path [in] journal file
+/// @param apply [in] function called per record, negative return value stops replay
+/// @param offset [in] records before this offset are skipped
+/// @return Negative on error, number of records on success. Missing file has no records
+int32_t CJournal::replay(const std::string &path, const apply_t &apply, uint64_t offset)
+{
+    int32_t rc;
+    int32_t records;
+    std::string record;
+
+    if (::access(path.c_str(), F_OK) != 0) {
+        return (errno == ENOENT) ? 0 : -errno;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (file.is_open() != true) {
+        return -EIO;
+    }
+
+    if ((offset != 0)&&(!file.seekg(static_cast<std::streamoff>(offset)))) {
+        return -EIO;
+    }
+
+    records = 0;
+    while (std::getline(file, record)) {
+        if (file.eof()) {
+            /*no new line, writer crashed in the middle of the record*/
+            break;
+        }
+
+        if (record.empty())
+            continue;
+
+        rc = apply(record);
+        if (rc < EXIT_SUCCESS) {
+            return rc;
+        }
+        records++;
+    }
+
+    return records;
+}
@@ -0,0 +1,399 @@
+#include <cerrno>
+#include <cstdlib>
+
+#include "jsonreader.h"
+
+
+/// @brief Standard constructor
+/// @param stream [in] document, must outlive the reader
+CJsonReader::CJsonReader(std::istream &stream) :\
+    m_stream(stream), m_buffer(m_buffer_size)
+{
+
+}
+
+/// @brief Read next block of the document into the buffer
+/// @return false at the end of the document
+bool CJsonReader::fill(void)
+{
+    m_stream.read(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+
+    m_pos = 0;
+    m_size = static_cast<std::size_t>(m_stream.gcount());
+    m_offset += m_size;
+
+    return (m_size != 0);
+}
+
+/// @brief Get next character
+/// @return character, -1 at the end of the document
+int32_t CJsonReader::get(void)
+{
+    if ((m_pos == m_size)&&(fill() != true)) {
+        return -1;
+    }
+
+    return static_cast<uint8_t>(m_buffer[m_pos++]);
+}
+
+/// @brief Get next character without consuming it, white space is skipped
+/// @return character, -1 at the end of the document
+int32_t CJsonReader::peek_token(void)
+{
+    for (;;) {
+        if ((m_pos == m_size)&&(fill() != true)) {
+            return -1;
+        }
+
+        char ch = m_buffer[m_pos];
+        if ((ch != ' ')&&(ch != '\t')&&(ch != '\r')&&(ch != '\n')) {
+            return static_cast<uint8_t>(ch);
+        }
+        m_pos++;
+    }
+}
+
+/// @brief Read next token
+/// @param token [out] token
+/// @return Negative on error, -EBADMSG if document is malformed, >=0 on success
+int32_t CJsonReader::next(token_t &token)
+{
+    int32_t ch;
+
+    for (;;) {
+        ch = peek_token();
+
+        switch (m_state) {
+        case state_t::done:
+            if (ch != -1) {
+                /*garbage after the document*/
+                return -EBADMSG;
+            }
+            token = token_t::end;
+            return EXIT_SUCCESS;
+
+        case state_t::separator:
+            if (ch == ',') {
+                m_pos++;
+                m_state = (m_nesting.back() == '{') ? state_t::key : state_t::value;
+                continue;
+            }
+            if ((ch == '}')&&(m_nesting.back() == '{')) {
+                m_pos++;
+                m_nesting.pop_back();
+                complete_value();
+                token = token_t::end_object;
+                return EXIT_SUCCESS;
+            }
+            if ((ch == ']')&&(m_nesting.back() == '[')) {
+                m_pos++;
+                m_nesting.pop_back();
+                complete_value();
+                token = token_t::end_array;
+                return EXIT_SUCCESS;
+            }
+            return -EBADMSG;
+
+        case state_t::first_key:
+        case state_t::key:
+            if ((ch == '}')&&(m_state == state_t::first_key)) {
+                m_pos++;
+                m_nesting.pop_back();
+                complete_value();
+                token = token_t::end_object;
+                return EXIT_SUCCESS;
+            }
+            if (ch != '"') {
+                return -EBADMSG;
+            }
+            m_pos++;
+            if (read_string() < EXIT_SUCCESS) {
+                return -EBADMSG;
+            }
+            if (peek_token() != ':') {
+                return -EBADMSG;
+            }
+            m_pos++;
+            m_state = state_t::value;
+            token = token_t::key;
+            return EXIT_SUCCESS;
+
+        case state_t::first_value:
+        case state_t::value:
+            if ((ch == ']')&&(m_state == state_t::first_value)) {
+                m_pos++;
+                m_nesting.pop_back();
+                complete_value();
+                token = token_t::end_array;
+                return EXIT_SUCCESS;
+            }
+            if ((ch == '{')||(ch == '[')) {
+                m_pos++;
+                m_nesting.push_back(static_cast<char>(ch));
+                m_state = (ch == '{') ? state_t::first_key : state_t::first_value;
+                token = (ch == '{') ? token_t::begin_object : token_t::begin_array;
+                return EXIT_SUCCESS;
+            }
+            if (ch == '"') {
+                m_pos++;
+                if (read_string() < EXIT_SUCCESS) {
+                    return -EBADMSG;
+                }
+                token = token_t::string;
+            }
+            else if ((ch == '-')||((ch >= '0')&&(ch <= '9'))) {
+                if (read_number() < EXIT_SUCCESS) {
+                    return -EBADMSG;
+                }
+                token = token_t::number;
+            }
+            else if ((ch == 't')||(ch == 'f')||(ch == 'n')) {
+                if (read_literal() < EXIT_SUCCESS) {
+                    return -EBADMSG;
+                }
+                token = token_t::literal;
+            }
+            else {
+                return -EBADMSG;
+            }
+            complete_value();
+            return EXIT_SUCCESS;
+        }
+    }
+}
+
+/// @brief Skip value, which starts with the token
+/// @param token [in] first token of the value
+/// @return Negative on error, >=0 on success
+int32_t CJsonReader::skip(token_t token)
+{
+    int32_t rc;
+    std::size_t depth;
+
+    if ((token != token_t::begin_object)&&(token != token_t::begin_array)) {
+        /*scalar was read already*/
+        return EXIT_SUCCESS;
+    }
+
+    depth = m_nesting.size();
+    while (m_nesting.size() >= depth) {
+        rc = next(token);
+        if (rc < EXIT_SUCCESS) {
+            return rc;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/// @brief Convert text of the last number or string to unsigned number
+/// @param value [out] number
+/// @return Negative on error, -ERANGE if it doesn't fit, >=0 on success
+int32_t CJsonReader::get_uint32(uint32_t &value) const
+{
+    uint64_t number;
+
+    if (m_text.empty()) {
+        return -EINVAL;
+    }
+
+    number = 0;
+    for (char ch : m_text) {
+        if ((ch < '0')||(ch > '9')) {
+            /*negative, fraction or not a number at all*/
+            return -EINVAL;
+        }
+
+        number = number * 10 + static_cast<uint64_t>(ch - '0');
+        if (number > UINT32_MAX) {
+            return -ERANGE;
+        }
+    }
+
+    value = static_cast<uint32_t>(number);
+    return EXIT_SUCCESS;
+}
+
+/// @brief Read four hex digits of unicode escape
+/// @param code [out] code unit
+/// @return Negative on error, >=0 on success
+int32_t CJsonReader::read_hex(uint32_t &code)
+{
+    int32_t ch;
+
+    code = 0;
+    for (uint32_t i = 0; i < 4; ++i) {
+        ch = get();
+        if ((ch >= '0')&&(ch <= '9')) {
+            code = (code << 4) | static_cast<uint32_t>(ch - '0');
+        }
+        else if ((ch >= 'a')&&(ch <= 'f')) {
+            code = (code << 4) | static_cast<uint32_t>(ch - 'a' + 10);
+        }
+        else if ((ch >= 'A')&&(ch <= 'F')) {
+            code = (code << 4) | static_cast<uint32_t>(ch - 'A' + 10);
+        }
+        else {
+            return -EBADMSG;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/// @brief Read string into the text, opening quote is consumed
+/// @return Negative on error, >=0 on success
+int32_t CJsonReader::read_string(void)
+{
+    int32_t ch;
+    uint32_t code;
+    uint32_t low;
+
+    m_text.clear();
+    for (;;) {
+        /*plain characters are copied in runs, straight from the buffer*/
+        std::size_t start = m_pos;
+        while ((m_pos < m_size)&&(m_buffer[m_pos] != '"')&&(m_buffer[m_pos] != '\\')&&(static_cast<uint8_t>(m_buffer[m_pos]) >= 0x20)) {
+            m_pos++;
+        }
+        m_text.append(m_buffer.data() + start, m_pos - start);
+
+        ch = get();
+        if (ch == '"') {
+            return EXIT_SUCCESS;
+        }
+        if (ch == -1) {
+            return -EBADMSG;
+        }
+        if (ch != '\\') {
+            if (ch < 0x20) {
+                /*control characters must be escaped*/
+                return -EBADMSG;
+            }
+            m_text.push_back(static_cast<char>(ch));
+            continue;
+        }
+
+        ch = get();
+        switch (ch) {
+        case '"': m_text.push_back('"'); break;
+        case '\\': m_text.push_back('\\'); break;
+        case '/': m_text.push_back('/'); break;
+        case 'b': m_text.push_back('\b'); break;
+        case 'f': m_text.push_back('\f'); break;
+        case 'n': m_text.push_back('\n'); break;
+        case 'r': m_text.push_back('\r'); break;
+        case 't': m_text.push_back('\t'); break;
+        case 'u':
+            if (read_hex(code) < EXIT_SUCCESS) {
+                return -EBADMSG;
+            }
+            if ((code >= 0xD800)&&(code <= 0xDBFF)) {
+                /*high surrogate, low one must follow*/
+                if ((get() != '\\')||(get() != 'u')||(read_hex(low) < EXIT_SUCCESS)||(low < 0xDC00)||(low > 0xDFFF)) {
+                    return -EBADMSG;
+                }
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            }
+            else if ((code >= 0xDC00)&&(code <= 0xDFFF)) {
+                return -EBADMSG;
+            }
+
+            /*UTF-8*/
+            if (code < 0x80) {
+                m_text.push_back(static_cast<char>(code));
+            }
+            else if (code < 0x800) {
+                m_text.push_back(static_cast<char>(0xC0 | (code >> 6)));
+                m_text.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+            }
+            else if (code < 0x10000) {
+                m_text.push_back(static_cast<char>(0xE0 | (code >> 12)));
+                m_text.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                m_text.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+            }
+            else {
+                m_text.push_back(static_cast<char>(0xF0 | (code >> 18)));
+                m_text.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+                m_text.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                m_text.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+            }
+            break;
+        default:
+            return -EBADMSG;
+        }
+    }
+}
+
+/// @brief Read number into the text
+/// @return Negative on error, >=0 on success
+int32_t CJsonReader::read_number(void)
+{
+    int32_t ch;
+    std::size_t digits;
+
+    auto read_digits = [this, &ch]() -> std::size_t
+    {
+        std::size_t count = 0;
+
+        while (((ch = peek_char()) >= '0')&&(ch <= '9')) {
+            m_text.push_back(static_cast<char>(get()));
+            count++;
+        }
+
+        return count;
+    };
+
+    m_text.clear();
+    if (peek_char() == '-') {
+        m_text.push_back(static_cast<char>(get()));
+    }
+
+    /*no leading zeros*/
+    if (peek_char() == '0') {
+        m_text.push_back(static_cast<char>(get()));
+    }
+    else if (read_digits() == 0) {
+        return -EBADMSG;
+    }
+
+    if (peek_char() == '.') {
+        m_text.push_back(static_cast<char>(get()));
+        if (read_digits() == 0) {
+            return -EBADMSG;
+        }
+    }
+
+    ch = peek_char();
+    if ((ch == 'e')||(ch == 'E')) {
+        m_text.push_back(static_cast<char>(get()));
+        ch = peek_char();
+        if ((ch == '+')||(ch == '-')) {
+            m_text.push_back(static_cast<char>(get()));
+        }
+        digits = read_digits();
+        if (digits == 0) {
+            return -EBADMSG;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/// @brief Read true, false or null into the text
+/// @return Negative on error, >=0 on success
+int32_t CJsonReader::read_literal(void)
+{
+    int32_t ch;
+
+    m_text.clear();
+    while (((ch = peek_char()) >= 'a')&&(ch <= 'z')) {
+        m_text.push_back(static_cast<char>(get()));
+    }
+
+    if ((m_text != "true")&&(m_text != "false")&&(m_text != "null")) {
+        return -EBADMSG;
+    }
+
+    return EXIT_SUCCESS;
+}
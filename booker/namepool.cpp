@@ -0,0 +1,59 @@
+#include <cstring>
+
+#include "namepool.h"
+
+
+/// @brief Get stored copy of the name, it is stored if it isn't yet
+/// @param name [in] name
+/// @return view of the stored name
+std::string_view CNamePool::intern(std::string_view name)
+{
+    auto it = m_names.find(name);
+    if (it != m_names.end()) {
+        return it->first;
+    }
+
+    /*hash table refers to the copy, the caller's buffer can go away*/
+    std::string_view stored = store(name);
+    m_names.insert(stored, static_cast<uint32_t>(m_names.size()));
+
+    return stored;
+}
+
+/// @brief Find stored name
+/// @param name [in] name
+/// @return view of the stored name, empty view with nullptr data if it isn't stored
+std::string_view CNamePool::find(std::string_view name) const
+{
+    auto it = m_names.find(name);
+
+    return (it != m_names.end()) ? it->first : std::string_view();
+}
+
+/// @brief Copy the name to the current block, new block is taken when it doesn't fit
+/// @param name [in] name
+/// @return view of the copy
+std::string_view CNamePool::store(std::string_view name)
+{
+    char *p_name;
+
+    if (name.size() > m_block_size) {
+        /*long name gets its own block, the current one is kept for next names*/
+        m_blocks.push_back(std::make_unique<char[]>(name.size()));
+        p_name = m_blocks.back().get();
+    }
+    else {
+        if ((m_block == nullptr)||(m_block_size - m_used < name.size())) {
+            m_blocks.push_back(std::make_unique<char[]>(m_block_size));
+            m_block = m_blocks.back().get();
+            m_used = 0;
+        }
+        p_name = m_block + m_used;
+        m_used += name.size();
+    }
+
+    std::memcpy(p_name, name.data(), name.size());
+    m_bytes += name.size();
+
+    return std::string_view(p_name, name.size());
+}
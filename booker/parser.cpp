@@ -2,6 +2,9 @@
 #include <string>
 #include <sstream>
 #include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <charconv>
 
 #include "parser.h"
 #include "booking.h"
@@ -73,6 +76,108 @@ std::set<uint32_t> get_seats(const std::string &seats)
     return str_to_seats(seats, CBooking::get_max_seats());
 }
 
+/// @brief Convert text to array of numbers
+/// @param seats [in] array in string
+/// @param capacity [in] number of seats in the theatre
+/// @return array of numbers
+std::set<uint32_t> get_seats(const std::string &seats, uint32_t capacity)
+{
+    return str_to_seats(seats, capacity);
+}
+
+/// @brief Parse request for contiguous seats
+///         "4"  -> 4 seats anywhere
+///         "4@B"  -> 4 seats in row B
+/// @param request [in] request in string
+/// @param n [out] number of seats
+/// @param row [out] row name, empty if not requested
+/// @return Negative on error, >=0 on success
+int32_t get_best_request(const std::string &request, uint32_t &n, std::string &row)
+{
+    std::string str = trim(request);
+    size_t at = str.find('@');
+    std::string count = trim(str.substr(0, at));
+
+    n = 0;
+    row.clear();
+
+    auto rc = std::from_chars(count.data(), count.data() + count.size(), n);
+    if ((rc.ec != std::errc())||(rc.ptr != count.data() + count.size())||(n == 0)) {
+        return -EINVAL;
+    }
+
+    if (at != std::string::npos) {
+        row = trim(str.substr(at + 1));
+        if (row.empty())
+            return -EINVAL;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/// @brief Split batch request to shows
+///         "Matrix/Tokyo:1-3;Avatar/Delhi:5,6"  -> [Matrix, Tokyo, "1-3"], [Avatar, Delhi, "5,6"]
+/// @param request [in] request in string
+/// @param shows [out] seat selection per show
+/// @return Negative on error, >=0 on success
+int32_t get_batch_request(const std::string &request, std::vector<show_seats_t> &shows)
+{
+    std::istringstream iss(request);
+    std::string sstr;
+
+    shows.clear();
+
+    while (std::getline(iss, sstr, ';')) {
+        sstr = trim(sstr);
+        if (sstr.empty())
+            continue;
+
+        size_t slash = sstr.find('/');
+        size_t colon = sstr.find(':');
+        if ((slash == std::string::npos)||(colon == std::string::npos)||(colon < slash)) {
+            return -EINVAL;
+        }
+
+        show_seats_t show;
+        show.movie_ = trim(sstr.substr(0, slash));
+        show.theatre_ = trim(sstr.substr(slash + 1, colon - slash - 1));
+        show.seats_ = trim(sstr.substr(colon + 1));
+        if ((show.movie_.empty())||(show.theatre_.empty())||(show.seats_.empty())) {
+            return -EINVAL;
+        }
+
+        shows.push_back(std::move(show));
+    }
+
+    return shows.empty() ? -EINVAL : static_cast<int32_t>(shows.size());
+}
+
+/// @brief Split exchange request to released and booked seats
+///         "1,2>5-6"  -> "1,2", "5-6"
+/// @param request [in] request in string
+/// @param release [out] seats to be released
+/// @param take [out] seats to be booked instead
+/// @return Negative on error, >=0 on success
+int32_t get_exchange_request(const std::string &request, std::string &release, std::string &take)
+{
+    size_t arrow = request.find('>');
+
+    release.clear();
+    take.clear();
+
+    if ((arrow == std::string::npos)||(request.find('>', arrow + 1) != std::string::npos)) {
+        return -EINVAL;
+    }
+
+    release = trim(request.substr(0, arrow));
+    take = trim(request.substr(arrow + 1));
+    if ((release.empty())||(take.empty())) {
+        return -EINVAL;
+    }
+
+    return EXIT_SUCCESS;
+}
+
 /// @brief Convert array back to string
 /// @param seats [out] string
 /// @param seats_set [in] array
@@ -0,0 +1,168 @@
+#include <thread>
+#include <cerrno>
+#include <climits>
+#include <functional>
+
+#include "registry.h"
+
+
+/// @brief Register booker and assign handle to it
+/// @param booker [in] new booker
+/// @return Negative on error, booker handle on success
+int32_t CBookerRegistry::insert(const CBooker::booker_ptr &booker)
+{
+    uint32_t handle;
+
+    if (booker == nullptr)
+        return -EINVAL;
+
+    if (booker->get_booker_id() != 0)
+        return -EEXIST;
+
+    /*left handles first, so handles stay dense*/
+    handle = 0;
+    if (m_free_handles.load(std::memory_order_relaxed) != 0) {
+        handle = reuse_handle(booker);
+    }
+
+    if (handle == 0) {
+        handle = m_next_handle.fetch_add(1, std::memory_order_relaxed);
+        if (handle > INT32_MAX) {
+            m_next_handle.fetch_sub(1, std::memory_order_relaxed);
+            return -ENOMEM;
+        }
+
+        shard &entry = m_shards_table[handle % m_shards];
+        std::lock_guard<std::mutex> lck(entry.mutex_);
+
+        /*handles of the shard can be taken by other threads out of order*/
+        if (entry.slots_.size() <= handle / m_shards) {
+            entry.slots_.resize(handle / m_shards + 1);
+        }
+        entry.slots_[handle / m_shards] = booker;
+        entry.size_.fetch_add(1, std::memory_order_relaxed);
+        entry.changes_.fetch_add(1, std::memory_order_relaxed);
+        booker->set_booker_id(handle);
+    }
+
+    return static_cast<int32_t>(handle);
+}
+
+/// @brief Find booker by handle
+/// @param handle [in] booker handle
+/// @return booker, nullptr if handle is not active
+CBooker::booker_ptr CBookerRegistry::find(uint32_t handle) const
+{
+    const shard &entry = m_shards_table[handle % m_shards];
+    std::lock_guard<std::mutex> lck(entry.mutex_);
+
+    if (handle / m_shards >= entry.slots_.size())
+        return nullptr;
+
+    return entry.slots_[handle / m_shards];
+}
+
+/// @brief Unregister booker
+/// @param booker [in] booker
+/// @param reuse [in] true, to reuse the handle and reset handle of the booker.
+///                   Handle, which still marks seats, must not be reused
+/// @return true, if the booker was registered
+bool CBookerRegistry::erase(const CBooker::booker_ptr &booker, bool reuse)
+{
+    uint32_t handle;
+
+    if (booker == nullptr)
+        return false;
+
+    handle = booker->get_booker_id();
+    if (handle == 0)
+        return false;
+
+    shard &entry = m_shards_table[handle % m_shards];
+    std::lock_guard<std::mutex> lck(entry.mutex_);
+
+    if ((handle / m_shards >= entry.slots_.size())||(entry.slots_[handle / m_shards] != booker))
+        return false;
+
+    entry.slots_[handle / m_shards] = nullptr;
+    entry.size_.fetch_sub(1, std::memory_order_relaxed);
+    entry.changes_.fetch_add(1, std::memory_order_relaxed);
+
+    if (reuse) {
+        entry.free_handles_.push_back(handle);
+        m_free_handles.fetch_add(1, std::memory_order_relaxed);
+        booker->set_booker_id(0);
+    }
+
+    return true;
+}
+
+/// @brief Never assign handles up to the given one, they still mark restored seats
+///     Must be called before bookers join
+/// @param handle [in] the highest used handle
+void CBookerRegistry::retire(uint32_t handle)
+{
+    uint32_t next;
+
+    next = m_next_handle.load(std::memory_order_relaxed);
+    while ((next <= handle)&&(m_next_handle.compare_exchange_weak(next, handle + 1, std::memory_order_relaxed) != true));
+}
+
+/// @brief Get number of active bookers
+/// @return number of bookers
+std::size_t CBookerRegistry::size(void) const
+{
+    std::size_t size;
+
+    size = 0;
+    for (const shard &entry : m_shards_table) {
+        size += entry.size_.load(std::memory_order_relaxed);
+    }
+
+    return size;
+}
+
+/// @brief Get version of the registry, it grows with every join and leave
+/// @return version
+uint64_t CBookerRegistry::version(void) const
+{
+    uint64_t version;
+
+    version = 0;
+    for (const shard &entry : m_shards_table) {
+        version += entry.changes_.load(std::memory_order_relaxed);
+    }
+
+    return version;
+}
+
+/// @brief Take reusable handle from any shard
+/// @param booker [in] new booker
+/// @return handle, 0 if there is none
+uint32_t CBookerRegistry::reuse_handle(const CBooker::booker_ptr &booker)
+{
+    uint32_t handle;
+    std::size_t first;
+
+    /*threads start searching in different shards, so they don't queue on one lock*/
+    first = std::hash<std::thread::id>()(std::this_thread::get_id());
+    for (std::size_t i = 0; i < m_shards; ++i) {
+        shard &entry = m_shards_table[(first + i) % m_shards];
+        std::lock_guard<std::mutex> lck(entry.mutex_);
+
+        if (entry.free_handles_.empty())
+            continue;
+
+        handle = entry.free_handles_.back();
+        entry.free_handles_.pop_back();
+        m_free_handles.fetch_sub(1, std::memory_order_relaxed);
+
+        entry.slots_[handle / m_shards] = booker;
+        entry.size_.fetch_add(1, std::memory_order_relaxed);
+        entry.changes_.fetch_add(1, std::memory_order_relaxed);
+        booker->set_booker_id(handle);
+        return handle;
+    }
+
+    return 0;
+}
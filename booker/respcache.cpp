@@ -0,0 +1,64 @@
+#include "respcache.h"
+
+
+/// @brief Get rendered response, render it if it is not cached yet
+/// @param id [in] id of the rendered object
+/// @param color [in] true, if response is colored
+/// @param version [in] version of the object, newer versions replace older ones
+/// @param render [in] function, which renders the response
+/// @return response, at least of the requested version
+CResponseCache::response_ptr CResponseCache::get(uint32_t id, bool color, uint64_t version, const render_t &render)
+{
+    uint64_t key;
+    std::promise<response_ptr> promise;
+    std::shared_future<response_ptr> future;
+    bool promise_owner = false;
+
+    key = (static_cast<uint64_t>(id) << 1) | (color ? 1 : 0);
+
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+
+        auto it = m_entries.find(key);
+        if ((it != m_entries.end())&&(it->second.version_ >= version)) {
+            /*ready, or somebody else is rendering it just now*/
+            future = it->second.response_;
+        }
+        else {
+            future = promise.get_future().share();
+            m_entries[key] = entry{version, future};
+            promise_owner = true;
+        }
+    }
+
+    if (promise_owner != true) {
+        return future.get();
+    }
+
+    try {
+        auto response = std::make_shared<std::string>();
+        render(*response);
+        m_renders.fetch_add(1, std::memory_order_relaxed);
+        promise.set_value(std::move(response));
+    }
+    catch (...) {
+        /*waiting sessions get the exception, next request renders again*/
+        promise.set_exception(std::current_exception());
+
+        std::lock_guard<std::mutex> lck(m_mutex);
+        auto it = m_entries.find(key);
+        if ((it != m_entries.end())&&(it->second.version_ == version))
+            m_entries.erase(it);
+    }
+
+    return future.get();
+}
+
+/// @brief Get number of cached responses
+/// @return number of responses
+std::size_t CResponseCache::size(void) const
+{
+    std::lock_guard<std::mutex> lck(m_mutex);
+
+    return m_entries.size();
+}
@@ -0,0 +1,250 @@
+#include <bit>
+#include <cassert>
+#include <algorithm>
+
+#include "runindex.h"
+
+
+/// @brief Build index of the map
+/// @param map [in] seat map, marked seats are free
+void CRunIndex::build(const CSeatMap &map)
+{
+    std::size_t size;
+
+    m_capacity = map.capacity();
+    m_words = map.words();
+    map.snapshot(m_leaves);
+
+    /*perfect tree, leaves behind the map are empty*/
+    size = std::bit_ceil(std::max<std::size_t>(m_words, 1));
+    m_tree.assign(2 * size, node());
+    for (std::size_t i = 0; i < m_words; ++i) {
+        m_tree[size + i] = summary(m_leaves[i], std::min<uint32_t>(CSeatMap::m_word_bits, m_capacity - static_cast<uint32_t>(i * CSeatMap::m_word_bits)));
+    }
+    for (std::size_t i = size - 1; i > 0; --i) {
+        m_tree[i] = merge(m_tree[2 * i], m_tree[2 * i + 1]);
+    }
+}
+
+/// @brief Refresh words changed since the last refresh, index is built by the first refresh
+/// @param map [in] seat map, marked seats are free
+/// @return number of refreshed words
+uint32_t CRunIndex::refresh(CSeatMap &map)
+{
+    std::vector<uint32_t> words;
+    std::vector<CSeatMap::word_t> value;
+
+    map.collect_dirty(words);
+    if (m_tree.empty()) {
+        /*flags are dropped before the copy, words changed meanwhile are flagged again*/
+        build(map);
+        return static_cast<uint32_t>(m_words);
+    }
+
+    assert(map.words() == m_words);
+
+    for (uint32_t word : words) {
+        map.snapshot(word, 1, value);
+        update(word, value[0]);
+    }
+
+    return static_cast<uint32_t>(words.size());
+}
+
+/// @brief Find the first run of free seats
+/// @param n [in] number of seats, the run must have
+/// @param first [in] first seat of the range, where the run is searched
+/// @param last [in] seat behind the range
+/// @return first seat of the run, negative if there is no such run
+int64_t CRunIndex::find(uint32_t n, uint32_t first, uint32_t last) const
+{
+    uint32_t carry;
+
+    last = std::min(last, m_capacity);
+    if ((n == 0)||(first >= last)||(last - first < n)||(longest() < n)) {
+        return -1;
+    }
+
+    carry = 0;
+    return find(1, 0, m_tree.size() / 2, n, first, last, carry);
+}
+
+/// @brief Summary of single word
+/// @param word [in] word, set bits are free seats
+/// @param len [in] number of valid bits
+/// @return summary
+CRunIndex::node CRunIndex::summary(CSeatMap::word_t word, uint32_t len)
+{
+    node result;
+
+    result.len_ = len;
+    if (len == 0)
+        return result;
+
+    result.prefix_ = std::min<uint32_t>(static_cast<uint32_t>(std::countr_one(word)), len);
+    result.suffix_ = static_cast<uint32_t>(std::countl_one(static_cast<CSeatMap::word_t>(word << (CSeatMap::m_word_bits - len))));
+    result.suffix_ = std::min(result.suffix_, len);
+
+    /*every step shortens all the runs by one*/
+    while (word != 0) {
+        word &= word >> 1;
+        result.best_++;
+    }
+
+    return result;
+}
+
+/// @brief Merge summaries of two neighbours
+/// @param left [in] left summary
+/// @param right [in] right summary
+/// @return merged summary
+CRunIndex::node CRunIndex::merge(const node &left, const node &right)
+{
+    node result;
+
+    result.len_ = left.len_ + right.len_;
+    result.prefix_ = (left.prefix_ == left.len_) ? left.len_ + right.prefix_ : left.prefix_;
+    result.suffix_ = (right.suffix_ == right.len_) ? right.len_ + left.suffix_ : right.suffix_;
+    result.best_ = std::max({left.best_, right.best_, left.suffix_ + right.prefix_});
+
+    return result;
+}
+
+/// @brief Change one leaf and all its parents
+/// @param word [in] index of the word
+/// @param value [in] new value of the word
+void CRunIndex::update(std::size_t word, CSeatMap::word_t value)
+{
+    std::size_t idx;
+
+    assert(word < m_words);
+
+    m_leaves[word] = value;
+    idx = m_tree.size() / 2 + word;
+    m_tree[idx] = summary(value, m_tree[idx].len_);
+    for (idx /= 2; idx > 0; idx /= 2) {
+        m_tree[idx] = merge(m_tree[2 * idx], m_tree[2 * idx + 1]);
+    }
+}
+
+/// @brief Search within the node, for run which is not covered by carried seats
+/// @param idx [in] node index
+/// @param lo [in] first word of the node
+/// @param hi [in] word behind the node
+/// @param n [in] number of seats
+/// @param first [in] first seat of the range
+/// @param last [in] seat behind the range
+/// @param carry [io] free seats just in front of the node
+/// @return first seat of the run, negative if there is no such run
+int64_t CRunIndex::find
+(
+    std::size_t idx,
+    std::size_t lo,
+    std::size_t hi,
+    uint32_t n,
+    uint32_t first,
+    uint32_t last,
+    uint32_t &carry
+) const
+{
+    int64_t rc;
+    uint64_t start;
+    uint64_t end;
+
+    start = lo * CSeatMap::m_word_bits;
+    end = std::min<uint64_t>(hi * CSeatMap::m_word_bits, m_capacity);
+    if ((end <= first)||(start >= last)||(start >= end)) {
+        return -1;
+    }
+
+    if ((hi - lo == 1)||((start >= first)&&(end <= last))) {
+        node summ;
+        CSeatMap::word_t word = 0;
+
+        if (hi - lo == 1) {
+            /*seats out of the range are taken as occupied*/
+            word = m_leaves[lo];
+            if (first > start)
+                word &= ~static_cast<CSeatMap::word_t>(0) << (first - start);
+            if (last < start + CSeatMap::m_word_bits)
+                word &= (static_cast<CSeatMap::word_t>(1) << (last - start)) - 1;
+            summ = summary(word, m_tree[idx].len_);
+        }
+        else {
+            summ = m_tree[idx];
+        }
+
+        if (carry + summ.prefix_ >= n) {
+            return static_cast<int64_t>(start) - carry;
+        }
+
+        if (summ.best_ >= n) {
+            if (hi - lo == 1)
+                return static_cast<int64_t>(start) + find_in_word(word, n);
+            return descend(idx, lo, hi, n);
+        }
+
+        carry = (summ.prefix_ == summ.len_) ? carry + summ.len_ : summ.suffix_;
+        return -1;
+    }
+
+    rc = find(2 * idx, lo, (lo + hi) / 2, n, first, last, carry);
+    if (rc >= 0)
+        return rc;
+
+    return find(2 * idx + 1, (lo + hi) / 2, hi, n, first, last, carry);
+}
+
+/// @brief Descend to the leftmost run of the node, node must contain it
+/// @param idx [in] node index
+/// @param lo [in] first word of the node
+/// @param hi [in] word behind the node
+/// @param n [in] number of seats
+/// @return first seat of the run
+int64_t CRunIndex::descend(std::size_t idx, std::size_t lo, std::size_t hi, uint32_t n) const
+{
+    std::size_t mid;
+
+    while (hi - lo > 1) {
+        mid = (lo + hi) / 2;
+        const node &left = m_tree[2 * idx];
+        const node &right = m_tree[2 * idx + 1];
+
+        if (left.best_ >= n) {
+            idx = 2 * idx;
+            hi = mid;
+        }
+        else if (left.suffix_ + right.prefix_ >= n) {
+            /*run crosses the middle*/
+            return static_cast<int64_t>(mid * CSeatMap::m_word_bits) - left.suffix_;
+        }
+        else {
+            idx = 2 * idx + 1;
+            lo = mid;
+        }
+    }
+
+    assert(m_tree[idx].best_ >= n);
+    return static_cast<int64_t>(lo * CSeatMap::m_word_bits) + find_in_word(m_leaves[lo], n);
+}
+
+/// @brief Find the first run of n set bits in word
+/// @param word [in] word
+/// @param n [in] length of the run, 1 - 64
+/// @return bit position, negative if there is no such run
+int32_t CRunIndex::find_in_word(CSeatMap::word_t word, uint32_t n)
+{
+    uint32_t k;
+    uint32_t step;
+
+    if ((n == 0)||(n > CSeatMap::m_word_bits))
+        return -1;
+
+    /*bit i stays set, if k bits from i are set. k grows by doubling*/
+    for (k = 1; k < n; k += step) {
+        step = std::min(k, n - k);
+        word &= word >> step;
+    }
+
+    return (word != 0) ? std::countr_zero(word) : -1;
+}
@@ -0,0 +1,654 @@
+#include <bit>
+#include <cerrno>
+#include <cassert>
+#include <cstdlib>
+#include <utility>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#endif
+
+#include "seatmap.h"
+
+
+/// @brief Move assignment, moved map is empty afterwards
+///     Maps must not be used concurrently while moving
+/// @param other [io] map to be moved
+/// @return this map
+CSeatMap &CSeatMap::operator=(CSeatMap &&other) noexcept
+{
+    m_capacity = std::exchange(other.m_capacity, 0);
+    m_storage = std::move(other.m_storage);
+    m_words = std::exchange(other.m_words, nullptr);
+    m_words_count = std::exchange(other.m_words_count, 0);
+    m_dirty = std::move(other.m_dirty);
+    m_marked.store(other.m_marked.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+
+    return *this;
+}
+
+/// @brief Resize the map, previous content is lost
+///     Map must not be used concurrently while resizing
+/// @param capacity [in] number of seats
+/// @param all_set [in] true, to mark all the seats
+void CSeatMap::resize(uint32_t capacity, bool all_set)
+{
+    std::size_t n;
+    uint32_t tail;
+
+    m_capacity = capacity;
+    n = words(capacity);
+
+    /*atomics are not movable, so new storage is created at once*/
+    m_storage = std::make_unique<atomic_word_t[]>(n);
+    m_words = m_storage.get();
+    m_words_count = n;
+    for (std::size_t i = 0; i < n; ++i) {
+        m_words[i].store(all_set ? ~static_cast<word_t>(0) : 0, std::memory_order_relaxed);
+    }
+
+    /*bits above the capacity must always stay cleared*/
+    tail = capacity % m_word_bits;
+    if ((all_set)&&(tail != 0)) {
+        m_words[n - 1].store((static_cast<word_t>(1) << tail) - 1, std::memory_order_relaxed);
+    }
+    m_marked.store(all_set ? capacity : 0, std::memory_order_release);
+
+    std::vector<atomic_word_t> new_dirty((n + m_word_bits - 1) / m_word_bits);
+    for (auto &word : new_dirty) {
+        word.store(0, std::memory_order_relaxed);
+    }
+    m_dirty.swap(new_dirty);
+}
+
+/// @brief Use external words, their content is kept
+///     Map must not be used concurrently while attaching
+/// @param words [in] words, must outlive the map or detach
+/// @param capacity [in] number of seats, words must cover them
+void CSeatMap::attach(atomic_word_t *words, uint32_t capacity)
+{
+    std::size_t n;
+
+    n = CSeatMap::words(capacity);
+    if (capacity != m_capacity) {
+        /*dirty flags follow the size*/
+        resize(capacity, false);
+    }
+
+    m_storage.reset();
+    m_words = words;
+    m_words_count = n;
+
+    /*whole content is new for the users of dirty words*/
+    for (std::size_t i = 0; i < n; ++i) {
+        mark_dirty(i);
+    }
+    m_marked.store(count(), std::memory_order_release);
+}
+
+/// @brief Copy attached words to own storage, so the external ones can go away
+///     Map must not be used concurrently while detaching
+void CSeatMap::detach(void)
+{
+    if (m_storage != nullptr)
+        return;
+
+    m_storage = std::make_unique<atomic_word_t[]>(m_words_count);
+    for (std::size_t i = 0; i < m_words_count; ++i) {
+        m_storage[i].store(m_words[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    m_words = m_storage.get();
+}
+
+/// @brief Overwrite words of the map, capacity is kept
+///     Map must not be used concurrently while assigning
+/// @param words [in] new words, must have the same number of words as the map
+void CSeatMap::assign(const std::vector<word_t> &words)
+{
+    assert(words.size() == m_words_count);
+
+    for (std::size_t i = 0; i < m_words_count; ++i) {
+        m_words[i].store(words[i], std::memory_order_relaxed);
+        mark_dirty(i);
+    }
+    m_marked.store(count(), std::memory_order_release);
+}
+
+/// @brief Check if seat is marked
+/// @param seat [in] seat number
+/// @return true if marked
+bool CSeatMap::test(uint32_t seat) const
+{
+    if (seat >= m_capacity)
+        return false;
+
+    return (m_words[seat / m_word_bits].load(std::memory_order_acquire) >> (seat % m_word_bits)) & 1;
+}
+
+/// @brief Number of marked seats
+/// @return number of marked seats
+uint32_t CSeatMap::count(void) const
+{
+    uint32_t count;
+
+    count = 0;
+    for (std::size_t i = 0; i < m_words_count; ++i) {
+        count += static_cast<uint32_t>(std::popcount(m_words[i].load(std::memory_order_relaxed)));
+    }
+
+    return count;
+}
+
+/// @brief Check if there is no marked seat
+/// @return true, if no seat is marked
+bool CSeatMap::none(void) const
+{
+    for (std::size_t i = 0; i < m_words_count; ++i) {
+        if (m_words[i].load(std::memory_order_relaxed) != 0)
+            return false;
+    }
+
+    return true;
+}
+
+/// @brief Copy words of the map
+///     Each word is read atomically, but the copy as a whole is not
+/// @param words [out] copy of the words
+void CSeatMap::snapshot(std::vector<word_t> &words) const
+{
+    snapshot(0, m_words_count, words);
+}
+
+/// @brief Copy range of words of the map
+/// @param first_word [in] index of the first word
+/// @param n [in] number of words
+/// @param words [out] copy of the words
+void CSeatMap::snapshot(uint32_t first_word, std::size_t n, std::vector<word_t> &words) const
+{
+    assert(first_word + n <= m_words_count);
+
+    words.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        words[i] = m_words[first_word + i].load(std::memory_order_acquire);
+    }
+}
+
+/// @brief Extract all marked seats
+/// @param seats [out] list of marked seats
+void CSeatMap::to_set(std::set<uint32_t> &seats) const
+{
+    std::vector<uint32_t> seats_vector;
+
+    to_vector(seats_vector);
+
+    seats.clear();
+    /*vector is sorted, so every insert is amortized O(1)*/
+    for (uint32_t seat : seats_vector) {
+        seats.insert(seats.end(), seat);
+    }
+}
+
+/// @brief Extract all marked seats
+/// @param seats [out] list of marked seats, in ascending order
+void CSeatMap::to_vector(std::vector<uint32_t> &seats) const
+{
+    std::vector<word_t> words;
+
+    snapshot(words);
+
+    seats.clear();
+    kernel_extract(words.data(), words.size(), 0, seats);
+}
+
+/// @brief Clear all the marked seats from the request with compare-and-swap per word
+///     Request of up to m_claim_max_words words is claimed as a whole or not at all.
+///     Words are claimed in ascending order, when a word fails, words claimed before
+///     are given back. Concurrent claim can see such seats taken for that short while.
+///     The map can be changed concurrently meanwhile
+/// @param request [in] request mask
+/// @param claimed [out] requested seats, which were marked. They are cleared on success, nothing is cleared on failure
+/// @param best_effort [in] true, to claim marked seats only, even if some are not marked
+/// @return true, if the seats were claimed
+bool CSeatMap::claim(const mask_t &request, mask_t &claimed, bool best_effort)
+{
+    word_t want;
+    word_t take;
+    word_t old;
+    std::size_t i;
+    uint32_t taken;
+
+    assert(request.words_.size() <= m_claim_max_words);
+    assert(request.first_word_ + request.words_.size() <= m_words_count);
+
+    claimed.first_word_ = request.first_word_;
+    claimed.words_.assign(request.words_.size(), 0);
+
+    for (i = 0; i < request.words_.size(); ++i) {
+        want = request.words_[i];
+        if (want == 0)
+            continue;
+
+        atomic_word_t &word = m_words[request.first_word_ + i];
+        old = word.load(std::memory_order_acquire);
+        do {
+            take = old & want;
+            if ((take != want)&&(best_effort == false)) {
+                break;
+            }
+        } while (word.compare_exchange_weak(old, old & ~take, std::memory_order_acq_rel, std::memory_order_acquire) != true);
+
+        claimed.words_[i] = take;
+        if ((take != want)&&(best_effort == false)) {
+            break;
+        }
+    }
+
+    if (i != request.words_.size()) {
+        /*somebody else holds the seat, whole request fails at this moment.
+          Seats of the previous words are ours, nobody else could set them meanwhile*/
+        for (std::size_t j = 0; j < i; ++j) {
+            old = m_words[request.first_word_ + j].fetch_or(claimed.words_[j], std::memory_order_acq_rel);
+            assert((old & claimed.words_[j]) == 0);
+            (void)old;
+        }
+        /*words behind the failed one report seats, which are marked now*/
+        for (std::size_t j = i + 1; j < request.words_.size(); ++j) {
+            claimed.words_[j] = m_words[request.first_word_ + j].load(std::memory_order_acquire) & request.words_[j];
+        }
+        return false;
+    }
+
+    taken = 0;
+    for (i = 0; i < claimed.words_.size(); ++i) {
+        if (claimed.words_[i] != 0) {
+            taken += static_cast<uint32_t>(std::popcount(claimed.words_[i]));
+            mark_dirty(request.first_word_ + i);
+        }
+    }
+    if (taken != 0) {
+        m_marked.fetch_sub(taken, std::memory_order_acq_rel);
+    }
+
+    return true;
+}
+
+/// @brief Clear all the marked seats from the request, with kernels on whole request.
+///     Seats which are neither marked nor owned are reported back.
+///     Kernels work on a copy of the words, taken seats are then cleared word by word
+///     with atomic fetch_and. Seats of the request must not be claimed concurrently
+/// @param request [in] request mask
+/// @param owned [in] seats of the request, which are owned by the booker already. Same words as request
+/// @param taken [out] seats, which were cleared
+/// @param unavailable [out] list of seats, which are taken by somebody else
+/// @param best_effort [in] true, to take the rest of the seats, even if some are unavailable
+/// @return true, if the seats were taken
+bool CSeatMap::book(
+    const mask_t &request,
+    const mask_t &owned,
+    mask_t &taken,
+    std::vector<uint32_t> &unavailable,
+    bool best_effort)
+{
+    std::size_t n;
+    uint32_t moved;
+    const word_t *p_req;
+    const word_t *p_owned;
+    word_t *p_free;
+    std::vector<word_t> free_words;
+
+    unavailable.clear();
+
+    n = request.words_.size();
+    taken.first_word_ = request.first_word_;
+    taken.words_.assign(n, 0);
+    if (n == 0)
+        return true;
+
+    assert(owned.first_word_ == request.first_word_);
+    assert(owned.words_.size() == n);
+    assert(request.first_word_ + n <= m_words_count);
+
+    /*single writer, readers validate their copies through sequence counters*/
+    snapshot(request.first_word_, n, free_words);
+    p_req = request.words_.data();
+    p_owned = owned.words_.data();
+    p_free = free_words.data();
+
+    if (kernel_any_andnot2(p_req, p_free, p_owned, n)) {
+        /*some of the seats are taken by somebody else*/
+        kernel_extract_andnot2(p_req, p_free, p_owned, n, request.first_word_ * m_word_bits, unavailable);
+        if (best_effort == false)
+            return false;
+    }
+
+    moved = kernel_move(p_free, taken.words_.data(), p_req, n);
+    if (moved != 0) {
+        for (std::size_t i = 0; i < n; ++i) {
+            if (taken.words_[i] != 0) {
+                m_words[request.first_word_ + i].fetch_and(~taken.words_[i], std::memory_order_acq_rel);
+                mark_dirty(request.first_word_ + i);
+            }
+        }
+        m_marked.fetch_sub(moved, std::memory_order_acq_rel);
+    }
+
+    return true;
+}
+
+/// @brief Mark all the seats from the mask
+/// @param mask [in] seats to be marked
+void CSeatMap::release(const mask_t &mask)
+{
+    assert(mask.first_word_ + mask.words_.size() <= m_words_count);
+
+    for (std::size_t i = 0; i < mask.words_.size(); ++i) {
+        if (mask.words_[i] != 0) {
+            word_t old = m_words[mask.first_word_ + i].fetch_or(mask.words_[i], std::memory_order_acq_rel);
+            /*only seats, which were not marked yet, are counted*/
+            m_marked.fetch_add(static_cast<uint32_t>(std::popcount(mask.words_[i] & ~old)), std::memory_order_acq_rel);
+            mark_dirty(mask.first_word_ + i);
+        }
+    }
+}
+
+/// @brief Collect words changed by claim or release since the last call
+///     Words are reported once, collecting clears the dirty flags
+/// @param words [out] indexes of changed words, in ascending order
+void CSeatMap::collect_dirty(std::vector<uint32_t> &words)
+{
+    words.clear();
+    for (std::size_t i = 0; i < m_dirty.size(); ++i) {
+        if (m_dirty[i].load(std::memory_order_relaxed) == 0)
+            continue;
+
+        word_t dirty = m_dirty[i].exchange(0, std::memory_order_acq_rel);
+        kernel_extract(&dirty, 1, static_cast<uint32_t>(i * m_word_bits), words);
+    }
+}
+
+/// @brief Flag word as changed
+/// @param word [in] index of the word
+void CSeatMap::mark_dirty(std::size_t word)
+{
+    atomic_word_t &dirty = m_dirty[word / m_word_bits];
+    word_t bit = static_cast<word_t>(1) << (word % m_word_bits);
+
+    /*hot words are usually flagged already, so the shared line is only read*/
+    if ((dirty.load(std::memory_order_relaxed) & bit) == 0)
+        dirty.fetch_or(bit, std::memory_order_release);
+}
+
+/// @brief Build request mask from the list of seats
+/// @param seats [in] list of seats
+/// @param capacity [in] number of seats in theatre
+/// @param mask [out] request mask
+/// @return Negative on error, >=0 on success
+int32_t CSeatMap::make_mask(const std::set<uint32_t> &seats, uint32_t capacity, mask_t &mask)
+{
+    uint32_t first_word;
+    uint32_t last_word;
+
+    mask.first_word_ = 0;
+    mask.words_.clear();
+
+    if (seats.empty())
+        return EXIT_SUCCESS;
+
+    /*set is ordered, so range check is needed on the last one only*/
+    if (*seats.rbegin() >= capacity)
+        return -ERANGE;
+
+    first_word = *seats.begin() / m_word_bits;
+    last_word = *seats.rbegin() / m_word_bits;
+
+    mask.first_word_ = first_word;
+    mask.words_.assign(last_word - first_word + 1, 0);
+    for (uint32_t seat : seats) {
+        mask.words_[seat / m_word_bits - first_word] |= static_cast<word_t>(1) << (seat % m_word_bits);
+    }
+
+    return static_cast<int32_t>(seats.size());
+}
+
+/// @brief Get number of words the request would span
+/// @param seats [in] list of seats
+/// @return number of words
+std::size_t CSeatMap::mask_words(const std::set<uint32_t> &seats)
+{
+    if (seats.empty())
+        return 0;
+
+    return *seats.rbegin() / m_word_bits - *seats.begin() / m_word_bits + 1;
+}
+
+/// @brief Extract seats of the mask
+/// @param mask [in] mask
+/// @param seats [out] extracted seats are appended, in ascending order
+void CSeatMap::mask_to_vector(const mask_t &mask, std::vector<uint32_t> &seats)
+{
+    kernel_extract(mask.words_.data(), mask.words_.size(), mask.first_word_ * m_word_bits, seats);
+}
+
+/// @brief Count all set bits
+/// @param words [in] array of words
+/// @param n [in] number of words
+/// @return number of set bits
+uint32_t CSeatMap::kernel_popcount(const word_t *words, std::size_t n)
+{
+    std::size_t i;
+    uint32_t c0, c1, c2, c3;
+
+    /*four independent accumulators, so popcnt instructions can be pipelined*/
+    c0 = c1 = c2 = c3 = 0;
+    for (i = 0; i + 4 <= n; i += 4) {
+        c0 += static_cast<uint32_t>(std::popcount(words[i]));
+        c1 += static_cast<uint32_t>(std::popcount(words[i + 1]));
+        c2 += static_cast<uint32_t>(std::popcount(words[i + 2]));
+        c3 += static_cast<uint32_t>(std::popcount(words[i + 3]));
+    }
+    for (; i < n; ++i) {
+        c0 += static_cast<uint32_t>(std::popcount(words[i]));
+    }
+
+    return c0 + c1 + c2 + c3;
+}
+
+/// @brief Check if any bit of the request is not set in a
+/// @param req [in] request words
+/// @param a [in] map words
+/// @param n [in] number of words
+/// @return true, if there is at least one such bit
+bool CSeatMap::kernel_any_andnot(const word_t *req, const word_t *a, std::size_t n)
+{
+    std::size_t i;
+    word_t acc;
+
+    i = 0;
+#if defined(__AVX2__)
+    for (; i + 4 <= n; i += 4) {
+        __m256i vreq = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(req + i));
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        /*testc returns 1, when all request bits are covered by a*/
+        if (_mm256_testc_si256(va, vreq) == 0)
+            return true;
+    }
+#endif
+
+    acc = 0;
+    for (; i < n; ++i) {
+        acc |= req[i] & ~a[i];
+    }
+
+    return acc != 0;
+}
+
+/// @brief Check if any bit of the request is neither in a nor in b
+/// @param req [in] request words
+/// @param a [in] first map words
+/// @param b [in] second map words
+/// @param n [in] number of words
+/// @return true, if there is at least one such bit
+bool CSeatMap::kernel_any_andnot2(const word_t *req, const word_t *a, const word_t *b, std::size_t n)
+{
+    std::size_t i;
+    word_t acc;
+
+    i = 0;
+#if defined(__AVX2__)
+    for (; i + 4 <= n; i += 4) {
+        __m256i vreq = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(req + i));
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        __m256i vab = _mm256_or_si256(va, vb);
+        /*testc returns 1, when all request bits are covered by a | b*/
+        if (_mm256_testc_si256(vab, vreq) == 0)
+            return true;
+    }
+#endif
+
+    acc = 0;
+    for (; i < n; ++i) {
+        acc |= req[i] & ~(a[i] | b[i]);
+    }
+
+    return acc != 0;
+}
+
+/// @brief Move requested bits, which are set in src, to dst
+///     src &= ~(req & src); dst |= (req & src)
+/// @param src [io] source words
+/// @param dst [io] destination words
+/// @param req [in] request words
+/// @param n [in] number of words
+/// @return number of moved bits
+uint32_t CSeatMap::kernel_move(word_t *src, word_t *dst, const word_t *req, std::size_t n)
+{
+    std::size_t i;
+    uint32_t moved;
+
+    i = 0;
+    moved = 0;
+#if defined(__AVX2__)
+    for (; i + 4 <= n; i += 4) {
+        alignas(32) word_t lanes[4];
+        __m256i vreq = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(req + i));
+        __m256i vsrc = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        __m256i vdst = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+        __m256i vmov = _mm256_and_si256(vreq, vsrc);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(src + i), _mm256_andnot_si256(vmov, vsrc));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_or_si256(vmov, vdst));
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), vmov);
+        moved += kernel_popcount(lanes, 4);
+    }
+#endif
+
+    for (; i < n; ++i) {
+        word_t mov = req[i] & src[i];
+        src[i] &= ~mov;
+        dst[i] |= mov;
+        moved += static_cast<uint32_t>(std::popcount(mov));
+    }
+
+    return moved;
+}
+
+/// @brief Extract positions of the set bits
+/// @param words [in] array of words
+/// @param n [in] number of words
+/// @param base [in] seat number of the first bit
+/// @param seats [out] extracted positions are appended
+void CSeatMap::kernel_extract(const word_t *words, std::size_t n, uint32_t base, std::vector<uint32_t> &seats)
+{
+    seats.reserve(seats.size() + kernel_popcount(words, n));
+
+    for (std::size_t i = 0; i < n; ++i) {
+        word_t word = words[i];
+        /*jump directly from one set bit to the next one*/
+        while (word != 0) {
+            seats.push_back(base + static_cast<uint32_t>(i * m_word_bits) + static_cast<uint32_t>(std::countr_zero(word)));
+            word &= word - 1;
+        }
+    }
+}
+
+/// @brief Extract positions of the bits set in req, but not in a
+/// @param req [in] request words
+/// @param a [in] map words
+/// @param n [in] number of words
+/// @param base [in] seat number of the first bit
+/// @param seats [out] extracted positions are appended
+void CSeatMap::kernel_extract_andnot(
+    const word_t *req,
+    const word_t *a,
+    std::size_t n,
+    uint32_t base,
+    std::vector<uint32_t> &seats)
+{
+    std::size_t i;
+
+    i = 0;
+#if defined(__AVX2__)
+    for (; i + 4 <= n; i += 4) {
+        alignas(32) word_t lanes[4];
+        __m256i vreq = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(req + i));
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        /*block, where all the request bits are in a, has nothing to extract*/
+        if (_mm256_testc_si256(va, vreq) != 0)
+            continue;
+
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), _mm256_andnot_si256(va, vreq));
+        kernel_extract(lanes, 4, base + static_cast<uint32_t>(i * m_word_bits), seats);
+    }
+#endif
+
+    for (; i < n; ++i) {
+        word_t word = req[i] & ~a[i];
+        while (word != 0) {
+            seats.push_back(base + static_cast<uint32_t>(i * m_word_bits) + static_cast<uint32_t>(std::countr_zero(word)));
+            word &= word - 1;
+        }
+    }
+}
+
+/// @brief Extract positions of the bits set in req, but not in a and not in b
+/// @param req [in] request words
+/// @param a [in] first map words
+/// @param b [in] second map words
+/// @param n [in] number of words
+/// @param base [in] seat number of the first bit
+/// @param seats [out] extracted positions are appended
+void CSeatMap::kernel_extract_andnot2(
+    const word_t *req,
+    const word_t *a,
+    const word_t *b,
+    std::size_t n,
+    uint32_t base,
+    std::vector<uint32_t> &seats)
+{
+    std::size_t i;
+
+    i = 0;
+#if defined(__AVX2__)
+    for (; i + 4 <= n; i += 4) {
+        alignas(32) word_t lanes[4];
+        __m256i vreq = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(req + i));
+        __m256i vab = _mm256_or_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i)));
+        /*block, where all the request bits are in a | b, has nothing to extract*/
+        if (_mm256_testc_si256(vab, vreq) != 0)
+            continue;
+
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), _mm256_andnot_si256(vab, vreq));
+        kernel_extract(lanes, 4, base + static_cast<uint32_t>(i * m_word_bits), seats);
+    }
+#endif
+
+    for (; i < n; ++i) {
+        word_t word = req[i] & ~(a[i] | b[i]);
+        while (word != 0) {
+            seats.push_back(base + static_cast<uint32_t>(i * m_word_bits) + static_cast<uint32_t>(std::countr_zero(word)));
+            word &= word - 1;
+        }
+    }
+}
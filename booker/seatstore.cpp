@@ -0,0 +1,226 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "seatstore.h"
+
+
+/// @brief Standard destructor, unmaps the file without marking it clean
+CSeatStore::~CSeatStore()
+{
+    unmap();
+}
+
+/// @brief Map the file, it is created again if it doesn't fit the catalog or it is dirty
+/// @param path [in] store file
+/// @param catalog [in] hash of the catalog
+/// @param capacities [in] number of seats per theatre, indexed by theatre id
+/// @return Negative on error, 0 if seats were rebuilt, 1 if seats were restored
+int32_t CSeatStore::open(const std::string &path, uint64_t catalog, const std::vector<uint32_t> &capacities)
+{
+    int32_t restored;
+    uint64_t size;
+    struct stat st;
+    header *p_header;
+    theatre_entry *p_table;
+    std::vector<theatre_entry> table;
+
+    if (is_open()) {
+        return -EALREADY;
+    }
+
+    /*layout follows the catalog, so it is known before the file is read*/
+    size = (sizeof(header) + capacities.size() * sizeof(theatre_entry) + m_align - 1) / m_align * m_align;
+    for (uint32_t capacity : capacities) {
+        theatre_entry entry = {};
+
+        entry.capacity_ = capacity;
+        entry.words_offset_ = size;
+        size += (CSeatMap::words(capacity) * sizeof(CSeatMap::word_t) + m_align - 1) / m_align * m_align;
+        entry.owners_offset_ = size;
+        size += (capacity * sizeof(uint32_t) + m_align - 1) / m_align * m_align;
+        table.push_back(entry);
+    }
+
+    m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0640);
+    if (m_fd < 0) {
+        return -errno;
+    }
+    m_path = path;
+
+    if (::fstat(m_fd, &st) != 0) {
+        unmap();
+        return -EIO;
+    }
+
+    restored = 0;
+    if (static_cast<uint64_t>(st.st_size) != size) {
+        /*new catalog or new file, content is created from scratch*/
+        if ((::ftruncate(m_fd, 0) != 0)||(::ftruncate(m_fd, static_cast<off_t>(size)) != 0)) {
+            unmap();
+            return -errno;
+        }
+    }
+
+    void *base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (base == MAP_FAILED) {
+        unmap();
+        return -errno;
+    }
+    m_base = static_cast<uint8_t *>(base);
+    m_size = size;
+    p_header = reinterpret_cast<header *>(m_base);
+    p_table = reinterpret_cast<theatre_entry *>(m_base + sizeof(header));
+
+    if ((std::memcmp(p_header->magic_, m_magic, sizeof(m_magic)) == 0)&&
+        (p_header->version_ == m_version)&&
+        (p_header->theatres_ == capacities.size())&&
+        (p_header->catalog_ == catalog)&&
+        (p_header->size_ == size)&&
+        (p_header->clean_ == 1)&&
+        (std::memcmp(p_table, table.data(), table.size() * sizeof(theatre_entry)) == 0)&&
+        (p_header->checksum_ == checksum())) {
+        restored = 1;
+        m_journal_offset = p_header->journal_offset_;
+    }
+    else {
+        /*dirty or foreign file, all the seats are free again*/
+        std::memset(m_base, 0, m_size);
+        std::memcpy(p_header->magic_, m_magic, sizeof(m_magic));
+        p_header->version_ = m_version;
+        p_header->theatres_ = static_cast<uint32_t>(capacities.size());
+        p_header->catalog_ = catalog;
+        p_header->size_ = size;
+        std::memcpy(p_table, table.data(), table.size() * sizeof(theatre_entry));
+
+        for (const theatre_entry &entry : table) {
+            CSeatMap::word_t *words = reinterpret_cast<CSeatMap::word_t *>(m_base + entry.words_offset_);
+            for (uint32_t i = 0; i < entry.capacity_ / CSeatMap::m_word_bits; ++i) {
+                words[i] = ~static_cast<CSeatMap::word_t>(0);
+            }
+            /*bits above the capacity stay cleared*/
+            if (entry.capacity_ % CSeatMap::m_word_bits != 0) {
+                words[entry.capacity_ / CSeatMap::m_word_bits] = (static_cast<CSeatMap::word_t>(1) << (entry.capacity_ % CSeatMap::m_word_bits)) - 1;
+            }
+        }
+        m_journal_offset = 0;
+    }
+
+    /*from now on content changes, crash before close must be detected*/
+    p_header->clean_ = 0;
+    if (::msync(m_base, m_size, MS_SYNC) != 0) {
+        unmap();
+        return -EIO;
+    }
+
+    for (const theatre_entry &entry : table) {
+        section new_section;
+
+        new_section.words_ = reinterpret_cast<CSeatMap::atomic_word_t *>(m_base + entry.words_offset_);
+        new_section.owners_ = reinterpret_cast<owner_t *>(m_base + entry.owners_offset_);
+        m_sections.push_back(new_section);
+    }
+
+    return restored;
+}
+
+/// @brief Checksum content and mark the file clean. Content must not change anymore
+/// @param journal_offset [in] size of the journal, which is contained in the seats
+/// @return Negative on error, >=0 on success
+int32_t CSeatStore::close(uint64_t journal_offset)
+{
+    header *p_header;
+
+    if (is_open() != true) {
+        return -EBADF;
+    }
+
+    p_header = reinterpret_cast<header *>(m_base);
+    p_header->journal_offset_ = journal_offset;
+    p_header->checksum_ = checksum();
+
+    /*content is on disk before it is declared clean*/
+    if (::msync(m_base, m_size, MS_SYNC) != 0) {
+        return -EIO;
+    }
+    p_header->clean_ = 1;
+    if (::msync(m_base, m_size, MS_SYNC) != 0) {
+        return -EIO;
+    }
+
+    unmap();
+    return EXIT_SUCCESS;
+}
+
+/// @brief Exchange mapped files of two stores
+/// @param other [io] the other store
+void CSeatStore::swap(CSeatStore &other)
+{
+    std::swap(m_path, other.m_path);
+    std::swap(m_fd, other.m_fd);
+    std::swap(m_base, other.m_base);
+    std::swap(m_size, other.m_size);
+    std::swap(m_journal_offset, other.m_journal_offset);
+    std::swap(m_sections, other.m_sections);
+}
+
+/// @brief Rename the mapped file, it replaces the file of the path
+/// @param path [in] new path of the file
+/// @return Negative on error, >=0 on success
+int32_t CSeatStore::rename(const std::string &path)
+{
+    if (m_base == nullptr) {
+        return -EBADF;
+    }
+
+    if (::rename(m_path.c_str(), path.c_str()) != 0) {
+        return -errno;
+    }
+
+    /*file is still mapped, only its name changed*/
+    m_path = path;
+
+    return EXIT_SUCCESS;
+}
+
+/// @brief Checksum of everything behind the header
+/// @return checksum
+uint64_t CSeatStore::checksum(void) const
+{
+    uint64_t hash;
+    uint64_t word;
+
+    /*FNV-1a over whole words, sections are aligned, so size is multiple of word*/
+    hash = 14695981039346656037ull;
+    for (std::size_t offset = sizeof(header); offset + sizeof(word) <= m_size; offset += sizeof(word)) {
+        std::memcpy(&word, m_base + offset, sizeof(word));
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+
+    return hash;
+}
+
+/// @brief Unmap and close the file
+void CSeatStore::unmap(void)
+{
+    m_sections.clear();
+    m_path.clear();
+
+    if (m_base != nullptr) {
+        ::munmap(m_base, m_size);
+        m_base = nullptr;
+        m_size = 0;
+    }
+
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
@@ -1,4 +1,6 @@
+#include <cerrno>
 #include <iostream>
+#include <system_error>
 
 #include <boost/asio/co_spawn.hpp>
 #include <boost/asio/use_awaitable.hpp>
@@ -31,6 +33,21 @@ static void telnet_event_handler_cb
     p_CSession->telnet_event_handler_cb(telnet, event);
 }
 
+/// @brief Convert rendered text to CR LF line ends, as CLI sends it
+/// @param buffer [io] rendered text
+static void to_crlf(std::string &buffer)
+{
+    std::string result;
+
+    result.reserve(buffer.size() + buffer.size() / 16);
+    for (char c : buffer) {
+        if (c == '\n')
+            result += '\r';
+        result += c;
+    }
+    buffer = std::move(result);
+}
+
 
 
 
@@ -174,8 +191,16 @@ boost::asio::awaitable<void> CSession::on_send(void)
             }
             else {
                 /*send message*/
-                co_await boost::asio::async_write(m_socket,\
-                    boost::asio::buffer(m_send_msgs_deque.front()), boost::asio::use_awaitable);
+                /*shared response is kept alive by the deque, until it is written*/
+                const send_msg_t &msg = m_send_msgs_deque.front();
+                if (msg.response_ != nullptr) {
+                    co_await boost::asio::async_write(m_socket,\
+                        boost::asio::buffer(*msg.response_), boost::asio::use_awaitable);
+                }
+                else {
+                    co_await boost::asio::async_write(m_socket,\
+                        boost::asio::buffer(msg.data_), boost::asio::use_awaitable);
+                }
                 m_send_msgs_deque.pop_front();
             }
         }
@@ -207,7 +232,7 @@ void CSession::send_raw_msg(const std::string &message)
 /// @param message [in] message to be send
 void CSession::send_raw_msg(std::vector<uint8_t> &message)
 {
-    m_send_msgs_deque.push_back(std::move(message));
+    m_send_msgs_deque.push_back(send_msg_t{std::move(message), nullptr});
     m_timer.cancel_one();
 }
 
@@ -226,6 +251,22 @@ void CSession::send_msg(std::vector<uint8_t> &message)
     telnet_send(m_p_telnet, reinterpret_cast<const char *>(message.data()), message.size());
 }
 
+/// @brief Send shared rendered response, behind everything written to CLI so far
+///     Response is queued for the socket as it is, when telnet would not change it
+/// @param response [in] response with CR LF line ends
+void CSession::send_response(const CResponseCache::response_ptr &response)
+{
+    /*CLI stream is not buffered, so everything written before is queued already.
+      Binary mode sends text as it is, only IAC would be escaped*/
+    if ((m_b_binary)&&(response->find(static_cast<char>(TELNET_IAC)) == std::string::npos)) {
+        m_send_msgs_deque.push_back(send_msg_t{{}, response});
+        m_timer.cancel_one();
+    }
+    else {
+        telnet_send_text(m_p_telnet, response->data(), response->size());
+    }
+}
+
 /// @brief Callback function called by CLI, to send text message to tlnet library
 /// @param message [in] message to be send
 void CSession::cli_send_text_msg_cb(const std::string &message)
@@ -265,7 +306,17 @@ void CSession::telnet_event_handler_cb (telnet_t *telnet, telnet_event_t *event)
         /* this will be input typed by the user.*/
         new_recv_msg.resize(event->data.size);
         std::copy(event->data.buffer, event->data.buffer + event->data.size, new_recv_msg.begin());
+
+        /*menus of reloaded catalog are picked up between commands, never within typed line*/
+        if ((m_b_cli_idle)&&(m_catalog_version != m_booking.get_catalog_version())) {
+            reload_cli();
+        }
+
         m_cli_session_ptr->Read(new_recv_msg);
+        if (new_recv_msg.empty() != true) {
+            /*line is executed with 0 or 10 behind 13*/
+            m_b_cli_idle = ((new_recv_msg.back() == 0)||(new_recv_msg.back() == 10));
+        }
         break;
     case TELNET_EV_SEND:
         /* This event is sent whenever libtelnet has generated data that must be sent over the wire to the remove end. */
@@ -274,6 +325,12 @@ void CSession::telnet_event_handler_cb (telnet_t *telnet, telnet_event_t *event)
         std::copy(event->data.buffer, event->data.buffer + event->data.size, new_send_msg.begin());
         send_raw_msg(new_send_msg);
         break;
+    case TELNET_EV_DO:
+    case TELNET_EV_DONT:
+        /*libtelnet translates line ends, unless remote end accepted binary transmission*/
+        if (event->neg.telopt == TELNET_TELOPT_BINARY)
+            m_b_binary = (event->type == TELNET_EV_DO);
+        break;
     case TELNET_EV_ERROR:
         // event->error.msg
         on_close();
@@ -289,7 +346,11 @@ void CSession::telnet_event_handler_cb (telnet_t *telnet, telnet_event_t *event)
 void CSession::init_cli(void)
 {
     std::size_t pos;
-    const CBooking::movies_map_t &movies_map = m_booking.get_configuration();
+    CBooking::catalog_ptr configuration = m_booking.get_configuration();
+    const CBooking::movies_map_t &movies_map = configuration->movies_map_;
+
+    m_catalog_version = configuration->version_;
+    m_movie_cmd_vector.clear();
 
     /*Create root menu holder*/
     auto rootMenu = std::make_unique<cli::Menu>("cli");
@@ -303,6 +364,63 @@ void CSession::init_cli(void)
         m_cli_status_cmd_cb,
         "Show current booking status" );
 
+    /*Batch command*/
+    m_cli_batch_cmd_cb = std::bind(&CSession::batch_cb, this, std::placeholders::_1, std::placeholders::_2);
+    assert(m_cli_batch_cmd_cb != nullptr);
+    rootMenu->Insert(
+        "batch",
+        m_cli_batch_cmd_cb,
+        "Book seats of several shows, all or nothing" );
+
+    /*Flat commands, scripted clients address shows by handle, without menu navigation*/
+    m_cli_shows_cmd_cb = std::bind(&CSession::shows_cb, this, std::placeholders::_1);
+    rootMenu->Insert(
+        "shows",
+        m_cli_shows_cmd_cb,
+        "List shows and their handles" );
+
+    m_cli_playing_cmd_cb = std::bind(&CSession::playing_cb, this, std::placeholders::_1, std::placeholders::_2);
+    rootMenu->Insert(
+        "playing",
+        m_cli_playing_cmd_cb,
+        "List movies played in the theatre: playing <theatre>" );
+
+    m_cli_available_cmd_cb = std::bind(&CSession::available_cb, this, std::placeholders::_1, std::placeholders::_2);
+    rootMenu->Insert(
+        "available",
+        m_cli_available_cmd_cb,
+        "List shows with at least n free seats: available <n>" );
+
+    m_cli_top_cmd_cb = std::bind(&CSession::top_cb, this, std::placeholders::_1, std::placeholders::_2);
+    rootMenu->Insert(
+        "top",
+        m_cli_top_cmd_cb,
+        "List k shows with the most free seats: top <k>" );
+
+    m_cli_show_seats_cmd_cb = std::bind(&CSession::show_free_seats, this, std::placeholders::_1, std::placeholders::_2);
+    rootMenu->Insert(
+        "seats",
+        m_cli_show_seats_cmd_cb,
+        "Show free seats of the show: seats <show>" );
+
+    m_cli_show_book_cmd_cb = std::bind(&CSession::show_book_seats, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, false);
+    rootMenu->Insert(
+        "book",
+        m_cli_show_book_cmd_cb,
+        "Book seats of the show: book <show> <seats>" );
+
+    m_cli_show_trybook_cmd_cb = std::bind(&CSession::show_book_seats, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, true);
+    rootMenu->Insert(
+        "trybook",
+        m_cli_show_trybook_cmd_cb,
+        "Book free seats of the show: trybook <show> <seats>" );
+
+    m_cli_show_unbook_cmd_cb = std::bind(&CSession::show_unbook_seats, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+    rootMenu->Insert(
+        "unbook",
+        m_cli_show_unbook_cmd_cb,
+        "Release seats of the show: unbook <show> <seats>" );
+
     /*turn on colors command*/
     m_colorCmd = rootMenu->Insert(
         "color",
@@ -330,23 +448,41 @@ void CSession::init_cli(void)
     /*Build commands based from the configuration*/
     for (auto& movie : movies_map) {
         cli_movie_cmds new_cli_movie;
-        std::string help = "Movie: " + movie.first;
+        std::string name(movie.first);
+        std::string help = "Movie: " + name;
         /*movie control holder*/
-        auto new_menu_movie = std::make_unique<cli::Menu>(movie.first, help, movie.first);
+        auto new_menu_movie = std::make_unique<cli::Menu>(name, help, name);
         assert(new_menu_movie != nullptr);
 
         new_cli_movie.movie = movie.first;
 
+        /*bookany*/
+        new_cli_movie.book_any.cli_cmd_cb = std::bind(
+            &CSession::bookany_seats_cb,
+            this,
+            std::placeholders::_1,
+            std::placeholders::_2,
+            m_movie_cmd_vector.size(),
+            0);
+        assert(new_cli_movie.book_any.cli_cmd_cb != nullptr);
+        new_cli_movie.book_any.cmd_handler = new_menu_movie->Insert(
+            "bookany",
+            new_cli_movie.book_any.cli_cmd_cb,
+            "Book contiguous seats in any theatre");
+
         pos = 0;
         for (auto& theatre : movie.second->theatre_reservations_map_) {
             cli_theatre_cmds new_cli_theatre_cmd;
-            std::string help2 = "Theatre: " + theatre.first;
+            std::string name2(theatre.first);
+            std::string help2 = "Theatre: " + name2;
 
             /*theatre control holder*/
-            auto new_menu_theatre = std::make_unique<cli::Menu>(theatre.first, help2, theatre.first);
+            auto new_menu_theatre = std::make_unique<cli::Menu>(name2, help2, name2);
             assert(new_menu_theatre != nullptr);
 
             new_cli_theatre_cmd.theatre = theatre.first;
+            new_cli_theatre_cmd.show = theatre.second->id_;
+            new_cli_theatre_cmd.capacity = theatre.second->get_seats().free_seats_map_.capacity();
 
             /*seats*/
             new_cli_theatre_cmd.seats.cli_cmd_cb = std::bind(
@@ -362,6 +498,20 @@ void CSession::init_cli(void)
                 new_cli_theatre_cmd.seats.cli_cmd_cb,
                 "Show free seats");
 
+            /*layout*/
+            new_cli_theatre_cmd.layout.cli_cmd_cb = std::bind(
+                &CSession::layout_cb,
+                this,
+                std::placeholders::_1,
+                std::placeholders::_2,
+                m_movie_cmd_vector.size(),
+                pos);
+            assert(new_cli_theatre_cmd.layout.cli_cmd_cb != nullptr);
+            new_cli_theatre_cmd.layout.cmd_handler = new_menu_theatre->Insert(
+                "layout",
+                new_cli_theatre_cmd.layout.cli_cmd_cb,
+                "Show seat layout");
+
             /*book*/
             new_cli_theatre_cmd.book.cli_cmd_cb = std::bind(
                 &CSession::book_seats_cb,
@@ -390,6 +540,20 @@ void CSession::init_cli(void)
             new_cli_theatre_cmd.try_book.cli_cmd_cb,
             "Try to book selected seats");
 
+            /*bookbest*/
+            new_cli_theatre_cmd.book_best.cli_cmd_cb = std::bind(
+                &CSession::bookbest_seats_cb,
+                this,
+                std::placeholders::_1,
+                std::placeholders::_2,
+                m_movie_cmd_vector.size(),
+                pos);
+            assert(new_cli_theatre_cmd.book_best.cli_cmd_cb != nullptr);
+            new_cli_theatre_cmd.book_best.cmd_handler = new_menu_theatre->Insert(
+            "bookbest",
+            new_cli_theatre_cmd.book_best.cli_cmd_cb,
+            "Book the first contiguous free seats, optionally within a row");
+
             /*unbook*/
             new_cli_theatre_cmd.unbook.cli_cmd_cb = std::bind(
                 &CSession::unbook_seats_cb,
@@ -404,6 +568,48 @@ void CSession::init_cli(void)
             new_cli_theatre_cmd.unbook.cli_cmd_cb,
             "Release selected seats");
 
+            /*exchange*/
+            new_cli_theatre_cmd.exchange.cli_cmd_cb = std::bind(
+                &CSession::exchange_seats_cb,
+                this,
+                std::placeholders::_1,
+                std::placeholders::_2,
+                m_movie_cmd_vector.size(),
+                pos);
+            assert(new_cli_theatre_cmd.exchange.cli_cmd_cb != nullptr);
+            new_cli_theatre_cmd.exchange.cmd_handler = new_menu_theatre->Insert(
+            "exchange",
+            new_cli_theatre_cmd.exchange.cli_cmd_cb,
+            "Release booked seats and book other seats at once: exchange <seats> > <seats>");
+
+            /*hold*/
+            new_cli_theatre_cmd.hold.cli_cmd_cb = std::bind(
+                &CSession::hold_seats_cb,
+                this,
+                std::placeholders::_1,
+                std::placeholders::_2,
+                m_movie_cmd_vector.size(),
+                pos);
+            assert(new_cli_theatre_cmd.hold.cli_cmd_cb != nullptr);
+            new_cli_theatre_cmd.hold.cmd_handler = new_menu_theatre->Insert(
+            "hold",
+            new_cli_theatre_cmd.hold.cli_cmd_cb,
+            "Hold selected seats for limited time");
+
+            /*confirm*/
+            new_cli_theatre_cmd.confirm.cli_cmd_cb = std::bind(
+                &CSession::confirm_seats_cb,
+                this,
+                std::placeholders::_1,
+                std::placeholders::_2,
+                m_movie_cmd_vector.size(),
+                pos);
+            assert(new_cli_theatre_cmd.confirm.cli_cmd_cb != nullptr);
+            new_cli_theatre_cmd.confirm.cmd_handler = new_menu_theatre->Insert(
+            "confirm",
+            new_cli_theatre_cmd.confirm.cli_cmd_cb,
+            "Confirm held seats");
+
             /*status*/
             new_cli_theatre_cmd.status.cli_cmd_cb = std::bind(
                 &CSession::book_status_cb,
@@ -474,13 +680,27 @@ void CSession::init_cli(void)
     assert(m_cli_session_ptr != nullptr);
 }
 
-/// @brief Support function to get all the reuierd names
-/// @param movie [out] Name of the movie
-/// @param theatre [out] Name of the theatre
+/// @brief Rebuild CLI menus from reloaded catalog, session starts again in the root menu
+/// @param  none
+void CSession::reload_cli(void)
+{
+    /*session refers to the CLI, so it goes first*/
+    m_cli_session_ptr.reset();
+    m_cli_ptr.reset();
+
+    init_cli();
+
+    send_msg("\r\nCatalog was reloaded\r\n");
+    m_cli_session_ptr->Prompt();
+}
+
+/// @brief Support function to get all the reuierd names, without copying them
+/// @param movie [out] Name of the movie, valid as long as the session
+/// @param theatre [out] Name of the theatre, valid as long as the session
 /// @param movie_pos [in] Position of the movie
 /// @param theatre_pos [in] Position of the theatre
 /// @return Negative on error, >=0 on success
-int32_t CSession::get_names (std::string &movie, std::string &theatre, size_t movie_pos, size_t theatre_pos)
+int32_t CSession::get_names (std::string_view &movie, std::string_view &theatre, size_t movie_pos, size_t theatre_pos)
 {
     std::vector<cli_theatre_cmds> *p_theatre_cmd;
 
@@ -496,6 +716,36 @@ int32_t CSession::get_names (std::string &movie, std::string &theatre, size_t mo
     return EXIT_SUCCESS;
 }
 
+/// @brief Support function to get the show handle
+/// @param movie_pos [in] Position of the movie
+/// @param theatre_pos [in] Position of the theatre
+/// @return Negative on error, show handle on success
+int32_t CSession::get_show (size_t movie_pos, size_t theatre_pos) const
+{
+    if (movie_pos >= m_movie_cmd_vector.size())
+        return -EFAULT;
+
+    if (theatre_pos >= m_movie_cmd_vector[movie_pos].theatre_cmd_vector.size())
+        return -EFAULT;
+
+    return static_cast<int32_t>(m_movie_cmd_vector[movie_pos].theatre_cmd_vector[theatre_pos].show);
+}
+
+/// @brief Support function to get the number of seats in the theatre
+/// @param movie_pos [in] Position of the movie
+/// @param theatre_pos [in] Position of the theatre
+/// @return number of seats, 0 if position is invalid
+uint32_t CSession::get_capacity (size_t movie_pos, size_t theatre_pos) const
+{
+    if (movie_pos >= m_movie_cmd_vector.size())
+        return 0;
+
+    if (theatre_pos >= m_movie_cmd_vector[movie_pos].theatre_cmd_vector.size())
+        return 0;
+
+    return m_movie_cmd_vector[movie_pos].theatre_cmd_vector[theatre_pos].capacity;
+}
+
 /// @brief Default error function, which also terminates the session
 /// @param out [out] leaving message stream
 /// @param msg [in] leaving message
@@ -519,13 +769,98 @@ void CSession::cli_sys_err(std::ostream& out, const std::string &msg)
 /// @param arg [in] unused
 void CSession::status_cb (std::ostream& out, const std::string& arg)
 {
-    std::string buffer;
+    int32_t rc;
+    CResponseCache::response_ptr response;
 
     (void)(arg);
 
-    m_booking.dump_status(buffer);
-    buffer += "\n";
-    out << buffer;
+    /*rendered once per change, shared by all the sessions*/
+    rc = m_booking.get_status_response(
+        cli::Color(),
+        [this](std::string &buffer)
+        {
+            m_booking.dump_status(buffer);
+            buffer += "Active bookers: " + std::to_string(m_booking.get_active_bookers()) + "\n";
+            buffer += "\n";
+            to_crlf(buffer);
+        },
+        response);
+    if (rc < EXIT_SUCCESS) {
+        /*failed rendering is retried by the next request, session goes on*/
+        out << cli::beforeError;
+        out << "Status not available\n";
+        out << cli::afterError;
+        return;
+    }
+
+    send_response(response);
+}
+
+/// @brief Callback function to book seats of several shows, all or nothing
+/// @param out [out] output stream
+/// @param arg [in] list of movie/theatre:seats, separated by ;
+void CSession::batch_cb (std::ostream& out, const std::string& arg)
+{
+    int32_t rc;
+    std::string tmp;
+    std::vector<show_seats_t> shows;
+    std::vector<CBooking::show_request> requests;
+    std::vector<std::vector<uint32_t>> unavalable_seats;
+
+    rc = get_batch_request(arg, shows);
+    if (rc < EXIT_SUCCESS) {
+        out << cli::beforeError;
+        out << "Invalid request, expected movie/theatre:seats;...\n";
+        out << cli::afterError;
+        return;
+    }
+
+    for (auto &show : shows) {
+        rc = m_booking.get_capacity(show.movie_, show.theatre_);
+        if (rc < EXIT_SUCCESS) {
+            out << cli::beforeError;
+            out << "Unknown show " << show.movie_ << "/" << show.theatre_ << "\n";
+            out << cli::afterError;
+            return;
+        }
+
+        /*convert slection text to list of seats*/
+        requests.push_back(CBooking::show_request{show.movie_, show.theatre_, get_seats(show.seats_, static_cast<uint32_t>(rc))});
+    }
+
+    rc = m_booking.book_batch(shared_from_this(), requests, unavalable_seats);
+    if (rc < EXIT_SUCCESS) {
+        out << cli::beforeError;
+        out << "Failed to process an request\n";
+        out << cli::afterError;
+        return;
+    }
+
+    if (rc == EXIT_SUCCESS) {
+        /*nothing was booked, list seats which caused that*/
+        out << cli::beforeWarn;
+        out << "Unavailble seats:";
+        for (std::size_t i = 0; i < requests.size(); ++i) {
+            if (unavalable_seats[i].empty())
+                continue;
+            tmp.clear();
+            seats_to_string(tmp, unavalable_seats[i]);
+            out << " " << requests[i].movie_ << "/" << requests[i].theatre_ << ": " << tmp << ";";
+        }
+        out << cli::afterWarn;
+        out << "\n";
+        return;
+    }
+
+    out << cli::beforeOK;
+    out << "Booked seats:";
+    for (auto &request : requests) {
+        tmp.clear();
+        seats_to_string(tmp, request.seats_);
+        out << " " << request.movie_ << "/" << request.theatre_ << ": " << tmp << ";";
+    }
+    out << cli::afterOK;
+    out << "\n";
 }
 
 /// @brief Callback function to list free seats
@@ -534,12 +869,32 @@ void CSession::status_cb (std::ostream& out, const std::string& arg)
 /// @param movie_pos [in] movie position
 /// @param theatre_pos [in] theatre position
 void CSession::free_seats_cb (std::ostream& out, const std::string& arg, size_t movie_pos, size_t theatre_pos)
+{
+    int32_t show;
+
+    (void)(arg);
+
+    /*show handle was resolved, when the menu was built*/
+    show = get_show(movie_pos, theatre_pos);
+    if (show < EXIT_SUCCESS) {
+        cli_sys_err(out);
+        return;
+    }
+
+    show_free_seats(out, static_cast<size_t>(show));
+}
+
+/// @brief Callback function to show seat layout of the theatre
+/// @param out [out] output stream
+/// @param arg [in] unused
+/// @param movie_pos [in] movie position
+/// @param theatre_pos [in] theatre position
+void CSession::layout_cb (std::ostream& out, const std::string& arg, size_t movie_pos, size_t theatre_pos)
 {
     int32_t rc;
-    std::string movie;
-    std::string theatre;
-    std::string str;
-    std::set<uint32_t> free_seats;
+    std::string_view movie;
+    std::string_view theatre;
+    std::vector<CBooking::seat_row> layout;
 
     (void)(arg);
 
@@ -550,20 +905,18 @@ void CSession::free_seats_cb (std::ostream& out, const std::string& arg, size_t
         return;
     }
 
-    /*get list of free seats*/
-    rc = m_booking.get_free_seats(movie, theatre, free_seats);
+    rc = m_booking.get_layout(movie, theatre, layout);
     if (rc < EXIT_SUCCESS) {
         cli_sys_err(out);
         return;
     }
 
-    if (free_seats.empty()) {
-        out << "There are no seats available\n";
-    }
-    else {
-        seats_to_string(str, free_seats);
-        out << "Free available seats: ";
-        out << str;
+    out << "Capacity: " << get_capacity(movie_pos, theatre_pos) << "\n";
+    for (auto &row : layout) {
+        if (row.section_.empty() != true)
+            out << "Section " << row.section_ << ", ";
+        out << "Row " << row.row_ << ": ";
+        out << row.first_seat_ << " - " << (row.first_seat_ + row.seats_ - 1);
         out << "\n";
     }
 }
@@ -576,26 +929,106 @@ void CSession::free_seats_cb (std::ostream& out, const std::string& arg, size_t
 /// @param movie_pos [in] movie position
 /// @param theatre_pos [in] theatre position
 void CSession::book_seats_cb (std::ostream& out, const std::string& arg, size_t movie_pos, size_t theatre_pos)
+{
+    int32_t show;
+
+    /*show handle was resolved, when the menu was built*/
+    show = get_show(movie_pos, theatre_pos);
+    if (show < EXIT_SUCCESS) {
+        cli_sys_err(out);
+        return;
+    }
+
+    show_book_seats(out, static_cast<size_t>(show), arg, false);
+}
+
+/// @brief Callback function to try to book the seats
+///     If any seat from the list is already taken, 
+///     that seat will be skipped, while funtion will continue
+//      with oter seats in the selection
+/// @param out [out] status output stream
+/// @param arg [in] booking parameters [list of seats]
+/// @param movie_pos [in] movie position
+/// @param theatre_pos [in] theatre position
+void CSession::trybook_seats_cb (std::ostream& out, const std::string& arg, size_t movie_pos, size_t theatre_pos)
+{
+    int32_t show;
+
+    /*show handle was resolved, when the menu was built*/
+    show = get_show(movie_pos, theatre_pos);
+    if (show < EXIT_SUCCESS) {
+        cli_sys_err(out);
+        return;
+    }
+
+    show_book_seats(out, static_cast<size_t>(show), arg, true);
+}
+
+/// @brief Release already booked selected seats
+/// @param out [out] status output stream
+/// @param arg [in] booking parameters [list of seats]
+/// @param movie_pos [in] movie position
+/// @param theatre_pos [in] theatre position
+void CSession::unbook_seats_cb (std::ostream& out, const std::string& arg, size_t movie_pos, size_t theatre_pos)
+{
+    int32_t show;
+
+    /*show handle was resolved, when the menu was built*/
+    show = get_show(movie_pos, theatre_pos);
+    if (show < EXIT_SUCCESS) {
+        cli_sys_err(out);
+        return;
+    }
+
+    show_unbook_seats(out, static_cast<size_t>(show), arg);
+}
+
+/// @brief Release booked seats and book other seats at once, all or nothing
+/// @param out [out] status output stream
+/// @param arg [in] booking parameters [list of released seats > list of booked seats]
+/// @param movie_pos [in] movie position
+/// @param theatre_pos [in] theatre position
+void CSession::exchange_seats_cb (std::ostream& out, const std::string& arg, size_t movie_pos, size_t theatre_pos)
 {
     int32_t rc;
+    int32_t show;
+    int32_t capacity;
     std::string tmp;
-    std::string movie;
-    std::string theatre;
-    std::set<uint32_t> req_free_seats;
+    std::string release;
+    std::string take;
+    std::set<uint32_t> seats;
     std::vector<uint32_t> unavalable_seats;
+    std::vector<uint32_t> invalid_seats;
 
-    /*retrive names from positions*/
-    rc = get_names(movie, theatre, movie_pos, theatre_pos);
-    if (rc < EXIT_SUCCESS) {
+    /*show handle was resolved, when the menu was built*/
+    show = get_show(movie_pos, theatre_pos);
+    if (show < EXIT_SUCCESS) {
         cli_sys_err(out);
         return;
     }
 
-    /*convert slection text to list of seats*/
-    req_free_seats = get_seats(arg);
+    capacity = m_booking.get_capacity(static_cast<uint32_t>(show));
+    if (capacity < EXIT_SUCCESS) {
+        unknown_show(out, static_cast<size_t>(show));
+        return;
+    }
 
-    /*book the seats*/
-    rc = m_booking.book_seats(shared_from_this(), movie, theatre, req_free_seats, unavalable_seats, false);
+    rc = get_exchange_request(arg, release, take);
+    if (rc < EXIT_SUCCESS) {
+        out << cli::beforeError;
+        out << "Invalid request, expected released seats > booked seats\n";
+        out << cli::afterError;
+        return;
+    }
+
+    /*both lists are applied within single critical section*/
+    rc = m_booking.exchange_seats(
+        shared_from_this(),
+        static_cast<uint32_t>(show),
+        get_seats(release, static_cast<uint32_t>(capacity)),
+        get_seats(take, static_cast<uint32_t>(capacity)),
+        unavalable_seats,
+        invalid_seats);
     if (rc < EXIT_SUCCESS) {
         out << cli::beforeError;
         out << "Failed to process an request\n";
@@ -603,8 +1036,8 @@ void CSession::book_seats_cb (std::ostream& out, const std::string& arg, size_t
         return;
     }
 
-    /*get latest list of currently booked list of the booker*/
-    rc = m_booking.get_booked_seats(shared_from_this(), movie, theatre, req_free_seats);
+    /*get latest list of currently booked seats, unchanged if exchange failed*/
+    rc = m_booking.get_booked_seats(shared_from_this(), static_cast<uint32_t>(show), seats);
     if (rc < EXIT_SUCCESS) {
         out << cli::beforeError;
         out << "Failed to process an request\n";
@@ -614,41 +1047,178 @@ void CSession::book_seats_cb (std::ostream& out, const std::string& arg, size_t
 
     out << cli::beforeOK;
     out << "Currently reserved seats: ";
-    seats_to_string(tmp, req_free_seats);
+    seats_to_string(tmp, seats);
     out << tmp;
     out << cli::afterOK;
     out << "\n";
+
+    if (invalid_seats.empty() != true) {
+        tmp.clear();
+        /*seats, which are not ours, nothing was exchanged*/
+        out << cli::beforeWarn;
+        out << "Invalid seats, nothing exchanged: ";
+        seats_to_string(tmp, invalid_seats);
+        out << tmp;
+        out << cli::afterWarn;
+        out << "\n";
+    }
+
+    if (unavalable_seats.empty() != true) {
+        tmp.clear();
+        /*seats, which are taken by others, nothing was exchanged*/
+        out << cli::beforeWarn;
+        out << "Unavailable seats, nothing exchanged: ";
+        seats_to_string(tmp, unavalable_seats);
+        out << tmp;
+        out << cli::afterWarn;
+        out << "\n";
+    }
 }
 
-/// @brief Callback function to try to book the seats
-///     If any seat from the list is already taken, 
-///     that seat will be skipped, while funtion will continue
-//      with oter seats in the selection
+/// @brief Callback function to list all the shows with their handles
+/// @param out [out] output stream
+void CSession::shows_cb (std::ostream& out)
+{
+    for (const auto &movie : m_movie_cmd_vector) {
+        for (const auto &theatre : movie.theatre_cmd_vector) {
+            out << theatre.show << ": " << movie.movie << "/" << theatre.theatre << ", capacity " << theatre.capacity << "\n";
+        }
+    }
+}
+
+/// @brief Callback function to list movies played in the theatre with their handles
+/// @param out [out] output stream
+/// @param theatre [in] theatre
+void CSession::playing_cb (std::ostream& out, const std::string& theatre)
+{
+    std::vector<std::pair<std::string, uint32_t>> shows;
+
+    /*theatre index of the catalog, movies of other theatres are not visited*/
+    if (m_booking.get_theatre_shows(theatre, shows) < EXIT_SUCCESS) {
+        out << cli::beforeError;
+        out << "Unknown theatre " << theatre << ", see shows command\n";
+        out << cli::afterError;
+        return;
+    }
+
+    for (const auto &[movie, show] : shows) {
+        out << show << ": " << movie << "/" << theatre << "\n";
+    }
+}
+
+/// @brief Callback function to list shows with at least n free seats
+/// @param out [out] output stream
+/// @param n [in] minimal number of free seats
+void CSession::available_cb (std::ostream& out, size_t n)
+{
+    std::vector<CBooking::show_availability> shows;
+
+    /*answered from free seat counts, seat maps are not read*/
+    m_booking.get_available(static_cast<uint32_t>(std::min<size_t>(n, UINT32_MAX)), shows);
+    write_availability(out, shows);
+}
+
+/// @brief Callback function to list shows with the most free seats
+/// @param out [out] output stream
+/// @param k [in] maximal number of shows
+void CSession::top_cb (std::ostream& out, size_t k)
+{
+    std::vector<CBooking::show_availability> shows;
+
+    m_booking.get_top(static_cast<uint32_t>(std::min<size_t>(k, UINT32_MAX)), shows);
+    write_availability(out, shows);
+}
+
+/// @brief Write shows and their free seats
+/// @param out [out] output stream
+/// @param shows [in] shows
+void CSession::write_availability (std::ostream& out, const std::vector<CBooking::show_availability> &shows)
+{
+    if (shows.empty()) {
+        out << "There are no such shows\n";
+        return;
+    }
+
+    for (const auto &show : shows) {
+        out << show.show_ << ": " << show.movie_ << "/" << show.theatre_ << ", free " << show.free_ << "\n";
+    }
+}
+
+/// @brief List free seats of the show, used by menu and by flat command
+/// @param out [out] output stream
+/// @param show [in] show handle
+void CSession::show_free_seats (std::ostream& out, size_t show)
+{
+    int32_t rc;
+    uint32_t handle;
+    CResponseCache::response_ptr response;
+
+    /*handle of removed show is refused too*/
+    if ((show >= m_booking.get_shows())||(m_booking.get_capacity(static_cast<uint32_t>(show)) < EXIT_SUCCESS)) {
+        unknown_show(out, show);
+        return;
+    }
+    handle = static_cast<uint32_t>(show);
+
+    /*rendered once per change of the theatre, shared by all the sessions*/
+    rc = m_booking.get_theatre_response(
+        handle,
+        cli::Color(),
+        [this, handle](std::string &buffer)
+        {
+            std::string str;
+            std::set<uint32_t> free_seats;
+
+            int32_t rc = m_booking.get_free_seats(handle, free_seats);
+            if (rc < EXIT_SUCCESS)
+                throw std::system_error(-rc, std::generic_category(), "free seats not available");
+
+            if (free_seats.empty()) {
+                buffer = "There are no seats available\n";
+            }
+            else {
+                seats_to_string(str, free_seats);
+                buffer = "Free available seats: " + str + "\n";
+            }
+            to_crlf(buffer);
+        },
+        response);
+    if (rc < EXIT_SUCCESS) {
+        /*failed rendering is retried by the next request, session goes on*/
+        out << cli::beforeError;
+        out << "Free seats not available, try again\n";
+        out << cli::afterError;
+        return;
+    }
+
+    send_response(response);
+}
+
+/// @brief Book seats of the show, used by menu and by flat command
 /// @param out [out] status output stream
+/// @param show [in] show handle
 /// @param arg [in] booking parameters [list of seats]
-/// @param movie_pos [in] movie position
-/// @param theatre_pos [in] theatre position
-void CSession::trybook_seats_cb (std::ostream& out, const std::string& arg, size_t movie_pos, size_t theatre_pos)
+/// @param best_effort [in] true, to skip already booked seats
+void CSession::show_book_seats (std::ostream& out, size_t show, const std::string& arg, bool best_effort)
 {
     int32_t rc;
+    uint32_t handle;
     std::string tmp;
-    std::string movie;
-    std::string theatre;
     std::set<uint32_t> req_free_seats;
     std::vector<uint32_t> unavalable_seats;
 
-    /*retrive names from positions*/
-    rc = get_names(movie, theatre, movie_pos, theatre_pos);
-    if (rc < EXIT_SUCCESS) {
-        cli_sys_err(out);
+    /*handle of removed show is refused too*/
+    if ((show >= m_booking.get_shows())||(m_booking.get_capacity(static_cast<uint32_t>(show)) < EXIT_SUCCESS)) {
+        unknown_show(out, show);
         return;
     }
+    handle = static_cast<uint32_t>(show);
 
     /*convert slection text to list of seats*/
-    req_free_seats = get_seats(arg);
+    req_free_seats = get_seats(arg, static_cast<uint32_t>(m_booking.get_capacity(handle)));
 
     /*book the seats*/
-    rc = m_booking.book_seats(shared_from_this(), movie, theatre, req_free_seats, unavalable_seats, true);
+    rc = m_booking.book_seats(shared_from_this(), handle, req_free_seats, unavalable_seats, best_effort);
     if (rc < EXIT_SUCCESS) {
         out << cli::beforeError;
         out << "Failed to process an request\n";
@@ -657,7 +1227,7 @@ void CSession::trybook_seats_cb (std::ostream& out, const std::string& arg, size
     }
 
     /*get latest list of currently booked list of the booker*/
-    rc = m_booking.get_booked_seats(shared_from_this(), movie, theatre, req_free_seats);
+    rc = m_booking.get_booked_seats(shared_from_this(), handle, req_free_seats);
     if (rc < EXIT_SUCCESS) {
         out << cli::beforeError;
         out << "Failed to process an request\n";
@@ -684,18 +1254,271 @@ void CSession::trybook_seats_cb (std::ostream& out, const std::string& arg, size
     }
 }
 
-/// @brief Release already booked selected seats
+/// @brief Release booked seats of the show, used by menu and by flat command
 /// @param out [out] status output stream
+/// @param show [in] show handle
 /// @param arg [in] booking parameters [list of seats]
+void CSession::show_unbook_seats (std::ostream& out, size_t show, const std::string& arg)
+{
+    int32_t rc;
+    uint32_t handle;
+    std::string tmp;
+    std::set<uint32_t> req_free_seats;
+    std::vector<uint32_t> invalid_seats;
+
+    /*handle of removed show is refused too*/
+    if ((show >= m_booking.get_shows())||(m_booking.get_capacity(static_cast<uint32_t>(show)) < EXIT_SUCCESS)) {
+        unknown_show(out, show);
+        return;
+    }
+    handle = static_cast<uint32_t>(show);
+
+    /*convert slection text to list of seats*/
+    req_free_seats = get_seats(arg, static_cast<uint32_t>(m_booking.get_capacity(handle)));
+
+    /*release selected seats*/
+    rc = m_booking.unbook_seats(shared_from_this(), handle, req_free_seats, invalid_seats);
+    if (rc < EXIT_SUCCESS) {
+        out << cli::beforeError;
+        out << "Failed to process an request\n";
+        out << cli::afterError;
+        return;
+    }
+
+    /*get latest list of still currently booked list of the booker*/
+    rc = m_booking.get_booked_seats(shared_from_this(), handle, req_free_seats);
+    if (rc < EXIT_SUCCESS) {
+        out << cli::beforeError;
+        out << "Failed to process an request\n";
+        out << cli::afterError;
+        return;
+    }
+
+    out << cli::beforeOK;
+    out << "Currently reserved seats: ";
+    seats_to_string(tmp, req_free_seats);
+    out << tmp;
+    out << cli::afterOK;
+    out << "\n";
+
+    if (invalid_seats.empty() != true) {
+        tmp.clear();
+        /*list of the seats, which were not booked by us, or are free*/
+        out << cli::beforeWarn;
+        out << "Invalid seats: ";
+        seats_to_string(tmp, invalid_seats);
+        out << tmp;
+        out << cli::afterWarn;
+        out << "\n";
+    }
+}
+
+/// @brief Report show handle, which doesn't exist
+/// @param out [out] output stream
+/// @param show [in] show handle
+void CSession::unknown_show (std::ostream& out, size_t show)
+{
+    out << cli::beforeError;
+    out << "Unknown show " << show << ", see shows command\n";
+    out << cli::afterError;
+}
+
+/// @brief Callback function to book the first contiguous free seats
+/// @param out [out] status output stream
+/// @param arg [in] booking parameters [number of seats, optionally @row]
 /// @param movie_pos [in] movie position
 /// @param theatre_pos [in] theatre position
-void CSession::unbook_seats_cb (std::ostream& out, const std::string& arg, size_t movie_pos, size_t theatre_pos)
+void CSession::bookbest_seats_cb (std::ostream& out, const std::string& arg, size_t movie_pos, size_t theatre_pos)
+{
+    int32_t rc;
+    uint32_t n;
+    std::string tmp;
+    std::string row;
+    std::string_view movie;
+    std::string_view theatre;
+    std::set<uint32_t> seats;
+
+    /*retrive names from positions*/
+    rc = get_names(movie, theatre, movie_pos, theatre_pos);
+    if (rc < EXIT_SUCCESS) {
+        cli_sys_err(out);
+        return;
+    }
+
+    rc = get_best_request(arg, n, row);
+    if (rc < EXIT_SUCCESS) {
+        out << cli::beforeError;
+        out << "Invalid request, expected number of seats and optional @row\n";
+        out << cli::afterError;
+        return;
+    }
+
+    /*find and book the seats*/
+    rc = m_booking.book_best_seats(shared_from_this(), movie, theatre, n, row, seats);
+    if (rc == -ENOSPC) {
+        out << cli::beforeWarn;
+        out << "No " << n << " contiguous free seats";
+        out << cli::afterWarn;
+        out << "\n";
+        return;
+    }
+    if (rc == -ENOENT) {
+        out << cli::beforeError;
+        out << "Unknown row " << row << "\n";
+        out << cli::afterError;
+        return;
+    }
+    if (rc < EXIT_SUCCESS) {
+        out << cli::beforeError;
+        out << "Failed to process an request\n";
+        out << cli::afterError;
+        return;
+    }
+
+    out << cli::beforeOK;
+    out << "Booked seats: ";
+    seats_to_string(tmp, seats);
+    out << tmp;
+    out << cli::afterOK;
+    out << "\n";
+}
+
+/// @brief Callback function to book contiguous free seats in any theatre of the movie
+/// @param out [out] status output stream
+/// @param arg [in] booking parameters [number of seats]
+/// @param movie_pos [in] movie position
+/// @param theatre_pos [in] not used, movie command has no theatre
+void CSession::bookany_seats_cb (std::ostream& out, const std::string& arg, size_t movie_pos, size_t theatre_pos)
+{
+    int32_t rc;
+    uint32_t n;
+    std::string tmp;
+    std::string row;
+    std::string theatre_name;
+    std::set<uint32_t> seats;
+
+    (void)(theatre_pos);
+
+    if (movie_pos >= m_movie_cmd_vector.size()) {
+        cli_sys_err(out);
+        return;
+    }
+    const std::string &movie = m_movie_cmd_vector[movie_pos].movie;
+
+    rc = get_best_request(arg, n, row);
+    if ((rc < EXIT_SUCCESS)||(row.empty() != true)) {
+        out << cli::beforeError;
+        out << "Invalid request, expected number of seats\n";
+        out << cli::afterError;
+        return;
+    }
+
+    /*single request, theatres are searched and booked by the booking*/
+    rc = m_booking.book_any_seats(shared_from_this(), movie, n, seats);
+    if (rc == -ENOSPC) {
+        out << cli::beforeWarn;
+        out << "No theatre has " << n << " contiguous free seats";
+        out << cli::afterWarn;
+        out << "\n";
+        return;
+    }
+    if (rc < EXIT_SUCCESS) {
+        out << cli::beforeError;
+        out << "Failed to process an request\n";
+        out << cli::afterError;
+        return;
+    }
+
+    /*theatre is named, when menus know the show*/
+    theatre_name = "show " + std::to_string(rc);
+    for (const auto &theatre : m_movie_cmd_vector[movie_pos].theatre_cmd_vector) {
+        if (theatre.show == static_cast<uint32_t>(rc))
+            theatre_name = theatre.theatre;
+    }
+
+    out << cli::beforeOK;
+    out << "Booked seats in " << theatre_name << ": ";
+    seats_to_string(tmp, seats);
+    out << tmp;
+    out << cli::afterOK;
+    out << "\n";
+}
+
+/// @brief Callback function to hold the seats for limited time
+///     If any seat from the list is already taken,
+///     none of the seats will be held
+/// @param out [out] status output stream
+/// @param arg [in] booking parameters [list of seats]
+/// @param movie_pos [in] movie position
+/// @param theatre_pos [in] theatre position
+void CSession::hold_seats_cb (std::ostream& out, const std::string& arg, size_t movie_pos, size_t theatre_pos)
 {
     int32_t rc;
     std::string tmp;
-    std::string movie;
-    std::string theatre;
+    std::string_view movie;
+    std::string_view theatre;
     std::set<uint32_t> req_free_seats;
+    std::vector<uint32_t> unavalable_seats;
+
+    /*retrive names from positions*/
+    rc = get_names(movie, theatre, movie_pos, theatre_pos);
+    if (rc < EXIT_SUCCESS) {
+        cli_sys_err(out);
+        return;
+    }
+
+    /*convert slection text to list of seats*/
+    req_free_seats = get_seats(arg, get_capacity(movie_pos, theatre_pos));
+
+    /*hold the seats*/
+    rc = m_booking.hold_seats(shared_from_this(), movie, theatre, req_free_seats, unavalable_seats, m_booking.get_hold_ttl());
+    if (rc < EXIT_SUCCESS) {
+        out << cli::beforeError;
+        out << "Failed to process an request\n";
+        out << cli::afterError;
+        return;
+    }
+
+    /*get latest list of currently held seats of the booker*/
+    rc = m_booking.get_held_seats(shared_from_this(), movie, theatre, req_free_seats);
+    if (rc < EXIT_SUCCESS) {
+        out << cli::beforeError;
+        out << "Failed to process an request\n";
+        out << cli::afterError;
+        return;
+    }
+
+    if (unavalable_seats.empty() != true) {
+        /*list of seats, which were not able to get taken*/
+        out << cli::beforeWarn;
+        out << "Unavailble seats: ";
+        seats_to_string(tmp, unavalable_seats);
+        out << tmp;
+        out << cli::afterWarn;
+        out << "\n";
+        return;
+    }
+
+    out << cli::beforeOK;
+    out << "Currently held seats: ";
+    seats_to_string(tmp, req_free_seats);
+    out << tmp;
+    out << cli::afterOK;
+    out << "\n";
+}
+
+/// @brief Callback function to make held seats permanent
+/// @param out [out] status output stream
+/// @param arg [in] booking parameters [list of seats]
+/// @param movie_pos [in] movie position
+/// @param theatre_pos [in] theatre position
+void CSession::confirm_seats_cb (std::ostream& out, const std::string& arg, size_t movie_pos, size_t theatre_pos)
+{
+    int32_t rc;
+    std::string tmp;
+    std::string_view movie;
+    std::string_view theatre;
+    std::set<uint32_t> req_seats;
     std::vector<uint32_t> invalid_seats;
 
     /*retrive names from positions*/
@@ -706,10 +1529,10 @@ void CSession::unbook_seats_cb (std::ostream& out, const std::string& arg, size_
     }
 
     /*convert slection text to list of seats*/
-    req_free_seats = get_seats(arg);
+    req_seats = get_seats(arg, get_capacity(movie_pos, theatre_pos));
 
-    /*release selected seats*/
-    rc = m_booking.unbook_seats(shared_from_this(), movie, theatre, req_free_seats, invalid_seats);
+    /*confirm the seats*/
+    rc = m_booking.confirm_seats(shared_from_this(), movie, theatre, req_seats, invalid_seats);
     if (rc < EXIT_SUCCESS) {
         out << cli::beforeError;
         out << "Failed to process an request\n";
@@ -717,8 +1540,8 @@ void CSession::unbook_seats_cb (std::ostream& out, const std::string& arg, size_
         return;
     }
 
-    /*get latest list of still currently booked list of the booker*/
-    rc = m_booking.get_booked_seats(shared_from_this(), movie, theatre, req_free_seats);
+    /*get latest list of currently booked list of the booker*/
+    rc = m_booking.get_booked_seats(shared_from_this(), movie, theatre, req_seats);
     if (rc < EXIT_SUCCESS) {
         out << cli::beforeError;
         out << "Failed to process an request\n";
@@ -728,14 +1551,14 @@ void CSession::unbook_seats_cb (std::ostream& out, const std::string& arg, size_
 
     out << cli::beforeOK;
     out << "Currently reserved seats: ";
-    seats_to_string(tmp, req_free_seats);
+    seats_to_string(tmp, req_seats);
     out << tmp;
     out << cli::afterOK;
     out << "\n";
 
     if (invalid_seats.empty() != true) {
         tmp.clear();
-        /*list of the seats, which were not booked by us, or are free*/
+        /*list of the seats, which were not held by us*/
         out << cli::beforeWarn;
         out << "Invalid seats: ";
         seats_to_string(tmp, invalid_seats);
@@ -754,8 +1577,8 @@ void CSession::book_status_cb (std::ostream& out, const std::string& arg, size_t
 {
     int32_t rc;
     std::string tmp;
-    std::string movie;
-    std::string theatre;
+    std::string_view movie;
+    std::string_view theatre;
     std::set<uint32_t> req_seats;
 
     (void)(arg);
@@ -782,5 +1605,17 @@ void CSession::book_status_cb (std::ostream& out, const std::string& arg, size_t
     out << tmp;
     out << cli::afterOK;
     out << "\n";
+
+    /*held seats are part of reserved seats, until they are confirmed*/
+    rc = m_booking.get_held_seats(shared_from_this(), movie, theatre, req_seats);
+    if ((rc > 0)&&(req_seats.empty() != true)) {
+        tmp.clear();
+        out << cli::beforeWarn;
+        out << "Held seats: ";
+        seats_to_string(tmp, req_seats);
+        out << tmp;
+        out << cli::afterWarn;
+        out << "\n";
+    }
 }
 
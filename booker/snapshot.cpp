@@ -0,0 +1,212 @@
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "snapshot.h"
+
+
+/// @brief Append plain value to the buffer
+/// @param buffer [io] file content
+/// @param value [in] value
+template <typename T>
+static void put(std::string &buffer, const T &value)
+{
+    buffer.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+/// @brief Append name to the buffer, length first
+/// @param buffer [io] file content
+/// @param name [in] name
+static void put_name(std::string &buffer, const std::string &name)
+{
+    put(buffer, static_cast<uint32_t>(name.size()));
+    buffer.append(name);
+}
+
+/// @brief Read plain value from the buffer
+/// @param buffer [in] file content
+/// @param offset [io] position of the value, moved behind it
+/// @param value [out] value
+/// @return true, if the value is within the buffer
+template <typename T>
+static bool get(const std::string &buffer, std::size_t &offset, T &value)
+{
+    if ((offset > buffer.size())||(buffer.size() - offset < sizeof(value))) {
+        return false;
+    }
+
+    std::memcpy(&value, buffer.data() + offset, sizeof(value));
+    offset += sizeof(value);
+    return true;
+}
+
+/// @brief Read name from the buffer
+/// @param buffer [in] file content
+/// @param offset [io] position of the name, moved behind it
+/// @param name [out] name
+/// @return true, if the name is within the buffer
+static bool get_name(const std::string &buffer, std::size_t &offset, std::string &name)
+{
+    uint32_t size;
+
+    if ((get(buffer, offset, size) != true)||(buffer.size() - offset < size)) {
+        return false;
+    }
+
+    name.assign(buffer, offset, size);
+    offset += size;
+    return true;
+}
+
+/// @brief FNV-1a checksum of the bytes
+/// @param data [in] bytes
+/// @param size [in] number of bytes
+/// @return checksum
+static uint64_t checksum(const char *data, std::size_t size)
+{
+    uint64_t hash = 14695981039346656037ull;
+
+    for (std::size_t i = 0; i < size; ++i) {
+        hash = (hash ^ static_cast<uint8_t>(data[i])) * 1099511628211ull;
+    }
+
+    return hash;
+}
+
+/// @brief Write image to the file
+/// @param path [in] snapshot file, replaced atomically
+/// @return Negative on error, size of the file on success
+int32_t CSnapshot::save(const std::string &path) const
+{
+    int fd;
+    int32_t rc;
+    std::string buffer;
+    std::string temp_path;
+
+    buffer.append(m_magic, sizeof(m_magic));
+    put(buffer, m_version);
+    put(buffer, static_cast<uint32_t>(theatres_.size()));
+    for (const theatre &item : theatres_) {
+        put_name(buffer, item.movie_);
+        put_name(buffer, item.theatre_);
+        put(buffer, item.capacity_);
+        put(buffer, static_cast<uint32_t>(item.owners_.size()));
+        put(buffer, item.version_);
+        buffer.append(reinterpret_cast<const char *>(item.free_words_.data()), item.free_words_.size() * sizeof(CSeatMap::word_t));
+        for (const auto &[seat, owner] : item.owners_) {
+            put(buffer, seat);
+            put(buffer, owner);
+        }
+    }
+    put(buffer, checksum(buffer.data(), buffer.size()));
+
+    /*readers see either the previous or the new snapshot, never a partial one*/
+    temp_path = path + ".tmp";
+    fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+    if (fd < 0) {
+        return -errno;
+    }
+
+    rc = EXIT_SUCCESS;
+    for (std::size_t written = 0; written < buffer.size();) {
+        ssize_t n = ::write(fd, buffer.data() + written, buffer.size() - written);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            rc = -errno;
+            break;
+        }
+        written += static_cast<std::size_t>(n);
+    }
+
+    if ((rc == EXIT_SUCCESS)&&(::fsync(fd) != 0)) {
+        rc = -errno;
+    }
+    ::close(fd);
+
+    if ((rc == EXIT_SUCCESS)&&(::rename(temp_path.c_str(), path.c_str()) != 0)) {
+        rc = -errno;
+    }
+    if (rc < EXIT_SUCCESS) {
+        ::unlink(temp_path.c_str());
+        return rc;
+    }
+
+    return static_cast<int32_t>(buffer.size());
+}
+
+/// @brief Read image from the file
+/// @param path [in] snapshot file
+/// @return Negative on error, number of theatres on success
+int32_t CSnapshot::load(const std::string &path)
+{
+    std::size_t offset;
+    uint32_t version;
+    uint32_t theatres;
+    uint64_t stored_checksum;
+    char magic[sizeof(m_magic)];
+    std::vector<theatre> new_theatres;
+
+    std::ifstream file(path, std::ios::binary);
+    if (file.is_open() != true) {
+        return -ENOENT;
+    }
+    std::string buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    /*whole file is verified before anything is parsed*/
+    if (buffer.size() < sizeof(m_magic) + sizeof(stored_checksum)) {
+        return -EINVAL;
+    }
+    std::memcpy(&stored_checksum, buffer.data() + buffer.size() - sizeof(stored_checksum), sizeof(stored_checksum));
+    buffer.resize(buffer.size() - sizeof(stored_checksum));
+    if (stored_checksum != checksum(buffer.data(), buffer.size())) {
+        return -EINVAL;
+    }
+
+    std::memcpy(magic, buffer.data(), sizeof(magic));
+    offset = sizeof(magic);
+    if ((std::memcmp(magic, m_magic, sizeof(m_magic)) != 0)||
+        (get(buffer, offset, version) != true)||(version != m_version)||
+        (get(buffer, offset, theatres) != true)) {
+        return -EINVAL;
+    }
+
+    for (uint32_t i = 0; i < theatres; ++i) {
+        theatre item;
+        uint32_t owners;
+
+        if ((get_name(buffer, offset, item.movie_) != true)||
+            (get_name(buffer, offset, item.theatre_) != true)||
+            (get(buffer, offset, item.capacity_) != true)||
+            (get(buffer, offset, owners) != true)||
+            (get(buffer, offset, item.version_) != true)) {
+            return -EINVAL;
+        }
+
+        item.free_words_.resize(CSeatMap::words(item.capacity_));
+        for (CSeatMap::word_t &word : item.free_words_) {
+            if (get(buffer, offset, word) != true)
+                return -EINVAL;
+        }
+
+        item.owners_.resize(owners);
+        for (auto &[seat, owner] : item.owners_) {
+            if ((get(buffer, offset, seat) != true)||(get(buffer, offset, owner) != true)||(seat >= item.capacity_))
+                return -EINVAL;
+        }
+
+        new_theatres.push_back(std::move(item));
+    }
+
+    if (offset != buffer.size()) {
+        return -EINVAL;
+    }
+
+    theatres_ = std::move(new_theatres);
+    return static_cast<int32_t>(theatres_.size());
+}
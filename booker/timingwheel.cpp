@@ -0,0 +1,91 @@
+#include <cassert>
+
+#include "timingwheel.h"
+
+
+/// @brief Schedule timer
+///     Timers in the past or in the current tick expire on the next tick.
+///     Timers beyond the range of the wheel are rescheduled, when they reach the last wheel
+/// @param id [in] timer id, returned back on expiration
+/// @param tick [in] tick, when the timer expires
+void CTimingWheel::schedule(timer_id_t id, uint64_t tick)
+{
+    if (tick <= m_now) {
+        tick = m_now + 1;
+    }
+
+    insert(timer{id, tick});
+    m_size++;
+}
+
+/// @brief Move wheel forward
+/// @param tick [in] new current tick, nothing happens if it is not in the future
+/// @param expired [out] ids of expired timers are appended
+void CTimingWheel::advance(uint64_t tick, std::vector<timer_id_t> &expired)
+{
+    uint32_t level;
+
+    while (m_now < tick) {
+        if (m_size == 0) {
+            /*nothing to expire, jump directly*/
+            m_now = tick;
+            break;
+        }
+
+        m_now++;
+
+        /*find the highest level, which slot starts now and cascade from the top*/
+        level = 0;
+        while ((level + 1 < m_levels)&&((m_now & ((static_cast<uint64_t>(1) << (m_slot_bits * (level + 1))) - 1)) == 0)) {
+            level++;
+        }
+        for (; level > 0; --level) {
+            cascade(level);
+        }
+
+        slot_t &slot = m_wheels[0][m_now & (m_slots - 1)];
+        for (const timer &entry : slot) {
+            assert(entry.tick_ <= m_now);
+            expired.push_back(entry.id_);
+        }
+        m_size -= slot.size();
+        slot.clear();
+    }
+}
+
+/// @brief Put timer to the slot, which corresponds to its distance from now
+/// @param entry [in] timer
+void CTimingWheel::insert(const timer &entry)
+{
+    uint32_t level;
+    uint64_t tick;
+    uint64_t delta;
+
+    delta = entry.tick_ - m_now;
+    tick = entry.tick_;
+
+    /*the farthest timers wait in the last level and are re-inserted on cascade*/
+    if (delta >= (static_cast<uint64_t>(1) << (m_slot_bits * m_levels))) {
+        tick = m_now + (static_cast<uint64_t>(1) << (m_slot_bits * m_levels)) - 1;
+        delta = tick - m_now;
+    }
+
+    level = 0;
+    while ((level + 1 < m_levels)&&(delta >= (static_cast<uint64_t>(1) << (m_slot_bits * (level + 1))))) {
+        level++;
+    }
+
+    m_wheels[level][(tick >> (m_slot_bits * level)) & (m_slots - 1)].push_back(entry);
+}
+
+/// @brief Move timers of the current slot of the level to lower levels
+/// @param level [in] level to be cascaded
+void CTimingWheel::cascade(uint32_t level)
+{
+    slot_t slot;
+
+    slot.swap(m_wheels[level][(m_now >> (m_slot_bits * level)) & (m_slots - 1)]);
+    for (const timer &entry : slot) {
+        insert(entry);
+    }
+}
@@ -1,6 +1,8 @@
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <thread>
 
 #ifndef _WIN32
     #include <unistd.h>
@@ -9,6 +11,7 @@
     #include <signal.h>
     #include <fcntl.h>
     #include <sys/stat.h>
+    #include <sys/resource.h>
 #else
     #include "getopt.h"
 #endif /* _WIN32 */
@@ -192,6 +195,152 @@ static void signal_handler_cb
 
 
 
+/// @brief Load catalog of movies and theatres from the file, from shards of the directory,
+///     or from compiled image. Time of the load and peak memory of the process are reported
+/// @param booking [io] booking reference
+/// @param path [in] catalog file, directory of *.json shards or catalog image
+/// @param threads [in] number of parser threads
+/// @return Negative on error, >=0 on success
+static int32_t load_catalog
+(
+    CBooking& booking,
+    const std::string &path,
+    uint32_t threads
+)
+{
+    int32_t rc;
+    std::chrono::steady_clock::time_point start;
+
+    start = std::chrono::steady_clock::now();
+    if (CCatalogImage::is_image(path)) {
+        /*compiled catalog isn't parsed at all*/
+        rc = booking.load_image(path);
+    }
+    else {
+        rc = booking.load_files(path, threads);
+    }
+    if (rc < EXIT_SUCCESS) {
+        return rc;
+    }
+
+    std::cout << "Catalog " << path << " shows: " << booking.get_shows()
+        << ", load: " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() << " ms";
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        std::cout << ", peak RSS: " << usage.ru_maxrss / 1024 << " MiB";
+    }
+#endif /* _WIN32 */
+    std::cout << "\n";
+
+    return rc;
+}
+
+/// @brief Reload coroutine, loads the catalog file again on SIGHUP.
+///     Sessions keep on booking meanwhile, they pick up new menus with their next command
+/// @param booking [io] booking reference
+/// @param io_context [io] boost io context
+/// @param path [in] catalog file or directory of shards
+/// @param threads [in] number of parser threads
+/// @return none
+static boost::asio::awaitable<void> on_reload
+(
+    CBooking& booking,
+    boost::asio::io_context& io_context,
+    std::string path,
+    uint32_t threads
+)
+{
+    int32_t rc;
+    boost::system::error_code ec;
+    boost::asio::signal_set signals(io_context, SIGHUP);
+
+    for (;;) {
+        co_await signals.async_wait(redirect_error(boost::asio::use_awaitable, ec));
+        if (ec) {
+            co_return;
+        }
+
+        /*failed reload keeps the current catalog*/
+        rc = load_catalog(booking, path, threads);
+        if (rc < EXIT_SUCCESS) {
+            std::cerr << "Catalog " << path << " can't be reloaded: " << rc << "\n";
+            continue;
+        }
+        std::cout << "Catalog " << path << " reloaded, version: " << booking.get_catalog_version() << "\n";
+    }
+}
+
+/// @brief Housekeeping coroutine, releases expired holds and seats of closed sessions after grace period
+/// @param booking [io] booking reference
+/// @param io_context [io] boost io context
+/// @return none
+static boost::asio::awaitable<void> on_housekeeping
+(
+    CBooking& booking,
+    boost::asio::io_context& io_context
+)
+{
+    int32_t journal_error;
+    boost::system::error_code ec;
+    boost::asio::steady_timer timer(io_context);
+
+    journal_error = EXIT_SUCCESS;
+    for (;;) {
+        /*one tick of the holds timing wheel*/
+        timer.expires_after(CBooking::get_hold_tick());
+        co_await timer.async_wait(redirect_error(boost::asio::use_awaitable, ec));
+        if (ec) {
+            co_return;
+        }
+
+        booking.expire_holds(std::chrono::steady_clock::now());
+        booking.release_departed(std::chrono::steady_clock::now());
+
+        /*writer error is sticky, it is reported once*/
+        if ((journal_error == EXIT_SUCCESS)&&(booking.get_journal().is_open())) {
+            journal_error = booking.get_journal().get_error();
+            if (journal_error < EXIT_SUCCESS) {
+                std::cerr << "Journal can't be written: " << journal_error << "\n";
+            }
+        }
+    }
+}
+
+/// @brief Snapshot coroutine, writes image of all the seats periodically.
+///     It runs in its own io context, so sessions are not delayed by the disk
+/// @param booking [io] booking reference
+/// @param io_context [io] boost io context of snapshots
+/// @param path [in] snapshot file
+/// @param period [in] time between snapshots
+/// @return none
+static boost::asio::awaitable<void> on_snapshot
+(
+    CBooking& booking,
+    boost::asio::io_context& io_context,
+    std::string path,
+    std::chrono::seconds period
+)
+{
+    int32_t rc;
+    boost::system::error_code ec;
+    boost::asio::steady_timer timer(io_context);
+
+    for (;;) {
+        timer.expires_after(period);
+        co_await timer.async_wait(redirect_error(boost::asio::use_awaitable, ec));
+        if (ec) {
+            co_return;
+        }
+
+        /*busy snapshot is taken with the next period*/
+        rc = booking.save_snapshot(path);
+        if ((rc < EXIT_SUCCESS)&&(rc != -EBUSY)) {
+            std::cerr << "Snapshot " << path << " can't be written: " << rc << "\n";
+        }
+    }
+}
+
 /// @brief Shut down coroutine
 /// @param server [io] server reference
 /// @param io_context [io] boost io context
@@ -223,6 +372,36 @@ static boost::asio::awaitable<void> on_shut_down
     co_return;
 }
 
+/// @brief Compile catalog to image, which is loaded at start without JSON parsing
+/// @param source [in] catalog file or directory of shards
+/// @param image [in] image file
+/// @param threads [in] number of parser threads
+/// @return Program compltition
+static int compile_catalog
+(
+    const std::string &source,
+    const std::string &image,
+    uint32_t threads
+)
+{
+    int32_t rc;
+    CBooking booking;
+
+    rc = load_catalog(booking, source, threads);
+    if (rc < EXIT_SUCCESS) {
+        std::cerr << "Catalog " << source << " can't be loaded: " << rc << "\n";
+        return EXIT_FAILURE;
+    }
+
+    rc = booking.save_image(image);
+    if (rc < EXIT_SUCCESS) {
+        std::cerr << "Image " << image << " can't be written: " << rc << "\n";
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Image " << image << " written, bytes: " << rc << "\n";
+    return EXIT_SUCCESS;
+}
 
 
 
@@ -234,14 +413,89 @@ static boost::asio::awaitable<void> on_shut_down
 int main(int argc, char* argv[])
 {
     int rc;
+    int opt;
     int threads;
+    uint32_t parser_threads;
     bool bdaemonize;
+    bool restored;
+    std::string journal_path;
+    std::string store_path;
+    std::string snapshot_path;
+    std::string catalog_path;
+    std::chrono::seconds snapshot_period;
+    CJournal::durability_t durability;
     CBooking booking;
     CServer server(booking);
-    boost::property_tree::ptree pt;
 
-    (void)(argc);
-    (void)(argv);
+    /*command line options*/
+    durability = CJournal::durability_t::batched;
+    snapshot_period = std::chrono::seconds(60);
+    parser_threads = std::max(1u, std::thread::hardware_concurrency());
+    if ((argc == 4)&&(strcmp(argv[1], "compile") == 0)) {
+        /*playd compile catalog_file|catalog_dir image_file*/
+        return compile_catalog(argv[2], argv[3], parser_threads);
+    }
+
+    while ((opt = getopt(argc, argv, "lr:t:j:d:s:b:i:c:p:")) != -1) {
+        switch (opt) {
+        case 'l':
+            /*book seats with compare-and-swap on seat words, without theatre lock*/
+            booking.set_engine(CBooking::engine_t::lock_free);
+            break;
+        case 'r':
+            /*release seats of closed sessions after grace period*/
+            booking.set_release_policy(CBooking::release_policy_t::release, std::chrono::seconds(atoi(optarg)));
+            break;
+        case 't':
+            /*how long seats are held by hold command*/
+            booking.set_hold_ttl(std::chrono::seconds(atoi(optarg)));
+            break;
+        case 'j':
+            /*journal of bookings, replayed on start*/
+            journal_path = optarg;
+            break;
+        case 's':
+            /*seats in memory mapped file, restored at once after clean shutdown*/
+            store_path = optarg;
+            break;
+        case 'b':
+            /*periodic snapshot of seats, loaded on start*/
+            snapshot_path = optarg;
+            break;
+        case 'i':
+            /*time between snapshots*/
+            snapshot_period = std::chrono::seconds(std::max(1, atoi(optarg)));
+            break;
+        case 'c':
+            /*catalog of movies and theatres, reloaded on SIGHUP*/
+            catalog_path = optarg;
+            break;
+        case 'p':
+            /*threads parsing shards of catalog directory*/
+            parser_threads = static_cast<uint32_t>(std::max(1, atoi(optarg)));
+            break;
+        case 'd':
+            /*durability of journal*/
+            if (strcmp(optarg, "none") == 0) {
+                durability = CJournal::durability_t::none;
+            }
+            else if (strcmp(optarg, "batched") == 0) {
+                durability = CJournal::durability_t::batched;
+            }
+            else if (strcmp(optarg, "per_op") == 0) {
+                durability = CJournal::durability_t::per_op;
+            }
+            else {
+                std::cerr << "Unknown durability: " << optarg << "\n";
+                return EXIT_FAILURE;
+            }
+            break;
+        default:
+            std::cerr << "Usage: " << argv[0] << " [-l] [-c catalog_file|catalog_dir|image_file [-p parser_threads]] [-r grace_seconds] [-t hold_seconds] [-s store_file] [-b snapshot_file [-i snapshot_seconds]] [-j journal_file [-d none|batched|per_op]]\n"
+                << "       " << argv[0] << " compile catalog_file|catalog_dir image_file\n";
+            return EXIT_FAILURE;
+        }
+    }
 
     lpf = -1;
     app_name = "playd"; /*!< App name */
@@ -267,7 +521,7 @@ int main(int argc, char* argv[])
         "               {"\
         "                   \"movie\": \"GodFather\","
         "                   \"theatres\": ["\
-        "                           \"Tokyo\","\
+        "                           {\"theatre\": \"Tokyo\", \"seats\": 30},"\
         "                           \"Delhi\","\
         "                           \"Shanghai\","\
         "                           \"SaoPaulo\","\
@@ -277,7 +531,14 @@ int main(int argc, char* argv[])
         "               {"\
         "                   \"movie\": \"Matrix\","
         "                   \"theatres\": ["\
-        "                           \"Tokyo\","\
+        "                           {"\
+        "                               \"theatre\": \"Tokyo\","\
+        "                               \"layout\": ["\
+        "                                   {\"section\": \"Stalls\", \"row\": \"A\", \"seats\": 10},"\
+        "                                   {\"section\": \"Stalls\", \"row\": \"B\", \"seats\": 12},"\
+        "                                   {\"section\": \"Balcony\", \"row\": \"C\", \"seats\": 8}"\
+        "                                         ]"\
+        "                           },"\
         "                           \"MexicoCity\""\
         "                               ]"\
         "               },"\
@@ -292,22 +553,58 @@ int main(int argc, char* argv[])
         "            ]"\
         "}"; /*!< Dummy configuration data */
 
-    std::stringstream ss;
-    ss << data;
-    boost::property_tree::read_json(ss, pt);
+    if (catalog_path.empty() != true) {
+        rc = load_catalog(booking, catalog_path, parser_threads);
+        if (rc < EXIT_SUCCESS) {
+            std::cerr << "Catalog " << catalog_path << " can't be loaded: " << rc << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+    else {
+        std::stringstream ss(data);
+
+        rc = booking.load_data(ss);
+        if (rc < EXIT_SUCCESS) {
+            return rc;
+        }
+    }
 
-#if 0
-    /*for debugging purposes only*/
-    std::ostringstream oss;
-    boost::property_tree::write_json(oss, pt);
-    std::cout << oss.str();
-#endif
+    restored = false;
+    if (store_path.empty() != true) {
+        /*seats of cleanly closed store are served at once, dirty one is rebuilt*/
+        rc = booking.open_seat_store(store_path);
+        if (rc < EXIT_SUCCESS) {
+            std::cerr << "Seat store " << store_path << " can't be opened: " << rc << "\n";
+            return EXIT_FAILURE;
+        }
+        std::cout << "Seat store " << store_path << ((rc > 0) ? " restored\n" : " rebuilt\n");
+        restored = (rc > 0);
+    }
 
-    rc = booking.load_data(pt);
-    if (rc < EXIT_SUCCESS) {
-        return rc;
+    if ((snapshot_path.empty() != true)&&(journal_path.empty())&&(restored != true)) {
+        /*journal contains everything, snapshot is loaded only without it*/
+        rc = booking.load_snapshot(snapshot_path);
+        if ((rc < EXIT_SUCCESS)&&(rc != -ENOENT)) {
+            std::cerr << "Snapshot " << snapshot_path << " can't be loaded: " << rc << "\n";
+            return EXIT_FAILURE;
+        }
+        if (rc >= EXIT_SUCCESS) {
+            std::cout << "Snapshot " << snapshot_path << " loaded, theatres: " << rc << "\n";
+        }
     }
 
+    if (journal_path.empty() != true) {
+        /*bookings of the previous run come back before any session joins*/
+        rc = booking.open_journal(journal_path, durability);
+        if (rc < EXIT_SUCCESS) {
+            std::cerr << "Journal " << journal_path << " can't be replayed: " << rc << "\n";
+            return EXIT_FAILURE;
+        }
+        std::cout << "Journal " << journal_path << " replayed, records: " << rc << "\n";
+    }
+
+    boost::asio::io_context snapshot_context;
+    std::thread snapshot_thread;
     try
     {
         boost::asio::io_context io_context(threads);
@@ -323,6 +620,18 @@ int main(int argc, char* argv[])
                 co_await on_shut_down(server, io_context, timer);
             }, boost::asio::detached);
 
+        boost::asio::co_spawn(io_context,
+            [&booking, &io_context]() mutable -> boost::asio::awaitable<void> {
+                co_await on_housekeeping(booking, io_context);
+            }, boost::asio::detached);
+
+        if (catalog_path.empty() != true) {
+            boost::asio::co_spawn(io_context,
+                [&booking, &io_context, catalog_path, parser_threads]() mutable -> boost::asio::awaitable<void> {
+                    co_await on_reload(booking, io_context, catalog_path, parser_threads);
+                }, boost::asio::detached);
+        }
+
         /*add listenning ports*/
         server.add_listener(io_context, boost::asio::ip::tcp::v4(), 50000);
 
@@ -332,6 +641,15 @@ int main(int argc, char* argv[])
             signal_handler_cb(timer, error, signal_number);
         });
 
+        /*snapshots are written by their own thread*/
+        if (snapshot_path.empty() != true) {
+            boost::asio::co_spawn(snapshot_context,
+                [&booking, &snapshot_context, snapshot_path, snapshot_period]() mutable -> boost::asio::awaitable<void> {
+                    co_await on_snapshot(booking, snapshot_context, snapshot_path, snapshot_period);
+                }, boost::asio::detached);
+            snapshot_thread = std::thread([&snapshot_context]() {snapshot_context.run();});
+        }
+
         /*run io contex*/
         io_context.run();
     }
@@ -340,6 +658,35 @@ int main(int argc, char* argv[])
         std::cerr << "Exception: " << e.what() << "\n";
     }
 
+    snapshot_context.stop();
+    if (snapshot_thread.joinable()) {
+        snapshot_thread.join();
+    }
+
+    if (journal_path.empty() != true) {
+        /*records of the last sessions might fail after housekeeping stopped*/
+        rc = booking.get_journal().get_error();
+        if (rc < EXIT_SUCCESS) {
+            std::cerr << "Journal " << journal_path << " failed: " << rc << "\n";
+        }
+    }
+
+    if (snapshot_path.empty() != true) {
+        /*sessions are closed, last snapshot has all the bookings*/
+        rc = booking.save_snapshot(snapshot_path);
+        if (rc < EXIT_SUCCESS) {
+            std::cerr << "Snapshot " << snapshot_path << " can't be written: " << rc << "\n";
+        }
+    }
+
+    if (store_path.empty() != true) {
+        /*sessions are closed, seats are declared clean for the next start*/
+        rc = booking.close_seat_store();
+        if (rc < EXIT_SUCCESS) {
+            std::cerr << "Seat store " << store_path << " can't be closed: " << rc << "\n";
+        }
+    }
+
     return EXIT_SUCCESS;
 }
 
@@ -0,0 +1,94 @@
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+#include <vector>
+
+#include "availability.h"
+
+
+/*
+    https://live.boost.org/doc/libs/1_87_0/libs/test/doc/html/boost_test/utf_reference.html
+*/
+
+
+BOOST_AUTO_TEST_SUITE(availability_suite)
+
+/// @brief Entries with enough free seats and the largest entries
+/// @param  availability_test_case_1
+BOOST_AUTO_TEST_CASE(availability_test_case_1)
+{
+    CAvailability tree;
+    std::vector<uint32_t> entries;
+
+    BOOST_TEST_CHECKPOINT("Empty tree");
+    tree.find_at_least(1, entries);
+    BOOST_CHECK(entries.empty());
+    tree.find_top(3, entries);
+    BOOST_CHECK(entries.empty());
+    BOOST_CHECK_EQUAL(tree.get_max(), 0);
+
+    BOOST_TEST_CHECKPOINT("Values are set");
+    tree.resize(5);
+    BOOST_CHECK_EQUAL(tree.size(), 5);
+    tree.set(0, 20);
+    tree.set(1, 5);
+    tree.set(2, 30);
+    tree.set(3, 0);
+    tree.set(4, 20);
+    tree.set(5, 100);
+    BOOST_CHECK_EQUAL(tree.get(2), 30);
+    BOOST_CHECK_EQUAL(tree.get(5), 0);
+    BOOST_CHECK_EQUAL(tree.get_max(), 30);
+
+    BOOST_TEST_CHECKPOINT("Entries with at least n");
+    tree.find_at_least(20, entries);
+    BOOST_CHECK(entries == std::vector<uint32_t>({0, 2, 4}));
+    tree.find_at_least(0, entries);
+    BOOST_CHECK(entries == std::vector<uint32_t>({0, 1, 2, 4}));
+    tree.find_at_least(31, entries);
+    BOOST_CHECK(entries.empty());
+
+    BOOST_TEST_CHECKPOINT("The largest entries, equal ones by index");
+    tree.find_top(3, entries);
+    BOOST_CHECK(entries == std::vector<uint32_t>({2, 0, 4}));
+    tree.find_top(10, entries);
+    BOOST_CHECK(entries == std::vector<uint32_t>({2, 0, 4, 1}));
+
+    BOOST_TEST_CHECKPOINT("Maximum follows lowered value");
+    tree.set(2, 1);
+    BOOST_CHECK_EQUAL(tree.get_max(), 20);
+    tree.find_top(1, entries);
+    BOOST_CHECK(entries == std::vector<uint32_t>({0}));
+}
+
+/// @brief Concurrent writers leave every node matching its children
+/// @param  availability_test_case_2
+BOOST_AUTO_TEST_CASE(availability_test_case_2)
+{
+    CAvailability tree;
+    std::vector<uint32_t> entries;
+    std::vector<std::thread> threads;
+
+    tree.resize(64);
+    for (uint32_t i = 0; i < 8; ++i) {
+        threads.emplace_back([&tree, i]() {
+            for (uint32_t value = 1000; value > 0; --value) {
+                tree.set(i * 8, value);
+                tree.set(i * 8 + 1, 1000 - value);
+            }
+            tree.set(i * 8, i + 1);
+            tree.set(i * 8 + 1, 0);
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    BOOST_CHECK_EQUAL(tree.get_max(), 8);
+    tree.find_at_least(7, entries);
+    BOOST_CHECK(entries == std::vector<uint32_t>({48, 56}));
+    tree.find_top(8, entries);
+    BOOST_CHECK(entries == std::vector<uint32_t>({56, 48, 40, 32, 24, 16, 8, 0}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
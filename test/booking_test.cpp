@@ -1,6 +1,15 @@
 #define BOOST_TEST_MODULE tests
 #include <boost/test/unit_test.hpp>
 
+#include <thread>
+#include <fstream>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
 
 #include "booker.h"
 #include "booking.h"
@@ -43,6 +52,13 @@ BOOST_AUTO_TEST_CASE(booking_basic_test_case_1)
     BOOST_TEST_CHECKPOINT("Proper response if booker is not null");
     rc = booking_test.join_booker(first_booker);
     BOOST_CHECK_EQUAL(rc, 1);
+    BOOST_CHECK_EQUAL(first_booker->get_booker_id(), 1);
+
+    BOOST_TEST_CHECKPOINT("Every booker gets its own handle");
+    rc = booking_test.join_booker(second_booker);
+    BOOST_CHECK_EQUAL(rc, 2);
+    rc = booking_test.join_booker(second_booker);
+    BOOST_CHECK_EQUAL(rc, -EEXIST);
 }
 
 /// @brief Convert JSON to boost tree
@@ -284,6 +300,2025 @@ BOOST_AUTO_TEST_CASE(bookig_basic_test_case_3)
     BOOST_CHECK_EQUAL_COLLECTIONS(set.begin(), set.end(), set2.begin(), set2.end());
 }
 
+/// @brief Per theatre capacity and seat layout
+/// @param  bookig_basic_test_case_4
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_4)
+{
+    int32_t rc;
+    std::string data;
+    std::stringstream ss;
+    CBooking booking;
+    boost::property_tree::ptree pt;
+    std::set<uint32_t> set;
+    std::vector<uint32_t> unavalable_seats;
+    std::vector<CBooking::seat_row> layout;
+    CBooker::booker_ptr booker = std::make_shared<CBooker>();
+
+    BOOST_TEST_CHECKPOINT("Load theatres with capacity and layout");
+    data =\
+        "{"\
+        "\"movies\": ["\
+        "               {"\
+        "                   \"movie\": \"Matrix\","
+        "                   \"theatres\": ["\
+        "                           \"Delhi\","\
+        "                           {\"theatre\": \"Tokyo\", \"seats\": 30},"\
+        "                           {\"theatre\": \"Arena\", \"layout\": ["\
+        "                               {\"section\": \"North\", \"row\": \"A\", \"seats\": 100},"\
+        "                               {\"section\": \"South\", \"seats\": 200}"\
+        "                           ]}"\
+        "                               ]"\
+        "               }"\
+        "            ]"\
+        "}";
+
+    ss << data;
+    BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, pt));
+    rc = booking.load_data(pt);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    rc = booking.join_booker(booker);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+
+    BOOST_TEST_CHECKPOINT("Check capacities");
+    BOOST_CHECK_EQUAL(booking.get_capacity("Matrix", "Delhi"), static_cast<int32_t>(booking.get_max_seats()));
+    BOOST_CHECK_EQUAL(booking.get_capacity("Matrix", "Tokyo"), 30);
+    BOOST_CHECK_EQUAL(booking.get_capacity("Matrix", "Arena"), 300);
+    BOOST_CHECK_LT(booking.get_capacity("Matrix", "Tokyo2"), EXIT_SUCCESS);
+
+    BOOST_TEST_CHECKPOINT("Check layout");
+    rc = booking.get_layout("Matrix", "Arena", layout);
+    BOOST_CHECK_EQUAL(rc, 2);
+    BOOST_CHECK_EQUAL(layout[0].section_, "North");
+    BOOST_CHECK_EQUAL(layout[0].row_, "A");
+    BOOST_CHECK_EQUAL(layout[1].row_, "2");
+    BOOST_CHECK_EQUAL(layout[1].first_seat_, 100);
+    BOOST_CHECK_EQUAL(layout[1].seats_, 200);
+
+    BOOST_TEST_CHECKPOINT("Range checks are per theatre");
+    set = std::set<uint32_t>({25, 29});
+    rc = booking.book_seats(booker, "Matrix", "Tokyo", set, unavalable_seats, false);
+    BOOST_CHECK_EQUAL(rc, 2);
+    set = std::set<uint32_t>({30});
+    rc = booking.book_seats(booker, "Matrix", "Tokyo", set, unavalable_seats, false);
+    BOOST_CHECK_EQUAL(rc, -ERANGE);
+    rc = booking.book_seats(booker, "Matrix", "Delhi", set, unavalable_seats, false);
+    BOOST_CHECK_EQUAL(rc, -ERANGE);
+    set = std::set<uint32_t>({299});
+    rc = booking.book_seats(booker, "Matrix", "Arena", set, unavalable_seats, false);
+    BOOST_CHECK_EQUAL(rc, 1);
+
+    BOOST_TEST_CHECKPOINT("Layout must match capacity");
+    data =\
+        "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": ["\
+        "   {\"theatre\": \"Tokyo\", \"seats\": 30, \"layout\": [{\"seats\": 20}]}"\
+        "]}]}";
+    ss.clear();
+    ss.str(data);
+    pt.clear();
+    BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, pt));
+    CBooking booking2;
+    rc = booking2.load_data(pt);
+    BOOST_CHECK_EQUAL(rc, -EBADMSG);
+
+    BOOST_TEST_CHECKPOINT("Theatre must have a name");
+    data =\
+        "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": ["\
+        "   {\"seats\": 30}"\
+        "]}]}";
+    ss.clear();
+    ss.str(data);
+    pt.clear();
+    BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, pt));
+    rc = booking2.load_data(pt);
+    BOOST_CHECK_EQUAL(rc, -EBADMSG);
+}
+
+/// @brief Concurrent booking in lock free engine
+/// @param  bookig_basic_test_case_5
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_5)
+{
+    int32_t rc;
+    std::stringstream ss;
+    CBooking booking;
+    boost::property_tree::ptree pt;
+    std::set<uint32_t> set;
+    std::vector<uint32_t> unavalable_seats;
+    std::vector<CBooker::booker_ptr> bookers;
+    std::vector<std::set<uint32_t>> booked(4);
+    std::vector<std::thread> threads;
+
+    BOOST_TEST_CHECKPOINT("Load theatre");
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [{\"theatre\": \"Tokyo\", \"seats\": 128}]}]}";
+    BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, pt));
+    booking.set_engine(CBooking::engine_t::lock_free);
+    BOOST_CHECK(booking.get_engine() == CBooking::engine_t::lock_free);
+    rc = booking.load_data(pt);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+
+    for (std::size_t i = 0; i < booked.size(); ++i) {
+        bookers.push_back(std::make_shared<CBooker>());
+        BOOST_CHECK_GE(booking.join_booker(bookers.back()), EXIT_SUCCESS);
+    }
+
+    BOOST_TEST_CHECKPOINT("Every seat is booked exactly once");
+    for (std::size_t i = 0; i < booked.size(); ++i) {
+        threads.emplace_back([&booking, &bookers, &booked, i]() {
+            std::vector<uint32_t> unavalable;
+            /*pairs of seats straddle the word boundary, so both words are claimed at once*/
+            for (uint32_t seat = 0; seat < 64; ++seat) {
+                std::set<uint32_t> request({seat, 127 - seat});
+                unavalable.clear();
+                if (booking.book_seats(bookers[i], "Matrix", "Tokyo", request, unavalable, false) > 0) {
+                    if (unavalable.empty())
+                        booked[i].insert(request.begin(), request.end());
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    set.clear();
+    for (std::size_t i = 0; i < booked.size(); ++i) {
+        for (uint32_t seat : booked[i]) {
+            BOOST_CHECK(set.insert(seat).second);
+        }
+        std::set<uint32_t> owned;
+        booking.get_booked_seats(bookers[i], "Matrix", "Tokyo", owned);
+        BOOST_CHECK_EQUAL_COLLECTIONS(owned.begin(), owned.end(), booked[i].begin(), booked[i].end());
+    }
+    set.clear();
+    rc = booking.get_free_seats("Matrix", "Tokyo", set);
+    BOOST_CHECK(set.empty());
+
+    BOOST_TEST_CHECKPOINT("Unbook without lock");
+    set = booked[0];
+    rc = booking.unbook_seats(bookers[0], "Matrix", "Tokyo", set, unavalable_seats);
+    BOOST_CHECK(unavalable_seats.empty());
+    set.clear();
+    booking.get_free_seats("Matrix", "Tokyo", set);
+    BOOST_CHECK_EQUAL(set.size(), booked[0].size());
+
+    for (auto &booker : bookers) {
+        booking.leave_booker(booker);
+    }
+}
+
+/// @brief Compact booker handles
+/// @param  bookig_basic_test_case_6
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_6)
+{
+    int32_t rc;
+    std::stringstream ss;
+    std::string status;
+    CBooking booking;
+    boost::property_tree::ptree pt;
+    std::set<uint32_t> set;
+    std::vector<uint32_t> unavalable_seats;
+    CBooker::booker_ptr bookers[4] = {
+        std::make_shared<CBooker>(), std::make_shared<CBooker>(),
+        std::make_shared<CBooker>(), std::make_shared<CBooker>()};
+    CBooker::booker_ptr new_booker = std::make_shared<CBooker>();
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [\"Tokyo\"]}]}";
+    BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, pt));
+    rc = booking.load_data(pt);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+
+    BOOST_TEST_CHECKPOINT("Booker, which has not joined, can't book");
+    set = std::set<uint32_t>({1});
+    rc = booking.book_seats(new_booker, "Matrix", "Tokyo", set, unavalable_seats, false);
+    BOOST_CHECK_EQUAL(rc, -EINVAL);
+
+    BOOST_TEST_CHECKPOINT("Handles are dense");
+    for (uint32_t i = 0; i < 3; ++i) {
+        rc = booking.join_booker(bookers[i]);
+        BOOST_CHECK_EQUAL(rc, static_cast<int32_t>(i + 1));
+    }
+    BOOST_CHECK_EQUAL(booking.get_active_bookers(), 3);
+    bookers[0]->set_uid("first");
+    rc = booking.book_seats(bookers[0], "Matrix", "Tokyo", set, unavalable_seats, false);
+    BOOST_CHECK_EQUAL(rc, 1);
+    BOOST_CHECK_EQUAL(bookers[0]->get_seats_count(), 1);
+
+    BOOST_TEST_CHECKPOINT("Handle without seats is reused");
+    booking.leave_booker(bookers[1]);
+    rc = booking.join_booker(new_booker);
+    BOOST_CHECK_EQUAL(rc, 2);
+
+    BOOST_TEST_CHECKPOINT("Handle, which still owns seats, is not reused");
+    booking.dump_status(status);
+    BOOST_CHECK(status.find("first") != std::string::npos);
+    booking.leave_booker(bookers[0]);
+    rc = booking.join_booker(bookers[3]);
+    BOOST_CHECK_EQUAL(rc, 4);
+
+    status.clear();
+    booking.dump_status(status);
+    BOOST_CHECK(status.find("#1") != std::string::npos);
+
+    rc = booking.unbook_seats(bookers[3], "Matrix", "Tokyo", set, unavalable_seats);
+    BOOST_CHECK_EQUAL(unavalable_seats.size(), 1);
+}
+
+/// @brief Release seats of closed sessions
+/// @param  bookig_basic_test_case_7
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_7)
+{
+    int32_t rc;
+    std::stringstream ss;
+    CBooking booking;
+    boost::property_tree::ptree pt;
+    std::set<uint32_t> set;
+    std::vector<uint32_t> unavalable_seats;
+    CBooker::booker_ptr booker = std::make_shared<CBooker>();
+    CBooker::booker_ptr booker2 = std::make_shared<CBooker>();
+    CBooker::holdings_t holdings;
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [\"Tokyo\", \"Delhi\"]}, {\"movie\": \"Inception\", \"theatres\": [\"Tokyo\"]}]}";
+    BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, pt));
+    rc = booking.load_data(pt);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+
+    BOOST_TEST_CHECKPOINT("Reverse index follows bookings");
+    booking.set_release_policy(CBooking::release_policy_t::release, std::chrono::seconds(60));
+    BOOST_CHECK(booking.get_release_policy() == CBooking::release_policy_t::release);
+    BOOST_CHECK_EQUAL(booking.join_booker(booker), 1);
+    set = std::set<uint32_t>({1, 2, 3});
+    rc = booking.book_seats(booker, "Matrix", "Tokyo", set, unavalable_seats, false);
+    BOOST_CHECK_EQUAL(rc, 3);
+    rc = booking.book_seats(booker, "Inception", "Tokyo", set, unavalable_seats, false);
+    BOOST_CHECK_EQUAL(rc, 3);
+    set = std::set<uint32_t>({2});
+    rc = booking.unbook_seats(booker, "Inception", "Tokyo", set, unavalable_seats);
+    BOOST_CHECK_EQUAL(rc, 1);
+    booker->get_holdings(holdings);
+    BOOST_CHECK_EQUAL(holdings.size(), 2);
+    BOOST_CHECK_EQUAL(booker->get_seats_count(), 5);
+
+    BOOST_TEST_CHECKPOINT("Seats are kept during grace period");
+    booking.leave_booker(booker);
+    BOOST_CHECK_EQUAL(booking.release_departed(std::chrono::steady_clock::now()), 0);
+    set.clear();
+    booking.get_free_seats("Matrix", "Tokyo", set);
+    BOOST_CHECK(set.find(1) == set.end());
+
+    BOOST_TEST_CHECKPOINT("Seats are released after grace period");
+    BOOST_CHECK_EQUAL(booking.release_departed(std::chrono::steady_clock::now() + std::chrono::seconds(61)), 5);
+    BOOST_CHECK_EQUAL(booker->get_seats_count(), 0);
+    set.clear();
+    booking.get_free_seats("Matrix", "Tokyo", set);
+    BOOST_CHECK_EQUAL(set.size(), booking.get_max_seats());
+    set.clear();
+    booking.get_free_seats("Inception", "Tokyo", set);
+    BOOST_CHECK_EQUAL(set.size(), booking.get_max_seats());
+
+    BOOST_TEST_CHECKPOINT("Released handle is reused, without grace seats are released at once");
+    booking.set_release_policy(CBooking::release_policy_t::release);
+    BOOST_CHECK_EQUAL(booking.join_booker(booker2), 1);
+    set = std::set<uint32_t>({4});
+    rc = booking.book_seats(booker2, "Matrix", "Delhi", set, unavalable_seats, false);
+    BOOST_CHECK_EQUAL(rc, 1);
+    booking.leave_booker(booker2);
+    set.clear();
+    booking.get_free_seats("Matrix", "Delhi", set);
+    BOOST_CHECK_EQUAL(set.size(), booking.get_max_seats());
+}
+
+/// @brief Timed holds
+/// @param  bookig_basic_test_case_8
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_8)
+{
+    int32_t rc;
+    std::stringstream ss;
+    CBooking booking;
+    boost::property_tree::ptree pt;
+    std::set<uint32_t> set;
+    std::vector<uint32_t> unavalable_seats;
+    CBooker::booker_ptr booker = std::make_shared<CBooker>();
+    CBooker::booker_ptr booker2 = std::make_shared<CBooker>();
+    std::chrono::steady_clock::time_point now;
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [\"Tokyo\"]}]}";
+    BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, pt));
+    rc = booking.load_data(pt);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(booking.join_booker(booker), 1);
+    BOOST_CHECK_EQUAL(booking.join_booker(booker2), 2);
+
+    BOOST_TEST_CHECKPOINT("Hold seats");
+    now = std::chrono::steady_clock::now();
+    set = std::set<uint32_t>({1, 2, 3});
+    rc = booking.hold_seats(booker, "Matrix", "Tokyo", set, unavalable_seats, std::chrono::seconds(10));
+    BOOST_CHECK_EQUAL(rc, 3);
+    rc = booking.hold_seats(booker2, "Matrix", "Tokyo", set, unavalable_seats, std::chrono::seconds(10));
+    BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(unavalable_seats.size(), 3);
+    rc = booking.hold_seats(booker, "Matrix", "Tokyo", set, unavalable_seats, std::chrono::seconds(0));
+    BOOST_CHECK_EQUAL(rc, -EINVAL);
+
+    BOOST_TEST_CHECKPOINT("Confirm part of the hold");
+    set = std::set<uint32_t>({2, 5});
+    rc = booking.confirm_seats(booker, "Matrix", "Tokyo", set, unavalable_seats);
+    BOOST_CHECK_EQUAL(rc, 1);
+    BOOST_CHECK_EQUAL(unavalable_seats.size(), 1);
+    BOOST_CHECK_EQUAL(unavalable_seats[0], 5);
+    rc = booking.get_held_seats(booker, "Matrix", "Tokyo", set);
+    BOOST_CHECK_EQUAL(rc, 2);
+
+    BOOST_TEST_CHECKPOINT("Unbooked held seat doesn't expire later");
+    set = std::set<uint32_t>({3});
+    rc = booking.unbook_seats(booker, "Matrix", "Tokyo", set, unavalable_seats);
+    BOOST_CHECK_EQUAL(rc, 1);
+    rc = booking.book_seats(booker, "Matrix", "Tokyo", set, unavalable_seats, false);
+    BOOST_CHECK_EQUAL(rc, 3);
+
+    BOOST_TEST_CHECKPOINT("Nothing expires before ttl");
+    BOOST_CHECK_EQUAL(booking.expire_holds(now + std::chrono::seconds(9)), 0);
+
+    BOOST_TEST_CHECKPOINT("Not confirmed seats expire");
+    BOOST_CHECK_EQUAL(booking.expire_holds(now + std::chrono::seconds(11)), 1);
+    rc = booking.get_booked_seats(booker, "Matrix", "Tokyo", set);
+    BOOST_CHECK_EQUAL(rc, 2);
+    BOOST_CHECK(set == std::set<uint32_t>({2, 3}));
+    rc = booking.get_held_seats(booker, "Matrix", "Tokyo", set);
+    BOOST_CHECK_EQUAL(rc, 0);
+
+    set = std::set<uint32_t>({1});
+    rc = booking.book_seats(booker2, "Matrix", "Tokyo", set, unavalable_seats, false);
+    BOOST_CHECK_EQUAL(rc, 1);
+}
+
+/// @brief Best available contiguous seats
+/// @param  bookig_basic_test_case_9
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_9)
+{
+    int32_t rc;
+    std::stringstream ss;
+    CBooking booking;
+    boost::property_tree::ptree pt;
+    std::set<uint32_t> set;
+    std::vector<uint32_t> unavalable_seats;
+    CBooker::booker_ptr booker = std::make_shared<CBooker>();
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [{\"theatre\": \"Tokyo\", \"layout\": ["\
+        "{\"row\": \"A\", \"seats\": 10}, {\"row\": \"B\", \"seats\": 12}, {\"row\": \"C\", \"seats\": 8}]}]}]}";
+    BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, pt));
+    rc = booking.load_data(pt);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(booking.join_booker(booker), 1);
+
+    set = std::set<uint32_t>({2, 15});
+    rc = booking.book_seats(booker, "Matrix", "Tokyo", set, unavalable_seats, false);
+    BOOST_CHECK_EQUAL(rc, 2);
+
+    BOOST_TEST_CHECKPOINT("First run in the theatre");
+    rc = booking.book_best_seats(booker, "Matrix", "Tokyo", 3, "", set);
+    BOOST_CHECK_EQUAL(rc, 5);
+    BOOST_CHECK(set == std::set<uint32_t>({3, 4, 5}));
+
+    BOOST_TEST_CHECKPOINT("First run in the row");
+    rc = booking.book_best_seats(booker, "Matrix", "Tokyo", 5, "B", set);
+    BOOST_CHECK_EQUAL(rc, 10);
+    BOOST_CHECK(set == std::set<uint32_t>({10, 11, 12, 13, 14}));
+    rc = booking.book_best_seats(booker, "Matrix", "Tokyo", 6, "B", set);
+    BOOST_CHECK_EQUAL(rc, 16);
+    BOOST_CHECK(set == std::set<uint32_t>({16, 17, 18, 19, 20, 21}));
+
+    BOOST_TEST_CHECKPOINT("Run doesn't leave the row");
+    rc = booking.book_best_seats(booker, "Matrix", "Tokyo", 9, "C", set);
+    BOOST_CHECK_EQUAL(rc, -ENOSPC);
+    BOOST_CHECK(set.empty());
+    rc = booking.book_best_seats(booker, "Matrix", "Tokyo", 2, "D", set);
+    BOOST_CHECK_EQUAL(rc, -ENOENT);
+    rc = booking.book_best_seats(booker, "Matrix", "Tokyo", 0, "", set);
+    BOOST_CHECK_EQUAL(rc, -EINVAL);
+
+    BOOST_TEST_CHECKPOINT("Released seats are found again");
+    set = std::set<uint32_t>({2, 15});
+    rc = booking.unbook_seats(booker, "Matrix", "Tokyo", set, unavalable_seats);
+    BOOST_CHECK_EQUAL(rc, 2);
+    rc = booking.book_best_seats(booker, "Matrix", "Tokyo", 15, "", set);
+    BOOST_CHECK_EQUAL(rc, -ENOSPC);
+    rc = booking.book_best_seats(booker, "Matrix", "Tokyo", 6, "", set);
+    BOOST_CHECK_EQUAL(rc, 20);
+    BOOST_CHECK(set == std::set<uint32_t>({22, 23, 24, 25, 26, 27}));
+}
+
+/// @brief Batch booking over several shows
+/// @param  bookig_basic_test_case_10
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_10)
+{
+    int32_t rc;
+    std::stringstream ss;
+    CBooking booking;
+    boost::property_tree::ptree pt;
+    std::set<uint32_t> set;
+    std::vector<uint32_t> unavalable_seats;
+    std::vector<std::vector<uint32_t>> batch_unavalable;
+    std::vector<CBooking::show_request> requests;
+    CBooker::booker_ptr booker = std::make_shared<CBooker>();
+    CBooker::booker_ptr booker2 = std::make_shared<CBooker>();
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [\"Tokyo\", \"Delhi\"]},"\
+        "{\"movie\": \"Avatar\", \"theatres\": [\"Tokyo\"]}]}";
+    BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, pt));
+    rc = booking.load_data(pt);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(booking.join_booker(booker), 1);
+    BOOST_CHECK_EQUAL(booking.join_booker(booker2), 2);
+
+    set = std::set<uint32_t>({5});
+    rc = booking.book_seats(booker2, "Avatar", "Tokyo", set, unavalable_seats, false);
+    BOOST_CHECK_EQUAL(rc, 1);
+    set = std::set<uint32_t>({7});
+    rc = booking.book_seats(booker, "Matrix", "Delhi", set, unavalable_seats, false);
+    BOOST_CHECK_EQUAL(rc, 1);
+
+    BOOST_TEST_CHECKPOINT("Nothing is booked, if any show fails");
+    requests = {
+        {"Matrix", "Tokyo", {1, 2}},
+        {"Matrix", "Delhi", {7, 8}},
+        {"Avatar", "Tokyo", {4, 5}}};
+    rc = booking.book_batch(booker, requests, batch_unavalable);
+    BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(batch_unavalable.size(), 3);
+    BOOST_CHECK(batch_unavalable[0].empty());
+    BOOST_CHECK(batch_unavalable[1].empty());
+    BOOST_CHECK(batch_unavalable[2] == std::vector<uint32_t>({5}));
+    rc = booking.get_booked_seats(booker, "Matrix", "Tokyo", set);
+    BOOST_CHECK_EQUAL(rc, 0);
+    rc = booking.get_booked_seats(booker, "Matrix", "Delhi", set);
+    BOOST_CHECK(set == std::set<uint32_t>({7}));
+    rc = booking.get_free_seats("Avatar", "Tokyo", set);
+    BOOST_CHECK_EQUAL(set.count(4), 1);
+
+    BOOST_TEST_CHECKPOINT("Invalid batch");
+    requests = {{"Matrix", "Tokyo", {1}}, {"Avatar", "Delhi", {1}}};
+    BOOST_CHECK_EQUAL(booking.book_batch(booker, requests, batch_unavalable), -EEXIST);
+    requests = {{"Matrix", "Tokyo", {1}}, {"Avatar", "Tokyo", {booking.get_max_seats()}}};
+    BOOST_CHECK_EQUAL(booking.book_batch(booker, requests, batch_unavalable), -ERANGE);
+
+    BOOST_TEST_CHECKPOINT("All the shows are booked");
+    requests = {
+        {"Avatar", "Tokyo", {6}},
+        {"Matrix", "Tokyo", {1, 2}},
+        {"Matrix", "Tokyo", {3}}};
+    rc = booking.book_batch(booker, requests, batch_unavalable);
+    BOOST_CHECK_EQUAL(rc, 4);
+    rc = booking.get_booked_seats(booker, "Matrix", "Tokyo", set);
+    BOOST_CHECK(set == std::set<uint32_t>({1, 2, 3}));
+    rc = booking.get_booked_seats(booker, "Avatar", "Tokyo", set);
+    BOOST_CHECK(set == std::set<uint32_t>({6}));
+
+    BOOST_TEST_CHECKPOINT("Seat listed twice for the show is counted once");
+    requests = {
+        {"Matrix", "Tokyo", {8}},
+        {"Matrix", "Tokyo", {8, 9}}};
+    rc = booking.book_batch(booker, requests, batch_unavalable);
+    BOOST_CHECK_EQUAL(rc, 2);
+
+    BOOST_TEST_CHECKPOINT("Batches in opposite order do not deadlock");
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < 2; ++i) {
+        threads.emplace_back([&booking, i]() {
+            int32_t thread_rc;
+            std::set<uint32_t> seats({10, 11});
+            std::vector<uint32_t> invalid_seats;
+            std::vector<std::vector<uint32_t>> thread_unavalable;
+            std::vector<CBooking::show_request> thread_requests({{"Matrix", "Tokyo", seats}, {"Avatar", "Tokyo", seats}});
+            CBooker::booker_ptr thread_booker = std::make_shared<CBooker>();
+
+            booking.join_booker(thread_booker);
+            if (i != 0)
+                std::swap(thread_requests[0], thread_requests[1]);
+
+            for (uint32_t j = 0; j < 1000; ++j) {
+                thread_rc = booking.book_batch(thread_booker, thread_requests, thread_unavalable);
+                if (thread_rc > 0) {
+                    booking.unbook_seats(thread_booker, "Matrix", "Tokyo", seats, invalid_seats);
+                    booking.unbook_seats(thread_booker, "Avatar", "Tokyo", seats, invalid_seats);
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    rc = booking.get_free_seats("Matrix", "Tokyo", set);
+    BOOST_CHECK_EQUAL(set.count(10) + set.count(11), 2);
+}
+
+/// @brief Readers copy seats without theatre lock
+/// @param  bookig_basic_test_case_11
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_11)
+{
+    int32_t rc;
+    std::stringstream ss;
+    CBooking booking;
+    boost::property_tree::ptree pt;
+    std::atomic<bool> stop = false;
+    std::atomic<uint32_t> torn = 0;
+    std::atomic<uint32_t> reads = 0;
+    std::vector<std::thread> threads;
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [{\"theatre\": \"Tokyo\", \"seats\": 200}]}]}";
+    BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, pt));
+    rc = booking.load_data(pt);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+
+    BOOST_TEST_CHECKPOINT("Seats of single booking, spanning two words, are seen together");
+    for (uint32_t i = 0; i < 2; ++i) {
+        threads.emplace_back([&booking, &stop]() {
+            std::set<uint32_t> seats({63, 64});
+            std::vector<uint32_t> invalid_seats;
+            CBooker::booker_ptr booker = std::make_shared<CBooker>();
+
+            booking.join_booker(booker);
+            while (stop != true) {
+                if (booking.book_seats(booker, "Matrix", "Tokyo", seats, invalid_seats, false) > 0)
+                    booking.unbook_seats(booker, "Matrix", "Tokyo", seats, invalid_seats);
+            }
+        });
+    }
+    threads.emplace_back([&booking, &torn, &reads]() {
+        std::set<uint32_t> free_seats;
+        std::string status;
+
+        for (uint32_t i = 0; i < 2000; ++i) {
+            booking.get_free_seats("Matrix", "Tokyo", free_seats);
+            if (free_seats.count(63) != free_seats.count(64))
+                torn++;
+
+            status.clear();
+            booking.dump_status(status);
+            if ((status.find("63, 64") == std::string::npos)&&(status.find("#") != std::string::npos))
+                torn++;
+            reads++;
+        }
+    });
+
+    threads.back().join();
+    stop = true;
+    for (auto &thread : threads) {
+        if (thread.joinable())
+            thread.join();
+    }
+
+    BOOST_CHECK_EQUAL(reads, 2000);
+    BOOST_CHECK_EQUAL(torn, 0);
+}
+
+/// @brief Rendered responses follow seat changes
+/// @param  bookig_basic_test_case_12
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_12)
+{
+    int32_t rc;
+    std::stringstream ss;
+    CBooking booking;
+    boost::property_tree::ptree pt;
+    std::set<uint32_t> set;
+    std::vector<uint32_t> unavalable_seats;
+    CBooker::booker_ptr booker = std::make_shared<CBooker>();
+    CResponseCache::response_ptr first;
+    CResponseCache::response_ptr second;
+    uint32_t renders;
+    auto render = [&renders](std::string &response)
+    {
+        renders++;
+        response = std::to_string(renders);
+    };
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [{\"theatre\": \"Tokyo\", \"seats\": 20}, {\"theatre\": \"Paris\", \"seats\": 20}]}]}";
+    BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, pt));
+    rc = booking.load_data(pt);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    renders = 0;
+
+    BOOST_TEST_CHECKPOINT("Unchanged theatre is rendered once");
+    rc = booking.get_theatre_response("Matrix", "Tokyo", false, render, first);
+    BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+    rc = booking.get_theatre_response("Matrix", "Tokyo", false, render, second);
+    BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+    BOOST_CHECK(first == second);
+    rc = booking.get_theatre_response("Matrix", "Rome", false, render, second);
+    BOOST_CHECK_EQUAL(rc, -EEXIST);
+    BOOST_CHECK_EQUAL(renders, 1);
+
+    BOOST_TEST_CHECKPOINT("Booking renders only its theatre again");
+    rc = booking.get_theatre_response("Matrix", "Paris", false, render, second);
+    BOOST_CHECK_EQUAL(*second, "2");
+    BOOST_CHECK_EQUAL(booking.join_booker(booker), 1);
+    set = std::set<uint32_t>({2, 3});
+    rc = booking.book_seats(booker, "Matrix", "Tokyo", set, unavalable_seats, false);
+    BOOST_CHECK_EQUAL(rc, 2);
+    rc = booking.get_theatre_response("Matrix", "Tokyo", false, render, first);
+    BOOST_CHECK_EQUAL(*first, "3");
+    rc = booking.get_theatre_response("Matrix", "Paris", false, render, second);
+    BOOST_CHECK_EQUAL(*second, "2");
+
+    BOOST_TEST_CHECKPOINT("Status follows seats and bookers");
+    rc = booking.get_status_response(false, render, first);
+    BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(*first, "4");
+    rc = booking.get_status_response(false, render, second);
+    BOOST_CHECK(second == first);
+    booking.leave_booker(booker);
+    rc = booking.get_status_response(false, render, second);
+    BOOST_CHECK_EQUAL(*second, "5");
+
+    BOOST_TEST_CHECKPOINT("Failed rendering is reported as error and not cached");
+    booker = std::make_shared<CBooker>();
+    BOOST_CHECK_GE(booking.join_booker(booker), 1);
+    set = std::set<uint32_t>({4});
+    rc = booking.book_seats(booker, "Matrix", "Tokyo", set, unavalable_seats, false);
+    BOOST_CHECK_EQUAL(rc, 1);
+    rc = booking.get_theatre_response("Matrix", "Tokyo", false,
+        [](std::string &) {throw std::system_error(ENOENT, std::generic_category());}, first);
+    BOOST_CHECK_EQUAL(rc, -ENOENT);
+    rc = booking.get_status_response(false,
+        [](std::string &) {throw std::runtime_error("render failed");}, first);
+    BOOST_CHECK_EQUAL(rc, -EIO);
+    rc = booking.get_theatre_response("Matrix", "Tokyo", false, render, first);
+    BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(*first, "6");
+}
+
+/// @brief Bookings survive restart through the journal
+/// @param  bookig_basic_test_case_13
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_13)
+{
+    int32_t rc;
+    std::stringstream ss;
+    boost::property_tree::ptree pt;
+    std::set<uint32_t> set;
+    std::vector<uint32_t> unavalable_seats;
+    std::vector<std::vector<uint32_t>> batch_unavalable;
+    std::string path = (std::filesystem::temp_directory_path() / "bookig_basic_test_case_13.log").string();
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [{\"theatre\": \"Tokyo\", \"seats\": 20}, \"Paris\"]}]}";
+    BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, pt));
+    std::filesystem::remove(path);
+
+    {
+        CBooking booking;
+        CBooker::booker_ptr booker = std::make_shared<CBooker>();
+        CBooker::booker_ptr booker2 = std::make_shared<CBooker>();
+
+        rc = booking.load_data(pt);
+        BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+        rc = booking.open_journal(path, CJournal::durability_t::per_op);
+        BOOST_CHECK_EQUAL(rc, 0);
+        BOOST_CHECK_EQUAL(booking.join_booker(booker), 1);
+        BOOST_CHECK_EQUAL(booking.join_booker(booker2), 2);
+        booker->set_uid("alice");
+        booker2->set_uid("bob");
+
+        BOOST_TEST_CHECKPOINT("Booked, released, held and confirmed seats");
+        set = std::set<uint32_t>({1, 2, 3});
+        rc = booking.book_seats(booker, "Matrix", "Tokyo", set, unavalable_seats, false);
+        BOOST_CHECK_EQUAL(rc, 3);
+        set = std::set<uint32_t>({2});
+        rc = booking.unbook_seats(booker, "Matrix", "Tokyo", set, unavalable_seats);
+        BOOST_CHECK_EQUAL(rc, 1);
+        set = std::set<uint32_t>({2, 7});
+        rc = booking.book_seats(booker2, "Matrix", "Paris", set, unavalable_seats, false);
+        BOOST_CHECK_EQUAL(rc, 2);
+
+        /*failed batch is rolled back before it is journaled, booked batch is a record per theatre*/
+        rc = booking.book_batch(booker, {{"Matrix", "Tokyo", std::set<uint32_t>({4})}, {"Matrix", "Paris", std::set<uint32_t>({2})}}, batch_unavalable);
+        BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+        rc = booking.book_batch(booker, {{"Matrix", "Tokyo", std::set<uint32_t>({4})}, {"Matrix", "Paris", std::set<uint32_t>({4})}}, batch_unavalable);
+        BOOST_CHECK_EQUAL(rc, 2);
+
+        set = std::set<uint32_t>({10, 11});
+        rc = booking.hold_seats(booker2, "Matrix", "Tokyo", set, unavalable_seats, std::chrono::minutes(5));
+        BOOST_CHECK_EQUAL(rc, 2);
+        set = std::set<uint32_t>({10});
+        rc = booking.confirm_seats(booker2, "Matrix", "Tokyo", set, unavalable_seats);
+        BOOST_CHECK_EQUAL(rc, 1);
+        set = std::set<uint32_t>({15});
+        rc = booking.hold_seats(booker2, "Matrix", "Tokyo", set, unavalable_seats, std::chrono::milliseconds(1));
+        BOOST_CHECK_EQUAL(rc, 3);
+        booking.close_journal();
+    }
+
+    BOOST_TEST_CHECKPOINT("Restart replays the journal");
+    {
+        CBooking booking;
+        std::string status;
+
+        rc = booking.load_data(pt);
+        BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+        /*table of theatres of the run is a record too*/
+        rc = booking.open_journal(path, CJournal::durability_t::batched);
+        BOOST_CHECK_EQUAL(rc, 11);
+
+        booking.get_free_seats("Matrix", "Tokyo", set);
+        BOOST_CHECK_EQUAL(set.count(1) + set.count(2) + set.count(3), 1);
+        BOOST_CHECK_EQUAL(set.count(4), 0);
+        BOOST_CHECK_EQUAL(set.count(10) + set.count(11) + set.count(15), 0);
+        booking.get_free_seats("Matrix", "Paris", set);
+        BOOST_CHECK_EQUAL(set.count(2) + set.count(4) + set.count(7), 0);
+
+        /*bookers of the journal left as closed sessions*/
+        booking.dump_status(status);
+        BOOST_CHECK(status.find("#1") != std::string::npos);
+        BOOST_CHECK(status.find("#2") != std::string::npos);
+        BOOST_CHECK_EQUAL(booking.get_active_bookers(), 0);
+
+        /*hold over its ttl expires with the next tick, the others go on*/
+        booking.expire_holds(std::chrono::steady_clock::now() + 2 * CBooking::get_hold_tick());
+        booking.get_free_seats("Matrix", "Tokyo", set);
+        BOOST_CHECK_EQUAL(set.count(15), 1);
+        BOOST_CHECK_EQUAL(set.count(10) + set.count(11), 0);
+        booking.close_journal();
+    }
+
+    BOOST_TEST_CHECKPOINT("Expiry after restart is journaled too");
+    {
+        CBooking booking;
+        std::set<uint32_t> free_seats;
+
+        rc = booking.load_data(pt);
+        BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+        rc = booking.open_journal(path, CJournal::durability_t::none);
+        BOOST_CHECK_EQUAL(rc, 13);
+        booking.get_free_seats("Matrix", "Tokyo", free_seats);
+        BOOST_CHECK_EQUAL(free_seats.count(15), 1);
+    }
+
+    std::filesystem::remove(path);
+}
+
+/// @brief Seats are restored from seat store, journal continues behind them
+/// @param  bookig_basic_test_case_14
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_14)
+{
+    int32_t rc;
+    std::stringstream ss;
+    boost::property_tree::ptree pt;
+    std::set<uint32_t> set;
+    std::vector<uint32_t> unavalable_seats;
+    std::string store_path = (std::filesystem::temp_directory_path() / "bookig_basic_test_case_14.dat").string();
+    std::string journal_path = (std::filesystem::temp_directory_path() / "bookig_basic_test_case_14.log").string();
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [{\"theatre\": \"Tokyo\", \"seats\": 100}, \"Paris\"]}]}";
+    BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, pt));
+    std::filesystem::remove(store_path);
+    std::filesystem::remove(journal_path);
+
+    {
+        CBooking booking;
+        CBooker::booker_ptr booker = std::make_shared<CBooker>();
+
+        rc = booking.load_data(pt);
+        BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+        rc = booking.open_seat_store(store_path);
+        BOOST_CHECK_EQUAL(rc, 0);
+        rc = booking.open_journal(journal_path, CJournal::durability_t::batched);
+        BOOST_CHECK_EQUAL(rc, 0);
+        BOOST_CHECK_EQUAL(booking.join_booker(booker), 1);
+
+        BOOST_TEST_CHECKPOINT("Booked seats stay, held ones are released on close");
+        set = std::set<uint32_t>({1, 64, 99});
+        rc = booking.book_seats(booker, "Matrix", "Tokyo", set, unavalable_seats, false);
+        BOOST_CHECK_EQUAL(rc, 3);
+        set = std::set<uint32_t>({50});
+        rc = booking.hold_seats(booker, "Matrix", "Tokyo", set, unavalable_seats, std::chrono::minutes(5));
+        BOOST_CHECK_EQUAL(rc, 4);
+        rc = booking.close_seat_store();
+        BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+
+        /*seats are still served after the store is closed*/
+        booking.get_free_seats("Matrix", "Tokyo", set);
+        BOOST_CHECK_EQUAL(set.size(), 97);
+    }
+
+    BOOST_TEST_CHECKPOINT("Clean store is restored, no record is replayed");
+    {
+        CBooking booking;
+        CBooker::booker_ptr booker = std::make_shared<CBooker>();
+
+        rc = booking.load_data(pt);
+        BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+        rc = booking.open_seat_store(store_path);
+        BOOST_CHECK_EQUAL(rc, 1);
+        rc = booking.open_journal(journal_path, CJournal::durability_t::batched);
+        BOOST_CHECK_EQUAL(rc, 0);
+
+        booking.get_free_seats("Matrix", "Tokyo", set);
+        BOOST_CHECK_EQUAL(set.size(), 97);
+        BOOST_CHECK_EQUAL(set.count(1) + set.count(64) + set.count(99), 0);
+        BOOST_CHECK_EQUAL(set.count(50), 1);
+
+        /*handle of the previous run still marks seats, it is not given again*/
+        BOOST_CHECK_EQUAL(booking.join_booker(booker), 2);
+        set = std::set<uint32_t>({1});
+        rc = booking.unbook_seats(booker, "Matrix", "Tokyo", set, unavalable_seats);
+        BOOST_CHECK_EQUAL(rc, 1);
+        BOOST_CHECK(unavalable_seats == std::vector<uint32_t>({1}));
+        set = std::set<uint32_t>({2});
+        rc = booking.book_seats(booker, "Matrix", "Paris", set, unavalable_seats, false);
+        BOOST_CHECK_EQUAL(rc, 1);
+        /*not closed, as if the process crashed*/
+        booking.close_journal();
+    }
+
+    BOOST_TEST_CHECKPOINT("Dirty store is rebuilt from the whole journal");
+    {
+        CBooking booking;
+
+        rc = booking.load_data(pt);
+        BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+        rc = booking.open_seat_store(store_path);
+        BOOST_CHECK_EQUAL(rc, 0);
+        rc = booking.open_journal(journal_path, CJournal::durability_t::batched);
+        BOOST_CHECK_EQUAL(rc, 7);
+
+        booking.get_free_seats("Matrix", "Tokyo", set);
+        BOOST_CHECK_EQUAL(set.size(), 97);
+        booking.get_free_seats("Matrix", "Paris", set);
+        BOOST_CHECK_EQUAL(set.count(2), 0);
+        rc = booking.close_seat_store();
+        BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+    }
+
+    std::filesystem::remove(store_path);
+    std::filesystem::remove(journal_path);
+}
+
+
+/// @brief Snapshot is taken while batches are booked, it is restored into new booking
+/// @param  bookig_basic_test_case_15
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_15)
+{
+    int32_t rc;
+    std::stringstream ss;
+    CBooking booking;
+    boost::property_tree::ptree pt;
+    boost::property_tree::ptree other_pt;
+    std::set<uint32_t> tokyo_seats;
+    std::set<uint32_t> delhi_seats;
+    std::vector<uint32_t> unavalable_seats;
+    std::atomic<bool> done = false;
+    std::string path = (std::filesystem::temp_directory_path() / "bookig_basic_test_case_15.snap").string();
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [{\"theatre\": \"Tokyo\", \"seats\": 200}, {\"theatre\": \"Delhi\", \"seats\": 200}]}]}";
+    BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, pt));
+    rc = booking.load_data(pt);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    std::filesystem::remove(path);
+
+    BOOST_TEST_CHECKPOINT("Snapshot never cuts through a batch");
+    std::thread writer([&booking, &done]() {
+        std::vector<std::vector<uint32_t>> batch_unavalable;
+        CBooker::booker_ptr booker = std::make_shared<CBooker>();
+
+        booking.join_booker(booker);
+        for (uint32_t seat = 0; seat < 200; ++seat) {
+            std::vector<CBooking::show_request> requests = {
+                {"Matrix", "Tokyo", {seat}},
+                {"Matrix", "Delhi", {seat}}};
+            booking.book_batch(booker, requests, batch_unavalable);
+        }
+        done = true;
+    });
+
+    for (bool last = false; last != true; ) {
+        CBooking restored;
+
+        last = done;
+        rc = booking.save_snapshot(path);
+        if (rc == -EBUSY)
+            continue;
+        BOOST_CHECK_GT(rc, 0);
+
+        rc = restored.load_data(pt);
+        BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+        rc = restored.load_snapshot(path);
+        BOOST_CHECK_EQUAL(rc, 2);
+        restored.get_free_seats("Matrix", "Tokyo", tokyo_seats);
+        restored.get_free_seats("Matrix", "Delhi", delhi_seats);
+        BOOST_CHECK(tokyo_seats == delhi_seats);
+    }
+    writer.join();
+
+    BOOST_TEST_CHECKPOINT("Restored seats keep their owner");
+    {
+        CBooking restored;
+        CBooker::booker_ptr booker = std::make_shared<CBooker>();
+
+        rc = restored.load_data(pt);
+        BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+        rc = restored.load_snapshot(path);
+        BOOST_CHECK_EQUAL(rc, 2);
+        restored.get_free_seats("Matrix", "Tokyo", tokyo_seats);
+        BOOST_CHECK(tokyo_seats.empty());
+
+        /*handle of the previous run still marks seats, it is not given again*/
+        BOOST_CHECK_EQUAL(restored.join_booker(booker), 2);
+        tokyo_seats = std::set<uint32_t>({5});
+        rc = restored.unbook_seats(booker, "Matrix", "Tokyo", tokyo_seats, unavalable_seats);
+        BOOST_CHECK_EQUAL(rc, 1);
+        BOOST_CHECK(unavalable_seats == std::vector<uint32_t>({5}));
+    }
+
+    BOOST_TEST_CHECKPOINT("Only theatres, which fit the catalog, are restored");
+    {
+        CBooking restored;
+
+        ss.str("");
+        ss.clear();
+        ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [{\"theatre\": \"Tokyo\", \"seats\": 201}, {\"theatre\": \"Delhi\", \"seats\": 200}]}]}";
+        BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, other_pt));
+        rc = restored.load_data(other_pt);
+        BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+        rc = restored.load_snapshot(path);
+        BOOST_CHECK_EQUAL(rc, 1);
+        restored.get_free_seats("Matrix", "Tokyo", tokyo_seats);
+        BOOST_CHECK_EQUAL(tokyo_seats.size(), 201);
+        restored.get_free_seats("Matrix", "Delhi", delhi_seats);
+        BOOST_CHECK(delhi_seats.empty());
+    }
+
+    BOOST_TEST_CHECKPOINT("Snapshot of other catalog is refused");
+    {
+        CBooking restored;
+
+        ss.str("");
+        ss.clear();
+        ss << "{\"movies\": [{\"movie\": \"Avatar\", \"theatres\": [{\"theatre\": \"Tokyo\", \"seats\": 200}]}]}";
+        other_pt.clear();
+        BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, other_pt));
+        rc = restored.load_data(other_pt);
+        BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+        rc = restored.load_snapshot(path);
+        BOOST_CHECK_EQUAL(rc, -ESTALE);
+    }
+
+    std::filesystem::remove(path);
+}
+
+
+/// @brief Shows are addressed by stable handles
+/// @param  bookig_basic_test_case_16
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_16)
+{
+    int32_t rc;
+    int32_t show;
+    std::stringstream ss;
+    CBooking booking;
+    boost::property_tree::ptree pt;
+    std::set<uint32_t> set;
+    std::vector<uint32_t> unavalable_seats;
+    CBooker::booker_ptr booker = std::make_shared<CBooker>();
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [\"Tokyo\", {\"theatre\": \"Delhi\", \"seats\": 40}]},"\
+        "{\"movie\": \"Avatar\", \"theatres\": [\"Tokyo\"]}]}";
+    BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, pt));
+    rc = booking.load_data(pt);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(booking.join_booker(booker), 1);
+
+    BOOST_TEST_CHECKPOINT("Every show has its own handle");
+    BOOST_CHECK_EQUAL(booking.get_shows(), 3);
+    BOOST_CHECK_EQUAL(booking.find_show("Matrix", "Tokyo"), 0);
+    BOOST_CHECK_EQUAL(booking.find_show("Avatar", "Tokyo"), 2);
+    BOOST_CHECK_EQUAL(booking.find_show("Avatar", "Delhi"), -EEXIST);
+    show = booking.find_show("Matrix", "Delhi");
+    BOOST_CHECK_EQUAL(show, 1);
+    BOOST_CHECK_EQUAL(booking.get_capacity(static_cast<uint32_t>(show)), 40);
+
+    BOOST_TEST_CHECKPOINT("Handle and names address the same seats");
+    set = std::set<uint32_t>({3, 4});
+    rc = booking.book_seats(booker, static_cast<uint32_t>(show), set, unavalable_seats);
+    BOOST_CHECK_EQUAL(rc, 2);
+    booking.get_booked_seats(booker, "Matrix", "Delhi", set);
+    BOOST_CHECK(set == std::set<uint32_t>({3, 4}));
+    booking.get_free_seats(static_cast<uint32_t>(show), set);
+    BOOST_CHECK_EQUAL(set.size(), 38);
+
+    set = std::set<uint32_t>({4, 5});
+    rc = booking.unbook_seats(booker, static_cast<uint32_t>(show), set, unavalable_seats);
+    BOOST_CHECK_EQUAL(rc, 1);
+    BOOST_CHECK(unavalable_seats == std::vector<uint32_t>({5}));
+    booking.get_booked_seats(booker, static_cast<uint32_t>(show), set);
+    BOOST_CHECK(set == std::set<uint32_t>({3}));
+
+    BOOST_TEST_CHECKPOINT("Unknown handle is refused");
+    BOOST_CHECK_EQUAL(booking.book_seats(booker, 3, set, unavalable_seats), -EEXIST);
+    BOOST_CHECK_EQUAL(booking.unbook_seats(booker, 3, set, unavalable_seats), -EEXIST);
+    BOOST_CHECK_EQUAL(booking.get_free_seats(3, set), -EEXIST);
+    BOOST_CHECK_EQUAL(booking.get_capacity(3), -EEXIST);
+}
+
+
+/// @brief Catalog is reloaded while bookings keep on running
+/// @param  bookig_basic_test_case_17
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_17)
+{
+    int32_t rc;
+    std::stringstream ss;
+    CBooking booking;
+    boost::property_tree::ptree pt;
+    boost::property_tree::ptree reload_pt;
+    boost::property_tree::ptree rome_pt;
+    std::set<uint32_t> set;
+    std::vector<uint32_t> unavalable_seats;
+    CBooking::catalog_ptr old_catalog;
+    std::atomic<bool> done = false;
+    std::atomic<uint32_t> failed = 0;
+    CBooker::booker_ptr booker = std::make_shared<CBooker>();
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [\"Tokyo\", {\"theatre\": \"Delhi\", \"seats\": 40}]},"\
+        "{\"movie\": \"Avatar\", \"theatres\": [\"Tokyo\"]}]}";
+    BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, pt));
+    rc = booking.load_data(pt);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(booking.get_catalog_version(), 1);
+    BOOST_CHECK_EQUAL(booking.join_booker(booker), 1);
+
+    set = std::set<uint32_t>({1, 2});
+    BOOST_CHECK_EQUAL(booking.book_seats(booker, "Matrix", "Tokyo", set, unavalable_seats), 2);
+    set = std::set<uint32_t>({3});
+    BOOST_CHECK_EQUAL(booking.book_seats(booker, "Matrix", "Delhi", set, unavalable_seats), 1);
+    set = std::set<uint32_t>({5});
+    BOOST_CHECK_EQUAL(booking.hold_seats(booker, "Avatar", "Tokyo", set, unavalable_seats, std::chrono::milliseconds(1000)), 1);
+
+    BOOST_TEST_CHECKPOINT("Unchanged theatre keeps its seats and handle");
+    old_catalog = booking.get_configuration();
+    ss.str("");
+    ss.clear();
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [\"Tokyo\", {\"theatre\": \"Delhi\", \"seats\": 50}, \"Rome\"]}]}";
+    BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, reload_pt));
+    rc = booking.load_data(reload_pt);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(booking.get_catalog_version(), 2);
+    BOOST_CHECK_EQUAL(booking.find_show("Matrix", "Tokyo"), 0);
+    booking.get_booked_seats(booker, 0, set);
+    BOOST_CHECK(set == std::set<uint32_t>({1, 2}));
+
+    BOOST_TEST_CHECKPOINT("Changed theatre is built again, removed theatre is gone");
+    BOOST_CHECK_EQUAL(booking.find_show("Matrix", "Delhi"), 3);
+    BOOST_CHECK_EQUAL(booking.find_show("Matrix", "Rome"), 4);
+    BOOST_CHECK_EQUAL(booking.get_shows(), 5);
+    booking.get_free_seats("Matrix", "Delhi", set);
+    BOOST_CHECK_EQUAL(set.size(), 50);
+    BOOST_CHECK_EQUAL(booking.find_show("Avatar", "Tokyo"), -EEXIST);
+    BOOST_CHECK_EQUAL(booking.get_capacity(1), -EEXIST);
+    BOOST_CHECK_EQUAL(booking.get_capacity(2), -EEXIST);
+    BOOST_CHECK_EQUAL(booker->get_seats_count(), 2);
+    BOOST_CHECK_EQUAL(booking.expire_holds(std::chrono::steady_clock::now() + std::chrono::seconds(10)), 0);
+
+    BOOST_TEST_CHECKPOINT("Old catalog lives as long as somebody holds it");
+    BOOST_CHECK(old_catalog->movies_map_.find("Avatar") != old_catalog->movies_map_.end());
+    BOOST_CHECK(booking.get_configuration()->movies_map_.find("Avatar") == booking.get_configuration()->movies_map_.end());
+    old_catalog.reset();
+
+    BOOST_TEST_CHECKPOINT("Invalid catalog keeps the current one");
+    BOOST_CHECK_EQUAL(booking.load_data(boost::property_tree::ptree()), -EBADMSG);
+    BOOST_CHECK_EQUAL(booking.get_catalog_version(), 2);
+    BOOST_CHECK_EQUAL(booking.find_show("Matrix", "Rome"), 4);
+
+    BOOST_TEST_CHECKPOINT("Bookings keep on running during reloads");
+    ss.str("");
+    ss.clear();
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [\"Tokyo\"]}]}";
+    BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, rome_pt));
+    std::thread writer([&booking, &done, &failed]() {
+        std::set<uint32_t> seats({10});
+        std::vector<uint32_t> invalid_seats;
+        CBooker::booker_ptr booker = std::make_shared<CBooker>();
+
+        booking.join_booker(booker);
+        while (done != true) {
+            if (booking.book_seats(booker, "Matrix", "Tokyo", seats, invalid_seats) != 1)
+                failed++;
+            if (booking.unbook_seats(booker, 0, seats, invalid_seats) != 1)
+                failed++;
+        }
+    });
+    for (uint32_t i = 0; i < 100; ++i) {
+        rc = booking.load_data(((i % 2) == 0) ? rome_pt : reload_pt);
+        BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    }
+    done = true;
+    writer.join();
+    BOOST_CHECK_EQUAL(failed, 0);
+    booking.get_booked_seats(booker, "Matrix", "Tokyo", set);
+    BOOST_CHECK(set == std::set<uint32_t>({1, 2}));
+
+    BOOST_TEST_CHECKPOINT("Journal addresses theatres of the first catalog");
+    BOOST_CHECK_EQUAL(booking.open_journal("reloaded.journal", CJournal::durability_t::none), -EBUSY);
+}
+
+/// @brief Streaming loader builds the same catalog as configuration tree, shards are loaded in parallel
+/// @param  bookig_basic_test_case_18
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_18)
+{
+    int32_t rc;
+    std::stringstream ss;
+    std::string document;
+    std::string status;
+    std::string streamed_status;
+    std::vector<CBooking::seat_row> layout;
+    std::set<uint32_t> set;
+    std::vector<uint32_t> unavalable_seats;
+    CBooking tree_booking;
+    CBooking booking;
+    boost::property_tree::ptree pt;
+    CBooker::booker_ptr booker = std::make_shared<CBooker>();
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "bookig_basic_test_case_18";
+
+    document = "{\"version\": {\"skipped\": [1, 2]}, \"movies\": ["\
+        "{\"movie\": \"Matrix\", \"rating\": 8.7, \"theatres\": [\"Tokyo\", {\"theatre\": \"Delhi\", \"seats\": \"40\"},"\
+        "{\"theatre\": \"Rome\", \"layout\": [{\"section\": \"Stalls\", \"row\": \"A\", \"seats\": 10}, {\"seats\": 12}]}]},"\
+        "{\"theatres\": [\"Tokyo\"], \"movie\": \"Avatar\"}]}";
+
+    BOOST_TEST_CHECKPOINT("Streamed catalog equals catalog of configuration tree");
+    ss << document;
+    BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, pt));
+    rc = tree_booking.load_data(pt);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    ss.str(document);
+    ss.clear();
+    rc = booking.load_data(ss);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    tree_booking.dump_status(status);
+    booking.dump_status(streamed_status);
+    BOOST_CHECK_EQUAL(status, streamed_status);
+    BOOST_CHECK_EQUAL(booking.get_shows(), 4);
+    BOOST_CHECK_EQUAL(booking.get_capacity("Matrix", "Delhi"), 40);
+    BOOST_CHECK_EQUAL(booking.get_layout("Matrix", "Rome", layout), 2);
+    BOOST_REQUIRE_EQUAL(layout.size(), 2);
+    BOOST_CHECK_EQUAL(layout[1].row_, "2");
+    BOOST_CHECK_EQUAL(layout[1].first_seat_, 10);
+
+    BOOST_TEST_CHECKPOINT("Malformed document keeps the catalog");
+    for (const std::string &bad : {
+            std::string("{\"movies\": [{\"movie\": \"Matrix\"}]}"),
+            std::string("{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [{\"seats\": 10}]}]}"),
+            std::string("{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [{\"theatre\": \"Tokyo\", \"seats\": 11, \"layout\": [{\"seats\": 10}]}]}]}"),
+            std::string("{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [{\"theatre\": \"Tokyo\", \"seats\": -1}]}]}"),
+            std::string("{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [\"Tokyo\"]}]"),
+            std::string("{\"cinemas\": []}")}) {
+        ss.str(bad);
+        ss.clear();
+        BOOST_CHECK_EQUAL(booking.load_data(ss), -EBADMSG);
+    }
+    BOOST_CHECK_EQUAL(booking.get_catalog_version(), 1);
+
+    BOOST_TEST_CHECKPOINT("Shards are merged in the order of names, whatever number of threads");
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir / "2.json") << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [\"Paris\"]}, {\"movie\": \"Dune\", \"theatres\": [\"Oslo\"]}]}";
+    std::ofstream(dir / "1.json") << document;
+    std::ofstream(dir / "notes.txt") << "not a shard";
+
+    for (uint32_t threads : {0u, 1u, 2u, 8u}) {
+        CBooking sharded;
+
+        rc = sharded.load_files(dir.string(), threads);
+        BOOST_CHECK_EQUAL(rc, 2);
+        BOOST_CHECK_EQUAL(sharded.get_shows(), 6);
+        BOOST_CHECK_EQUAL(sharded.find_show("Matrix", "Rome"), 2);
+        BOOST_CHECK_EQUAL(sharded.find_show("Matrix", "Paris"), 4);
+        BOOST_CHECK_EQUAL(sharded.find_show("Dune", "Oslo"), 5);
+    }
+
+    BOOST_TEST_CHECKPOINT("Reload from shards keeps seats of unchanged theatres");
+    BOOST_CHECK_EQUAL(booking.join_booker(booker), 1);
+    set = std::set<uint32_t>({1, 2});
+    BOOST_CHECK_EQUAL(booking.book_seats(booker, "Matrix", "Delhi", set, unavalable_seats), 2);
+    rc = booking.load_files(dir.string(), 2);
+    BOOST_CHECK_EQUAL(rc, 2);
+    BOOST_CHECK_EQUAL(booking.get_catalog_version(), 2);
+    BOOST_CHECK_EQUAL(booking.get_booked_seats(booker, "Matrix", "Delhi", set), 2);
+
+    BOOST_TEST_CHECKPOINT("Show listed in two shards is refused");
+    std::ofstream(dir / "3.json") << "{\"movies\": [{\"movie\": \"Dune\", \"theatres\": [\"Oslo\"]}]}";
+    BOOST_CHECK_EQUAL(booking.load_files(dir.string(), 2), -EEXIST);
+    std::filesystem::remove(dir / "3.json");
+
+    BOOST_TEST_CHECKPOINT("Malformed shard or missing catalog keeps the catalog");
+    std::ofstream(dir / "0.json") << "{\"movies\": [";
+    BOOST_CHECK_EQUAL(booking.load_files(dir.string(), 2), -EBADMSG);
+    BOOST_CHECK_EQUAL(booking.load_files((dir / "missing.json").string(), 2), -ENOENT);
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    BOOST_CHECK_EQUAL(booking.load_files(dir.string(), 2), -ENOENT);
+    BOOST_CHECK_EQUAL(booking.get_catalog_version(), 2);
+
+    std::filesystem::remove_all(dir);
+}
+
+/// @brief Compiled catalog image is loaded with the same shows and handles
+/// @param  bookig_basic_test_case_19
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_19)
+{
+    int32_t rc;
+    std::stringstream ss;
+    std::string status;
+    std::string image_status;
+    std::set<uint32_t> set;
+    std::vector<uint32_t> unavalable_seats;
+    std::vector<CBooking::seat_row> layout;
+    CBooking booking;
+    CBooking restored;
+    CBooking reloaded;
+    CBooking::catalog_ptr configuration;
+    std::vector<std::pair<std::string, uint32_t>> shows;
+    CBooker::booker_ptr booker = std::make_shared<CBooker>();
+    std::string path = (std::filesystem::temp_directory_path() / "bookig_basic_test_case_19.img").string();
+    std::string damaged_path = path + ".damaged";
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [\"Tokyo\", {\"theatre\": \"Arena\", \"layout\": "\
+        "[{\"section\": \"North\", \"row\": \"A\", \"seats\": 10}, {\"seats\": 12}]}]}, {\"movie\": \"Avatar\", \"theatres\": [\"Tokyo\"]}]}";
+    rc = booking.load_data(ss);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+
+    BOOST_TEST_CHECKPOINT("Image is loaded into empty booking");
+    std::filesystem::remove(path);
+    BOOST_CHECK_GT(booking.save_image(path), 0);
+    rc = restored.load_image(path);
+    BOOST_CHECK_EQUAL(rc, 3);
+    booking.dump_status(status);
+    restored.dump_status(image_status);
+    BOOST_CHECK_EQUAL(status, image_status);
+    BOOST_CHECK_EQUAL(restored.find_show("Matrix", "Arena"), 1);
+    BOOST_CHECK_EQUAL(restored.find_show("Avatar", "Tokyo"), 2);
+    BOOST_CHECK_EQUAL(restored.get_layout("Matrix", "Arena", layout), 2);
+    BOOST_CHECK_EQUAL(layout[1].row_, "2");
+    BOOST_CHECK_EQUAL(layout[1].first_seat_, 10);
+
+    BOOST_TEST_CHECKPOINT("Names and hash tables are used in the mapped image");
+    configuration = restored.get_configuration();
+    BOOST_CHECK(configuration->image_ != nullptr);
+    BOOST_CHECK_EQUAL(configuration->names_.size(), 0);
+    BOOST_CHECK(configuration->theatre_shows_.empty());
+    BOOST_CHECK_EQUAL(configuration->theatres_index_.find("Tokyo")->second.size(), 2);
+    BOOST_CHECK(configuration->movies_map_.find("Dune") == configuration->movies_map_.end());
+    BOOST_CHECK_EQUAL(restored.get_theatre_shows("Tokyo", shows), 2);
+    BOOST_CHECK_EQUAL(shows[1].first, "Avatar");
+    BOOST_CHECK_EQUAL(shows[1].second, 2);
+    configuration.reset();
+
+    BOOST_TEST_CHECKPOINT("Image reloaded over other catalog gets ids of the booking");
+    ss.str("{\"movies\": [{\"movie\": \"Dune\", \"theatres\": [\"Rome\"]}]}");
+    ss.clear();
+    BOOST_CHECK_GE(reloaded.load_data(ss), EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(reloaded.load_image(path), 3);
+    BOOST_CHECK_EQUAL(reloaded.find_show("Dune", "Rome"), -EEXIST);
+    BOOST_CHECK_EQUAL(reloaded.find_show("Matrix", "Arena"), 2);
+    BOOST_CHECK_EQUAL(reloaded.get_theatre_shows("Tokyo", shows), 2);
+    BOOST_CHECK_EQUAL(shows[0].second, 1);
+    BOOST_CHECK_EQUAL(shows[1].second, 3);
+    BOOST_CHECK_EQUAL(reloaded.get_capacity("Avatar", "Tokyo"), 20);
+
+    BOOST_TEST_CHECKPOINT("Image reload keeps seats");
+    BOOST_CHECK_EQUAL(restored.join_booker(booker), 1);
+    set = std::set<uint32_t>({4, 5});
+    BOOST_CHECK_EQUAL(restored.book_seats(booker, 1, set, unavalable_seats), 2);
+    rc = restored.load_image(path);
+    BOOST_CHECK_EQUAL(rc, 3);
+    BOOST_CHECK_EQUAL(restored.get_catalog_version(), 2);
+    BOOST_CHECK_EQUAL(restored.get_booked_seats(booker, 1, set), 2);
+
+    BOOST_TEST_CHECKPOINT("Catalog with handles out of order can't be compiled");
+    ss.str("{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [\"Rome\", \"Tokyo\"]}]}");
+    ss.clear();
+    rc = booking.load_data(ss);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(booking.save_image(path), -EINVAL);
+
+    BOOST_TEST_CHECKPOINT("Damaged image keeps the catalog");
+    /*mapped image is never changed in place, damaged one is a copy*/
+    std::filesystem::copy_file(path, damaged_path, std::filesystem::copy_options::overwrite_existing);
+    std::filesystem::resize_file(damaged_path, std::filesystem::file_size(damaged_path) / 2);
+    BOOST_CHECK_EQUAL(restored.load_image(damaged_path), -EBADMSG);
+    BOOST_CHECK_EQUAL(restored.get_catalog_version(), 2);
+    BOOST_CHECK_EQUAL(restored.find_show("Avatar", "Tokyo"), 2);
+
+    std::filesystem::remove(damaged_path);
+    std::filesystem::remove(path);
+}
+
+/// @brief Shows share all free seats until they are changed for the first time
+/// @param  bookig_basic_test_case_20
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_20)
+{
+    int32_t rc;
+    std::stringstream ss;
+    std::set<uint32_t> set;
+    std::vector<uint32_t> unavalable_seats;
+    std::vector<std::thread> threads;
+    std::atomic<uint32_t> booked = 0;
+    CBooking booking;
+    CBooker::booker_ptr booker = std::make_shared<CBooker>();
+    std::string path = (std::filesystem::temp_directory_path() / "bookig_basic_test_case_20.snap").string();
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [\"Tokyo\", \"Delhi\", \"Rome\", {\"theatre\": \"Arena\", \"seats\": 64}]}]}";
+    booking.set_engine(CBooking::engine_t::lock_free);
+    rc = booking.load_data(ss);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(booking.join_booker(booker), 1);
+
+    BOOST_TEST_CHECKPOINT("Nothing is allocated for untouched shows");
+    BOOST_CHECK_EQUAL(booking.get_active_shows(), 0);
+    BOOST_CHECK_EQUAL(booking.get_free_seats("Matrix", "Tokyo", set), EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(set.size(), 20);
+    BOOST_CHECK_EQUAL(booking.get_capacity("Matrix", "Arena"), 64);
+    set = std::set<uint32_t>({1});
+    BOOST_CHECK_EQUAL(booking.unbook_seats(booker, "Matrix", "Delhi", set, unavalable_seats), 1);
+    BOOST_CHECK_EQUAL(booking.get_active_shows(), 0);
+
+    BOOST_TEST_CHECKPOINT("Concurrent first bookings agree on the same seats");
+    for (uint32_t i = 0; i < 8; ++i) {
+        threads.emplace_back([&booking, &booked, i]() {
+            std::set<uint32_t> seats({i * 2, i * 2 + 1});
+            std::vector<uint32_t> unavalable;
+            CBooker::booker_ptr thread_booker = std::make_shared<CBooker>();
+
+            booking.join_booker(thread_booker);
+            if (booking.book_seats(thread_booker, "Matrix", "Tokyo", seats, unavalable) == 2)
+                booked += 2;
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    BOOST_CHECK_EQUAL(booked, 16);
+    BOOST_CHECK_EQUAL(booking.get_free_seats("Matrix", "Tokyo", set), EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(set.size(), 4);
+    BOOST_CHECK_EQUAL(booking.get_active_shows(), 1);
+
+    BOOST_TEST_CHECKPOINT("Shows of the same capacity are not changed with it");
+    BOOST_CHECK_EQUAL(booking.get_free_seats("Matrix", "Delhi", set), EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(set.size(), 20);
+    set = std::set<uint32_t>({5, 6});
+    BOOST_CHECK_EQUAL(booking.book_best_seats(booker, "Matrix", "Delhi", 3, "", set), 3);
+    BOOST_CHECK(set == std::set<uint32_t>({0, 1, 2}));
+    BOOST_CHECK_EQUAL(booking.get_active_shows(), 2);
+    BOOST_CHECK_EQUAL(booking.get_free_seats("Matrix", "Rome", set), EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(set.size(), 20);
+
+    BOOST_TEST_CHECKPOINT("Snapshot restores only shows, which were changed");
+    std::filesystem::remove(path);
+    BOOST_CHECK_GT(booking.save_snapshot(path), 0);
+    {
+        CBooking restored;
+
+        ss.str("{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [\"Tokyo\", \"Delhi\", \"Rome\", {\"theatre\": \"Arena\", \"seats\": 64}]}]}");
+        ss.clear();
+        rc = restored.load_data(ss);
+        BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+        BOOST_CHECK_EQUAL(restored.load_snapshot(path), 4);
+        BOOST_CHECK_EQUAL(restored.get_active_shows(), 2);
+        BOOST_CHECK_EQUAL(restored.get_free_seats("Matrix", "Tokyo", set), EXIT_SUCCESS);
+        BOOST_CHECK_EQUAL(set.size(), 4);
+        BOOST_CHECK_EQUAL(restored.get_free_seats("Matrix", "Arena", set), EXIT_SUCCESS);
+        BOOST_CHECK_EQUAL(set.size(), 64);
+    }
+    std::filesystem::remove(path);
+}
+
+/// @brief Names are stored once per catalog, theatre index lists shows of the theatre
+/// @param  bookig_basic_test_case_21
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_21)
+{
+    int32_t rc;
+    std::stringstream ss;
+    CBooking booking;
+    CBooking::catalog_ptr configuration;
+    std::vector<std::pair<std::string, uint32_t>> shows;
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [\"Tokyo\", \"Delhi\"]}, {\"movie\": \"Avatar\", \"theatres\": [\"Delhi\", \"Rome\"]}, {\"movie\": \"Dune\", \"theatres\": [\"Delhi\"]}]}";
+    rc = booking.load_data(ss);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+
+    BOOST_TEST_CHECKPOINT("Theatre played by several movies is stored once");
+    configuration = booking.get_configuration();
+    BOOST_CHECK_EQUAL(configuration->names_.size(), 6);
+    auto matrix = configuration->movies_map_.find("Matrix");
+    auto avatar = configuration->movies_map_.find("Avatar");
+    BOOST_REQUIRE(matrix != configuration->movies_map_.end());
+    BOOST_REQUIRE(avatar != configuration->movies_map_.end());
+    BOOST_CHECK(matrix->second->theatre_reservations_map_.find("Delhi")->first.data() ==
+        avatar->second->theatre_reservations_map_.find("Delhi")->first.data());
+
+    BOOST_TEST_CHECKPOINT("Shows of the theatre");
+    BOOST_CHECK_EQUAL(booking.get_theatre_shows("Delhi", shows), 3);
+    BOOST_REQUIRE_EQUAL(shows.size(), 3);
+    BOOST_CHECK_EQUAL(shows[0].first, "Matrix");
+    BOOST_CHECK_EQUAL(shows[0].second, booking.find_show("Matrix", "Delhi"));
+    BOOST_CHECK_EQUAL(shows[1].first, "Avatar");
+    BOOST_CHECK_EQUAL(shows[2].first, "Dune");
+    BOOST_CHECK_EQUAL(shows[2].second, booking.find_show("Dune", "Delhi"));
+    BOOST_CHECK_EQUAL(booking.get_theatre_shows("Rome", shows), 1);
+    BOOST_CHECK_EQUAL(booking.get_theatre_shows("Paris", shows), -EEXIST);
+    BOOST_CHECK(shows.empty());
+
+    BOOST_TEST_CHECKPOINT("Reload rebuilds the index, old catalog keeps its names");
+    ss.str("{\"movies\": [{\"movie\": \"Avatar\", \"theatres\": [\"Delhi\", \"Paris\"]}, {\"movie\": \"Dune\", \"theatres\": [\"Rome\"]}]}");
+    ss.clear();
+    rc = booking.load_data(ss);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(booking.get_theatre_shows("Delhi", shows), 1);
+    BOOST_REQUIRE_EQUAL(shows.size(), 1);
+    BOOST_CHECK_EQUAL(shows[0].first, "Avatar");
+    BOOST_CHECK_EQUAL(booking.get_theatre_shows("Rome", shows), 1);
+    BOOST_CHECK_EQUAL(shows[0].first, "Dune");
+    BOOST_CHECK_EQUAL(booking.get_theatre_shows("Tokyo", shows), -EEXIST);
+    BOOST_CHECK_EQUAL(matrix->first, "Matrix");
+    BOOST_CHECK_EQUAL(configuration->theatres_index_.find("Tokyo")->second.size(), 1);
+}
+
+/// @brief Availability follows every change of seats, without reading seats
+/// @param  bookig_basic_test_case_22
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_22)
+{
+    int32_t rc;
+    std::stringstream ss;
+    std::set<uint32_t> set;
+    std::vector<uint32_t> unavalable_seats;
+    std::vector<CBooking::show_availability> shows;
+    CBooking booking;
+    CBooker::booker_ptr booker = std::make_shared<CBooker>();
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [\"Tokyo\", {\"theatre\": \"Arena\", \"seats\": 30}]}, {\"movie\": \"Avatar\", \"theatres\": [{\"theatre\": \"Rome\", \"seats\": 10}]}]}";
+    booking.set_engine(CBooking::engine_t::lock_free);
+    rc = booking.load_data(ss);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(booking.join_booker(booker), 1);
+
+    BOOST_TEST_CHECKPOINT("Untouched shows have all the seats free");
+    BOOST_CHECK_EQUAL(booking.get_available(20, shows), 2);
+    BOOST_REQUIRE_EQUAL(shows.size(), 2);
+    BOOST_CHECK_EQUAL(shows[0].theatre_, "Tokyo");
+    BOOST_CHECK_EQUAL(shows[0].free_, 20);
+    BOOST_CHECK_EQUAL(shows[1].theatre_, "Arena");
+    BOOST_CHECK_EQUAL(shows[1].free_, 30);
+    BOOST_CHECK_EQUAL(booking.get_top(1, shows), 1);
+    BOOST_CHECK_EQUAL(shows[0].show_, booking.find_show("Matrix", "Arena"));
+
+    BOOST_TEST_CHECKPOINT("Booking and unbooking change the counts");
+    set = std::set<uint32_t>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14});
+    BOOST_CHECK_EQUAL(booking.book_seats(booker, "Matrix", "Arena", set, unavalable_seats), 15);
+    BOOST_CHECK_EQUAL(booking.get_available(20, shows), 1);
+    BOOST_CHECK_EQUAL(shows[0].theatre_, "Tokyo");
+    BOOST_CHECK_EQUAL(booking.get_available("Matrix", 15, shows), 2);
+    BOOST_CHECK_EQUAL(shows[1].free_, 15);
+    BOOST_CHECK_EQUAL(booking.get_top(3, shows), 3);
+    BOOST_CHECK_EQUAL(shows[0].theatre_, "Tokyo");
+    BOOST_CHECK_EQUAL(shows[1].theatre_, "Arena");
+    BOOST_CHECK_EQUAL(shows[2].theatre_, "Rome");
+    set = std::set<uint32_t>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+    BOOST_CHECK_EQUAL(booking.book_seats(booker, "Avatar", "Rome", set, unavalable_seats), 10);
+    BOOST_CHECK_EQUAL(booking.get_available("Avatar", 1, shows), 0);
+    BOOST_CHECK_EQUAL(booking.get_top(3, shows), 2);
+    set = std::set<uint32_t>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14});
+    BOOST_CHECK_EQUAL(booking.unbook_seats(booker, "Matrix", "Arena", set, unavalable_seats), 15);
+    BOOST_CHECK_EQUAL(booking.get_top(1, shows), 1);
+    BOOST_CHECK_EQUAL(shows[0].free_, 30);
+    BOOST_CHECK_EQUAL(booking.get_available("Dune", 1, shows), -EEXIST);
+
+    BOOST_TEST_CHECKPOINT("Reload keeps counts of unchanged shows, removed shows are gone");
+    ss.str("{\"movies\": [{\"movie\": \"Avatar\", \"theatres\": [{\"theatre\": \"Rome\", \"seats\": 10}, \"Paris\"]}]}");
+    ss.clear();
+    rc = booking.load_data(ss);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(booking.get_available(1, shows), 1);
+    BOOST_CHECK_EQUAL(shows[0].theatre_, "Paris");
+    BOOST_CHECK_EQUAL(booking.get_available("Avatar", 1, shows), 1);
+    BOOST_CHECK_EQUAL(booking.get_top(10, shows), 1);
+}
+
+/// @brief Seats are booked in any theatre of the movie, which has them
+/// @param  bookig_basic_test_case_23
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_23)
+{
+    int32_t rc;
+    std::stringstream ss;
+    std::set<uint32_t> set;
+    std::vector<uint32_t> unavalable_seats;
+    std::vector<std::thread> threads;
+    std::atomic<uint32_t> booked = 0;
+    std::vector<CBooking::show_availability> shows;
+    CBooking booking;
+    CBooker::booker_ptr booker = std::make_shared<CBooker>();
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [{\"theatre\": \"Small\", \"seats\": 4}, {\"theatre\": \"Tokyo\", \"seats\": 10}, {\"theatre\": \"Delhi\", \"seats\": 10}]}]}";
+    booking.set_engine(CBooking::engine_t::lock_free);
+    rc = booking.load_data(ss);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(booking.join_booker(booker), 1);
+
+    BOOST_TEST_CHECKPOINT("The first theatre, which fits, is booked");
+    BOOST_CHECK_EQUAL(booking.book_any_seats(booker, "Matrix", 5, set), booking.find_show("Matrix", "Tokyo"));
+    BOOST_CHECK(set == std::set<uint32_t>({0, 1, 2, 3, 4}));
+    BOOST_CHECK_EQUAL(booking.book_any_seats(booker, "Matrix", 3, set), booking.find_show("Matrix", "Small"));
+
+    BOOST_TEST_CHECKPOINT("Scattered seats are skipped");
+    set = std::set<uint32_t>({5, 7, 9});
+    BOOST_CHECK_EQUAL(booking.book_seats(booker, "Matrix", "Tokyo", set, unavalable_seats), 8);
+    BOOST_CHECK_EQUAL(booking.book_any_seats(booker, "Matrix", 2, set), booking.find_show("Matrix", "Delhi"));
+    BOOST_CHECK(set == std::set<uint32_t>({0, 1}));
+
+    BOOST_TEST_CHECKPOINT("Errors");
+    BOOST_CHECK_EQUAL(booking.book_any_seats(booker, "Matrix", 9, set), -ENOSPC);
+    BOOST_CHECK(set.empty());
+    BOOST_CHECK_EQUAL(booking.book_any_seats(booker, "Matrix", 0, set), -EINVAL);
+    BOOST_CHECK_EQUAL(booking.book_any_seats(booker, "Dune", 1, set), -EEXIST);
+
+    BOOST_TEST_CHECKPOINT("Concurrent requests never share a seat");
+    for (uint32_t i = 0; i < 8; ++i) {
+        threads.emplace_back([&booking, &booked]() {
+            std::set<uint32_t> seats;
+            CBooker::booker_ptr thread_booker = std::make_shared<CBooker>();
+
+            booking.join_booker(thread_booker);
+            while (booking.book_any_seats(thread_booker, "Matrix", 1, seats) >= EXIT_SUCCESS) {
+                booked++;
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    /*1 seat left in Small, 2 in Tokyo, 8 in Delhi*/
+    BOOST_CHECK_EQUAL(booked, 11);
+    BOOST_CHECK_EQUAL(booking.get_top(3, shows), 0);
+}
+
+
+/// @brief Exchange releases and books seats at once, or changes nothing
+/// @param  bookig_basic_test_case_24
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_24)
+{
+    int32_t rc;
+    std::stringstream ss;
+    std::set<uint32_t> set;
+    std::vector<uint32_t> unavalable_seats;
+    std::vector<uint32_t> invalid_seats;
+    std::atomic<uint32_t> stolen = 0;
+    CBooking booking;
+    CBooker::booker_ptr booker = std::make_shared<CBooker>();
+    CBooker::booker_ptr other = std::make_shared<CBooker>();
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [{\"theatre\": \"Tokyo\", \"seats\": 10}]}]}";
+    booking.set_engine(CBooking::engine_t::lock_free);
+    rc = booking.load_data(ss);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(booking.join_booker(booker), 1);
+    BOOST_CHECK_EQUAL(booking.join_booker(other), 2);
+    set = std::set<uint32_t>({0, 1, 2});
+    BOOST_CHECK_EQUAL(booking.book_seats(booker, "Matrix", "Tokyo", set, unavalable_seats), 3);
+    set = std::set<uint32_t>({5});
+    BOOST_CHECK_EQUAL(booking.book_seats(other, "Matrix", "Tokyo", set, unavalable_seats), 1);
+
+    BOOST_TEST_CHECKPOINT("Seat taken by others leaves everything as it was");
+    rc = booking.exchange_seats(booker, "Matrix", "Tokyo", std::set<uint32_t>({0, 1}), std::set<uint32_t>({5, 6}), unavalable_seats, invalid_seats);
+    BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+    BOOST_CHECK(unavalable_seats == std::vector<uint32_t>({5}));
+    BOOST_CHECK(invalid_seats.empty());
+    BOOST_CHECK_GE(booking.get_booked_seats(booker, "Matrix", "Tokyo", set), EXIT_SUCCESS);
+    BOOST_CHECK(set == std::set<uint32_t>({0, 1, 2}));
+    BOOST_CHECK_GE(booking.get_free_seats("Matrix", "Tokyo", set), EXIT_SUCCESS);
+    BOOST_CHECK(set == std::set<uint32_t>({3, 4, 6, 7, 8, 9}));
+
+    BOOST_TEST_CHECKPOINT("Seat not ours leaves everything as it was");
+    rc = booking.exchange_seats(booker, "Matrix", "Tokyo", std::set<uint32_t>({0, 5}), std::set<uint32_t>({6}), unavalable_seats, invalid_seats);
+    BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+    BOOST_CHECK(invalid_seats == std::vector<uint32_t>({5}));
+    BOOST_CHECK(unavalable_seats.empty());
+    BOOST_CHECK_GE(booking.get_free_seats("Matrix", "Tokyo", set), EXIT_SUCCESS);
+    BOOST_CHECK(set == std::set<uint32_t>({3, 4, 6, 7, 8, 9}));
+
+    BOOST_TEST_CHECKPOINT("Seats are exchanged, seat in both lists stays ours");
+    rc = booking.exchange_seats(booker, "Matrix", "Tokyo", std::set<uint32_t>({0, 1}), std::set<uint32_t>({1, 6, 7}), unavalable_seats, invalid_seats);
+    BOOST_CHECK_EQUAL(rc, 4);
+    BOOST_CHECK_GE(booking.get_booked_seats(booker, "Matrix", "Tokyo", set), EXIT_SUCCESS);
+    BOOST_CHECK(set == std::set<uint32_t>({1, 2, 6, 7}));
+    set = std::set<uint32_t>({0});
+    BOOST_CHECK_EQUAL(booking.book_seats(other, "Matrix", "Tokyo", set, unavalable_seats), 2);
+
+    BOOST_TEST_CHECKPOINT("Errors");
+    rc = booking.exchange_seats(booker, "Matrix", "Tokyo", std::set<uint32_t>({1}), std::set<uint32_t>({10}), unavalable_seats, invalid_seats);
+    BOOST_CHECK_EQUAL(rc, -ERANGE);
+    rc = booking.exchange_seats(booker, "Matrix", "Delhi", std::set<uint32_t>({1}), std::set<uint32_t>({3}), unavalable_seats, invalid_seats);
+    BOOST_CHECK_EQUAL(rc, -EEXIST);
+
+    BOOST_TEST_CHECKPOINT("Exchanged seat is never free in between");
+    set = std::set<uint32_t>({8});
+    BOOST_CHECK_EQUAL(booking.book_seats(booker, "Matrix", "Tokyo", set, unavalable_seats), 5);
+    std::thread mover([&booking, booker]() {
+        std::vector<uint32_t> unavalable;
+        std::vector<uint32_t> invalid;
+
+        for (uint32_t i = 0; i < 1000; ++i) {
+            booking.exchange_seats(booker, "Matrix", "Tokyo", std::set<uint32_t>({8}), std::set<uint32_t>({9}), unavalable, invalid);
+            booking.exchange_seats(booker, "Matrix", "Tokyo", std::set<uint32_t>({9}), std::set<uint32_t>({8}), unavalable, invalid);
+        }
+    });
+    std::thread thief([&booking, other, &stolen]() {
+        std::vector<uint32_t> unavalable;
+
+        for (uint32_t i = 0; i < 1000; ++i) {
+            /*both seats are free only if exchange released the old one before it booked the new one*/
+            booking.book_seats(other, "Matrix", "Tokyo", std::set<uint32_t>({8, 9}), unavalable);
+            if (unavalable.empty())
+                stolen++;
+        }
+    });
+    mover.join();
+    thief.join();
+    BOOST_CHECK_EQUAL(stolen, 0);
+    BOOST_CHECK_GE(booking.get_booked_seats(booker, "Matrix", "Tokyo", set), EXIT_SUCCESS);
+    BOOST_CHECK(set == std::set<uint32_t>({1, 2, 6, 7, 8}));
+}
+
+
+/// @brief Success of contended lock free booking means the seats are ours
+/// @param  bookig_basic_test_case_25
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_25)
+{
+    int32_t rc;
+    std::stringstream ss;
+    std::set<uint32_t> set;
+    std::vector<uint32_t> unavalable_seats;
+    std::vector<std::thread> threads;
+    std::atomic<bool> done = false;
+    uint32_t lost = 0;
+    CBooking booking;
+    CBooker::booker_ptr booker = std::make_shared<CBooker>();
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [{\"theatre\": \"Tokyo\", \"seats\": 128}]}]}";
+    booking.set_engine(CBooking::engine_t::lock_free);
+    rc = booking.load_data(ss);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(booking.join_booker(booker), 1);
+
+    /*seat 64 is taken and released all the time, while seats 63 and 64 spanning two words are booked*/
+    for (uint32_t i = 0; i < 3; ++i) {
+        threads.emplace_back([&booking, &done]() {
+            std::vector<uint32_t> unavalable;
+            std::vector<uint32_t> invalid;
+            CBooker::booker_ptr thread_booker = std::make_shared<CBooker>();
+
+            booking.join_booker(thread_booker);
+            while (done.load() != true) {
+                if ((booking.book_seats(thread_booker, "Matrix", "Tokyo", std::set<uint32_t>({64}), unavalable) > 0)&&(unavalable.empty())) {
+                    booking.unbook_seats(thread_booker, "Matrix", "Tokyo", std::set<uint32_t>({64}), invalid);
+                }
+            }
+        });
+    }
+
+    for (uint32_t i = 0; i < 20000; ++i) {
+        rc = booking.book_seats(booker, "Matrix", "Tokyo", std::set<uint32_t>({63, 64}), unavalable_seats);
+        if ((rc <= EXIT_SUCCESS)||(unavalable_seats.empty() != true))
+            continue;
+
+        booking.get_booked_seats(booker, "Matrix", "Tokyo", set);
+        if (set != std::set<uint32_t>({63, 64}))
+            lost++;
+        booking.unbook_seats(booker, "Matrix", "Tokyo", std::set<uint32_t>({63, 64}), unavalable_seats);
+    }
+    done = true;
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    BOOST_CHECK_EQUAL(lost, 0);
+}
+
+
+/// @brief Contended lock free exchange keeps either the old seats or the new ones
+/// @param  bookig_basic_test_case_26
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_26)
+{
+    int32_t rc;
+    std::stringstream ss;
+    std::set<uint32_t> set;
+    std::vector<uint32_t> unavalable_seats;
+    std::vector<uint32_t> invalid_seats;
+    std::vector<std::thread> threads;
+    std::atomic<bool> done = false;
+    uint32_t lost = 0;
+    CBooking booking;
+    CBooker::booker_ptr booker = std::make_shared<CBooker>();
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [{\"theatre\": \"Tokyo\", \"seats\": 128}]}]}";
+    booking.set_engine(CBooking::engine_t::lock_free);
+    rc = booking.load_data(ss);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(booking.join_booker(booker), 1);
+    BOOST_CHECK_EQUAL(booking.book_seats(booker, "Matrix", "Tokyo", std::set<uint32_t>({1}), unavalable_seats), 1);
+
+    /*seat 64 is taken and released all the time by lock free bookings*/
+    for (uint32_t i = 0; i < 3; ++i) {
+        threads.emplace_back([&booking, &done]() {
+            std::vector<uint32_t> unavalable;
+            std::vector<uint32_t> invalid;
+            CBooker::booker_ptr thread_booker = std::make_shared<CBooker>();
+
+            booking.join_booker(thread_booker);
+            while (done.load() != true) {
+                if ((booking.book_seats(thread_booker, "Matrix", "Tokyo", std::set<uint32_t>({64}), unavalable) > 0)&&(unavalable.empty())) {
+                    booking.unbook_seats(thread_booker, "Matrix", "Tokyo", std::set<uint32_t>({64}), invalid);
+                }
+            }
+        });
+    }
+
+    for (uint32_t i = 0; i < 20000; ++i) {
+        rc = booking.exchange_seats(booker, "Matrix", "Tokyo", std::set<uint32_t>({1}), std::set<uint32_t>({2, 64}), unavalable_seats, invalid_seats);
+        booking.get_booked_seats(booker, "Matrix", "Tokyo", set);
+        if ((rc > EXIT_SUCCESS)&&(set == std::set<uint32_t>({2, 64}))) {
+            /*seat 1 is free again, only this booker uses it*/
+            rc = booking.exchange_seats(booker, "Matrix", "Tokyo", std::set<uint32_t>({2, 64}), std::set<uint32_t>({1}), unavalable_seats, invalid_seats);
+            booking.get_booked_seats(booker, "Matrix", "Tokyo", set);
+        }
+        if (set != std::set<uint32_t>({1})) {
+            lost++;
+            break;
+        }
+    }
+    done = true;
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    BOOST_CHECK_EQUAL(lost, 0);
+}
+
+
+/// @brief Booking in per_op durability fails, when its journal record can't be written
+/// @param  bookig_basic_test_case_27
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_27)
+{
+    int32_t rc;
+    int full_fd;
+    int journal_fd;
+    std::stringstream ss;
+    std::set<uint32_t> set;
+    std::vector<uint32_t> unavalable_seats;
+    std::vector<uint32_t> invalid_seats;
+    std::vector<std::vector<uint32_t>> batch_unavalable;
+    std::string path = (std::filesystem::temp_directory_path() / "bookig_basic_test_case_27.log").string();
+    CBooking booking;
+    CBooker::booker_ptr booker = std::make_shared<CBooker>();
+
+    std::filesystem::remove(path);
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [{\"theatre\": \"Tokyo\", \"seats\": 20}]}]}";
+    rc = booking.load_data(ss);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(booking.open_journal(path, CJournal::durability_t::per_op), EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(booking.join_booker(booker), 1);
+    set = std::set<uint32_t>({1, 2});
+    BOOST_CHECK_EQUAL(booking.book_seats(booker, "Matrix", "Tokyo", set, unavalable_seats), 2);
+
+    BOOST_TEST_CHECKPOINT("Journal file is replaced by full device");
+    journal_fd = -1;
+    for (const auto &entry : std::filesystem::directory_iterator("/proc/self/fd")) {
+        std::error_code ec;
+        if (std::filesystem::read_symlink(entry.path(), ec) == std::filesystem::path(path))
+            journal_fd = std::stoi(entry.path().filename().string());
+    }
+    BOOST_REQUIRE_GE(journal_fd, 0);
+    full_fd = ::open("/dev/full", O_WRONLY | O_CLOEXEC);
+    BOOST_REQUIRE_GE(full_fd, 0);
+    BOOST_REQUIRE_EQUAL(::dup2(full_fd, journal_fd), journal_fd);
+    ::close(full_fd);
+
+    BOOST_TEST_CHECKPOINT("Changes are not reported as done");
+    set = std::set<uint32_t>({3});
+    BOOST_CHECK_EQUAL(booking.book_seats(booker, "Matrix", "Tokyo", set, unavalable_seats), -EIO);
+    BOOST_CHECK_LT(booking.get_journal().get_error(), EXIT_SUCCESS);
+    set = std::set<uint32_t>({1});
+    BOOST_CHECK_EQUAL(booking.unbook_seats(booker, "Matrix", "Tokyo", set, invalid_seats), -EIO);
+    set = std::set<uint32_t>({4});
+    BOOST_CHECK_EQUAL(booking.hold_seats(booker, "Matrix", "Tokyo", set, unavalable_seats, std::chrono::minutes(5)), -EIO);
+    BOOST_CHECK_EQUAL(booking.confirm_seats(booker, "Matrix", "Tokyo", set, invalid_seats), -EIO);
+    BOOST_CHECK_EQUAL(booking.book_batch(booker, {{"Matrix", "Tokyo", std::set<uint32_t>({5})}}, batch_unavalable), -EIO);
+    rc = booking.exchange_seats(booker, "Matrix", "Tokyo", std::set<uint32_t>({2}), std::set<uint32_t>({6}), unavalable_seats, invalid_seats);
+    BOOST_CHECK_EQUAL(rc, -EIO);
+
+    BOOST_TEST_CHECKPOINT("Failures of the request itself are reported as before");
+    BOOST_CHECK_EQUAL(booking.book_seats(booker, "Matrix", "Delhi", set, unavalable_seats), -EEXIST);
+
+    booking.close_journal();
+    std::filesystem::remove(path);
+}
+
+
+/// @brief Batch in lock free engine is all or nothing, single word bookings wait for its commit
+/// @param  bookig_basic_test_case_28
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_28)
+{
+    int32_t rc;
+    std::stringstream ss;
+    std::set<uint32_t> tokyo;
+    std::set<uint32_t> delhi;
+    std::vector<std::thread> threads;
+    std::vector<std::vector<uint32_t>> batch_unavalable;
+    std::vector<uint32_t> invalid_seats;
+    std::atomic<bool> done = false;
+    uint32_t broken = 0;
+    CBooking booking;
+    CBooker::booker_ptr booker = std::make_shared<CBooker>();
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [{\"theatre\": \"Tokyo\", \"seats\": 128}, {\"theatre\": \"Delhi\", \"seats\": 20}]}]}";
+    booking.set_engine(CBooking::engine_t::lock_free);
+    rc = booking.load_data(ss);
+    BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(booking.join_booker(booker), 1);
+
+    /*seat 64 is taken and released all the time by lock free bookings*/
+    for (uint32_t i = 0; i < 3; ++i) {
+        threads.emplace_back([&booking, &done]() {
+            std::vector<uint32_t> unavalable;
+            std::vector<uint32_t> invalid;
+            CBooker::booker_ptr thread_booker = std::make_shared<CBooker>();
+
+            booking.join_booker(thread_booker);
+            while (done.load() != true) {
+                if ((booking.book_seats(thread_booker, "Matrix", "Tokyo", std::set<uint32_t>({64}), unavalable) > 0)&&(unavalable.empty())) {
+                    booking.unbook_seats(thread_booker, "Matrix", "Tokyo", std::set<uint32_t>({64}), invalid);
+                }
+            }
+        });
+    }
+
+    for (uint32_t i = 0; i < 20000; ++i) {
+        rc = booking.book_batch(booker, {{"Matrix", "Tokyo", std::set<uint32_t>({63, 64})}, {"Matrix", "Delhi", std::set<uint32_t>({1})}}, batch_unavalable);
+        booking.get_booked_seats(booker, "Matrix", "Tokyo", tokyo);
+        booking.get_booked_seats(booker, "Matrix", "Delhi", delhi);
+        if (rc == 3) {
+            if ((tokyo != std::set<uint32_t>({63, 64}))||(delhi != std::set<uint32_t>({1})))
+                broken++;
+            booking.unbook_seats(booker, "Matrix", "Tokyo", tokyo, invalid_seats);
+            booking.unbook_seats(booker, "Matrix", "Delhi", delhi, invalid_seats);
+        }
+        else if ((rc != EXIT_SUCCESS)||(tokyo.empty() != true)||(delhi.empty() != true)||
+            (batch_unavalable[0] != std::vector<uint32_t>({64}))||(batch_unavalable[1].empty() != true)) {
+            broken++;
+        }
+        if (broken != 0)
+            break;
+    }
+    done = true;
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    BOOST_CHECK_EQUAL(broken, 0);
+}
+
+
+/// @brief Catalog is reloaded with journal and seat store open, restart finds seats by names
+/// @param  bookig_basic_test_case_29
+BOOST_AUTO_TEST_CASE(bookig_basic_test_case_29)
+{
+    int32_t rc;
+    std::stringstream ss;
+    boost::property_tree::ptree pt;
+    boost::property_tree::ptree reload_pt;
+    boost::property_tree::ptree restart_pt;
+    std::set<uint32_t> set;
+    std::vector<uint32_t> unavalable_seats;
+    std::string store_path = (std::filesystem::temp_directory_path() / "bookig_basic_test_case_29.dat").string();
+    std::string journal_path = (std::filesystem::temp_directory_path() / "bookig_basic_test_case_29.log").string();
+
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [\"Tokyo\", {\"theatre\": \"Delhi\", \"seats\": 40}, \"Paris\"]},"\
+        "{\"movie\": \"Avatar\", \"theatres\": [\"Tokyo\"]}]}";
+    BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, pt));
+    ss.str("");
+    ss.clear();
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [\"Tokyo\", {\"theatre\": \"Delhi\", \"seats\": 50}, \"Rome\"]}]}";
+    BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, reload_pt));
+    ss.str("");
+    ss.clear();
+    ss << "{\"movies\": [{\"movie\": \"Matrix\", \"theatres\": [\"Rome\", \"Paris\", {\"theatre\": \"Delhi\", \"seats\": 50}, \"Tokyo\"]}]}";
+    BOOST_CHECK_NO_THROW(boost::property_tree::read_json(ss, restart_pt));
+    std::filesystem::remove(store_path);
+    std::filesystem::remove(journal_path);
+
+    {
+        CBooking booking;
+        CBooker::booker_ptr booker = std::make_shared<CBooker>();
+
+        rc = booking.load_data(pt);
+        BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+        rc = booking.open_seat_store(store_path);
+        BOOST_CHECK_EQUAL(rc, 0);
+        rc = booking.open_journal(journal_path, CJournal::durability_t::batched);
+        BOOST_CHECK_EQUAL(rc, 0);
+        BOOST_CHECK_EQUAL(booking.join_booker(booker), 1);
+        booker->set_uid("alice");
+
+        set = std::set<uint32_t>({1, 2});
+        BOOST_CHECK_EQUAL(booking.book_seats(booker, "Matrix", "Tokyo", set, unavalable_seats), 2);
+        set = std::set<uint32_t>({4});
+        BOOST_CHECK_EQUAL(booking.book_seats(booker, "Matrix", "Delhi", set, unavalable_seats), 1);
+        set = std::set<uint32_t>({7});
+        BOOST_CHECK_EQUAL(booking.book_seats(booker, "Matrix", "Paris", set, unavalable_seats), 1);
+        set = std::set<uint32_t>({3});
+        BOOST_CHECK_EQUAL(booking.book_seats(booker, "Avatar", "Tokyo", set, unavalable_seats), 1);
+
+        BOOST_TEST_CHECKPOINT("Reload moves seats to the store laid out by new ids");
+        std::atomic<bool> done = false;
+        std::atomic<uint32_t> failed = 0;
+        std::thread writer([&booking, &done, &failed]() {
+            std::set<uint32_t> seats({10});
+            std::vector<uint32_t> invalid_seats;
+            CBooker::booker_ptr booker = std::make_shared<CBooker>();
+
+            booking.join_booker(booker);
+            while (done != true) {
+                if (booking.book_seats(booker, "Matrix", "Tokyo", seats, invalid_seats) != 1)
+                    failed++;
+                if (booking.unbook_seats(booker, "Matrix", "Tokyo", seats, invalid_seats) != 1)
+                    failed++;
+            }
+        });
+        for (uint32_t i = 0; i < 20; ++i) {
+            rc = booking.load_data(((i % 2) == 0) ? pt : reload_pt);
+            BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+        }
+        done = true;
+        writer.join();
+        BOOST_CHECK_EQUAL(failed, 0);
+        booking.get_booked_seats(booker, "Matrix", "Tokyo", set);
+        BOOST_CHECK(set == std::set<uint32_t>({1, 2}));
+        set = std::set<uint32_t>({5});
+        BOOST_CHECK_EQUAL(booking.book_seats(booker, "Matrix", "Rome", set, unavalable_seats), 1);
+        set = std::set<uint32_t>({6});
+        BOOST_CHECK_EQUAL(booking.book_seats(booker, "Matrix", "Delhi", set, unavalable_seats), 1);
+        BOOST_CHECK_EQUAL(booker->get_seats_count(), 4);
+        rc = booking.close_seat_store();
+        BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+
+        /*every reload replaced the file of the same path*/
+        BOOST_CHECK(std::filesystem::exists(store_path));
+        BOOST_CHECK(std::filesystem::exists(store_path + ".new") != true);
+    }
+
+    BOOST_TEST_CHECKPOINT("Restart with other ids replays the journal by names");
+    {
+        CBooking booking;
+
+        rc = booking.load_data(restart_pt);
+        BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+        rc = booking.open_seat_store(store_path);
+        BOOST_CHECK_EQUAL(rc, 0);
+        rc = booking.open_journal(journal_path, CJournal::durability_t::batched);
+        BOOST_CHECK_GT(rc, 0);
+
+        booking.get_free_seats("Matrix", "Tokyo", set);
+        BOOST_CHECK_EQUAL(set.size(), 18);
+        BOOST_CHECK_EQUAL(set.count(1) + set.count(2), 0);
+        booking.get_free_seats("Matrix", "Rome", set);
+        BOOST_CHECK_EQUAL(set.size(), 19);
+        BOOST_CHECK_EQUAL(set.count(5), 0);
+        /*seat of the old Delhi went away with it*/
+        booking.get_free_seats("Matrix", "Delhi", set);
+        BOOST_CHECK_EQUAL(set.size(), 49);
+        BOOST_CHECK_EQUAL(set.count(6), 0);
+        /*Paris was removed by the reload, its seats were freed*/
+        booking.get_free_seats("Matrix", "Paris", set);
+        BOOST_CHECK_EQUAL(set.size(), 20);
+        rc = booking.close_seat_store();
+        BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+    }
+
+    BOOST_TEST_CHECKPOINT("Clean store of the same catalog is restored");
+    {
+        CBooking booking;
+
+        rc = booking.load_data(restart_pt);
+        BOOST_CHECK_GE(rc, EXIT_SUCCESS);
+        rc = booking.open_seat_store(store_path);
+        BOOST_CHECK_EQUAL(rc, 1);
+        rc = booking.open_journal(journal_path, CJournal::durability_t::batched);
+        BOOST_CHECK_EQUAL(rc, 0);
+
+        booking.get_free_seats("Matrix", "Tokyo", set);
+        BOOST_CHECK_EQUAL(set.size(), 18);
+        booking.get_free_seats("Matrix", "Delhi", set);
+        BOOST_CHECK_EQUAL(set.size(), 49);
+        booking.get_free_seats("Matrix", "Paris", set);
+        BOOST_CHECK_EQUAL(set.size(), 20);
+        rc = booking.close_seat_store();
+        BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+    }
+
+    std::filesystem::remove(store_path);
+    std::filesystem::remove(journal_path);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
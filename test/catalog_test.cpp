@@ -0,0 +1,107 @@
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+#include <string_view>
+
+#include "catalog.h"
+
+
+/*
+    https://live.boost.org/doc/libs/1_87_0/libs/test/doc/html/boost_test/utf_reference.html
+*/
+
+
+BOOST_AUTO_TEST_SUITE(catalog_suite)
+
+/// @brief Entries are found by string view, names are unique, order of insertion is kept
+/// @param  catalog_test_case_1
+BOOST_AUTO_TEST_CASE(catalog_test_case_1)
+{
+    uint32_t i;
+    CCatalog<uint32_t> catalog;
+    std::string buffer = "movie/Tokyo";
+
+    BOOST_TEST_CHECKPOINT("Empty catalog");
+    BOOST_CHECK(catalog.empty());
+    BOOST_CHECK(catalog.find("Tokyo") == catalog.end());
+
+    BOOST_TEST_CHECKPOINT("Names are unique");
+    BOOST_CHECK(catalog.insert("Tokyo", 1).second == true);
+    BOOST_CHECK(catalog.insert("Delhi", 2).second == true);
+    auto rc = catalog.insert("Tokyo", 3);
+    BOOST_CHECK(rc.second == false);
+    BOOST_CHECK_EQUAL(rc.first->second, 1);
+    BOOST_CHECK_EQUAL(catalog.size(), 2);
+
+    BOOST_TEST_CHECKPOINT("Part of another string is looked up without copy");
+    auto it = catalog.find(std::string_view(buffer).substr(6));
+    BOOST_CHECK(it != catalog.end());
+    BOOST_CHECK_EQUAL(it->second, 1);
+    BOOST_CHECK(catalog.find(std::string_view(buffer).substr(6, 3)) == catalog.end());
+
+    BOOST_TEST_CHECKPOINT("Table grows, entries stay in the order of insertion");
+    for (i = 0; i < 1000; ++i) {
+        BOOST_CHECK(catalog.insert("Theatre" + std::to_string(i), i + 10).second == true);
+    }
+    BOOST_CHECK_EQUAL(catalog.size(), 1002);
+    for (i = 0; i < 1000; ++i) {
+        it = catalog.find("Theatre" + std::to_string(i));
+        if ((it == catalog.end())||(it->second != i + 10))
+            break;
+    }
+    BOOST_CHECK_EQUAL(i, 1000);
+
+    i = 0;
+    for (const auto &entry : catalog) {
+        if (i == 1)
+            BOOST_CHECK_EQUAL(entry.first, "Delhi");
+        if (i == 1001)
+            BOOST_CHECK_EQUAL(entry.first, "Theatre999");
+        i++;
+    }
+}
+
+/// @brief Keys are views of names kept outside the catalog
+/// @param  catalog_test_case_2
+BOOST_AUTO_TEST_CASE(catalog_test_case_2)
+{
+    CCatalog<uint32_t, std::string_view> catalog;
+    std::string names = "TokyoDelhi";
+
+    BOOST_CHECK(catalog.insert(std::string_view(names).substr(0, 5), 1).second == true);
+    BOOST_CHECK(catalog.insert(std::string_view(names).substr(5), 2).second == true);
+    BOOST_CHECK(catalog.insert("Tokyo", 3).second == false);
+
+    auto it = catalog.find(std::string("Delhi"));
+    BOOST_REQUIRE(it != catalog.end());
+    BOOST_CHECK_EQUAL(it->second, 2);
+    /*key is the view given on insert, nothing is copied*/
+    BOOST_CHECK(it->first.data() == names.data() + 5);
+}
+
+/// @brief Hash table kept outside is attached, entries are appended in the order of its indexes
+/// @param  catalog_test_case_3
+BOOST_AUTO_TEST_CASE(catalog_test_case_3)
+{
+    CCatalog<uint32_t, std::string_view> built;
+    CCatalog<uint32_t, std::string_view> attached;
+
+    BOOST_CHECK(built.insert("Tokyo", 1).second == true);
+    BOOST_CHECK(built.insert("Delhi", 2).second == true);
+    BOOST_CHECK(built.insert("Rome", 3).second == true);
+
+    std::vector<catalog_slot> slots(built.get_slots().begin(), built.get_slots().end());
+    attached.attach(slots);
+    for (const auto &[name, value] : built) {
+        attached.append(name, value * 10);
+    }
+
+    BOOST_CHECK(attached.get_slots().data() == slots.data());
+    BOOST_CHECK_EQUAL(attached.size(), 3);
+    BOOST_CHECK_EQUAL(attached.find("Delhi")->second, 20);
+    BOOST_CHECK_EQUAL(attached.find(std::string("Rome"))->second, 30);
+    BOOST_CHECK(attached.find("Paris") == attached.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
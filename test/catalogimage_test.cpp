@@ -0,0 +1,151 @@
+#include <boost/test/unit_test.hpp>
+
+#include <span>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+
+#include "catalogimage.h"
+
+
+/*
+    https://live.boost.org/doc/libs/1_87_0/libs/test/doc/html/boost_test/utf_reference.html
+*/
+
+
+BOOST_AUTO_TEST_SUITE(catalogimage_suite)
+
+/// @brief Image is read back as it was compiled, names are stored once
+/// @param  catalogimage_test_case_1
+BOOST_AUTO_TEST_CASE(catalogimage_test_case_1)
+{
+    int32_t rc;
+    int32_t size;
+    CCatalogImage image;
+    CCatalogImage::movie item;
+    std::vector<CCatalogImage::movie> movies;
+    std::string path = (std::filesystem::temp_directory_path() / "catalogimage_test_case_1.img").string();
+
+    movies.push_back({"Matrix", {{"Tokyo", 0, 20, {}}, {"Arena", 1, 30, {{"North", "A", 0, 10}, {"North", "B", 10, 20}}}}});
+    movies.push_back({"Avatar", {{"Tokyo", 2, 20, {}}}});
+    movies.push_back({"Dune", {}});
+
+    BOOST_TEST_CHECKPOINT("Image is written");
+    std::filesystem::remove(path);
+    BOOST_CHECK(CCatalogImage::is_image(path) == false);
+    size = CCatalogImage::save(path, movies);
+    BOOST_CHECK_GT(size, 0);
+    BOOST_CHECK_EQUAL(std::filesystem::file_size(path), static_cast<uintmax_t>(size));
+    BOOST_CHECK(CCatalogImage::is_image(path));
+
+    BOOST_TEST_CHECKPOINT("Image is mapped");
+    rc = image.open(path);
+    BOOST_CHECK_EQUAL(rc, 3);
+    BOOST_CHECK_EQUAL(image.open(path), -EALREADY);
+    BOOST_CHECK_EQUAL(image.get_movies(), 3);
+    BOOST_CHECK_EQUAL(image.get_shows(), 3);
+
+    BOOST_TEST_CHECKPOINT("Movies, shows and rows are read back");
+    BOOST_CHECK_EQUAL(image.get_movie(0, item), EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(item.movie_, "Matrix");
+    BOOST_REQUIRE_EQUAL(item.shows_.size(), 2);
+    BOOST_CHECK_EQUAL(item.shows_[1].theatre_, "Arena");
+    BOOST_CHECK_EQUAL(item.shows_[1].handle_, 1);
+    BOOST_CHECK_EQUAL(item.shows_[1].capacity_, 30);
+    BOOST_REQUIRE_EQUAL(item.shows_[1].layout_.size(), 2);
+    BOOST_CHECK_EQUAL(item.shows_[1].layout_[1].section_, "North");
+    BOOST_CHECK_EQUAL(item.shows_[1].layout_[1].row_, "B");
+    BOOST_CHECK_EQUAL(item.shows_[1].layout_[1].first_seat_, 10);
+    BOOST_CHECK_EQUAL(item.shows_[1].layout_[1].seats_, 20);
+    std::string_view matrix_tokyo = item.shows_[0].theatre_;
+
+    BOOST_CHECK_EQUAL(image.get_movie(1, item), EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(item.movie_, "Avatar");
+    BOOST_REQUIRE_EQUAL(item.shows_.size(), 1);
+    BOOST_CHECK_EQUAL(item.shows_[0].handle_, 2);
+    /*the same name is stored once*/
+    BOOST_CHECK(item.shows_[0].theatre_.data() == matrix_tokyo.data());
+
+    BOOST_CHECK_EQUAL(image.get_movie(2, item), EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(item.movie_, "Dune");
+    BOOST_CHECK(item.shows_.empty());
+    BOOST_CHECK_EQUAL(image.get_movie(3, item), -ERANGE);
+
+    BOOST_TEST_CHECKPOINT("Theatres list their shows");
+    CCatalogImage::theatre theatre_item;
+    BOOST_CHECK_EQUAL(image.get_theatres(), 2);
+    BOOST_CHECK_EQUAL(image.get_theatre(0, theatre_item), EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(theatre_item.theatre_, "Tokyo");
+    BOOST_REQUIRE_EQUAL(theatre_item.shows_.size(), 2);
+    BOOST_CHECK_EQUAL(theatre_item.shows_[0], 0);
+    BOOST_CHECK_EQUAL(theatre_item.shows_[1], 2);
+    BOOST_CHECK(theatre_item.theatre_.data() == matrix_tokyo.data());
+    BOOST_CHECK_EQUAL(image.get_theatre(2, theatre_item), -ERANGE);
+
+    BOOST_TEST_CHECKPOINT("Catalog looks names up in hash tables of the image");
+    std::span<const catalog_slot> slots;
+    CCatalog<uint32_t, std::string_view> movie_index;
+    CCatalog<uint32_t, std::string_view> show_index;
+    movie_index.attach(image.get_movie_slots());
+    for (uint32_t i = 0; i < image.get_movies(); ++i) {
+        BOOST_CHECK_EQUAL(image.get_movie(i, item), EXIT_SUCCESS);
+        movie_index.append(item.movie_, i);
+    }
+    BOOST_CHECK_EQUAL(movie_index.find("Dune")->second, 2);
+    BOOST_CHECK(movie_index.find("Rome") == movie_index.end());
+    BOOST_CHECK_EQUAL(image.get_show_slots(0, slots), EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(image.get_movie(0, item), EXIT_SUCCESS);
+    show_index.attach(slots);
+    for (uint32_t i = 0; i < item.shows_.size(); ++i) {
+        show_index.append(item.shows_[i].theatre_, i);
+    }
+    BOOST_CHECK_EQUAL(show_index.find("Arena")->second, 1);
+    BOOST_CHECK_EQUAL(image.get_show_slots(2, slots), EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(image.get_show_slots(3, slots), -ERANGE);
+
+    image.close();
+    BOOST_CHECK(image.is_open() == false);
+    BOOST_CHECK_EQUAL(image.get_movie(0, item), -EBADF);
+
+    std::filesystem::remove(path);
+}
+
+/// @brief Handles out of order and damaged files are refused
+/// @param  catalogimage_test_case_2
+BOOST_AUTO_TEST_CASE(catalogimage_test_case_2)
+{
+    CCatalogImage image;
+    std::vector<CCatalogImage::movie> movies;
+    std::string path = (std::filesystem::temp_directory_path() / "catalogimage_test_case_2.img").string();
+
+    BOOST_TEST_CHECKPOINT("Handles must follow order of shows");
+    movies.push_back({"Matrix", {{"Tokyo", 1, 20, {}}}});
+    BOOST_CHECK_EQUAL(CCatalogImage::save(path, movies), -EINVAL);
+    movies.front().shows_.front().handle_ = 0;
+    movies.front().shows_.front().capacity_ = 0;
+    BOOST_CHECK_EQUAL(CCatalogImage::save(path, movies), -EINVAL);
+    movies.front().shows_.front().capacity_ = 20;
+    BOOST_CHECK_GT(CCatalogImage::save(path, movies), 0);
+
+    BOOST_TEST_CHECKPOINT("Names must be unique");
+    movies.push_back({"Matrix", {}});
+    BOOST_CHECK_EQUAL(CCatalogImage::save(path + ".dup", movies), -EINVAL);
+    movies.back() = {"Avatar", {{"Tokyo", 1, 20, {}}, {"Tokyo", 2, 20, {}}}};
+    BOOST_CHECK_EQUAL(CCatalogImage::save(path + ".dup", movies), -EINVAL);
+    movies.pop_back();
+
+    BOOST_TEST_CHECKPOINT("Truncated image is refused");
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    BOOST_CHECK_EQUAL(image.open(path), -EBADMSG);
+    BOOST_CHECK(image.is_open() == false);
+
+    BOOST_TEST_CHECKPOINT("Foreign file is refused");
+    std::ofstream(path, std::ios::trunc) << "{\"movies\": []}";
+    BOOST_CHECK(CCatalogImage::is_image(path) == false);
+    BOOST_CHECK_EQUAL(image.open(path), -EBADMSG);
+    std::filesystem::remove(path);
+    BOOST_CHECK_EQUAL(image.open(path), -ENOENT);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
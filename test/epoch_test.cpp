@@ -0,0 +1,125 @@
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "epoch.h"
+
+
+/*
+    https://live.boost.org/doc/libs/1_87_0/libs/test/doc/html/boost_test/utf_reference.html
+*/
+
+
+BOOST_AUTO_TEST_SUITE(epoch_suite)
+
+/// @brief Writer waits for readers, which started before it
+/// @param  epoch_test_case_1
+BOOST_AUTO_TEST_CASE(epoch_test_case_1)
+{
+    CEpoch epoch;
+    uint64_t start;
+    std::atomic<bool> entered = false;
+    std::atomic<bool> leave = false;
+    std::atomic<bool> synchronized = false;
+
+    BOOST_TEST_CHECKPOINT("Nobody reads, nobody waits");
+    start = epoch.epoch();
+    epoch.synchronize();
+    BOOST_CHECK_EQUAL(epoch.epoch(), start + 1);
+
+    BOOST_TEST_CHECKPOINT("Reader holds the writer");
+    std::thread reader_thread([&epoch, &entered, &leave]() {
+        CEpoch::reader reader(epoch);
+
+        entered = true;
+        while (leave != true) {
+            std::this_thread::yield();
+        }
+    });
+    while (entered != true) {
+        std::this_thread::yield();
+    }
+
+    std::thread writer_thread([&epoch, &synchronized]() {
+        epoch.synchronize();
+        synchronized = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    BOOST_CHECK(synchronized == false);
+
+    BOOST_TEST_CHECKPOINT("Reader started after writer doesn't hold it");
+    {
+        /*nested reader of the main thread announces the new epoch*/
+        while (epoch.epoch() != start + 2) {
+            std::this_thread::yield();
+        }
+        CEpoch::reader reader(epoch);
+
+        leave = true;
+        writer_thread.join();
+        BOOST_CHECK(synchronized == true);
+    }
+    reader_thread.join();
+
+    BOOST_TEST_CHECKPOINT("Left reader doesn't hold the writer");
+    {
+        CEpoch::reader reader(epoch);
+
+        reader.leave();
+        start = epoch.epoch();
+        epoch.synchronize();
+        BOOST_CHECK_EQUAL(epoch.epoch(), start + 1);
+        reader.leave();
+    }
+}
+
+/// @brief Data unpublished before synchronize is never seen by readers afterwards
+/// @param  epoch_test_case_2
+BOOST_AUTO_TEST_CASE(epoch_test_case_2)
+{
+    struct data
+    {
+        std::atomic<uint32_t> magic_ = 0x600dda7a;
+    };
+
+    CEpoch epoch;
+    std::atomic<data *> published = new data;
+    std::atomic<bool> done = false;
+    std::atomic<uint32_t> damaged = 0;
+    std::vector<std::thread> readers;
+
+    for (uint32_t i = 0; i < 4; ++i) {
+        readers.emplace_back([&epoch, &published, &done, &damaged]() {
+            while (done != true) {
+                CEpoch::reader reader(epoch);
+                data *p_data = published.load(std::memory_order_seq_cst);
+
+                if (p_data->magic_.load(std::memory_order_relaxed) != 0x600dda7a)
+                    damaged++;
+            }
+        });
+    }
+
+    for (uint32_t i = 0; i < 2000; ++i) {
+        data *old_data = published.exchange(new data, std::memory_order_seq_cst);
+
+        epoch.synchronize();
+        old_data->magic_ = 0;
+        delete old_data;
+    }
+
+    done = true;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    delete published.load();
+
+    BOOST_CHECK_EQUAL(damaged, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,106 @@
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+
+#include "journal.h"
+
+
+/*
+    https://live.boost.org/doc/libs/1_87_0/libs/test/doc/html/boost_test/utf_reference.html
+*/
+
+
+BOOST_AUTO_TEST_SUITE(journal_suite)
+
+/// @brief Records are replayed in order, torn record is dropped
+/// @param  journal_test_case_1
+BOOST_AUTO_TEST_CASE(journal_test_case_1)
+{
+    int32_t rc;
+    CJournal journal;
+    std::vector<std::string> records;
+    std::string path = (std::filesystem::temp_directory_path() / "journal_test_case_1.log").string();
+    auto apply = [&records](const std::string &record) {records.push_back(record); return EXIT_SUCCESS;};
+
+    std::filesystem::remove(path);
+
+    BOOST_TEST_CHECKPOINT("Missing journal has no records");
+    BOOST_CHECK_EQUAL(CJournal::replay(path, apply), 0);
+
+    BOOST_TEST_CHECKPOINT("Records are written on close");
+    rc = journal.open(path, CJournal::durability_t::batched);
+    BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+    BOOST_CHECK(journal.is_open());
+    BOOST_CHECK_EQUAL(journal.open(path, CJournal::durability_t::batched), -EALREADY);
+    journal.append("B 0 1,2 a");
+    journal.append("U 0 2 a");
+    journal.close();
+    BOOST_CHECK(journal.is_open() == false);
+    BOOST_CHECK_EQUAL(journal.get_error(), EXIT_SUCCESS);
+
+    BOOST_CHECK_EQUAL(CJournal::replay(path, apply), 2);
+    BOOST_CHECK(records == std::vector<std::string>({"B 0 1,2 a", "U 0 2 a"}));
+
+    BOOST_TEST_CHECKPOINT("Torn record is ignored and cut off before next append");
+    {
+        std::ofstream file(path, std::ios::app | std::ios::binary);
+        file << "B 0 3";
+    }
+    records.clear();
+    BOOST_CHECK_EQUAL(CJournal::replay(path, apply), 2);
+
+    rc = journal.open(path, CJournal::durability_t::none);
+    BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+    journal.append("B 0 4 b");
+    journal.close();
+
+    records.clear();
+    BOOST_CHECK_EQUAL(CJournal::replay(path, apply), 3);
+    BOOST_CHECK_EQUAL(records.back(), "B 0 4 b");
+
+    BOOST_TEST_CHECKPOINT("Failed record stops replay");
+    rc = CJournal::replay(path, [](const std::string &) {return -EBADMSG;});
+    BOOST_CHECK_EQUAL(rc, -EBADMSG);
+
+    std::filesystem::remove(path);
+}
+
+/// @brief Concurrent sessions share flushes
+/// @param  journal_test_case_2
+BOOST_AUTO_TEST_CASE(journal_test_case_2)
+{
+    int32_t rc;
+    CJournal journal;
+    std::vector<std::thread> threads;
+    std::string path = (std::filesystem::temp_directory_path() / "journal_test_case_2.log").string();
+
+    std::filesystem::remove(path);
+
+    rc = journal.open(path, CJournal::durability_t::per_op);
+    BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+
+    for (uint32_t i = 0; i < 4; ++i) {
+        threads.emplace_back([&journal, i]() {
+            for (uint32_t j = 0; j < 100; ++j) {
+                CJournal::commit commit(journal);
+                journal.append("B " + std::to_string(i) + " " + std::to_string(j) + " t" + std::to_string(i));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    /*every record was flushed, when its session went on*/
+    BOOST_CHECK_EQUAL(CJournal::replay(path, [](const std::string &) {return EXIT_SUCCESS;}), 400);
+    BOOST_CHECK_LE(journal.get_batches(), 400);
+    BOOST_CHECK_EQUAL(journal.sync(), EXIT_SUCCESS);
+    journal.close();
+
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
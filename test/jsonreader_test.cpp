@@ -0,0 +1,153 @@
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <sstream>
+#include <vector>
+
+#include "jsonreader.h"
+
+
+/*
+    https://live.boost.org/doc/libs/1_87_0/libs/test/doc/html/boost_test/utf_reference.html
+*/
+
+
+/// @brief Read all the tokens of the document
+/// @param document [in] JSON document
+/// @param tokens [out] tokens and their text, joined
+/// @return result of the last read
+static int32_t read_all(const std::string &document, std::string &tokens)
+{
+    int32_t rc;
+    std::stringstream ss(document);
+    CJsonReader reader(ss);
+    CJsonReader::token_t token;
+
+    tokens.clear();
+    for (;;) {
+        rc = reader.next(token);
+        if (rc < EXIT_SUCCESS) {
+            return rc;
+        }
+
+        switch (token) {
+        case CJsonReader::token_t::begin_object: tokens += "{"; break;
+        case CJsonReader::token_t::end_object: tokens += "}"; break;
+        case CJsonReader::token_t::begin_array: tokens += "["; break;
+        case CJsonReader::token_t::end_array: tokens += "]"; break;
+        case CJsonReader::token_t::key: tokens += "k:" + reader.get_text() + " "; break;
+        case CJsonReader::token_t::string: tokens += "s:" + reader.get_text() + " "; break;
+        case CJsonReader::token_t::number: tokens += "n:" + reader.get_text() + " "; break;
+        case CJsonReader::token_t::literal: tokens += "l:" + reader.get_text() + " "; break;
+        case CJsonReader::token_t::end: return rc;
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE(jsonreader_suite)
+
+/// @brief Tokens of valid documents
+/// @param  jsonreader_test_case_1
+BOOST_AUTO_TEST_CASE(jsonreader_test_case_1)
+{
+    int32_t rc;
+    std::string tokens;
+
+    BOOST_TEST_CHECKPOINT("Nested containers and scalars");
+    rc = read_all(" {\"a\": [1, -2.5e+3, \"x\", true, null, {}], \"b\" : {\"c\": []}}\n", tokens);
+    BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(tokens, "{k:a [n:1 n:-2.5e+3 s:x l:true l:null {}]k:b {k:c []}}");
+
+    BOOST_TEST_CHECKPOINT("Escapes are decoded to UTF-8");
+    rc = read_all("[\"a\\\"b\\\\c\\/\\n\", \"\\u0041\\u00e9\\u20ac\\ud83d\\ude00\"]", tokens);
+    BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(tokens, "[s:a\"b\\c/\n s:A\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80 ]");
+
+    BOOST_TEST_CHECKPOINT("Scalar document");
+    rc = read_all("42", tokens);
+    BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(tokens, "n:42 ");
+}
+
+/// @brief Malformed documents are refused
+/// @param  jsonreader_test_case_2
+BOOST_AUTO_TEST_CASE(jsonreader_test_case_2)
+{
+    std::string tokens;
+    std::vector<std::string> documents = {
+        "",
+        "{",
+        "[1,]",
+        "[1 2]",
+        "{\"a\" 1}",
+        "{\"a\": 1,}",
+        "{1: 2}",
+        "[1}",
+        "{\"a\": 1]",
+        "[01]",
+        "[1.]",
+        "[-]",
+        "[tru]",
+        "[\"a\nb\"]",
+        "[\"\\x\"]",
+        "[\"\\udc00\"]",
+        "[\"abc",
+        "{} {}",
+        "[] x"
+    };
+
+    for (const auto &document : documents) {
+        BOOST_TEST_CONTEXT("Document: " << document) {
+            BOOST_CHECK_EQUAL(read_all(document, tokens), -EBADMSG);
+        }
+    }
+}
+
+/// @brief Unknown values are skipped, numbers are converted, long strings cross buffer boundary
+/// @param  jsonreader_test_case_3
+BOOST_AUTO_TEST_CASE(jsonreader_test_case_3)
+{
+    int32_t rc;
+    uint32_t value;
+    std::string long_name(200 * 1024, 'x');
+    std::stringstream ss("{\"skip\": {\"a\": [1, {\"b\": 2}], \"c\": \"d\"}, \"seats\": 4294967295, \"big\": 4294967296, \"name\": \"" + long_name + "\"}");
+    CJsonReader reader(ss);
+    CJsonReader::token_t token;
+
+    BOOST_CHECK_EQUAL(reader.next(token), EXIT_SUCCESS);
+    BOOST_CHECK(token == CJsonReader::token_t::begin_object);
+
+    BOOST_TEST_CHECKPOINT("Nested value is skipped at once");
+    BOOST_CHECK_EQUAL(reader.next(token), EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(reader.get_text(), "skip");
+    BOOST_CHECK_EQUAL(reader.next(token), EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(reader.skip(token), EXIT_SUCCESS);
+
+    BOOST_TEST_CHECKPOINT("Number fits, or it is refused");
+    BOOST_CHECK_EQUAL(reader.next(token), EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(reader.get_text(), "seats");
+    BOOST_CHECK_EQUAL(reader.next(token), EXIT_SUCCESS);
+    BOOST_CHECK(token == CJsonReader::token_t::number);
+    rc = reader.get_uint32(value);
+    BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(value, 4294967295u);
+    BOOST_CHECK_EQUAL(reader.next(token), EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(reader.next(token), EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(reader.get_uint32(value), -ERANGE);
+
+    BOOST_TEST_CHECKPOINT("String longer than the buffer");
+    BOOST_CHECK_EQUAL(reader.next(token), EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(reader.next(token), EXIT_SUCCESS);
+    BOOST_CHECK(token == CJsonReader::token_t::string);
+    BOOST_CHECK(reader.get_text() == long_name);
+    BOOST_CHECK_EQUAL(reader.get_uint32(value), -EINVAL);
+
+    BOOST_CHECK_EQUAL(reader.next(token), EXIT_SUCCESS);
+    BOOST_CHECK(token == CJsonReader::token_t::end_object);
+    BOOST_CHECK_EQUAL(reader.next(token), EXIT_SUCCESS);
+    BOOST_CHECK(token == CJsonReader::token_t::end);
+    BOOST_CHECK_EQUAL(reader.get_offset(), static_cast<uint64_t>(ss.str().size()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,59 @@
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <string_view>
+
+#include "namepool.h"
+
+
+/*
+    https://live.boost.org/doc/libs/1_87_0/libs/test/doc/html/boost_test/utf_reference.html
+*/
+
+
+BOOST_AUTO_TEST_SUITE(namepool_suite)
+
+/// @brief Equal names are stored once, views outlive the interned buffers
+/// @param  namepool_test_case_1
+BOOST_AUTO_TEST_CASE(namepool_test_case_1)
+{
+    CNamePool pool;
+    std::string_view tokyo;
+    std::string_view delhi;
+    std::string long_name(100 * 1024, 'x');
+
+    BOOST_TEST_CHECKPOINT("Empty pool");
+    BOOST_CHECK_EQUAL(pool.size(), 0);
+    BOOST_CHECK(pool.find("Tokyo").data() == nullptr);
+
+    BOOST_TEST_CHECKPOINT("Name is stored once");
+    {
+        std::string buffer = "Tokyo";
+        tokyo = pool.intern(buffer);
+        buffer = "Delhi";
+        delhi = pool.intern(buffer);
+    }
+    BOOST_CHECK_EQUAL(tokyo, "Tokyo");
+    BOOST_CHECK_EQUAL(delhi, "Delhi");
+    BOOST_CHECK(pool.intern(std::string("Tokyo")).data() == tokyo.data());
+    BOOST_CHECK(pool.find("Delhi").data() == delhi.data());
+    BOOST_CHECK_EQUAL(pool.size(), 2);
+    BOOST_CHECK_EQUAL(pool.get_bytes(), 10);
+
+    BOOST_TEST_CHECKPOINT("Names stay in place, while blocks are added");
+    for (uint32_t i = 0; i < 20000; ++i) {
+        pool.intern("Theatre" + std::to_string(i));
+    }
+    BOOST_CHECK_EQUAL(pool.intern(long_name), long_name);
+    BOOST_CHECK(pool.intern("Tokyo").data() == tokyo.data());
+    BOOST_CHECK_EQUAL(tokyo, "Tokyo");
+    BOOST_CHECK_EQUAL(pool.find("Theatre19999"), "Theatre19999");
+    BOOST_CHECK_EQUAL(pool.size(), 20003);
+
+    BOOST_TEST_CHECKPOINT("Empty name is stored too");
+    BOOST_CHECK(pool.find("").data() == nullptr);
+    BOOST_CHECK(pool.intern("").data() != nullptr);
+    BOOST_CHECK(pool.find("").data() != nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
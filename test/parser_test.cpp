@@ -35,6 +35,40 @@ BOOST_AUTO_TEST_CASE(parser_test_case_1)
     str2 = "3, 4, 5";
     seats_to_string(str, vect);
     BOOST_CHECK_EQUAL(str, str2);
+
+    BOOST_TEST_CHECKPOINT("Request for contiguous seats");
+    uint32_t n;
+    BOOST_CHECK_EQUAL(get_best_request("4", n, str), EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(n, 4);
+    BOOST_CHECK(str.empty());
+    BOOST_CHECK_EQUAL(get_best_request("3@B", n, str), EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(n, 3);
+    BOOST_CHECK_EQUAL(str, "B");
+    BOOST_CHECK_LT(get_best_request("0", n, str), EXIT_SUCCESS);
+    BOOST_CHECK_LT(get_best_request("x@B", n, str), EXIT_SUCCESS);
+    BOOST_CHECK_LT(get_best_request("3@", n, str), EXIT_SUCCESS);
+
+    BOOST_TEST_CHECKPOINT("Batch request");
+    std::vector<show_seats_t> shows;
+    BOOST_CHECK_EQUAL(get_batch_request("Matrix/Tokyo:1-3; Avatar/Delhi:5,6", shows), 2);
+    BOOST_CHECK_EQUAL(shows[0].movie_, "Matrix");
+    BOOST_CHECK_EQUAL(shows[0].theatre_, "Tokyo");
+    BOOST_CHECK_EQUAL(shows[0].seats_, "1-3");
+    BOOST_CHECK_EQUAL(shows[1].movie_, "Avatar");
+    BOOST_CHECK_EQUAL(shows[1].seats_, "5,6");
+    BOOST_CHECK_LT(get_batch_request("Matrix:1", shows), EXIT_SUCCESS);
+    BOOST_CHECK_LT(get_batch_request("Matrix/Tokyo:", shows), EXIT_SUCCESS);
+    BOOST_CHECK_LT(get_batch_request("", shows), EXIT_SUCCESS);
+
+    BOOST_TEST_CHECKPOINT("Exchange request");
+    std::string take;
+    BOOST_CHECK_EQUAL(get_exchange_request("1,2 > 5-6", str, take), EXIT_SUCCESS);
+    BOOST_CHECK_EQUAL(str, "1,2");
+    BOOST_CHECK_EQUAL(take, "5-6");
+    BOOST_CHECK_LT(get_exchange_request("1,2", str, take), EXIT_SUCCESS);
+    BOOST_CHECK_LT(get_exchange_request(">5", str, take), EXIT_SUCCESS);
+    BOOST_CHECK_LT(get_exchange_request("1>", str, take), EXIT_SUCCESS);
+    BOOST_CHECK_LT(get_exchange_request("1>2>3", str, take), EXIT_SUCCESS);
 }
 
 
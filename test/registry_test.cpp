@@ -0,0 +1,93 @@
+#include <boost/test/unit_test.hpp>
+
+#include <set>
+#include <thread>
+
+#include "registry.h"
+
+
+/*
+    https://live.boost.org/doc/libs/1_87_0/libs/test/doc/html/boost_test/utf_reference.html
+*/
+
+
+BOOST_AUTO_TEST_SUITE(registry_suite)
+
+/// @brief Handles are dense and reused
+/// @param  registry_test_case_1
+BOOST_AUTO_TEST_CASE(registry_test_case_1)
+{
+    CBookerRegistry registry;
+    std::vector<CBooker::booker_ptr> bookers;
+    uint64_t version;
+
+    BOOST_TEST_CHECKPOINT("Handles span all the shards");
+    for (uint32_t i = 0; i < 2 * CBookerRegistry::m_shards; ++i) {
+        bookers.push_back(std::make_shared<CBooker>());
+        BOOST_CHECK_EQUAL(registry.insert(bookers.back()), static_cast<int32_t>(i + 1));
+        BOOST_CHECK(registry.find(i + 1) == bookers.back());
+    }
+    BOOST_CHECK_EQUAL(registry.size(), 2 * CBookerRegistry::m_shards);
+    BOOST_CHECK_EQUAL(registry.insert(bookers[0]), -EEXIST);
+    BOOST_CHECK(registry.find(0) == nullptr);
+    BOOST_CHECK(registry.find(1000) == nullptr);
+
+    BOOST_TEST_CHECKPOINT("Reused handle");
+    version = registry.version();
+    BOOST_CHECK(registry.erase(bookers[4], true));
+    BOOST_CHECK_GT(registry.version(), version);
+    BOOST_CHECK(registry.erase(bookers[4], true) == false);
+    BOOST_CHECK_EQUAL(bookers[4]->get_booker_id(), 0);
+    BOOST_CHECK_EQUAL(registry.size(), 2 * CBookerRegistry::m_shards - 1);
+    BOOST_CHECK(registry.find(5) == nullptr);
+    BOOST_CHECK_EQUAL(registry.insert(bookers[4]), 5);
+
+    BOOST_TEST_CHECKPOINT("Retired handle");
+    BOOST_CHECK(registry.erase(bookers[5], false));
+    BOOST_CHECK_EQUAL(bookers[5]->get_booker_id(), 6);
+    BOOST_CHECK(registry.find(6) == nullptr);
+    BOOST_CHECK_EQUAL(registry.insert(std::make_shared<CBooker>()), static_cast<int32_t>(2 * CBookerRegistry::m_shards + 1));
+    BOOST_CHECK_EQUAL(registry.capacity(), 2 * CBookerRegistry::m_shards + 1);
+}
+
+/// @brief Concurrent joins and leaves
+/// @param  registry_test_case_2
+BOOST_AUTO_TEST_CASE(registry_test_case_2)
+{
+    CBookerRegistry registry;
+    std::vector<std::thread> threads;
+    std::vector<std::vector<CBooker::booker_ptr>> kept(4);
+    std::set<uint32_t> handles;
+
+    for (uint32_t i = 0; i < kept.size(); ++i) {
+        threads.emplace_back([&registry, &kept, i]() {
+            for (uint32_t j = 0; j < 5000; ++j) {
+                CBooker::booker_ptr booker = std::make_shared<CBooker>();
+                if (registry.insert(booker) <= 0)
+                    continue;
+
+                /*every tenth booker stays*/
+                if (j % 10 == 0)
+                    kept[i].push_back(booker);
+                else
+                    registry.erase(booker, true);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    BOOST_CHECK_EQUAL(registry.size(), 2000);
+    for (auto &bookers : kept) {
+        for (auto &booker : bookers) {
+            BOOST_CHECK(handles.insert(booker->get_booker_id()).second);
+            BOOST_CHECK(registry.find(booker->get_booker_id()) == booker);
+        }
+    }
+    BOOST_CHECK_EQUAL(handles.size(), 2000);
+    /*handles freed by other threads meanwhile can be missed, but not many of them*/
+    BOOST_CHECK_LE(registry.capacity(), 2000 + CBookerRegistry::m_shards);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
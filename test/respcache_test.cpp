@@ -0,0 +1,99 @@
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <stdexcept>
+
+#include "respcache.h"
+
+
+/*
+    https://live.boost.org/doc/libs/1_87_0/libs/test/doc/html/boost_test/utf_reference.html
+*/
+
+
+BOOST_AUTO_TEST_SUITE(respcache_suite)
+
+/// @brief Responses are rendered once per version and color
+/// @param  respcache_test_case_1
+BOOST_AUTO_TEST_CASE(respcache_test_case_1)
+{
+    CResponseCache cache;
+    CResponseCache::response_ptr first;
+    CResponseCache::response_ptr second;
+    uint32_t renders;
+    auto render = [&renders](std::string &response)
+    {
+        renders++;
+        response = "render " + std::to_string(renders);
+    };
+
+    renders = 0;
+
+    BOOST_TEST_CHECKPOINT("Same version is shared");
+    first = cache.get(1, false, 0, render);
+    second = cache.get(1, false, 0, render);
+    BOOST_CHECK(first == second);
+    BOOST_CHECK_EQUAL(*first, "render 1");
+    BOOST_CHECK_EQUAL(cache.get_renders(), 1);
+
+    BOOST_TEST_CHECKPOINT("Color and id are separate responses");
+    BOOST_CHECK_EQUAL(*cache.get(1, true, 0, render), "render 2");
+    BOOST_CHECK_EQUAL(*cache.get(2, false, 0, render), "render 3");
+    BOOST_CHECK_EQUAL(cache.size(), 3);
+
+    BOOST_TEST_CHECKPOINT("Newer version replaces, older one is served by newer");
+    second = cache.get(1, false, 2, render);
+    BOOST_CHECK_EQUAL(*second, "render 4");
+    BOOST_CHECK(cache.get(1, false, 1, render) == second);
+    BOOST_CHECK_EQUAL(cache.size(), 3);
+    /*replaced response stays valid for its holders*/
+    BOOST_CHECK_EQUAL(*first, "render 1");
+
+    BOOST_TEST_CHECKPOINT("Failed rendering is not cached");
+    BOOST_CHECK_THROW(
+        cache.get(3, false, 0, [](std::string &) {throw std::runtime_error("failed");}),
+        std::runtime_error);
+    BOOST_CHECK_EQUAL(*cache.get(3, false, 0, render), "render 5");
+    BOOST_CHECK_EQUAL(cache.get_renders(), 5);
+}
+
+/// @brief Concurrent requests wait for single rendering
+/// @param  respcache_test_case_2
+BOOST_AUTO_TEST_CASE(respcache_test_case_2)
+{
+    CResponseCache cache;
+    std::vector<std::thread> threads;
+    std::vector<CResponseCache::response_ptr> responses(8);
+    std::atomic<uint32_t> renders = 0;
+    std::atomic<bool> go = false;
+
+    for (uint32_t i = 0; i < responses.size(); ++i) {
+        threads.emplace_back([&, i]() {
+            while (go.load() != true)
+                std::this_thread::yield();
+
+            responses[i] = cache.get(7, false, 1, [&renders](std::string &response)
+            {
+                renders++;
+                /*slow rendering, so the others come meanwhile*/
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                response = "seats";
+            });
+        });
+    }
+    go = true;
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    BOOST_CHECK_EQUAL(renders.load(), 1);
+    for (auto &response : responses) {
+        BOOST_CHECK(response == responses[0]);
+    }
+    BOOST_CHECK_EQUAL(*responses[0], "seats");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
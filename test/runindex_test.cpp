@@ -0,0 +1,124 @@
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+
+#include "runindex.h"
+
+
+/*
+    https://live.boost.org/doc/libs/1_87_0/libs/test/doc/html/boost_test/utf_reference.html
+*/
+
+
+/// @brief Reference search, seat by seat
+/// @param map [in] seat map
+/// @param n [in] number of seats
+/// @param first [in] first seat of the range
+/// @param last [in] seat behind the range
+/// @return first seat of the run, negative if there is no such run
+static int64_t find_slow(const CSeatMap &map, uint32_t n, uint32_t first, uint32_t last)
+{
+    uint32_t run = 0;
+
+    for (uint32_t seat = first; (seat < last)&&(seat < map.capacity()); ++seat) {
+        run = map.test(seat) ? run + 1 : 0;
+        if ((n != 0)&&(run == n))
+            return static_cast<int64_t>(seat + 1 - n);
+    }
+
+    return -1;
+}
+
+BOOST_AUTO_TEST_SUITE(runindex_suite)
+
+/// @brief Runs inside words, across words and within ranges
+/// @param  runindex_test_case_1
+BOOST_AUTO_TEST_CASE(runindex_test_case_1)
+{
+    CSeatMap map(200, true);
+    CRunIndex runs;
+    CSeatMap::mask_t request;
+    CSeatMap::mask_t owned;
+    CSeatMap::mask_t claimed;
+    std::vector<uint32_t> unavailable;
+
+    runs.build(map);
+    BOOST_CHECK_EQUAL(runs.longest(), 200);
+    BOOST_CHECK_EQUAL(runs.find(200, 0, 200), 0);
+    BOOST_CHECK(runs.find(201, 0, 200) < 0);
+    BOOST_CHECK_EQUAL(runs.find(5, 70, 200), 70);
+
+    BOOST_TEST_CHECKPOINT("Occupied seats split the runs");
+    BOOST_CHECK_EQUAL(CSeatMap::make_mask({3, 60, 130}, map.capacity(), request), 3);
+    owned.first_word_ = request.first_word_;
+    owned.words_.assign(request.words_.size(), 0);
+    BOOST_CHECK(map.book(request, owned, claimed, unavailable, false));
+    BOOST_CHECK_EQUAL(runs.refresh(map), 2);
+    BOOST_CHECK_EQUAL(runs.refresh(map), 0);
+
+    BOOST_CHECK_EQUAL(runs.longest(), 69);
+    BOOST_CHECK_EQUAL(runs.find(3, 0, 200), 0);
+    BOOST_CHECK_EQUAL(runs.find(4, 0, 200), 4);
+    BOOST_CHECK_EQUAL(runs.find(60, 0, 200), 61);
+    BOOST_CHECK_EQUAL(runs.find(69, 0, 200), 61);
+    BOOST_CHECK(runs.find(70, 0, 200) < 0);
+
+    BOOST_TEST_CHECKPOINT("Range limits the run");
+    BOOST_CHECK_EQUAL(runs.find(10, 100, 200), 100);
+    BOOST_CHECK_EQUAL(runs.find(30, 100, 200), 100);
+    BOOST_CHECK_EQUAL(runs.find(31, 100, 200), 131);
+    BOOST_CHECK(runs.find(31, 100, 161) < 0);
+    BOOST_CHECK(runs.find(2, 60, 61) < 0);
+
+    BOOST_TEST_CHECKPOINT("Released seats join the runs");
+    map.release(claimed);
+    runs.refresh(map);
+    BOOST_CHECK_EQUAL(runs.longest(), 200);
+
+    BOOST_TEST_CHECKPOINT("First refresh builds the index");
+    CRunIndex lazy_runs;
+    BOOST_CHECK(map.book(request, owned, claimed, unavailable, false));
+    BOOST_CHECK_EQUAL(lazy_runs.refresh(map), map.words());
+    BOOST_CHECK_EQUAL(lazy_runs.refresh(map), 0);
+    BOOST_CHECK_EQUAL(lazy_runs.longest(), 69);
+    BOOST_CHECK_EQUAL(lazy_runs.find(60, 0, 200), 61);
+}
+
+/// @brief Random bookings, compared with seat by seat search
+/// @param  runindex_test_case_2
+BOOST_AUTO_TEST_CASE(runindex_test_case_2)
+{
+    CSeatMap map(1000, true);
+    CRunIndex runs;
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<uint32_t> seat_dist(0, 999);
+    std::uniform_int_distribution<uint32_t> n_dist(1, 150);
+
+    runs.build(map);
+
+    for (uint32_t i = 0; i < 2000; ++i) {
+        CSeatMap::mask_t request;
+        CSeatMap::mask_t claimed;
+        uint32_t seat = seat_dist(gen);
+
+        CSeatMap::make_mask({seat}, map.capacity(), request);
+        if (map.test(seat))
+            map.claim(request, claimed, false);
+        else
+            map.release(request);
+
+        if (i % 3 == 0)
+            runs.refresh(map);
+        else
+            continue;
+
+        uint32_t n = n_dist(gen);
+        uint32_t first = seat_dist(gen);
+        uint32_t last = first + seat_dist(gen);
+        BOOST_CHECK_EQUAL(runs.find(n % 10 + 1, 0, 1000), find_slow(map, n % 10 + 1, 0, 1000));
+        BOOST_CHECK_EQUAL(runs.find(n, 0, 1000), find_slow(map, n, 0, 1000));
+        BOOST_CHECK_EQUAL(runs.find(n % 20 + 1, first, last), find_slow(map, n % 20 + 1, first, last));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
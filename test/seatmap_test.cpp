@@ -0,0 +1,257 @@
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+
+#include "seatmap.h"
+
+
+/*
+    https://live.boost.org/doc/libs/1_87_0/libs/test/doc/html/boost_test/utf_reference.html
+*/
+
+
+BOOST_AUTO_TEST_SUITE(seatmap_suite)
+
+/// @brief Basic bitmap operations and kernels
+/// @param  seatmap_test_case_1
+BOOST_AUTO_TEST_CASE(seatmap_test_case_1)
+{
+    std::set<uint32_t> set1;
+    std::set<uint32_t> set2({0, 63, 64, 129, 199});
+    std::vector<uint32_t> vect;
+    CSeatMap::mask_t mask;
+    CSeatMap::mask_t claimed;
+    CSeatMap map(200, false);
+
+    BOOST_TEST_CHECKPOINT("Empty map");
+    BOOST_CHECK_EQUAL(map.capacity(), 200);
+    BOOST_CHECK_EQUAL(map.words(), 4);
+    BOOST_CHECK_EQUAL(map.count(), 0);
+    BOOST_CHECK_EQUAL(map.marked(), map.count());
+    BOOST_CHECK(map.none());
+
+    BOOST_TEST_CHECKPOINT("Release and extract seats over word boundaries");
+    BOOST_CHECK_EQUAL(CSeatMap::make_mask(set2, map.capacity(), mask), 5);
+    map.release(mask);
+    BOOST_CHECK_EQUAL(map.count(), set2.size());
+    BOOST_CHECK_EQUAL(map.marked(), map.count());
+    map.to_set(set1);
+    BOOST_CHECK_EQUAL_COLLECTIONS(set1.begin(), set1.end(), set2.begin(), set2.end());
+    CSeatMap::mask_to_vector(mask, vect);
+    BOOST_CHECK_EQUAL_COLLECTIONS(vect.begin(), vect.end(), set2.begin(), set2.end());
+
+    BOOST_TEST_CHECKPOINT("Claim single seat");
+    CSeatMap::make_mask(std::set<uint32_t>({63}), map.capacity(), mask);
+    BOOST_CHECK(map.claim(mask, claimed, false));
+    BOOST_CHECK(map.test(63) != true);
+    BOOST_CHECK(map.test(64));
+    BOOST_CHECK(map.test(200) != true);
+
+    BOOST_TEST_CHECKPOINT("Full map does not count seats above capacity");
+    map.resize(200, true);
+    BOOST_CHECK_EQUAL(map.count(), 200);
+    BOOST_CHECK_EQUAL(map.marked(), map.count());
+}
+
+/// @brief Claim, book and release trough request masks
+/// @param  seatmap_test_case_2
+BOOST_AUTO_TEST_CASE(seatmap_test_case_2)
+{
+    int32_t rc;
+    CSeatMap::mask_t mask;
+    CSeatMap::mask_t owned;
+    CSeatMap::mask_t claimed;
+    CSeatMap free_map(300, true);
+    std::vector<uint32_t> vect;
+    std::vector<uint32_t> vect2;
+
+    BOOST_TEST_CHECKPOINT("Mask out of range");
+    rc = CSeatMap::make_mask(std::set<uint32_t>({10, 300}), free_map.capacity(), mask);
+    BOOST_CHECK_EQUAL(rc, -ERANGE);
+
+    BOOST_TEST_CHECKPOINT("Mask covers touched words only");
+    rc = CSeatMap::make_mask(std::set<uint32_t>({130, 140, 260}), free_map.capacity(), mask);
+    BOOST_CHECK_EQUAL(rc, 3);
+    BOOST_CHECK_EQUAL(mask.first_word_, 2);
+    BOOST_CHECK_EQUAL(mask.words_.size(), 3);
+    BOOST_CHECK_EQUAL(CSeatMap::mask_words(std::set<uint32_t>({130, 140, 260})), 3);
+
+    BOOST_TEST_CHECKPOINT("Book seats");
+    owned.first_word_ = mask.first_word_;
+    owned.words_.assign(mask.words_.size(), 0);
+    BOOST_CHECK(free_map.book(mask, owned, claimed, vect, false));
+    BOOST_CHECK(vect.empty());
+    BOOST_CHECK_EQUAL(free_map.count(), 297);
+    BOOST_CHECK_EQUAL(free_map.marked(), free_map.count());
+    CSeatMap::mask_to_vector(claimed, vect);
+    vect2 = std::vector<uint32_t>({130, 140, 260});
+    BOOST_CHECK_EQUAL_COLLECTIONS(vect.begin(), vect.end(), vect2.begin(), vect2.end());
+
+    BOOST_TEST_CHECKPOINT("Book taken seats - all or nothing");
+    rc = CSeatMap::make_mask(std::set<uint32_t>({1, 140, 260}), free_map.capacity(), mask);
+    owned.first_word_ = mask.first_word_;
+    owned.words_.assign(mask.words_.size(), 0);
+    vect2 = std::vector<uint32_t>({140, 260});
+    BOOST_CHECK(free_map.book(mask, owned, claimed, vect, false) != true);
+    BOOST_CHECK_EQUAL_COLLECTIONS(vect.begin(), vect.end(), vect2.begin(), vect2.end());
+    BOOST_CHECK_EQUAL(free_map.count(), 297);
+    BOOST_CHECK(free_map.test(1));
+
+    BOOST_TEST_CHECKPOINT("Owned seats are not unavailable");
+    owned.words_[2] = static_cast<CSeatMap::word_t>(1) << (140 % 64);
+    vect2 = std::vector<uint32_t>({260});
+    BOOST_CHECK(free_map.book(mask, owned, claimed, vect, false) != true);
+    BOOST_CHECK_EQUAL_COLLECTIONS(vect.begin(), vect.end(), vect2.begin(), vect2.end());
+
+    BOOST_TEST_CHECKPOINT("Book taken seats - best effort");
+    BOOST_CHECK(free_map.book(mask, owned, claimed, vect, true));
+    BOOST_CHECK_EQUAL_COLLECTIONS(vect.begin(), vect.end(), vect2.begin(), vect2.end());
+    vect.clear();
+    CSeatMap::mask_to_vector(claimed, vect);
+    vect2 = std::vector<uint32_t>({1});
+    BOOST_CHECK_EQUAL_COLLECTIONS(vect.begin(), vect.end(), vect2.begin(), vect2.end());
+    BOOST_CHECK_EQUAL(free_map.count(), 296);
+    BOOST_CHECK_EQUAL(free_map.marked(), free_map.count());
+
+    BOOST_TEST_CHECKPOINT("Release seats");
+    free_map.release(claimed);
+    BOOST_CHECK(free_map.test(1));
+    BOOST_CHECK_EQUAL(free_map.count(), 297);
+    BOOST_CHECK_EQUAL(free_map.marked(), free_map.count());
+
+    BOOST_TEST_CHECKPOINT("Claim single word - all or nothing");
+    rc = CSeatMap::make_mask(std::set<uint32_t>({129, 130, 131}), free_map.capacity(), mask);
+    BOOST_CHECK_EQUAL(mask.words_.size(), 1);
+    BOOST_CHECK(free_map.claim(mask, claimed, false) != true);
+    vect.clear();
+    CSeatMap::mask_to_vector(claimed, vect);
+    vect2 = std::vector<uint32_t>({129, 131});
+    BOOST_CHECK_EQUAL_COLLECTIONS(vect.begin(), vect.end(), vect2.begin(), vect2.end());
+    BOOST_CHECK(free_map.test(129));
+    BOOST_CHECK_EQUAL(free_map.marked(), 297);
+
+    BOOST_TEST_CHECKPOINT("Claim single word - best effort");
+    BOOST_CHECK(free_map.claim(mask, claimed, true));
+    BOOST_CHECK(free_map.test(129) != true);
+    BOOST_CHECK(free_map.test(131) != true);
+    BOOST_CHECK_EQUAL(free_map.count(), 295);
+    BOOST_CHECK_EQUAL(free_map.marked(), free_map.count());
+
+    BOOST_TEST_CHECKPOINT("Claim more words - failed word gives the others back");
+    rc = CSeatMap::make_mask(std::set<uint32_t>({1, 70, 140, 200}), free_map.capacity(), mask);
+    BOOST_CHECK_EQUAL(mask.words_.size(), 4);
+    BOOST_CHECK(free_map.claim(mask, claimed, false) != true);
+    vect.clear();
+    CSeatMap::mask_to_vector(claimed, vect);
+    vect2 = std::vector<uint32_t>({1, 70, 200});
+    BOOST_CHECK_EQUAL_COLLECTIONS(vect.begin(), vect.end(), vect2.begin(), vect2.end());
+    BOOST_CHECK(free_map.test(1));
+    BOOST_CHECK(free_map.test(70));
+    BOOST_CHECK_EQUAL(free_map.count(), 295);
+    BOOST_CHECK_EQUAL(free_map.marked(), free_map.count());
+
+    BOOST_TEST_CHECKPOINT("Claim more words");
+    rc = CSeatMap::make_mask(std::set<uint32_t>({1, 70, 141, 200}), free_map.capacity(), mask);
+    BOOST_CHECK(free_map.claim(mask, claimed, false));
+    BOOST_CHECK(free_map.test(1) != true);
+    BOOST_CHECK(free_map.test(200) != true);
+    BOOST_CHECK_EQUAL(free_map.count(), 291);
+    BOOST_CHECK_EQUAL(free_map.marked(), free_map.count());
+}
+
+/// @brief Kernels on plain words
+/// @param  seatmap_test_case_3
+BOOST_AUTO_TEST_CASE(seatmap_test_case_3)
+{
+    std::vector<CSeatMap::word_t> req({1, 0, 0, 0, 0x10});
+    std::vector<CSeatMap::word_t> map({1, ~0ull, ~0ull, 0, 0x30});
+    std::vector<uint32_t> vect;
+    std::vector<uint32_t> vect2({0, 256, 260, 261});
+
+    BOOST_CHECK_EQUAL(CSeatMap::kernel_popcount(map.data(), map.size()), 131);
+    BOOST_CHECK(CSeatMap::kernel_any_andnot(req.data(), map.data(), req.size()) != true);
+    map[4] = 0x20;
+    BOOST_CHECK(CSeatMap::kernel_any_andnot(req.data(), map.data(), req.size()));
+
+    vect.clear();
+    CSeatMap::kernel_extract_andnot(req.data(), map.data(), req.size(), 0, vect);
+    BOOST_CHECK_EQUAL(vect.size(), 1);
+    BOOST_CHECK_EQUAL(vect[0], 260);
+
+    vect.clear();
+    req[1] = 0x6;
+    map[1] = 0x4;
+    CSeatMap::kernel_extract_andnot(req.data(), map.data(), req.size(), 64, vect);
+    BOOST_CHECK(vect == std::vector<uint32_t>({129, 324}));
+
+    vect.clear();
+    map = std::vector<CSeatMap::word_t>({1, 0, 0, 0, 0x31});
+    CSeatMap::kernel_extract(map.data(), map.size(), 0, vect);
+    BOOST_CHECK_EQUAL_COLLECTIONS(vect.begin(), vect.end(), vect2.begin(), vect2.end());
+
+    BOOST_TEST_CHECKPOINT("Kernels over two maps");
+    std::vector<CSeatMap::word_t> req2({0x3, 0, 0, 0, 0x11});
+    std::vector<CSeatMap::word_t> other({0x2, 0, 0, 0, 0x10});
+    std::vector<CSeatMap::word_t> moved(req2.size(), 0);
+    BOOST_CHECK(CSeatMap::kernel_any_andnot2(req2.data(), map.data(), other.data(), req2.size()) != true);
+    other[0] = 0;
+    BOOST_CHECK(CSeatMap::kernel_any_andnot2(req2.data(), map.data(), other.data(), req2.size()));
+    vect.clear();
+    CSeatMap::kernel_extract_andnot2(req2.data(), map.data(), other.data(), req2.size(), 0, vect);
+    BOOST_CHECK(vect == std::vector<uint32_t>({1}));
+
+    BOOST_CHECK_EQUAL(CSeatMap::kernel_move(map.data(), moved.data(), req2.data(), req2.size()), 3);
+    BOOST_CHECK(moved == std::vector<CSeatMap::word_t>({1, 0, 0, 0, 0x11}));
+    BOOST_CHECK(map == std::vector<CSeatMap::word_t>({0, 0, 0, 0, 0x20}));
+}
+
+
+/// @brief Number of marked seats follows every change, also concurrent ones
+/// @param  seatmap_test_case_4
+BOOST_AUTO_TEST_CASE(seatmap_test_case_4)
+{
+    CSeatMap map(300, true);
+    CSeatMap::mask_t mask;
+    CSeatMap::mask_t claimed;
+    std::vector<std::thread> threads;
+    std::vector<CSeatMap::word_t> words(CSeatMap::words(300), 0);
+
+    BOOST_TEST_CHECKPOINT("Marked seats are released only once");
+    BOOST_CHECK_EQUAL(map.marked(), 300);
+    BOOST_CHECK_GE(CSeatMap::make_mask(std::set<uint32_t>({1, 2, 3}), 300, mask), EXIT_SUCCESS);
+    BOOST_CHECK(map.claim(mask, claimed, false));
+    BOOST_CHECK_EQUAL(map.marked(), 297);
+    map.release(mask);
+    map.release(mask);
+    BOOST_CHECK_EQUAL(map.marked(), 300);
+
+    BOOST_TEST_CHECKPOINT("Concurrent claims and releases");
+    for (uint32_t i = 0; i < 4; ++i) {
+        threads.emplace_back([&map, i]() {
+            CSeatMap::mask_t thread_mask;
+            CSeatMap::mask_t thread_claimed;
+
+            CSeatMap::make_mask(std::set<uint32_t>({i, i + 16, i + 32}), 300, thread_mask);
+            for (uint32_t j = 0; j < 1000; ++j) {
+                if (map.claim(thread_mask, thread_claimed, false))
+                    map.release(thread_claimed);
+            }
+            map.claim(thread_mask, thread_claimed, false);
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    BOOST_CHECK_EQUAL(map.marked(), 288);
+    BOOST_CHECK_EQUAL(map.marked(), map.count());
+
+    BOOST_TEST_CHECKPOINT("Assigned and moved words are counted");
+    words[0] = 0xff;
+    map.assign(words);
+    BOOST_CHECK_EQUAL(map.marked(), 8);
+    CSeatMap moved(std::move(map));
+    BOOST_CHECK_EQUAL(moved.marked(), 8);
+    BOOST_CHECK_EQUAL(map.marked(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,127 @@
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <filesystem>
+
+#include "seatstore.h"
+
+
+/*
+    https://live.boost.org/doc/libs/1_87_0/libs/test/doc/html/boost_test/utf_reference.html
+*/
+
+
+BOOST_AUTO_TEST_SUITE(seatstore_suite)
+
+/// @brief Clean store is restored, dirty or foreign one is rebuilt
+/// @param  seatstore_test_case_1
+BOOST_AUTO_TEST_CASE(seatstore_test_case_1)
+{
+    int32_t rc;
+    CSeatMap map;
+    std::string path = (std::filesystem::temp_directory_path() / "seatstore_test_case_1.dat").string();
+    std::vector<uint32_t> capacities({70, 20});
+
+    std::filesystem::remove(path);
+
+    BOOST_TEST_CHECKPOINT("New store has all the seats free");
+    {
+        CSeatStore store;
+
+        rc = store.open(path, 1, capacities);
+        BOOST_CHECK_EQUAL(rc, 0);
+        BOOST_CHECK_EQUAL(store.open(path, 1, capacities), -EALREADY);
+
+        map.attach(store.get_section(0).words_, 70);
+        BOOST_CHECK_EQUAL(map.count(), 70);
+        map.attach(store.get_section(1).words_, 20);
+        BOOST_CHECK_EQUAL(map.count(), 20);
+
+        /*seat 5 of the second theatre is taken by booker 3*/
+        store.get_section(1).words_[0].fetch_and(~(static_cast<CSeatMap::word_t>(1) << 5));
+        store.get_section(1).owners_[5].store(3);
+        map.detach();
+
+        rc = store.close(42);
+        BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+        BOOST_CHECK(store.is_open() == false);
+    }
+
+    BOOST_TEST_CHECKPOINT("Clean store is restored");
+    {
+        CSeatStore store;
+
+        rc = store.open(path, 1, capacities);
+        BOOST_CHECK_EQUAL(rc, 1);
+        BOOST_CHECK_EQUAL(store.get_journal_offset(), 42);
+        BOOST_CHECK_EQUAL(store.get_section(1).owners_[5].load(), 3);
+        map.attach(store.get_section(1).words_, 20);
+        BOOST_CHECK_EQUAL(map.count(), 19);
+        BOOST_CHECK(map.test(5) == false);
+        map.detach();
+        /*not closed, as if the process crashed*/
+    }
+
+    BOOST_TEST_CHECKPOINT("Dirty store is rebuilt");
+    {
+        CSeatStore store;
+
+        rc = store.open(path, 1, capacities);
+        BOOST_CHECK_EQUAL(rc, 0);
+        BOOST_CHECK_EQUAL(store.get_journal_offset(), 0);
+        BOOST_CHECK_EQUAL(store.get_section(1).owners_[5].load(), 0);
+        store.get_section(0).owners_[0].store(1);
+        rc = store.close(0);
+        BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+    }
+
+    BOOST_TEST_CHECKPOINT("Damaged content is rebuilt");
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-1, std::ios::end);
+        file.put('x');
+    }
+    {
+        CSeatStore store;
+
+        rc = store.open(path, 1, capacities);
+        BOOST_CHECK_EQUAL(rc, 0);
+        BOOST_CHECK_EQUAL(store.get_section(0).owners_[0].load(), 0);
+        rc = store.close(0);
+        BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+    }
+
+    BOOST_TEST_CHECKPOINT("Other catalog is rebuilt");
+    {
+        CSeatStore store;
+
+        rc = store.open(path, 2, capacities);
+        BOOST_CHECK_EQUAL(rc, 0);
+        rc = store.close(0);
+        BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+
+        rc = store.open(path, 2, std::vector<uint32_t>({70, 21}));
+        BOOST_CHECK_EQUAL(rc, 0);
+    }
+
+    BOOST_TEST_CHECKPOINT("Swapped store keeps its file");
+    {
+        CSeatStore store;
+        CSeatStore other;
+
+        rc = store.open(path, 2, std::vector<uint32_t>({70, 21}));
+        BOOST_CHECK_EQUAL(rc, 0);
+        BOOST_CHECK_EQUAL(store.get_path(), path);
+        store.swap(other);
+        BOOST_CHECK(store.is_open() == false);
+        BOOST_CHECK(store.get_path().empty());
+        BOOST_CHECK_EQUAL(other.get_path(), path);
+        rc = other.close(0);
+        BOOST_CHECK_EQUAL(rc, EXIT_SUCCESS);
+        BOOST_CHECK(other.get_path().empty());
+    }
+
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
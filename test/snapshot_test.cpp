@@ -0,0 +1,75 @@
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <filesystem>
+
+#include "snapshot.h"
+
+
+/*
+    https://live.boost.org/doc/libs/1_87_0/libs/test/doc/html/boost_test/utf_reference.html
+*/
+
+
+BOOST_AUTO_TEST_SUITE(snapshot_suite)
+
+/// @brief Saved image is loaded back, damaged file is refused
+/// @param  snapshot_test_case_1
+BOOST_AUTO_TEST_CASE(snapshot_test_case_1)
+{
+    int32_t rc;
+    CSnapshot snapshot;
+    CSnapshot loaded;
+    std::string path = (std::filesystem::temp_directory_path() / "snapshot_test_case_1.snap").string();
+
+    std::filesystem::remove(path);
+
+    BOOST_TEST_CHECKPOINT("Missing file is reported");
+    rc = loaded.load(path);
+    BOOST_CHECK_EQUAL(rc, -ENOENT);
+
+    BOOST_TEST_CHECKPOINT("Image is written");
+    snapshot.theatres_.resize(2);
+    snapshot.theatres_[0].movie_ = "Matrix";
+    snapshot.theatres_[0].theatre_ = "Tokyo";
+    snapshot.theatres_[0].capacity_ = 70;
+    snapshot.theatres_[0].version_ = 2;
+    snapshot.theatres_[0].free_words_ = {~(static_cast<CSeatMap::word_t>(1) << 3), 0x3d};
+    snapshot.theatres_[0].owners_ = {{3, 1}, {65, 4}};
+    snapshot.theatres_[1].movie_ = "Matrix";
+    snapshot.theatres_[1].theatre_ = "Delhi";
+    snapshot.theatres_[1].capacity_ = 20;
+    snapshot.theatres_[1].free_words_ = {(1u << 20) - 1};
+
+    rc = snapshot.save(path);
+    BOOST_CHECK_GT(rc, 0);
+    BOOST_CHECK_EQUAL(std::filesystem::file_size(path), static_cast<uintmax_t>(rc));
+    BOOST_CHECK(std::filesystem::exists(path + ".tmp") == false);
+
+    BOOST_TEST_CHECKPOINT("Image is read back");
+    rc = loaded.load(path);
+    BOOST_CHECK_EQUAL(rc, 2);
+    BOOST_CHECK_EQUAL(loaded.theatres_[0].movie_, "Matrix");
+    BOOST_CHECK_EQUAL(loaded.theatres_[0].theatre_, "Tokyo");
+    BOOST_CHECK_EQUAL(loaded.theatres_[0].capacity_, 70);
+    BOOST_CHECK_EQUAL(loaded.theatres_[0].version_, 2);
+    BOOST_CHECK(loaded.theatres_[0].free_words_ == snapshot.theatres_[0].free_words_);
+    BOOST_CHECK(loaded.theatres_[0].owners_ == snapshot.theatres_[0].owners_);
+    BOOST_CHECK_EQUAL(loaded.theatres_[1].theatre_, "Delhi");
+    BOOST_CHECK_EQUAL(loaded.theatres_[1].capacity_, 20);
+    BOOST_CHECK(loaded.theatres_[1].owners_.empty());
+
+    BOOST_TEST_CHECKPOINT("Damaged file is refused, loaded image is kept");
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(20);
+        file.put('x');
+    }
+    rc = loaded.load(path);
+    BOOST_CHECK_EQUAL(rc, -EINVAL);
+    BOOST_CHECK_EQUAL(loaded.theatres_.size(), 2);
+
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
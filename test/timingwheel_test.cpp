@@ -0,0 +1,95 @@
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+
+#include "timingwheel.h"
+
+
+/*
+    https://live.boost.org/doc/libs/1_87_0/libs/test/doc/html/boost_test/utf_reference.html
+*/
+
+
+BOOST_AUTO_TEST_SUITE(timingwheel_suite)
+
+/// @brief Timers expire exactly in their tick
+/// @param  timingwheel_test_case_1
+BOOST_AUTO_TEST_CASE(timingwheel_test_case_1)
+{
+    CTimingWheel wheel;
+    std::vector<CTimingWheel::timer_id_t> expired;
+
+    BOOST_TEST_CHECKPOINT("Empty wheel jumps forward");
+    wheel.advance(1000, expired);
+    BOOST_CHECK_EQUAL(wheel.now(), 1000);
+    BOOST_CHECK(expired.empty());
+
+    BOOST_TEST_CHECKPOINT("Timers of all the levels");
+    wheel.schedule(1, 1001);
+    wheel.schedule(2, 1000 + 64);
+    wheel.schedule(3, 1000 + 64 * 64 + 5);
+    wheel.schedule(4, 1000 + 64 * 64 * 64 + 7);
+    wheel.schedule(5, 999);
+    BOOST_CHECK_EQUAL(wheel.size(), 5);
+
+    wheel.advance(1001, expired);
+    std::sort(expired.begin(), expired.end());
+    BOOST_CHECK_EQUAL(expired.size(), 2);
+    BOOST_CHECK_EQUAL(expired[0], 1);
+    BOOST_CHECK_EQUAL(expired[1], 5);
+
+    expired.clear();
+    wheel.advance(1000 + 63, expired);
+    BOOST_CHECK(expired.empty());
+    wheel.advance(1000 + 64, expired);
+    BOOST_CHECK_EQUAL(expired.size(), 1);
+
+    expired.clear();
+    wheel.advance(1000 + 64 * 64 + 4, expired);
+    BOOST_CHECK(expired.empty());
+    wheel.advance(1000 + 64 * 64 + 5, expired);
+    BOOST_CHECK_EQUAL(expired.size(), 1);
+    BOOST_CHECK_EQUAL(expired[0], 3);
+
+    expired.clear();
+    wheel.advance(1000 + 64 * 64 * 64 + 6, expired);
+    BOOST_CHECK(expired.empty());
+    wheel.advance(1000 + 64 * 64 * 64 + 7, expired);
+    BOOST_CHECK_EQUAL(expired.size(), 1);
+    BOOST_CHECK_EQUAL(expired[0], 4);
+    BOOST_CHECK_EQUAL(wheel.size(), 0);
+}
+
+/// @brief Random timers and timers beyond the range of the wheel
+/// @param  timingwheel_test_case_2
+BOOST_AUTO_TEST_CASE(timingwheel_test_case_2)
+{
+    uint64_t tick;
+    uint64_t seed;
+    CTimingWheel wheel;
+    std::vector<uint64_t> deadlines;
+    std::vector<CTimingWheel::timer_id_t> expired;
+
+    /*simple LCG, so the test is reproducible*/
+    seed = 12345;
+    wheel.advance(77, expired);
+    for (CTimingWheel::timer_id_t id = 0; id < 2000; ++id) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        deadlines.push_back(78 + (seed >> 33) % 300000);
+        wheel.schedule(id, deadlines.back());
+    }
+    deadlines.push_back(77 + (static_cast<uint64_t>(1) << 26));
+    wheel.schedule(deadlines.size() - 1, deadlines.back());
+
+    for (tick = 78; wheel.size() != 0; tick += 13) {
+        expired.clear();
+        wheel.advance(tick, expired);
+        for (CTimingWheel::timer_id_t id : expired) {
+            /*timer expires within the advanced step, never earlier*/
+            BOOST_CHECK_LE(deadlines[id], tick);
+            BOOST_CHECK_GT(deadlines[id] + 13, tick);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()